@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "../common/asyncstream.h"
 #include "../common/cmdsystem.h"
+#include "../common/compression.h"
 #include "../common/demometadata.h"
 #include "../common/singletonholder.h"
 #include "../common/pipeutils.h"
@@ -40,6 +41,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "serverlist.h"
 
+#include <algorithm>
 #include <random>
 #include <unordered_map>
 
@@ -1646,6 +1648,35 @@ static void CL_CheckForResend( void ) {
 	}
 }
 
+/*
+* CL_RequestGamestateChunk
+*
+* Requests the gamestate chunk that starts at the item.
+* The server replies by "precache" once all items have been requested.
+*/
+static void CL_RequestGamestateChunk( int start ) {
+	CL_AddReliableCommand( va( "gamestate %i %i", cl.servercount, start ) );
+
+	cl.gamestateNextItem = start;
+	cl.gamestateRequestedAt = start < SV_GAMESTATE_NUM_ITEMS ? Sys_Milliseconds() : 0;
+}
+
+/*
+* CL_CheckGamestateTimeout
+*
+* Requests the awaited gamestate chunk again as chunks are sent unreliably
+*/
+static void CL_CheckGamestateTimeout( void ) {
+	if( cls.state != CA_CONNECTED || !cl.gamestateRequestedAt ) {
+		return;
+	}
+
+	if( Sys_Milliseconds() - cl.gamestateRequestedAt >= 1000 ) {
+		Com_DPrintf( "Requesting the gamestate chunk at %d again\n", cl.gamestateNextItem );
+		CL_RequestGamestateChunk( cl.gamestateNextItem );
+	}
+}
+
 static void CL_Connect( const char *servername, socket_type_t type, netadr_t *address, const char *serverchain ) {
 	cl_connectChain[0] = '\0';
 	cl_nextString[0] = '\0';
@@ -3261,8 +3292,12 @@ static void CL_ParseServerData( msg_t *msg ) {
 
 	//assert( numpure == 0 );
 
-	// get the configstrings request
-	CL_AddReliableCommand( va( "configstrings %i 0", cl.servercount ) );
+	// get the configstrings and baselines request
+	if( ( sv_bitflags & SV_BITFLAGS_GAMESTATE ) && !cls.demoPlayer.playing ) {
+		CL_RequestGamestateChunk( 0 );
+	} else {
+		CL_AddReliableCommand( va( "configstrings %i 0", cl.servercount ) );
+	}
 
 	const bool old_sv_pure = cls.sv_pure;
 	cls.sv_pure = ( sv_bitflags & SV_BITFLAGS_PURE ) != 0;
@@ -3560,6 +3595,70 @@ static void CL_ParseServerCommand( msg_t *msg ) {
 	Com_Printf( "Unknown server command: %s\n", cmdArgs[0].data() );
 }
 
+/*
+* CL_ParseGamestate
+*
+* Inflates a chunk of configstrings and baselines sent to a connecting client
+*/
+static void CL_ParseGamestate( msg_t *msg ) {
+	static uint8_t chunkData[MAX_MSGLEN];
+
+	const int start = MSG_ReadInt32( msg );
+	const int next = MSG_ReadInt32( msg );
+	const int uncompressedSize = MSG_ReadInt32( msg );
+	const int compressedSize = MSG_ReadInt32( msg );
+	const int dataSize = compressedSize ? compressedSize : uncompressedSize;
+	if( uncompressedSize < 0 || uncompressedSize > MAX_MSGLEN || compressedSize < 0 ||
+		(size_t)dataSize > msg->cursize - msg->readcount ) {
+		Com_Error( ERR_DROP, "CL_ParseGamestate: Bad gamestate chunk size" );
+		return;
+	}
+
+	// skip chunks that were not requested (e.g. duplicates that were sent in reply to repeated requests)
+	if( !cl.gamestateRequestedAt || start != cl.gamestateNextItem ) {
+		MSG_SkipData( msg, dataSize );
+		return;
+	}
+
+	if( next <= start || next > SV_GAMESTATE_NUM_ITEMS ) {
+		Com_Error( ERR_DROP, "CL_ParseGamestate: Bad gamestate chunk range" );
+		return;
+	}
+
+	uLongf chunkSize = uncompressedSize;
+	if( compressedSize ) {
+		chunkSize = sizeof( chunkData );
+		if( qzuncompress( chunkData, &chunkSize, msg->data + msg->readcount, compressedSize ) != Z_OK ||
+			chunkSize != (uLongf)uncompressedSize ) {
+			Com_Error( ERR_DROP, "CL_ParseGamestate: Failed to decompress a gamestate chunk" );
+			return;
+		}
+	} else {
+		memcpy( chunkData, msg->data + msg->readcount, uncompressedSize );
+	}
+	MSG_SkipData( msg, dataSize );
+
+	msg_t chunk;
+	MSG_Init( &chunk, chunkData, sizeof( chunkData ) );
+	chunk.cursize = chunkSize;
+
+	while( chunk.readcount < chunk.cursize ) {
+		switch( MSG_ReadUint8( &chunk ) ) {
+			case svc_servercs:
+				CL_ParseServerCommand( &chunk );
+				break;
+			case svc_spawnbaseline:
+				CL_ParseBaseline( &chunk );
+				break;
+			default:
+				Com_Error( ERR_DROP, "CL_ParseGamestate: Illegible gamestate chunk" );
+				return;
+		}
+	}
+
+	CL_RequestGamestateChunk( next );
+}
+
 void CL_ParseServerMessage( msg_t *msg ) {
 	if( cl_shownet->integer == 1 ) {
 		Com_Printf( "%" PRIu64 " ", (uint64_t)msg->cursize );
@@ -3628,6 +3727,10 @@ void CL_ParseServerMessage( msg_t *msg ) {
 				CL_ParseBaseline( msg );
 				break;
 
+			case svc_gamestate:
+				CL_ParseGamestate( msg );
+				break;
+
 			case svc_download:
 				CL_ParseDownload( msg );
 				break;
@@ -3647,7 +3750,11 @@ void CL_ParseServerMessage( msg_t *msg ) {
 				break;
 
 			case svc_frame:
-				CL_ParseFrame( msg );
+				if( cls.demoPlayer.play_skip_frames ) {
+					SNAP_SkipFrame( msg, NULL );
+				} else {
+					CL_ParseFrame( msg );
+				}
 				break;
 
 			case svc_demoinfo:
@@ -3729,7 +3836,8 @@ const char * const svc_strings[256] =
 		"svc_servercs", // reliable command as unreliable for demos
 		"svc_frame",
 		"svc_demoinfo",
-		"svc_extension"
+		"svc_extension",
+		"svc_gamestate"
 	};
 
 void _SHOWNET( msg_t *msg, const char *s, int shownet ) {
@@ -4244,6 +4352,17 @@ void CL_Record_f( const CmdArgs &cmdArgs ) {
 	}
 }
 
+/*
+* A demo keyframe is a message that carries a non-delta frame.
+* Playback may be restarted from it without parsing any preceding frames.
+*/
+typedef struct {
+	int64_t serverTime;
+	int fileOffset;
+} demo_keyframe_t;
+
+static wsw::PodVector<demo_keyframe_t> g_demoKeyframes;
+
 /*
 * CL_DemoCompleted
 *
@@ -4268,6 +4387,8 @@ void CL_DemoCompleted( void ) {
 
 	CL_PauseDemo( false );
 
+	g_demoKeyframes.clear();
+
 	clNotice() << "Demo completed";
 
 	memset( &cls.demoPlayer, 0, sizeof( cls.demoPlayer ) );
@@ -4327,6 +4448,123 @@ void CL_ReadDemoPackets( void ) {
 	cls.demoPlayer.play_jump = false;
 }
 
+/*
+* CL_IndexDemoKeyframes
+*
+* Scans the entire demo once, recording file offsets of messages that contain non-delta frames.
+* Frames are skipped using their length prefix, so this is about as cheap as reading the file.
+*/
+static void CL_IndexDemoKeyframes( void ) {
+	static uint8_t msgbuf[MAX_MSGLEN];
+	static snapshot_t header;
+	msg_t msg;
+
+	g_demoKeyframes.clear();
+
+	const int demofile = cls.demoPlayer.demofilehandle;
+	const int oldOffset = FS_Tell( demofile );
+
+	MSG_Init( &msg, msgbuf, sizeof( msgbuf ) );
+	FS_Seek( demofile, 0, FS_SEEK_SET );
+
+	for(;; ) {
+		const int offset = FS_Tell( demofile );
+		if( SNAP_ReadDemoMessage( demofile, &msg ) == -1 ) {
+			break;
+		}
+
+		bool done = false;
+		while( !done && msg.readcount < msg.cursize ) {
+			switch( MSG_ReadUint8( &msg ) ) {
+				case svc_nop:
+					break;
+
+				case svc_servercmd:
+					if( !cls.reliable ) {
+						MSG_ReadInt32( &msg );
+					}
+					[[fallthrough]];
+				case svc_servercs:
+					MSG_ReadString( &msg );
+					break;
+
+				case svc_clcack:
+					MSG_ReadUintBase128( &msg );
+					MSG_ReadUintBase128( &msg );
+					MSG_ReadIntBase128( &msg );
+					break;
+
+				case svc_frame:
+					SNAP_SkipFrame( &msg, &header );
+					if( !header.delta ) {
+						g_demoKeyframes.push_back( { header.serverTime, offset } );
+					}
+					break;
+
+				case svc_demoinfo:
+					MSG_ReadInt32( &msg );
+					MSG_ReadInt32( &msg );
+					MSG_ReadInt32( &msg );
+					MSG_SkipData( &msg, (size_t)MSG_ReadInt32( &msg ) );
+					break;
+
+				case svc_extension:
+					MSG_ReadUint8( &msg );
+					MSG_ReadUint8( &msg );
+					MSG_SkipData( &msg, MSG_ReadInt16( &msg ) );
+					break;
+
+				default:
+					// serverdata, baselines and other startup data never share a message with frames
+					done = true;
+					break;
+			}
+		}
+	}
+
+	FS_Seek( demofile, oldOffset, FS_SEEK_SET );
+
+	cls.demoPlayer.keyframes_indexed = true;
+}
+
+/*
+* CL_FindDemoKeyframe
+*
+* Returns the last keyframe that is not later than the given server time
+*/
+static const demo_keyframe_t *CL_FindDemoKeyframe( int64_t serverTime ) {
+	if( !cls.demoPlayer.keyframes_indexed ) {
+		CL_IndexDemoKeyframes();
+	}
+
+	const auto it = std::upper_bound( g_demoKeyframes.begin(), g_demoKeyframes.end(), serverTime,
+									  []( int64_t time, const demo_keyframe_t &keyframe ) {
+		return time < keyframe.serverTime;
+	});
+	return it != g_demoKeyframes.begin() ? it - 1 : NULL;
+}
+
+/*
+* CL_SkipDemoFramesToOffset
+*
+* Executes server commands of demo messages up to the given offset without parsing their frames
+*/
+static void CL_SkipDemoFramesToOffset( int offset ) {
+	static uint8_t msgbuf[MAX_MSGLEN];
+	msg_t msg;
+
+	MSG_Init( &msg, msgbuf, sizeof( msgbuf ) );
+
+	cls.demoPlayer.play_skip_frames = true;
+	while( FS_Tell( cls.demoPlayer.demofilehandle ) < offset ) {
+		if( SNAP_ReadDemoMessage( cls.demoPlayer.demofilehandle, &msg ) == -1 ) {
+			break;
+		}
+		CL_ParseServerMessage( &msg );
+	}
+	cls.demoPlayer.play_skip_frames = false;
+}
+
 /*
 * CL_LatchedDemoJump
 *
@@ -4345,14 +4583,32 @@ void CL_LatchedDemoJump( void ) {
 
 	CL_AdjustServerTime( 1 );
 
-	if( cl.serverTime < cl.snapShots[cl.receivedSnapNum & UPDATE_MASK].serverTime ) {
-		cls.demoPlayer.demofilelen = cls.demoPlayer.demofilelentotal;
+	cls.demoPlayer.play_jump = true;
+	cls.demoPlayer.play_jump_latched = false;
+
+	const bool rewind = cl.serverTime < cl.snapShots[cl.receivedSnapNum & UPDATE_MASK].serverTime;
+	const int currentOffset = FS_Tell( cls.demoPlayer.demofilehandle );
+
+	// jump to the closest preceding keyframe if it saves parsing any frames
+	const demo_keyframe_t *keyframe = CL_FindDemoKeyframe( cl.serverTime );
+	if( keyframe && !rewind && keyframe->fileOffset <= currentOffset ) {
+		keyframe = NULL;
+	}
+
+	if( rewind ) {
 		FS_Seek( cls.demoPlayer.demofilehandle, 0, FS_SEEK_SET );
-		cl.currentSnapNum = cl.receivedSnapNum = 0;
 	}
 
-	cls.demoPlayer.play_jump = true;
-	cls.demoPlayer.play_jump_latched = false;
+	if( keyframe ) {
+		// configstrings and other server commands still have to be applied in order
+		CL_SkipDemoFramesToOffset( keyframe->fileOffset );
+		FS_Seek( cls.demoPlayer.demofilehandle, keyframe->fileOffset, FS_SEEK_SET );
+	}
+
+	if( rewind || keyframe ) {
+		cls.demoPlayer.demofilelen = cls.demoPlayer.demofilelentotal;
+		cl.currentSnapNum = cl.receivedSnapNum = 0;
+	}
 }
 
 static void CL_StartDemo( const char *demoname, bool pause_on_stop ) {
@@ -5427,6 +5683,7 @@ static void CL_NetFrame( int realMsec, int gameMsec ) {
 
 	// resend a connection request if necessary
 	CL_CheckForResend();
+	CL_CheckGamestateTimeout();
 	CL_CheckDownloadTimeout();
 
 	ServerList::instance()->frame();
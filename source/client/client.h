@@ -123,6 +123,9 @@ typedef struct client_state_s {
 
 	char servermessage[MAX_STRING_CHARS];
 
+	int gamestateNextItem;          // the first item of the requested gamestate chunk
+	int64_t gamestateRequestedAt;   // zero if no gamestate chunk is awaited
+
 	int configStringFragmentIndex;
 	int configStringFragmentNum;
 	int configStringNumFragments;
@@ -203,6 +206,8 @@ struct DemoPlayer {
 	bool play_jump;
 	bool play_jump_latched;
 	int64_t play_jump_time;
+	bool play_skip_frames;      // parse only server commands while skipping to a keyframe
+	bool keyframes_indexed;
 	bool play_ignore_next_frametime;
 
 	bool pause_on_stop;
@@ -102,6 +102,21 @@ typedef struct {
 	int area;
 } cleaf_t;
 
+// A node of the bounding volume hierarchy of world brushes and patch facets.
+// Bounds of children are kept in SoA form, so all 4 children get tested at once.
+typedef struct {
+	float mins[3][4];
+	float maxs[3][4];
+	int children[4];            // a node number, or a first primitive number for leaf children
+	int numprims[4];            // 0 for node children
+	int contents[4];            // 0 for empty slots
+} cbvhnode_t;
+
+typedef struct {
+	const cbrush_t *brush;
+	int contents;               // contents of a patch for facets
+} cbvhprim_t;
+
 typedef struct cmodel_s {
 	cface_t *faces;
 	cbrush_t *brushes;
@@ -171,6 +186,11 @@ struct cmodel_state_s {
 
 	vec3_t *leaf_bounds;            // kept aside from "hot" leaf data as being rarely accessed
 
+	int numbvhnodes;
+	cbvhnode_t *map_bvhnodes;       // instance-local (is not shared)
+	int numbvhprims;
+	cbvhprim_t *map_bvhprims;       // instance-local (is not shared)
+
 	int nummarkfaces;
 	cface_t **map_markfaces;        // instance-local (is not shared)
 
@@ -209,17 +229,15 @@ struct cmodel_state_s {
 	cbrush_t *oct_markbrushes[1];
 	cmodel_t oct_cmodel[1];
 
-	mutable int leaf_count, leaf_maxcount;
-	mutable int *leaf_list;
-	mutable const float *leaf_mins, *leaf_maxs;
-	mutable int leaf_topnode;
-
 	struct Ops *ops;
 	alignas( alignof( void * ) ) uint8_t opsStorage[16];
 };
 
 //=======================================================================
 
+// 0 - traverse BSP nodes by world traces, 1 - traverse the BVH, 2 - do both and compare results
+extern cvar_t *cm_bvh;
+
 void CM_InitBoxHull( cmodel_state_t *cms );
 
 void CM_InitOctagonHull( cmodel_state_t *cms );
@@ -28,6 +28,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 static bool cm_initialized = false;
 
 static cvar_t *cm_noAreas;
+cvar_t *cm_bvh;
 
 void CM_LoadQ3BrushModel( cmodel_state_t *cms, void *parent, void *buffer, bspFormatDesc_t *format );
 
@@ -127,6 +128,18 @@ static void CM_Clear( cmodel_state_t *cms ) {
 		cms->leaf_bounds = NULL;
 	}
 
+	if( cms->map_bvhnodes ) {
+		Q_free( cms->map_bvhnodes );
+		cms->map_bvhnodes = NULL;
+		cms->numbvhnodes = 0;
+	}
+
+	if( cms->map_bvhprims ) {
+		Q_free( cms->map_bvhprims );
+		cms->map_bvhprims = NULL;
+		cms->numbvhprims = 0;
+	}
+
 	if( cms->map_nodes ) {
 		Q_free( cms->map_nodes );
 		cms->map_nodes = NULL;
@@ -516,7 +529,7 @@ int CM_ClusterRowSize( const cmodel_state_t *cms ) {
 /*
 * CM_ClusterRowLongs
 */
-static int CM_ClusterRowLongs( cmodel_state_t *cms ) {
+static int CM_ClusterRowLongs( const cmodel_state_t *cms ) {
 	return cms->map_pvs ? ( cms->map_pvs->rowsize + 3 ) / 4 : MAX_CM_LEAFS / 32;
 }
 
@@ -530,7 +543,7 @@ int CM_NumClusters( const cmodel_state_t *cms ) {
 /*
 * CM_ClusterPVS
 */
-static inline const uint8_t *CM_ClusterPVS( const cmodel_state_t *cms, int cluster ) {
+const uint8_t *CM_ClusterPVS( const cmodel_state_t *cms, int cluster ) {
 	const dvis_t *vis = cms->map_pvs;
 
 	if( cluster == -1 || !vis ) {
@@ -795,14 +808,12 @@ bool CM_HeadnodeVisible( const cmodel_state_t *cms, int nodenum, const uint8_t *
 
 
 /*
-* CM_MergePVS
-* Merge PVS at origin into out
+* CM_FatPVSClusters
+* Gets distinct clusters which PVS rows are merged by CM_MergePVS at origin
 */
-void CM_MergePVS( cmodel_state_t *cms, const vec3_t org, uint8_t *out ) {
+int CM_FatPVSClusters( const cmodel_state_t *cms, const vec3_t org, int *clusters, int maxClusters ) {
 	int leafs[128];
-	int i, j, count;
-	int longs;
-	const uint8_t *src;
+	int i, j, count, numClusters;
 	vec3_t mins, maxs;
 
 	for( i = 0; i < 3; i++ ) {
@@ -812,24 +823,41 @@ void CM_MergePVS( cmodel_state_t *cms, const vec3_t org, uint8_t *out ) {
 
 	count = CM_BoxLeafnums( cms, mins, maxs, leafs, sizeof( leafs ) / sizeof( int ), NULL );
 	if( count < 1 ) {
-		Com_Error( ERR_FATAL, "CM_MergePVS: count < 1" );
+		Com_Error( ERR_FATAL, "CM_FatPVSClusters: count < 1" );
 	}
-	longs = CM_ClusterRowLongs( cms );
-
-	// convert leafs to clusters
-	for( i = 0; i < count; i++ )
-		leafs[i] = CM_LeafCluster( cms, leafs[i] );
 
-	// or in all the other leaf bits
-	for( i = 0; i < count; i++ ) {
-		for( j = 0; j < i; j++ )
-			if( leafs[i] == leafs[j] ) {
+	// convert leafs to clusters, skipping ones we already have
+	numClusters = 0;
+	for( i = 0; i < count && numClusters < maxClusters; i++ ) {
+		const int cluster = CM_LeafCluster( cms, leafs[i] );
+		for( j = 0; j < numClusters; j++ )
+			if( clusters[j] == cluster ) {
 				break;
 			}
-		if( j != i ) {
-			continue; // already have the cluster we want
+		if( j == numClusters ) {
+			clusters[numClusters++] = cluster;
 		}
-		src = CM_ClusterPVS( cms, leafs[i] );
+	}
+
+	return numClusters;
+}
+
+/*
+* CM_MergePVS
+* Merge PVS at origin into out
+*/
+void CM_MergePVS( const cmodel_state_t *cms, const vec3_t org, uint8_t *out ) {
+	int clusters[128];
+	int i, j, count;
+	int longs;
+	const uint8_t *src;
+
+	count = CM_FatPVSClusters( cms, org, clusters, sizeof( clusters ) / sizeof( int ) );
+	longs = CM_ClusterRowLongs( cms );
+
+	// or in all the cluster bits
+	for( i = 0; i < count; i++ ) {
+		src = CM_ClusterPVS( cms, clusters[i] );
 		for( j = 0; j < longs; j++ )
 			( (int *)out )[j] |= ( (int *)src )[j];
 	}
@@ -838,7 +866,7 @@ void CM_MergePVS( cmodel_state_t *cms, const vec3_t org, uint8_t *out ) {
 /*
 * CM_MergeVisSets
 */
-int CM_MergeVisSets( cmodel_state_t *cms, const vec3_t org, uint8_t *pvs, uint8_t *areabits ) {
+int CM_MergeVisSets( const cmodel_state_t *cms, const vec3_t org, uint8_t *pvs, uint8_t *areabits ) {
 	int area;
 
 	assert( pvs || areabits );
@@ -940,6 +968,31 @@ cmodel_state_t *CM_New() {
 	return cms;
 }
 
+/*
+* CM_SelectOps
+*/
+bool CM_SelectOps( cmodel_state_t *cms, const char *name ) {
+	const unsigned cpuFeatures = Sys_GetProcessorFeatures();
+	if( !Q_stricmp( name, "avx" ) ) {
+		if( !( cpuFeatures & Q_CPU_FEATURE_AVX ) ) {
+			return false;
+		}
+		cms->ops = new( cms->opsStorage )AvxOps;
+	} else if( !Q_stricmp( name, "sse42" ) ) {
+		if( !( cpuFeatures & Q_CPU_FEATURE_SSE42 ) ) {
+			return false;
+		}
+		cms->ops = new( cms->opsStorage )Sse42Ops;
+	} else if( !Q_stricmp( name, "generic" ) ) {
+		cms->ops = new( cms->opsStorage )GenericOps;
+	} else {
+		return false;
+	}
+
+	cms->ops->cms = cms;
+	return true;
+}
+
 /*
 * CM_Free
 */
@@ -977,6 +1030,7 @@ void CM_Init( void ) {
 	assert( !cm_initialized );
 
 	cm_noAreas =        Cvar_Get( "cm_noAreas", "0", CVAR_CHEAT );
+	cm_bvh =            Cvar_Get( "cm_bvh", "0", CVAR_ARCHIVE );
 
 	cm_initialized = true;
 }
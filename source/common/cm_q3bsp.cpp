@@ -30,8 +30,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "wswstringsplitter.h"
 #include "wswtonum.h"
 #include "wswvector.h"
+#include "wswpodvector.h"
 #include "memspecbuilder.h"
 
+#include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
 #include <memory>
@@ -1034,6 +1036,176 @@ static void CMod_LoadEntityString( cmodel_state_t *cms, lump_t *l ) {
 	memcpy( cms->map_entitystring, cms->cmod_base + l->fileofs, l->filelen );
 }
 
+#define CM_BVH_MAX_LEAF_PRIMS 4
+
+typedef struct {
+	vec3_t mins, maxs;
+	vec3_t center;
+	cbvhprim_t prim;
+} cbvhbuildprim_t;
+
+/*
+* CMod_SplitBvhRange
+*
+* Partitions primitives by the median of centers along the axis of the largest centers extent
+*/
+static int CMod_SplitBvhRange( cbvhbuildprim_t *prims, int count ) {
+	vec3_t mins, maxs;
+	ClearBounds( mins, maxs );
+	for( int i = 0; i < count; i++ ) {
+		AddPointToBounds( prims[i].center, mins, maxs );
+	}
+
+	int axis = 0;
+	for( int i = 1; i < 3; i++ ) {
+		if( maxs[i] - mins[i] > maxs[axis] - mins[axis] ) {
+			axis = i;
+		}
+	}
+
+	const int half = count / 2;
+	std::nth_element( prims, prims + half, prims + count, [=]( const cbvhbuildprim_t &a, const cbvhbuildprim_t &b ) {
+		return a.center[axis] < b.center[axis];
+	});
+	return half;
+}
+
+/*
+* CMod_BuildBvhNode
+*/
+static int CMod_BuildBvhNode( wsw::PodVector<cbvhnode_t> *nodes, cbvhbuildprim_t *prims, int first, int count, int depth ) {
+	if( depth > 32 ) {
+		Com_Error( ERR_DROP, "CMod_BuildBvhNode: the hierarchy is too deep" );
+	}
+
+	// Split the range twice, so we get up to 4 children
+	int ranges[4][2];
+	int numRanges = 0;
+	const int half = CMod_SplitBvhRange( prims + first, count );
+	const int halves[2][2] = { { first, half }, { first + half, count - half } };
+	for( const auto &[halfFirst, halfCount]: halves ) {
+		if( halfCount > CM_BVH_MAX_LEAF_PRIMS ) {
+			const int quarter = CMod_SplitBvhRange( prims + halfFirst, halfCount );
+			ranges[numRanges][0] = halfFirst;
+			ranges[numRanges++][1] = quarter;
+			ranges[numRanges][0] = halfFirst + quarter;
+			ranges[numRanges++][1] = halfCount - quarter;
+		} else if( halfCount ) {
+			ranges[numRanges][0] = halfFirst;
+			ranges[numRanges++][1] = halfCount;
+		}
+	}
+
+	// Reserve the node before building children, nodes are addressed by numbers as the storage could grow
+	const int nodeNum = (int)nodes->size();
+	nodes->push_back( cbvhnode_t {} );
+
+	cbvhnode_t node {};
+	for( int i = 0; i < 4; i++ ) {
+		for( int j = 0; j < 3; j++ ) {
+			node.mins[j][i] = +999999;
+			node.maxs[j][i] = -999999;
+		}
+	}
+
+	for( int i = 0; i < numRanges; i++ ) {
+		const int rangeFirst = ranges[i][0], rangeCount = ranges[i][1];
+
+		vec3_t mins, maxs;
+		ClearBounds( mins, maxs );
+		int contents = 0;
+		for( int j = rangeFirst; j < rangeFirst + rangeCount; j++ ) {
+			AddPointToBounds( prims[j].mins, mins, maxs );
+			AddPointToBounds( prims[j].maxs, mins, maxs );
+			contents |= prims[j].prim.contents;
+		}
+
+		for( int j = 0; j < 3; j++ ) {
+			node.mins[j][i] = mins[j];
+			node.maxs[j][i] = maxs[j];
+		}
+		node.contents[i] = contents;
+
+		if( rangeCount > CM_BVH_MAX_LEAF_PRIMS ) {
+			node.children[i] = CMod_BuildBvhNode( nodes, prims, rangeFirst, rangeCount, depth + 1 );
+			node.numprims[i] = 0;
+		} else {
+			node.children[i] = rangeFirst;
+			node.numprims[i] = rangeCount;
+		}
+	}
+
+	( *nodes )[nodeNum] = node;
+	return nodeNum;
+}
+
+/*
+* CMod_BuildBvh
+*
+* Builds a hierarchy of bounds of world brushes and patch facets.
+* Leaves store copies of brushes touching them, the hierarchy refers to every primitive just once.
+*/
+static void CMod_BuildBvh( cmodel_state_t *cms ) {
+	wsw::PodVector<bool> addedBrushes, addedFaces;
+	addedBrushes.resize( cms->numbrushes + 1, false );
+	addedFaces.resize( cms->numfaces + 1, false );
+
+	wsw::PodVector<cbvhbuildprim_t> prims;
+	const auto addPrim = [&]( const cbrush_t *brush, int contents ) {
+		if( !brush->numsides ) {
+			return;
+		}
+		cbvhbuildprim_t prim;
+		VectorCopy( brush->mins, prim.mins );
+		VectorCopy( brush->maxs, prim.maxs );
+		VectorAvg( prim.mins, prim.maxs, prim.center );
+		prim.prim.brush = brush;
+		prim.prim.contents = contents;
+		prims.push_back( prim );
+	};
+
+	for( int i = 0; i < cms->numleafs; i++ ) {
+		const cleaf_t *leaf = &cms->map_leafs[i];
+		for( int j = 0; j < leaf->numbrushes; j++ ) {
+			const unsigned globalNumber = leaf->brushes[j].globalNumber;
+			if( !addedBrushes[globalNumber] ) {
+				addedBrushes[globalNumber] = true;
+				// Refer to the original brush, not to the copy owned by the leaf
+				const cbrush_t *brush = &cms->map_brushes[globalNumber - 1];
+				addPrim( brush, brush->contents );
+			}
+		}
+		for( int j = 0; j < leaf->numfaces; j++ ) {
+			const unsigned globalNumber = leaf->faces[j].globalNumber;
+			if( !addedFaces[globalNumber] ) {
+				addedFaces[globalNumber] = true;
+				const cface_t *patch = &cms->map_faces[globalNumber - 1];
+				for( int k = 0; k < patch->numfacets; k++ ) {
+					addPrim( &patch->facets[k], patch->contents );
+				}
+			}
+		}
+	}
+
+	if( prims.empty() ) {
+		return;
+	}
+
+	wsw::PodVector<cbvhnode_t> nodes;
+	nodes.reserve( 2 * ( prims.size() / CM_BVH_MAX_LEAF_PRIMS ) + 1 );
+	(void)CMod_BuildBvhNode( &nodes, prims.data(), 0, (int)prims.size(), 0 );
+
+	cms->numbvhnodes = (int)nodes.size();
+	cms->map_bvhnodes = (cbvhnode_t *)Q_malloc( nodes.size() * sizeof( cbvhnode_t ) );
+	memcpy( cms->map_bvhnodes, nodes.data(), nodes.size() * sizeof( cbvhnode_t ) );
+
+	cms->numbvhprims = (int)prims.size();
+	cms->map_bvhprims = (cbvhprim_t *)Q_malloc( prims.size() * sizeof( cbvhprim_t ) );
+	for( size_t i = 0; i < prims.size(); i++ ) {
+		cms->map_bvhprims[i] = prims[i].prim;
+	}
+}
+
 /*
 * CM_LoadQ3BrushModel
 */
@@ -1071,6 +1243,7 @@ void CM_LoadQ3BrushModel( cmodel_state_t *cms, void *parent, void *buf, bspForma
 	CMod_LoadSubmodels( cms, &header.lumps[LUMP_MODELS] );
 	CMod_LoadVisibility( cms, &header.lumps[LUMP_VISIBILITY] );
 	CMod_LoadEntityString( cms, &header.lumps[LUMP_ENTITIES] );
+	CMod_BuildBvh( cms );
 
 	FS_FreeFile( buf );
 
@@ -56,6 +56,7 @@ void CM_InitBoxHull( cmodel_state_t *cms ) {
 	cms->box_cmodel->faces = NULL;
 	cms->box_cmodel->brushes = cms->box_brush;
 	cms->box_cmodel->numbrushes = 1;
+	VectorClear( cms->box_cmodel->cyl_offset );
 
 	for( int i = 0; i < 6; i++ ) {
 		// brush sides
@@ -152,13 +153,41 @@ void CM_InitOctagonHull( cmodel_state_t *cms ) {
 	}
 }
 
+// The actual layout of CMHullModelStorage contents
+typedef struct {
+	cbrushside_t brushsides[10];
+	cbrush_t brush;
+	cmodel_t cmodel;
+} chullmodel_t;
+
+static_assert( sizeof( chullmodel_t ) <= sizeof( CMHullModelStorage ) );
+static_assert( alignof( chullmodel_t ) <= alignof( CMHullModelStorage ) );
+
 /*
-* CM_ModelForBBox
+* CM_CopyHullModel
 *
-* To keep everything totally uniform, bounding boxes are turned into inline models
+* Makes a private copy of a builtin hull so it could be modified without touching the shared instance
 */
-cmodel_t *CM_ModelForBBox( cmodel_state_t *cms, const vec3_t mins, const vec3_t maxs ) {
-	cbrushside_t *sides = cms->box_brush->brushsides;
+static cmodel_t *CM_CopyHullModel( const cmodel_t *builtinModel, CMHullModelStorage *storage ) {
+	const cbrush_t *builtinBrush = builtinModel->brushes;
+	assert( builtinModel->builtin && builtinModel->numbrushes == 1 );
+	assert( builtinBrush->numsides <= (int)( sizeof( chullmodel_t::brushsides ) / sizeof( cbrushside_t ) ) );
+
+	auto *const hull = new( storage->data )chullmodel_t;
+	std::memcpy( hull->brushsides, builtinBrush->brushsides, builtinBrush->numsides * sizeof( cbrushside_t ) );
+	hull->brush = *builtinBrush;
+	hull->brush.brushsides = hull->brushsides;
+	hull->cmodel = *builtinModel;
+	hull->cmodel.brushes = &hull->brush;
+
+	return &hull->cmodel;
+}
+
+/*
+* CM_SetupBoxModel
+*/
+static cmodel_t *CM_SetupBoxModel( cmodel_t *cmodel, const vec3_t mins, const vec3_t maxs ) {
+	cbrushside_t *sides = cmodel->brushes->brushsides;
 	sides[0].plane.dist = maxs[0];
 	sides[1].plane.dist = -mins[0];
 	sides[2].plane.dist = maxs[1];
@@ -166,19 +195,31 @@ cmodel_t *CM_ModelForBBox( cmodel_state_t *cms, const vec3_t mins, const vec3_t
 	sides[4].plane.dist = maxs[2];
 	sides[5].plane.dist = -mins[2];
 
-	VectorCopy( mins, cms->box_cmodel->mins );
-	VectorCopy( maxs, cms->box_cmodel->maxs );
+	VectorCopy( mins, cmodel->mins );
+	VectorCopy( maxs, cmodel->maxs );
 
-	return cms->box_cmodel;
+	return cmodel;
 }
 
 /*
-* CM_OctagonModelForBBox
+* CM_ModelForBBox
+*
+* To keep everything totally uniform, bounding boxes are turned into inline models
+*/
+cmodel_t *CM_ModelForBBox( cmodel_state_t *cms, const vec3_t mins, const vec3_t maxs ) {
+	return CM_SetupBoxModel( cms->box_cmodel, mins, maxs );
+}
+
+cmodel_t *CM_ModelForBBox( const cmodel_state_t *cms, const vec3_t mins, const vec3_t maxs, CMHullModelStorage *storage ) {
+	return CM_SetupBoxModel( CM_CopyHullModel( cms->box_cmodel, storage ), mins, maxs );
+}
+
+/*
+* CM_SetupOctagonModel
 *
-* Same as CM_ModelForBBox with 4 additional planes at corners.
 * Internally offset to be symmetric on all sides.
 */
-cmodel_t *CM_OctagonModelForBBox( cmodel_state_t *cms, const vec3_t mins, const vec3_t maxs ) {
+static cmodel_t *CM_SetupOctagonModel( cmodel_t *cmodel, const vec3_t mins, const vec3_t maxs ) {
 	int i;
 	float a, b, d, t;
 	float sina, cosa;
@@ -190,11 +231,11 @@ cmodel_t *CM_OctagonModelForBBox( cmodel_state_t *cms, const vec3_t mins, const
 		size[1][i] = maxs[i] - offset[i];
 	}
 
-	VectorCopy( offset, cms->oct_cmodel->cyl_offset );
-	VectorCopy( size[0], cms->oct_cmodel->mins );
-	VectorCopy( size[1], cms->oct_cmodel->maxs );
+	VectorCopy( offset, cmodel->cyl_offset );
+	VectorCopy( size[0], cmodel->mins );
+	VectorCopy( size[1], cmodel->maxs );
 
-	cbrushside_t *sides = cms->oct_brush->brushsides;
+	cbrushside_t *sides = cmodel->brushes->brushsides;
 	sides[0].plane.dist = size[1][0];
 	sides[1].plane.dist = -size[0][0];
 	sides[2].plane.dist = size[1][1];
@@ -232,7 +273,20 @@ cmodel_t *CM_OctagonModelForBBox( cmodel_state_t *cms, const vec3_t mins, const
 	VectorSet( sides[9].plane.normal, cosa, -sina, 0 );
 	sides[9].plane.dist = d;
 
-	return cms->oct_cmodel;
+	return cmodel;
+}
+
+/*
+* CM_OctagonModelForBBox
+*
+* Same as CM_ModelForBBox with 4 additional planes at corners.
+*/
+cmodel_t *CM_OctagonModelForBBox( cmodel_state_t *cms, const vec3_t mins, const vec3_t maxs ) {
+	return CM_SetupOctagonModel( cms->oct_cmodel, mins, maxs );
+}
+
+cmodel_t *CM_OctagonModelForBBox( const cmodel_state_t *cms, const vec3_t mins, const vec3_t maxs, CMHullModelStorage *storage ) {
+	return CM_SetupOctagonModel( CM_CopyHullModel( cms->oct_cmodel, storage ), mins, maxs );
 }
 
 void Ops::ClipBoxToBrush( CMTraceContext *tlc, const cbrush_t *brush ) {
@@ -537,13 +591,69 @@ void Ops::ClipBoxToLeaf( CMTraceContext *tlc, const cbrush_t *brushes, int numbr
 	}
 }
 
+/*
+* CM_NodeDistances
+*
+* Finds the point distances to the separating plane and the offset for the size of the box.
+* RecursiveBatchHullCheck() computes the same expressions for every lane, so keep these in sync.
+*/
+static inline void CM_NodeDistances( const cplane_t *plane, const CMTraceContext *tlc,
+									 const float *p1, const float *p2, float *t1, float *t2, float *offset ) {
+	if( plane->type < 3 ) {
+		*t1 = p1[plane->type] - plane->dist;
+		*t2 = p2[plane->type] - plane->dist;
+		*offset = tlc->extents[plane->type];
+	} else {
+		*t1 = DotProduct( plane->normal, p1 ) - plane->dist;
+		*t2 = DotProduct( plane->normal, p2 ) - plane->dist;
+		if( tlc->ispoint ) {
+			*offset = 0;
+		} else {
+			*offset = fabsf( tlc->extents[0] * plane->normal[0] ) +
+					  fabsf( tlc->extents[1] * plane->normal[1] ) +
+					  fabsf( tlc->extents[2] * plane->normal[2] );
+		}
+	}
+}
+
+/*
+* CM_SplitSweep
+*
+* Finds the near side and fractions of the sweep parts that are on both sides of a node.
+* This is shared by the single and the batched traversal, so they take exactly the same paths.
+*/
+static inline int CM_SplitSweep( float t1, float t2, float offset, float *frac, float *frac2 ) {
+	// put the crosspoint DIST_EPSILON pixels on the near side
+	int side;
+	float idist;
+	if( t1 < t2 ) {
+		idist = 1.0 / ( t1 - t2 );
+		side = 1;
+		*frac2 = ( t1 + offset + DIST_EPSILON ) * idist;
+		*frac = ( t1 - offset + DIST_EPSILON ) * idist;
+	} else if( t1 > t2 ) {
+		idist = 1.0 / ( t1 - t2 );
+		side = 0;
+		*frac2 = ( t1 - offset - DIST_EPSILON ) * idist;
+		*frac = ( t1 + offset + DIST_EPSILON ) * idist;
+	} else {
+		side = 0;
+		*frac = 1;
+		*frac2 = 0;
+	}
+
+	Q_clamp( *frac, 0, 1 );
+	Q_clamp( *frac2, 0, 1 );
+	return side;
+}
+
 void Ops::RecursiveHullCheck( CMTraceContext *tlc, int num, float p1f, float p2f, const vec3_t p1, const vec3_t p2 ) {
 	cnode_t *node;
 	cplane_t *plane;
 	int side;
 	float t1, t2, offset;
 	float frac, frac2;
-	float idist, midf;
+	float midf;
 	vec3_t mid;
 
 loc0:
@@ -567,22 +677,7 @@ loc0:
 	//
 	node = cms->map_nodes + num;
 	plane = node->plane;
-
-	if( plane->type < 3 ) {
-		t1 = p1[plane->type] - plane->dist;
-		t2 = p2[plane->type] - plane->dist;
-		offset = tlc->extents[plane->type];
-	} else {
-		t1 = DotProduct( plane->normal, p1 ) - plane->dist;
-		t2 = DotProduct( plane->normal, p2 ) - plane->dist;
-		if( tlc->ispoint ) {
-			offset = 0;
-		} else {
-			offset = fabsf( tlc->extents[0] * plane->normal[0] ) +
-					 fabsf( tlc->extents[1] * plane->normal[1] ) +
-					 fabsf( tlc->extents[2] * plane->normal[2] );
-		}
-	}
+	CM_NodeDistances( plane, tlc, p1, p2, &t1, &t2, &offset );
 
 	// see which sides we need to consider
 	if( t1 >= offset && t2 >= offset ) {
@@ -594,157 +689,260 @@ loc0:
 		goto loc0;
 	}
 
-	// put the crosspoint DIST_EPSILON pixels on the near side
-	if( t1 < t2 ) {
-		idist = 1.0 / ( t1 - t2 );
-		side = 1;
-		frac2 = ( t1 + offset + DIST_EPSILON ) * idist;
-		frac = ( t1 - offset + DIST_EPSILON ) * idist;
-	} else if( t1 > t2 ) {
-		idist = 1.0 / ( t1 - t2 );
-		side = 0;
-		frac2 = ( t1 - offset - DIST_EPSILON ) * idist;
-		frac = ( t1 + offset + DIST_EPSILON ) * idist;
-	} else {
-		side = 0;
-		frac = 1;
-		frac2 = 0;
-	}
+	side = CM_SplitSweep( t1, t2, offset, &frac, &frac2 );
 
 	// move up to the node
-	Q_clamp( frac, 0, 1 );
 	midf = p1f + ( p2f - p1f ) * frac;
 	VectorLerp( p1, frac, p2, mid );
 
 	RecursiveHullCheck( tlc, node->children[side], p1f, midf, p1, mid );
 
 	// go past the node
-	Q_clamp( frac2, 0, 1 );
 	midf = p1f + ( p2f - p1f ) * frac2;
 	VectorLerp( p1, frac2, p2, mid );
 
 	RecursiveHullCheck( tlc, node->children[side ^ 1], midf, p2f, mid, p2 );
 }
 
-void Ops::SetupCollideContext( CMTraceContext *__restrict tlc, trace_t *__restrict tr, const float *start,
-							   const float *end, const float *mins, const float *maxs, int brushmask ) {
-	tlc->trace = tr;
-	tlc->contents = brushmask;
-	VectorCopy( start, tlc->start );
-	VectorCopy( end, tlc->end );
-	VectorCopy( mins, tlc->mins );
-	VectorCopy( maxs, tlc->maxs );
-
-	// TODO: Supply 4-component vectors as arguments of this method so we can use explicit SIMD overloads
-	BoundsBuilder boundsBuilder;
+/*
+* CM_CopyBatchLane
+*/
+static inline void CM_CopyBatchLane( const CMBatchPacket *from, int fromLane, CMBatchPacket *to, int toLane ) {
+	for( int i = 0; i < 3; ++i ) {
+		to->p1[i][toLane] = from->p1[i][fromLane];
+		to->p2[i][toLane] = from->p2[i][fromLane];
+	}
+	to->p1f[toLane] = from->p1f[fromLane];
+	to->p2f[toLane] = from->p2f[fromLane];
+	to->traceNums[toLane] = from->traceNums[fromLane];
+}
 
-	VectorAdd( start, tlc->mins, tlc->startmins );
-	boundsBuilder.addPoint( tlc->startmins );
+/*
+* CM_PadBatchLanes
+*
+* Makes the last tested group of lanes hold valid numbers
+*/
+static inline void CM_PadBatchLanes( CMBatchPacket *packet, int numSweeps ) {
+	for( int lane = numSweeps; lane % 4; ++lane ) {
+		CM_CopyBatchLane( packet, 0, packet, lane );
+	}
+}
 
-	VectorAdd( start, tlc->maxs, tlc->startmaxs );
-	boundsBuilder.addPoint( tlc->startmaxs );
+/*
+* CM_SetBatchLaneNearPart
+*
+* Sets the part of the sweep that is before the node like RecursiveHullCheck() does
+*/
+static inline void CM_SetBatchLaneNearPart( const CMBatchPacket *__restrict from, int fromLane, float frac,
+											CMBatchPacket *__restrict to, int toLane ) {
+	for( int i = 0; i < 3; ++i ) {
+		const float p1 = from->p1[i][fromLane];
+		to->p1[i][toLane] = p1;
+		to->p2[i][toLane] = p1 + frac * ( from->p2[i][fromLane] - p1 );
+	}
+	const float p1f = from->p1f[fromLane];
+	to->p1f[toLane] = p1f;
+	to->p2f[toLane] = p1f + ( from->p2f[fromLane] - p1f ) * frac;
+	to->traceNums[toLane] = from->traceNums[fromLane];
+}
 
-	VectorAdd( end, tlc->mins, tlc->endmins );
-	boundsBuilder.addPoint( tlc->endmins );
+/*
+* CM_SetBatchLaneFarPart
+*
+* Sets the part of the sweep that is past the node like RecursiveHullCheck() does
+*/
+static inline void CM_SetBatchLaneFarPart( const CMBatchPacket *__restrict from, int fromLane, float frac2,
+										   CMBatchPacket *__restrict to, int toLane ) {
+	for( int i = 0; i < 3; ++i ) {
+		const float p1 = from->p1[i][fromLane];
+		const float p2 = from->p2[i][fromLane];
+		to->p1[i][toLane] = p1 + frac2 * ( p2 - p1 );
+		to->p2[i][toLane] = p2;
+	}
+	const float p1f = from->p1f[fromLane];
+	const float p2f = from->p2f[fromLane];
+	to->p1f[toLane] = p1f + ( p2f - p1f ) * frac2;
+	to->p2f[toLane] = p2f;
+	to->traceNums[toLane] = from->traceNums[fromLane];
+}
 
-	VectorAdd( end, tlc->maxs, tlc->endmaxs );
-	boundsBuilder.addPoint( tlc->endmaxs );
+static_assert( sizeof( CMBatchPacket::p1f ) / sizeof( float ) == Ops::kMaxBatchSweeps );
+static_assert( Ops::kMaxBatchSweeps % 4 == 0, "Lanes are tested in groups of 4" );
 
-	boundsBuilder.storeTo( tlc->absmins, tlc->absmaxs );
-}
+void Ops::RecursiveBatchHullCheck( CMTraceContext *tlcs, int num, const CMBatchPacket *packet, int numSweeps ) {
+	assert( numSweeps > 0 && numSweeps <= kMaxBatchSweeps );
 
-void Ops::Trace( trace_t *tr, const vec3_t start, const vec3_t end, const vec3_t mins, const vec3_t maxs,
-							 const cmodel_t *cmodel, int brushmask, int topNodeHint ) {
-	assert( topNodeHint >= 0 );
+	// Fractions do not change while descending without visiting leaves,
+	// so testing lanes once is the same as testing these at every node like RecursiveHullCheck() does.
+	unsigned activeMask = 0;
+	for( int lane = 0; lane < numSweeps; ++lane ) {
+		const bool isActive = tlcs[packet->traceNums[lane]].trace->fraction > packet->p1f[lane];
+		activeMask |= (unsigned)isActive << lane;
+	}
+	if( !activeMask ) {
+		return; // already hit something nearer
+	}
 
-	// fill in a default trace
-	memset( tr, 0, sizeof( *tr ) );
-	tr->fraction = 1;
-	if( !cms->numnodes ) { // map not loaded
+	// Nothing is shared by a single sweep, the single sweep code path is cheaper and takes the same steps
+	if( !( activeMask & ( activeMask - 1 ) ) ) {
+		const int lane = _wsw_ctz( activeMask );
+		vec3_t p1, p2;
+		for( int i = 0; i < 3; ++i ) {
+			p1[i] = packet->p1[i][lane];
+			p2[i] = packet->p2[i][lane];
+		}
+		RecursiveHullCheck( &tlcs[packet->traceNums[lane]], num, packet->p1f[lane], packet->p2f[lane], p1, p2 );
 		return;
 	}
 
-	alignas( 16 ) CMTraceContext tlc;
-	SetupCollideContext( &tlc, tr, start, end, mins, maxs, brushmask );
-
-	//
-	// check for position test special case
-	//
-	if( VectorCompare( start, end ) ) {
-		auto func = &Ops::TestBoxInBrush;
-		if( cmodel != cms->map_cmodels ) {
-			if( BoundsIntersect( cmodel->mins, cmodel->maxs, tlc.absmins, tlc.absmaxs ) ) {
-				CollideBox( &tlc, func, cmodel->brushes, cmodel->numbrushes, cmodel->faces, cmodel->numfaces );
+	// All sweeps of a batch have the same size, so the box offset is the same for all lanes
+	const CMTraceContext *const sizeTlc = tlcs;
+	alignas( 16 ) float t1[kMaxBatchSweeps], t2[kMaxBatchSweeps];
+	const cnode_t *node;
+	unsigned frontMask, backMask;
+	float offset;
+	for(;; ) {
+		// if < 0, we are in a leaf node
+		if( num < 0 ) {
+			const cleaf_t *leaf = &cms->map_leafs[-1 - num];
+			for( unsigned mask = activeMask; mask; mask &= mask - 1 ) {
+				CMTraceContext *tlc = &tlcs[packet->traceNums[_wsw_ctz( mask )]];
+				if( leaf->contents & tlc->contents ) {
+					ClipBoxToLeaf( tlc, leaf->brushes, leaf->numbrushes, leaf->faces, leaf->numfaces );
+				}
 			}
+			return;
+		}
+
+		node = cms->map_nodes + num;
+		const cplane_t *plane = node->plane;
+		// The same expressions as ones of CM_NodeDistances() are computed for every lane
+		if( plane->type < 3 ) {
+			offset = sizeTlc->extents[plane->type];
+		} else if( sizeTlc->ispoint ) {
+			offset = 0;
 		} else {
-			vec3_t boxmins, boxmaxs;
-			for( int i = 0; i < 3; i++ ) {
-				boxmins[i] = start[i] + mins[i] - 1;
-				boxmaxs[i] = start[i] + maxs[i] + 1;
-			}
+			offset = fabsf( sizeTlc->extents[0] * plane->normal[0] ) +
+					 fabsf( sizeTlc->extents[1] * plane->normal[1] ) +
+					 fabsf( sizeTlc->extents[2] * plane->normal[2] );
+		}
 
-			int leafs[1024];
-			int topnode;
-			int numleafs = CM_BoxLeafnums( cms, boxmins, boxmaxs, leafs, 1024, &topnode, topNodeHint );
-			for( int i = 0; i < numleafs; i++ ) {
-				cleaf_t *leaf = &cms->map_leafs[leafs[i]];
-					if( leaf->contents & tlc.contents ) {
-						CollideBox( &tlc, func, leaf->brushes, leaf->numbrushes, leaf->faces, leaf->numfaces );
-						if( tr->allsolid ) {
-							break;
-						}
-					}
+		frontMask = 0, backMask = 0;
+#ifdef CM_USE_SSE
+		const __m128 xmmDist = _mm_set1_ps( plane->dist );
+		const __m128 xmmOffset = _mm_set1_ps( offset );
+		const __m128 xmmNegOffset = _mm_set1_ps( -offset );
+		for( int group = 0; group < numSweeps; group += 4 ) {
+			__m128 xmmT1, xmmT2;
+			if( plane->type < 3 ) {
+				xmmT1 = _mm_sub_ps( _mm_load_ps( &packet->p1[plane->type][group] ), xmmDist );
+				xmmT2 = _mm_sub_ps( _mm_load_ps( &packet->p2[plane->type][group] ), xmmDist );
+			} else {
+				const __m128 xmmNormalX = _mm_set1_ps( plane->normal[0] );
+				const __m128 xmmNormalY = _mm_set1_ps( plane->normal[1] );
+				const __m128 xmmNormalZ = _mm_set1_ps( plane->normal[2] );
+				xmmT1 = _mm_add_ps( _mm_mul_ps( xmmNormalX, _mm_load_ps( &packet->p1[0][group] ) ),
+									_mm_mul_ps( xmmNormalY, _mm_load_ps( &packet->p1[1][group] ) ) );
+				xmmT1 = _mm_add_ps( xmmT1, _mm_mul_ps( xmmNormalZ, _mm_load_ps( &packet->p1[2][group] ) ) );
+				xmmT1 = _mm_sub_ps( xmmT1, xmmDist );
+				xmmT2 = _mm_add_ps( _mm_mul_ps( xmmNormalX, _mm_load_ps( &packet->p2[0][group] ) ),
+									_mm_mul_ps( xmmNormalY, _mm_load_ps( &packet->p2[1][group] ) ) );
+				xmmT2 = _mm_add_ps( xmmT2, _mm_mul_ps( xmmNormalZ, _mm_load_ps( &packet->p2[2][group] ) ) );
+				xmmT2 = _mm_sub_ps( xmmT2, xmmDist );
 			}
+			_mm_store_ps( &t1[group], xmmT1 );
+			_mm_store_ps( &t2[group], xmmT2 );
+			const __m128 xmmFront = _mm_and_ps( _mm_cmpge_ps( xmmT1, xmmOffset ), _mm_cmpge_ps( xmmT2, xmmOffset ) );
+			const __m128 xmmBack = _mm_and_ps( _mm_cmplt_ps( xmmT1, xmmNegOffset ), _mm_cmplt_ps( xmmT2, xmmNegOffset ) );
+			frontMask |= (unsigned)_mm_movemask_ps( xmmFront ) << group;
+			backMask |= (unsigned)_mm_movemask_ps( xmmBack ) << group;
+		}
+#else
+		for( int lane = 0; lane < numSweeps; ++lane ) {
+			if( plane->type < 3 ) {
+				t1[lane] = packet->p1[plane->type][lane] - plane->dist;
+				t2[lane] = packet->p2[plane->type][lane] - plane->dist;
+			} else {
+				t1[lane] = plane->normal[0] * packet->p1[0][lane] + plane->normal[1] * packet->p1[1][lane] +
+						   plane->normal[2] * packet->p1[2][lane] - plane->dist;
+				t2[lane] = plane->normal[0] * packet->p2[0][lane] + plane->normal[1] * packet->p2[1][lane] +
+						   plane->normal[2] * packet->p2[2][lane] - plane->dist;
+			}
+			frontMask |= (unsigned)( t1[lane] >= offset && t2[lane] >= offset ) << lane;
+			backMask |= (unsigned)( t1[lane] < -offset && t2[lane] < -offset ) << lane;
+		}
+#endif
+		frontMask &= activeMask;
+		backMask &= activeMask;
+
+		// Keep descending without branching while all sweeps are on the same side
+		if( frontMask == activeMask ) {
+			num = node->children[0];
+		} else if( backMask == activeMask ) {
+			num = node->children[1];
+		} else {
+			break;
 		}
-
-		VectorCopy( start, tr->endpos );
-		return;
 	}
 
-	//
-	// check for point special case
-	//
-	if( VectorCompare( mins, vec3_origin ) && VectorCompare( maxs, vec3_origin ) ) {
-		tlc.ispoint = true;
-		VectorClear( tlc.extents );
-	} else {
-		tlc.ispoint = false;
-		VectorSet( tlc.extents,
-				   -mins[0] > maxs[0] ? -mins[0] : maxs[0],
-				   -mins[1] > maxs[1] ? -mins[1] : maxs[1],
-				   -mins[2] > maxs[2] ? -mins[2] : maxs[2] );
+	const unsigned crossingMask = activeMask & ~( frontMask | backMask );
+	unsigned nearBackMask = 0;
+	float fracs[kMaxBatchSweeps], fracs2[kMaxBatchSweeps];
+	for( unsigned mask = crossingMask; mask; mask &= mask - 1 ) {
+		const int lane = _wsw_ctz( mask );
+		const int side = CM_SplitSweep( t1[lane], t2[lane], offset, &fracs[lane], &fracs2[lane] );
+		nearBackMask |= (unsigned)side << lane;
 	}
-
-	// TODO: Why do we have to prepare all these vars for all cases, otherwise platforms/movers are malfunctioning?
-	SetupClipContext( &tlc );
-
-	VectorSubtract( end, start, tlc.traceDir );
-	VectorNormalize( tlc.traceDir );
-	float squareDiameter = DistanceSquared( mins, maxs );
-	if( squareDiameter >= 2.0f ) {
-		tlc.boxRadius = 0.5f * sqrtf( squareDiameter ) + 8.0f;
-	} else {
-		tlc.boxRadius = 8.0f;
+	const unsigned nearFrontMask = crossingMask & ~nearBackMask;
+
+	// Every sweep must visit children in the same order as in RecursiveHullCheck(),
+	// while sweeps of different traces do not depend on each other.
+	// The first pass visits the front child by sweeps that are in front and near parts of ones that cross with the front near side.
+	// The second pass visits the back child by sweeps that are behind, near parts of ones that cross with the back near side
+	// and far parts of ones that cross with the front near side.
+	// The third pass visits the front child by far parts of sweeps that cross with the back near side.
+	CMBatchPacket children;
+	int numChildren = 0;
+	for( unsigned mask = frontMask; mask; mask &= mask - 1 ) {
+		CM_CopyBatchLane( packet, _wsw_ctz( mask ), &children, numChildren++ );
+	}
+	for( unsigned mask = nearFrontMask; mask; mask &= mask - 1 ) {
+		const int lane = _wsw_ctz( mask );
+		CM_SetBatchLaneNearPart( packet, lane, fracs[lane], &children, numChildren++ );
+	}
+	if( numChildren ) {
+		CM_PadBatchLanes( &children, numChildren );
+		RecursiveBatchHullCheck( tlcs, node->children[0], &children, numChildren );
 	}
 
-	//
-	// general sweeping through world
-	//
-	if( cmodel == cms->map_cmodels ) {
-		RecursiveHullCheck( &tlc, topNodeHint, 0, 1, start, end );
-	} else if( BoundsIntersect( cmodel->mins, cmodel->maxs, tlc.absmins, tlc.absmaxs ) ) {
-		auto func = &Ops::ClipBoxToBrush;
-		CollideBox( &tlc, func, cmodel->brushes, cmodel->numbrushes, cmodel->faces, cmodel->numfaces );
+	numChildren = 0;
+	for( unsigned mask = backMask; mask; mask &= mask - 1 ) {
+		CM_CopyBatchLane( packet, _wsw_ctz( mask ), &children, numChildren++ );
+	}
+	for( unsigned mask = nearBackMask; mask; mask &= mask - 1 ) {
+		const int lane = _wsw_ctz( mask );
+		CM_SetBatchLaneNearPart( packet, lane, fracs[lane], &children, numChildren++ );
+	}
+	for( unsigned mask = nearFrontMask; mask; mask &= mask - 1 ) {
+		const int lane = _wsw_ctz( mask );
+		CM_SetBatchLaneFarPart( packet, lane, fracs2[lane], &children, numChildren++ );
+	}
+	if( numChildren ) {
+		CM_PadBatchLanes( &children, numChildren );
+		RecursiveBatchHullCheck( tlcs, node->children[1], &children, numChildren );
 	}
 
-	if( tr->fraction == 1 ) {
-		VectorCopy( end, tr->endpos );
-	} else {
-		VectorLerp( start, tr->fraction, end, tr->endpos );
+	numChildren = 0;
+	for( unsigned mask = nearBackMask; mask; mask &= mask - 1 ) {
+		const int lane = _wsw_ctz( mask );
+		CM_SetBatchLaneFarPart( packet, lane, fracs2[lane], &children, numChildren++ );
+	}
+	if( numChildren ) {
+		CM_PadBatchLanes( &children, numChildren );
+		RecursiveBatchHullCheck( tlcs, node->children[0], &children, numChildren );
 	}
 }
 
-#ifdef CM_SELF_TEST
 static void CompareTraceResults( const trace_t *tr, const char **tags, int count, bool interrupt = false ) {
 	if( count < 2 ) {
 		return;
@@ -833,7 +1031,304 @@ static void CompareTraceResults( const trace_t *tr, const char **tags, int count
 		}
 	}
 }
-#endif
+
+void Ops::ClipBoxToBvh( CMTraceContext *tlc ) {
+	const cbvhnode_t *const nodes = cms->map_bvhnodes;
+	const cbvhprim_t *const prims = cms->map_bvhprims;
+
+	// Save the exact address to avoid pointer chasing in loops
+	const float *fraction = &tlc->trace->fraction;
+
+	CMBvhRay ray;
+	setupBvhRay( tlc, &ray );
+
+	CMBvhStackEntry stack[kMaxBvhStackEntries];
+	stack[0] = { 0, 0, 0.0f };
+	int stackSize = 1;
+	do {
+		const CMBvhStackEntry entry = stack[--stackSize];
+		if( entry.tnear > *fraction ) {
+			continue; // already hit something nearer
+		}
+
+		if( entry.numPrims ) {
+			for( int i = entry.num; i < entry.num + entry.numPrims; i++ ) {
+				if( !( prims[i].contents & tlc->contents ) ) {
+					continue;
+				}
+				const cbrush_t *__restrict b = prims[i].brush;
+				if( !doBoundsAndLineDistTest( b->mins, b->maxs, b->center, b->radius, tlc ) ) {
+					continue;
+				}
+				ClipBoxToBrush( tlc, b );
+				if( !*fraction ) {
+					return;
+				}
+			}
+			continue;
+		}
+
+		const cbvhnode_t *__restrict node = nodes + entry.num;
+		float tnear[4];
+		unsigned hitMask = 0;
+		for( int i = 0; i < 4; i++ ) {
+			if( !( node->contents[i] & tlc->contents ) ) {
+				continue;
+			}
+			float tmin = 0.0f, tmax = *fraction;
+			for( int j = 0; j < 3; j++ ) {
+				const float t0 = ( node->mins[j][i] - ray.minsShift[j] ) * ray.invDir[j];
+				const float t1 = ( node->maxs[j][i] - ray.maxsShift[j] ) * ray.invDir[j];
+				tmin = wsw::max( tmin, wsw::min( t0, t1 ) );
+				tmax = wsw::min( tmax, wsw::max( t0, t1 ) );
+			}
+			if( tmin <= tmax ) {
+				tnear[i] = tmin;
+				hitMask |= 1u << i;
+			}
+		}
+
+		stackSize = pushBvhChildren( stack, stackSize, node, tnear, hitMask );
+	} while( stackSize );
+}
+
+void Ops::ClipBoxToBvhAndCompare( CMTraceContext *tlc, int topNodeHint ) {
+	trace_t traces[2];
+	traces[1] = *tlc->trace;
+
+	alignas( 16 ) CMTraceContext bvhTlc = *tlc;
+	bvhTlc.trace = &traces[1];
+
+	RecursiveHullCheck( tlc, topNodeHint, 0, 1, tlc->start, tlc->end );
+	ClipBoxToBvh( &bvhTlc );
+	traces[0] = *tlc->trace;
+
+	for( trace_t &tr: traces ) {
+		if( tr.fraction == 1 ) {
+			VectorCopy( tlc->end, tr.endpos );
+		} else {
+			VectorLerp( tlc->start, tr.fraction, tlc->end, tr.endpos );
+		}
+	}
+
+	const char *tags[2] { "bsp", "bvh" };
+	CompareTraceResults( traces, tags, 2 );
+}
+
+void Ops::SetupCollideContext( CMTraceContext *__restrict tlc, trace_t *__restrict tr, const float *start,
+							   const float *end, const float *mins, const float *maxs, int brushmask ) {
+	tlc->trace = tr;
+	tlc->contents = brushmask;
+	VectorCopy( start, tlc->start );
+	VectorCopy( end, tlc->end );
+	VectorCopy( mins, tlc->mins );
+	VectorCopy( maxs, tlc->maxs );
+
+	// TODO: Supply 4-component vectors as arguments of this method so we can use explicit SIMD overloads
+	BoundsBuilder boundsBuilder;
+
+	VectorAdd( start, tlc->mins, tlc->startmins );
+	boundsBuilder.addPoint( tlc->startmins );
+
+	VectorAdd( start, tlc->maxs, tlc->startmaxs );
+	boundsBuilder.addPoint( tlc->startmaxs );
+
+	VectorAdd( end, tlc->mins, tlc->endmins );
+	boundsBuilder.addPoint( tlc->endmins );
+
+	VectorAdd( end, tlc->maxs, tlc->endmaxs );
+	boundsBuilder.addPoint( tlc->endmaxs );
+
+	boundsBuilder.storeTo( tlc->absmins, tlc->absmaxs );
+}
+
+void Ops::SetupSweepContext( CMTraceContext *tlc, const vec3_t start, const vec3_t end,
+							 const vec3_t mins, const vec3_t maxs ) {
+	//
+	// check for point special case
+	//
+	if( VectorCompare( mins, vec3_origin ) && VectorCompare( maxs, vec3_origin ) ) {
+		tlc->ispoint = true;
+		VectorClear( tlc->extents );
+	} else {
+		tlc->ispoint = false;
+		VectorSet( tlc->extents,
+				   -mins[0] > maxs[0] ? -mins[0] : maxs[0],
+				   -mins[1] > maxs[1] ? -mins[1] : maxs[1],
+				   -mins[2] > maxs[2] ? -mins[2] : maxs[2] );
+	}
+
+	// TODO: Why do we have to prepare all these vars for all cases, otherwise platforms/movers are malfunctioning?
+	SetupClipContext( tlc );
+
+	VectorSubtract( end, start, tlc->traceDir );
+	VectorNormalize( tlc->traceDir );
+	float squareDiameter = DistanceSquared( mins, maxs );
+	if( squareDiameter >= 2.0f ) {
+		tlc->boxRadius = 0.5f * sqrtf( squareDiameter ) + 8.0f;
+	} else {
+		tlc->boxRadius = 8.0f;
+	}
+}
+
+void Ops::Trace( trace_t *tr, const vec3_t start, const vec3_t end, const vec3_t mins, const vec3_t maxs,
+							 const cmodel_t *cmodel, int brushmask, int topNodeHint ) {
+	assert( topNodeHint >= 0 );
+
+	// fill in a default trace
+	memset( tr, 0, sizeof( *tr ) );
+	tr->fraction = 1;
+	if( !cms->numnodes ) { // map not loaded
+		return;
+	}
+
+	alignas( 16 ) CMTraceContext tlc;
+	SetupCollideContext( &tlc, tr, start, end, mins, maxs, brushmask );
+
+	//
+	// check for position test special case
+	//
+	if( VectorCompare( start, end ) ) {
+		auto func = &Ops::TestBoxInBrush;
+		if( cmodel != cms->map_cmodels ) {
+			if( BoundsIntersect( cmodel->mins, cmodel->maxs, tlc.absmins, tlc.absmaxs ) ) {
+				CollideBox( &tlc, func, cmodel->brushes, cmodel->numbrushes, cmodel->faces, cmodel->numfaces );
+			}
+		} else {
+			vec3_t boxmins, boxmaxs;
+			for( int i = 0; i < 3; i++ ) {
+				boxmins[i] = start[i] + mins[i] - 1;
+				boxmaxs[i] = start[i] + maxs[i] + 1;
+			}
+
+			int leafs[1024];
+			int topnode;
+			int numleafs = CM_BoxLeafnums( cms, boxmins, boxmaxs, leafs, 1024, &topnode, topNodeHint );
+			for( int i = 0; i < numleafs; i++ ) {
+				cleaf_t *leaf = &cms->map_leafs[leafs[i]];
+					if( leaf->contents & tlc.contents ) {
+						CollideBox( &tlc, func, leaf->brushes, leaf->numbrushes, leaf->faces, leaf->numfaces );
+						if( tr->allsolid ) {
+							break;
+						}
+					}
+			}
+		}
+
+		VectorCopy( start, tr->endpos );
+		return;
+	}
+
+	SetupSweepContext( &tlc, start, end, mins, maxs );
+
+	//
+	// general sweeping through world
+	//
+	if( cmodel == cms->map_cmodels ) {
+		const int bvhMode = ( cm_bvh && cms->numbvhnodes ) ? cm_bvh->integer : 0;
+		if( !bvhMode ) {
+			RecursiveHullCheck( &tlc, topNodeHint, 0, 1, start, end );
+		} else if( bvhMode == 1 ) {
+			ClipBoxToBvh( &tlc );
+		} else {
+			ClipBoxToBvhAndCompare( &tlc, topNodeHint );
+		}
+	} else if( BoundsIntersect( cmodel->mins, cmodel->maxs, tlc.absmins, tlc.absmaxs ) ) {
+		auto func = &Ops::ClipBoxToBrush;
+		CollideBox( &tlc, func, cmodel->brushes, cmodel->numbrushes, cmodel->faces, cmodel->numfaces );
+	}
+
+	if( tr->fraction == 1 ) {
+		VectorCopy( end, tr->endpos );
+	} else {
+		VectorLerp( start, tr->fraction, end, tr->endpos );
+	}
+}
+
+void Ops::TraceBatch( trace_t *traces, const vec3_t *starts, const vec3_t *ends, int numTraces,
+					  const vec3_t mins, const vec3_t maxs, int brushmask, int topNodeHint ) {
+	assert( topNodeHint >= 0 );
+
+	// Packets are only descended through BSP nodes, let other paths trace rays separately
+	const int bvhMode = ( cm_bvh && cms->numbvhnodes ) ? cm_bvh->integer : 0;
+	if( !cms->numnodes || bvhMode ) {
+		for( int i = 0; i < numTraces; ++i ) {
+			Trace( &traces[i], starts[i], ends[i], mins, maxs, cms->map_cmodels, brushmask, topNodeHint );
+		}
+		return;
+	}
+
+	alignas( 16 ) CMTraceContext tlcs[kMaxBatchSweeps];
+	CMBatchPacket packet;
+	int numSweeps = 0;
+	auto traceSweeps = [&]() {
+		CM_PadBatchLanes( &packet, numSweeps );
+		RecursiveBatchHullCheck( tlcs, topNodeHint, &packet, numSweeps );
+		for( int i = 0; i < numSweeps; ++i ) {
+			trace_t *const tr = tlcs[i].trace;
+			if( tr->fraction == 1 ) {
+				VectorCopy( tlcs[i].end, tr->endpos );
+			} else {
+				VectorLerp( tlcs[i].start, tr->fraction, tlcs[i].end, tr->endpos );
+			}
+		}
+		numSweeps = 0;
+	};
+
+	// Sweeps that go to the same octant are way more coherent, so packets are filled in the order of octants.
+	// Traces are independent, so the order does not affect results.
+	constexpr int kMaxOrderedTraces = 64;
+	int order[kMaxOrderedTraces];
+	for( int chunkStart = 0; chunkStart < numTraces; chunkStart += kMaxOrderedTraces ) {
+		const int chunkSize = std::min( kMaxOrderedTraces, numTraces - chunkStart );
+		int octantOffsets[9] = { 0 };
+		uint8_t octants[kMaxOrderedTraces];
+		for( int i = 0; i < chunkSize; ++i ) {
+			const float *start = starts[chunkStart + i], *end = ends[chunkStart + i];
+			octants[i] = ( end[0] < start[0] ) | ( ( end[1] < start[1] ) << 1 ) | ( ( end[2] < start[2] ) << 2 );
+			octantOffsets[octants[i] + 1]++;
+		}
+		for( int i = 1; i < 9; ++i ) {
+			octantOffsets[i] += octantOffsets[i - 1];
+		}
+		for( int i = 0; i < chunkSize; ++i ) {
+			order[octantOffsets[octants[i]]++] = chunkStart + i;
+		}
+
+		for( int k = 0; k < chunkSize; ++k ) {
+			const int i = order[k];
+			trace_t *const tr = &traces[i];
+			// Position tests do not descend the tree
+			if( VectorCompare( starts[i], ends[i] ) ) {
+				Trace( tr, starts[i], ends[i], mins, maxs, cms->map_cmodels, brushmask, topNodeHint );
+				continue;
+			}
+
+			memset( tr, 0, sizeof( *tr ) );
+			tr->fraction = 1;
+
+			CMTraceContext *const tlc = &tlcs[numSweeps];
+			SetupCollideContext( tlc, tr, starts[i], ends[i], mins, maxs, brushmask );
+			SetupSweepContext( tlc, starts[i], ends[i], mins, maxs );
+
+			for( int j = 0; j < 3; ++j ) {
+				packet.p1[j][numSweeps] = starts[i][j];
+				packet.p2[j][numSweeps] = ends[i][j];
+			}
+			packet.p1f[numSweeps] = 0;
+			packet.p2f[numSweeps] = 1;
+			packet.traceNums[numSweeps] = numSweeps;
+
+			if( ++numSweeps == kMaxBatchSweeps ) {
+				traceSweeps();
+			}
+		}
+	}
+
+	if( numSweeps ) {
+		traceSweeps();
+	}
+}
 
 /*
 * CM_TransformedBoxTrace
@@ -871,8 +1366,8 @@ void CM_TransformedBoxTrace( const cmodel_state_t *cms, trace_t *tr,
 		}
 	}
 
-	// cylinder offset
-	if( cmodel == cms->oct_cmodel ) {
+	// cylinder offset (it's zero for box hulls, octagon hulls may live in caller-owned storage)
+	if( cmodel->builtin ) {
 		VectorSubtract( start, cmodel->cyl_offset, start_l );
 		VectorSubtract( end, cmodel->cyl_offset, end_l );
 	} else {
@@ -939,6 +1434,16 @@ void CM_TransformedBoxTrace( const cmodel_state_t *cms, trace_t *tr,
 	}
 }
 
+/*
+* CM_TraceBatch
+*/
+void CM_TraceBatch( const cmodel_state_t *cms, trace_t *traces,
+					const vec3_t *starts, const vec3_t *ends, int numTraces,
+					const vec3_t mins, const vec3_t maxs, int brushmask,
+					int topNodeHint ) {
+	cms->ops->TraceBatch( traces, starts, ends, numTraces, mins, maxs, brushmask, topNodeHint );
+}
+
 void Ops::BuildShapeList( CMShapeList *list, const float *mins, const float *maxs, int clipMask ) {
 	int leafNums[1024], topNode;
 	// TODO: This can be optimized
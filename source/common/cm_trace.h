@@ -35,6 +35,16 @@ struct CMTraceContext {
 	bool ispoint;      // optimized case
 };
 
+// Up to 8 sweeps of a batch of traces that are checked against a subtree of BSP nodes.
+// Sweeps are stored in lanes, so node planes get tested for 4 sweeps at once.
+struct alignas( 16 ) CMBatchPacket {
+	float p1[3][8];
+	float p2[3][8];
+	float p1f[8];
+	float p2f[8];
+	int traceNums[8];
+};
+
 struct CMShapeList;
 
 // TODO: We don't need Ops, just set method pointers in the cms instance
@@ -64,9 +74,28 @@ struct Ops {
 
 	void RecursiveHullCheck( CMTraceContext *tlc, int num, float p1f, float p2f, const vec3_t p1, const vec3_t p2 );
 
+	// Sweeps of a batch are traversed together, so coherent sweeps share the BSP descent
+	static constexpr int kMaxBatchSweeps = 8;
+
+	// Does exactly the same per-sweep steps as RecursiveHullCheck() but for all sweeps of the packet at once
+	void RecursiveBatchHullCheck( CMTraceContext *tlcs, int num, const CMBatchPacket *packet, int numSweeps );
+
+	// Clips the box against world brushes and facets using the bounding volume hierarchy instead of BSP nodes
+	virtual void ClipBoxToBvh( CMTraceContext *tlc );
+	// Uses results of the BSP traversal but reports mismatches of BVH ones
+	void ClipBoxToBvhAndCompare( CMTraceContext *tlc, int topNodeHint );
+
+	// Prepares the context for sweeping (start != end) assuming the collide context has been set up
+	void SetupSweepContext( CMTraceContext *tlc, const vec3_t start, const vec3_t end,
+							const vec3_t mins, const vec3_t maxs );
+
 	void Trace( trace_t *tr, const vec3_t start, const vec3_t end, const vec3_t mins,
 				const vec3_t maxs, const cmodel_s *cmodel, int brushmask, int topNodeHint );
 
+	// Traces boxes of the same size through the world model, results match ones of separate Trace() calls
+	void TraceBatch( trace_t *traces, const vec3_t *starts, const vec3_t *ends, int numTraces,
+					 const vec3_t mins, const vec3_t maxs, int brushmask, int topNodeHint );
+
 	virtual void BuildShapeList( CMShapeList *list, const float *mins, const float *maxs, int clipMask );
 	virtual void ClipShapeList( CMShapeList *list, const CMShapeList *baseList, const float *mins, const float *maxs );
 
@@ -87,6 +116,8 @@ struct Sse42Ops: public Ops {
 	void ClipBoxToLeaf( CMTraceContext *tlc, const cbrush_s *brushes, int numbrushes,
 						const cface_s *markfaces, int nummarkfaces ) override;
 
+	void ClipBoxToBvh( CMTraceContext *tlc ) override;
+
 	// Overrides a base member by hiding it
 	void ClipBoxToBrush( CMTraceContext *tlc, const cbrush_s *brush );
 
@@ -136,6 +167,55 @@ inline bool doBoundsAndLineDistTest( const float *__restrict shapeMins,
 	return VectorLengthSquared( perp ) <= distanceThreshold * distanceThreshold;
 }
 
+// Testing a ray of the swept box center against BVH bounds that are extended by the box size
+// is the same as testing the swept box against the original bounds.
+// The ray is parametrized the same way as trace fractions are.
+struct CMBvhRay {
+	vec3_t minsShift;     // the ray origin shifted to be tested against children mins
+	vec3_t maxsShift;     // the ray origin shifted to be tested against children maxs
+	vec3_t invDir;
+};
+
+struct CMBvhStackEntry {
+	int num;
+	int numPrims;         // 0 for nodes
+	float tnear;
+};
+
+// Every pop pushes at most 4 entries, and the hierarchy depth is limited by 32
+static constexpr int kMaxBvhStackEntries = 3 * 33 + 1;
+
+inline void setupBvhRay( const CMTraceContext *__restrict tlc, CMBvhRay *__restrict ray ) {
+	for( int i = 0; i < 3; ++i ) {
+		const float center = tlc->start[i] + 0.5f * ( tlc->mins[i] + tlc->maxs[i] );
+		const float halfSize = 0.5f * ( tlc->maxs[i] - tlc->mins[i] ) + DIST_EPSILON;
+		ray->minsShift[i] = center + halfSize;
+		ray->maxsShift[i] = center - halfSize;
+		const float dir = tlc->end[i] - tlc->start[i];
+		// Avoid infinities as zero products yield NaN's
+		ray->invDir[i] = std::fabs( dir ) > 1e-20f ? 1.0f / dir : 1e30f;
+	}
+}
+
+// Pushes hit children so the nearest one is going to be popped first
+inline int pushBvhChildren( CMBvhStackEntry *__restrict stack, int stackSize,
+							const cbvhnode_t *__restrict node, const float *__restrict tnear, unsigned hitMask ) {
+	assert( stackSize + 4 <= kMaxBvhStackEntries );
+	CMBvhStackEntry *const first = stack + stackSize;
+	CMBvhStackEntry *last = first;
+	for( int i = 0; i < 4; ++i ) {
+		if( hitMask & ( 1u << i ) ) {
+			CMBvhStackEntry *slot = last++;
+			// Keep entries sorted by descending distance
+			for(; slot != first && ( slot - 1 )->tnear < tnear[i]; --slot ) {
+				*slot = *( slot - 1 );
+			}
+			*slot = { node->children[i], node->numprims[i], tnear[i] };
+		}
+	}
+	return stackSize + (int)( last - first );
+}
+
 #ifdef CM_USE_SSE
 
 inline bool boundsIntersectSse42( __m128 traceAbsmins, __m128 traceAbsmaxs, __m128 shapeMins, __m128 shapeMaxs ) {
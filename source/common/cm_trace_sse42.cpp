@@ -59,6 +59,86 @@ void Sse42Ops::ClipBoxToLeaf( CMTraceContext *tlc, const cbrush_t *brushes, int
 	}
 }
 
+void Sse42Ops::ClipBoxToBvh( CMTraceContext *tlc ) {
+	[[maybe_unused]] volatile VexScopedFence fence;
+
+	const cbvhnode_t *const nodes = cms->map_bvhnodes;
+	const cbvhprim_t *const prims = cms->map_bvhprims;
+
+	// Save the exact address to avoid pointer chasing in loops
+	const float *fraction = &tlc->trace->fraction;
+
+	CMBvhRay ray;
+	setupBvhRay( tlc, &ray );
+
+	const __m128 xmmMinsShiftX = _mm_set1_ps( ray.minsShift[0] );
+	const __m128 xmmMinsShiftY = _mm_set1_ps( ray.minsShift[1] );
+	const __m128 xmmMinsShiftZ = _mm_set1_ps( ray.minsShift[2] );
+	const __m128 xmmMaxsShiftX = _mm_set1_ps( ray.maxsShift[0] );
+	const __m128 xmmMaxsShiftY = _mm_set1_ps( ray.maxsShift[1] );
+	const __m128 xmmMaxsShiftZ = _mm_set1_ps( ray.maxsShift[2] );
+	const __m128 xmmInvDirX = _mm_set1_ps( ray.invDir[0] );
+	const __m128 xmmInvDirY = _mm_set1_ps( ray.invDir[1] );
+	const __m128 xmmInvDirZ = _mm_set1_ps( ray.invDir[2] );
+	const __m128i xmmContents = _mm_set1_epi32( tlc->contents );
+
+	CMBvhStackEntry stack[kMaxBvhStackEntries];
+	stack[0] = { 0, 0, 0.0f };
+	int stackSize = 1;
+	do {
+		const CMBvhStackEntry entry = stack[--stackSize];
+		if( entry.tnear > *fraction ) {
+			continue; // already hit something nearer
+		}
+
+		if( entry.numPrims ) {
+			for( int i = entry.num; i < entry.num + entry.numPrims; i++ ) {
+				if( !( prims[i].contents & tlc->contents ) ) {
+					continue;
+				}
+				const cbrush_t *__restrict b = prims[i].brush;
+				if( !doBoundsAndLineDistTestSse42( b->mins, b->maxs, b->center, b->radius, tlc ) ) {
+					continue;
+				}
+				// Specify the "overridden" method explicitly
+				Sse42Ops::ClipBoxToBrush( tlc, b );
+				if( !*fraction ) {
+					return;
+				}
+			}
+			continue;
+		}
+
+		// Test all 4 children at once
+		const cbvhnode_t *__restrict node = nodes + entry.num;
+		__m128 t0 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( node->mins[0] ), xmmMinsShiftX ), xmmInvDirX );
+		__m128 t1 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( node->maxs[0] ), xmmMaxsShiftX ), xmmInvDirX );
+		__m128 tmin = _mm_max_ps( _mm_setzero_ps(), _mm_min_ps( t0, t1 ) );
+		__m128 tmax = _mm_min_ps( _mm_set1_ps( *fraction ), _mm_max_ps( t0, t1 ) );
+
+		t0 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( node->mins[1] ), xmmMinsShiftY ), xmmInvDirY );
+		t1 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( node->maxs[1] ), xmmMaxsShiftY ), xmmInvDirY );
+		tmin = _mm_max_ps( tmin, _mm_min_ps( t0, t1 ) );
+		tmax = _mm_min_ps( tmax, _mm_max_ps( t0, t1 ) );
+
+		t0 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( node->mins[2] ), xmmMinsShiftZ ), xmmInvDirZ );
+		t1 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( node->maxs[2] ), xmmMaxsShiftZ ), xmmInvDirZ );
+		tmin = _mm_max_ps( tmin, _mm_min_ps( t0, t1 ) );
+		tmax = _mm_min_ps( tmax, _mm_max_ps( t0, t1 ) );
+
+		const __m128i xmmNodeContents = _mm_and_si128( _mm_loadu_si128( (const __m128i *)node->contents ), xmmContents );
+		const int emptyMask = _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpeq_epi32( xmmNodeContents, _mm_setzero_si128() ) ) );
+		const int hitMask = _mm_movemask_ps( _mm_cmple_ps( tmin, tmax ) ) & ~emptyMask;
+		if( !hitMask ) {
+			continue;
+		}
+
+		alignas( 16 ) float tnear[4];
+		_mm_store_ps( tnear, tmin );
+		stackSize = pushBvhChildren( stack, stackSize, node, tnear, (unsigned)hitMask );
+	} while( stackSize );
+}
+
 #ifndef _MSC_VER
 __attribute__ ( (noinline) ) int BuildSimdBrushsideData( const cbrushside_t *sides, int numSides, uint8_t *buffer );
 #else
@@ -39,6 +39,20 @@ int CM_ShaderrefForName( const cmodel_state_t *cms, const char *name );
 struct cmodel_s *CM_ModelForBBox( cmodel_state_t *cms, const vec3_t mins, const vec3_t maxs );
 struct cmodel_s *CM_OctagonModelForBBox( cmodel_state_t *cms, const vec3_t mins, const vec3_t maxs );
 
+/**
+ * A caller-owned storage of a clipping hull for an arbitrary bounding box.
+ * Overloads of {@code CM_ModelForBBox()}/{@code CM_OctagonModelForBBox()} which accept it
+ * do not modify the shared hull of the collision model instance,
+ * so these overloads (and traces against returned models) are safe to call from worker threads.
+ * A returned model is valid as long as the storage is not reused.
+ */
+struct CMHullModelStorage {
+	alignas( 16 ) uint8_t data[512];
+};
+
+struct cmodel_s *CM_ModelForBBox( const cmodel_state_t *cms, const vec3_t mins, const vec3_t maxs, CMHullModelStorage *storage );
+struct cmodel_s *CM_OctagonModelForBBox( const cmodel_state_t *cms, const vec3_t mins, const vec3_t maxs, CMHullModelStorage *storage );
+
 void CM_InlineModelBounds( const cmodel_state_t *cms, const struct cmodel_s *cmodel, vec3_t mins, vec3_t maxs );
 
 /**
@@ -84,6 +98,18 @@ void CM_TransformedBoxTrace( const cmodel_state_t *cms, trace_t *tr,
 							 const vec3_t origin, const vec3_t angles,
 							 int topNodeHint = 0 );
 
+/**
+ * Traces boxes of the same size and contents mask through the world model.
+ * Traces are descended through BSP nodes in packets, so a node is tested once for all traces
+ * that are on the same side of it, and coherent rays (e.g. ones that are emitted from the same point)
+ * are cheaper to trace in a batch. Results are the same as ones of separate
+ * {@code CM_TransformedBoxTrace()} calls for the world model.
+ */
+void CM_TraceBatch( const cmodel_state_t *cms, trace_t *traces,
+					const vec3_t *starts, const vec3_t *ends, int numTraces,
+					const vec3_t mins, const vec3_t maxs, int brushmask,
+					int topNodeHint = 0 );
+
 int CM_ClusterRowSize( const cmodel_state_t *cms );
 int CM_AreaRowSize( const cmodel_state_t *cms );
 int CM_PointLeafnum( const cmodel_state_t *cms, const vec3_t p, int topNodeHint = 0 );
@@ -108,9 +134,12 @@ bool CM_HeadnodeVisible( const cmodel_state_t *cms, int headnode, const uint8_t
 void CM_WritePortalState( cmodel_state_t *cms, int file );
 void CM_ReadPortalState( cmodel_state_t *cms, int file );
 
-void CM_MergePVS( cmodel_state_t *cms, const vec3_t org, uint8_t *out );
+void CM_MergePVS( const cmodel_state_t *cms, const vec3_t org, uint8_t *out );
+// Writes distinct clusters which PVS rows get merged by CM_MergePVS(), returns their number
+int CM_FatPVSClusters( const cmodel_state_t *cms, const vec3_t org, int *clusters, int maxClusters );
+const uint8_t *CM_ClusterPVS( const cmodel_state_t *cms, int cluster );
 void CM_MergePHS( cmodel_state_t *cms, int cluster, uint8_t *out );
-int CM_MergeVisSets( cmodel_state_t *cms, const vec3_t org, uint8_t *pvs, uint8_t *areabits );
+int CM_MergeVisSets( const cmodel_state_t *cms, const vec3_t org, uint8_t *pvs, uint8_t *areabits );
 
 bool CM_InPVS( const cmodel_state_t *cms, const vec3_t p1, const vec3_t p2 );
 
@@ -122,6 +151,34 @@ const vec3_t *CM_GetLeafBounds( const cmodel_state_t *cms, int leafNum );
 //
 cmodel_state_t *CM_New();
 
+/**
+ * Overrides the collision code path that has been chosen by {@code CM_New()}.
+ * Accepted names are "generic", "sse42" and "avx".
+ * Fails if the name is unknown or the CPU does not support the code path.
+ * Shape lists that have been built using another code path must not be reused.
+ */
+bool CM_SelectOps( cmodel_state_t *cms, const char *name );
+
+#define CM_TRACE_CAPTURE_MAGIC      "WCMT"
+#define CM_TRACE_CAPTURE_VERSION    1
+
+/**
+ * A header of a file of captured game traces.
+ * It is followed by an array of {@code CMTraceCaptureRecord} till the end of the file.
+ */
+struct CMTraceCaptureHeader {
+	char magic[4];
+	int32_t version;
+	char mapName[MAX_QPATH];
+};
+
+struct CMTraceCaptureRecord {
+	float start[3], end[3];
+	float mins[3], maxs[3];
+	int32_t contentMask;
+	int32_t passEntNum;
+};
+
 void CM_AddReference( cmodel_state_t *cms );
 void CM_ReleaseReference( cmodel_state_t *cms );
 
@@ -122,6 +122,9 @@ void MSG_ReadDeltaScoreboardData( msg_t *msg, const ReplicatedScoreboardData *fr
 void MSG_ReadDir( msg_t *sb, vec3_t vector );
 void MSG_ReadData( msg_t *sb, void *buffer, size_t length );
 void MSG_ReadDeltaStruct( msg_t *msg, const void *from, void *to, size_t size, const msg_field_t *fields, size_t numFields );
+#ifndef PUBLIC_BUILD
+bool MSG_CheckDeltaCodecs( unsigned numIterations );
+#endif
 int MSG_BytesLeft( const msg_t *msg );
 //============================================================================
 
@@ -241,9 +244,12 @@ enum svc_ops_e {
 	svc_servercs,           //tmp jalfixme : send reliable commands as unreliable
 	svc_frame,
 	svc_demoinfo,
-	svc_extension           // for future expansion
+	svc_extension,          // for future expansion
+	svc_gamestate           // [int] start [int] next [int] uncompressed size [int] compressed size (zero if stored) [...] configstrings and baselines
 };
 
+#define SV_GAMESTATE_NUM_ITEMS      ( MAX_CONFIGSTRINGS + MAX_EDICTS )  // configstrings, then baselines
+
 //==============================================
 
 //
@@ -265,6 +271,7 @@ enum clc_ops_e {
 #define SV_BITFLAGS_RELIABLE        ( 1 << 1 )
 #define SV_BITFLAGS_HTTP            ( 1 << 3 )
 #define SV_BITFLAGS_HTTP_BASEURL    ( 1 << 4 )
+#define SV_BITFLAGS_GAMESTATE       ( 1 << 5 )  // the gamestate may be requested in chunks
 
 // framesnap flags
 #define FRAMESNAP_FLAG_DELTA        ( 1 << 0 )
@@ -645,7 +652,7 @@ void SV_Init( void );
 void SV_Shutdown( const char *finalmsg );
 void SV_ShutdownGame( const char *finalmsg, bool reconnect );
 void SV_Frame( unsigned realMsec, unsigned gameMsec );
-bool SV_SendMessageToClient( struct client_s *client, msg_t *msg );
+bool SV_SendMessageToClient( struct client_s *client, msg_t *msg, bool compress );
 void SV_ParseClientMessage( struct client_s *client, msg_t *msg );
 
 /*
@@ -58,6 +58,7 @@ void ConfigStringStorage::assignEntryData( Entry *entry, char *data, size_t capa
 }
 
 void ConfigStringStorage::clear() {
+	m_modificationCount++;
 	freeEntries();
 	makeFreeListLinks();
 }
@@ -82,6 +83,8 @@ void ConfigStringStorage::setNoCheck( unsigned index, const wsw::StringView &str
 	auto *const entry = &m_entries[index];
 	const size_t len = string.length();
 
+	m_modificationCount++;
+
 	if( !len ) {
 		char *const data = m_entries[index].data;
 		m_entries[index].data = nullptr;
@@ -31,6 +31,9 @@ protected:
 	ShortStringBlock *m_freeHead { nullptr };
 	ShortStringBlock *m_usedHead { nullptr };
 
+	// Gets incremented on every modification so caches of the contents can be validated
+	unsigned m_modificationCount { 0 };
+
 	// TODO: Generalize...
 	ShortStringBlock m_localBlocks[128];
 
@@ -80,6 +83,9 @@ public:
 
 	virtual void clear();
 
+	[[nodiscard]]
+	auto getModificationCount() const -> unsigned { return m_modificationCount; }
+
 	virtual void copyFrom( const ConfigStringStorage &that );
 
 	[[nodiscard]]
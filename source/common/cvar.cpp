@@ -162,6 +162,9 @@ static void setValueString( cvar_t *var, const char *string ) {
 }
 
 static void Cvar_SetModified( cvar_t *var ) {
+	if( Cvar_FlagIsSet( var->flags, CVAR_SERVERINFO ) ) {
+		serverinfo_modification_count++;
+	}
 	// TODO: This field should be gone
 	var->modified = true;
 	( (std::atomic<uint64_t> *)&var->modificationId )->fetch_add( 1 );
@@ -238,6 +241,9 @@ cvar_t *Cvar_Get( const char *var_name, const char *var_value, cvar_flag_t flags
 			userinfo_modified = true; // transmit at next oportunity
 
 		}
+		if( reset || ( Cvar_FlagIsSet( flags, CVAR_SERVERINFO ) && !Cvar_FlagIsSet( var->flags, CVAR_SERVERINFO ) ) ) {
+			serverinfo_modification_count++;
+		}
 		Cvar_FlagSet( &var->flags, flags );
 		return var;
 	}
@@ -383,6 +389,10 @@ cvar_t *Cvar_FullSet( const char *var_name, const char *value, cvar_flag_t flags
 		return Cvar_Get( var_name, value, flags );
 	}
 
+	if( ( var->flags ^ flags ) & CVAR_SERVERINFO ) {
+		serverinfo_modification_count++;
+	}
+
 	if( overwrite_flags ) {
 		var->flags = flags;
 	} else {
@@ -437,6 +447,9 @@ void Cvar_GetLatchedVars( cvar_flag_t flags ) {
 		var->latched_string = NULL;
 		var->value = atof( var->string );
 		var->integer = Q_rint( var->value );
+		if( Cvar_FlagIsSet( var->flags, CVAR_SERVERINFO ) ) {
+			serverinfo_modification_count++;
+		}
 	}
 	Trie_FreeDump( dump );
 }
@@ -720,6 +733,7 @@ static void Cvar_ArchiveList_f( const CmdArgs & ) {
 #endif
 
 bool userinfo_modified;
+unsigned serverinfo_modification_count;
 
 static char *Cvar_BitInfo( int bit ) {
 	static char info[MAX_INFO_STRING];
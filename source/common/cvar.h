@@ -30,6 +30,10 @@ static inline bool Cvar_FlagIsSet( cvar_flag_t flags, cvar_flag_t flag );
 // that the client knows to send it to the server
 extern bool userinfo_modified;
 
+// this is incremented each time a CVAR_SERVERINFO variable is changed
+// so that cached server info strings can be validated
+extern unsigned serverinfo_modification_count;
+
 struct CmdArgs;
 
 class DeclaredConfigVar;
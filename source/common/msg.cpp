@@ -20,8 +20,14 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // msg.c -- Message IO functions
 #include "common.h"
 #include "half_float.h"
+#include "randomgenerator.h"
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <iterator> // std::begin(), std::end()
+#include <memory>
+#include <utility>
 
 /*
 ==============================================================================
@@ -906,13 +912,510 @@ void MSG_ReadDeltaStruct( msg_t *msg, const void *from, void *to, size_t size, c
 	MSG_ReadStructFields( msg, from, to, fields, numFields, fieldMask, sizeof( fieldMask ), byteMask );
 }
 
+//==================================================
+// GENERATED DELTA CODECS
+//==================================================
+
+template <int Bits> struct DeltaFieldTypes {};
+template <> struct DeltaFieldTypes<0> { using CompareType = float; };
+template <> struct DeltaFieldTypes<1> { using CompareType = bool; };
+template <> struct DeltaFieldTypes<8> { using CompareType = int8_t; using Signed = int8_t; using Unsigned = uint8_t; };
+template <> struct DeltaFieldTypes<16> { using CompareType = int16_t; using Signed = int16_t; using Unsigned = uint16_t; };
+template <> struct DeltaFieldTypes<32> { using CompareType = int32_t; using Signed = int32_t; using Unsigned = uint32_t; };
+template <> struct DeltaFieldTypes<64> { using CompareType = int64_t; using Signed = int64_t; using Unsigned = uint64_t; };
+
+/*
+* DeltaFieldCodec
+*
+* A specialization of MSG_CompareField(), MSG_WriteField(), MSG_ReadField()
+* and delta arrays IO for a field description known at compile time.
+*/
+template <msg_field_t Field>
+struct DeltaFieldCodec {
+	using Types = DeltaFieldTypes<Field.bits>;
+	using CompareType = typename Types::CompareType;
+
+	// Must match MSG_FieldBytes()
+	static constexpr size_t kElemBytes = Field.bits == 0 ? sizeof( float ) : (size_t)( Field.bits >> 3 );
+	static constexpr size_t kNumElems = (size_t)Field.count;
+
+	// Elements masks of delta arrays are assumed to fit a single 64-bit word
+	static_assert( kNumElems >= 1 && kNumElems <= 64 );
+
+	static bool compareElem( const uint8_t *from, const uint8_t *to ) {
+		return *( (const CompareType *)to ) != *( (const CompareType *)from );
+	}
+
+	static void writeElem( msg_t *msg, const uint8_t *to ) {
+		if constexpr( Field.encoding == WIRE_BOOL ) {
+			// the value is toggled by the mask bit
+		} else if constexpr( Field.encoding == WIRE_FIXED_INT8 ) {
+			MSG_WriteInt8( msg, *( (const int8_t *)to ) );
+		} else if constexpr( Field.encoding == WIRE_FIXED_INT16 ) {
+			MSG_WriteInt16( msg, *( (const int16_t *)to ) );
+		} else if constexpr( Field.encoding == WIRE_FIXED_INT32 ) {
+			MSG_WriteInt32( msg, *( (const int32_t *)to ) );
+		} else if constexpr( Field.encoding == WIRE_FIXED_INT64 ) {
+			MSG_WriteInt64( msg, *( (const int64_t *)to ) );
+		} else if constexpr( Field.encoding == WIRE_FLOAT ) {
+			MSG_WriteFloat( msg, *( (const float *)to ) );
+		} else if constexpr( Field.encoding == WIRE_HALF_FLOAT ) {
+			MSG_WriteHalfFloat( msg, *( (const float *)to ) );
+		} else if constexpr( Field.encoding == WIRE_ANGLE ) {
+			MSG_WriteHalfFloat( msg, anglemod( *( (const float *)to ) ) );
+		} else if constexpr( Field.encoding == WIRE_BASE128 ) {
+			if constexpr( Field.bits == 8 ) {
+				MSG_WriteInt8( msg, *( (const int8_t *)to ) );
+			} else {
+				MSG_WriteIntBase128( msg, *( (const typename Types::Signed *)to ) );
+			}
+		} else if constexpr( Field.encoding == WIRE_UBASE128 ) {
+			if constexpr( Field.bits == 8 ) {
+				MSG_WriteUint8( msg, *( (const uint8_t *)to ) );
+			} else {
+				MSG_WriteUintBase128( msg, *( (const typename Types::Unsigned *)to ) );
+			}
+		} else {
+			static_assert( Field.encoding < 0, "Unknown encoding type" );
+		}
+	}
+
+	static void readElem( msg_t *msg, uint8_t *to ) {
+		if constexpr( Field.encoding == WIRE_BOOL ) {
+			*( (bool *)to ) ^= true;
+		} else if constexpr( Field.encoding == WIRE_FIXED_INT8 ) {
+			*( (int8_t *)to ) = MSG_ReadInt8( msg );
+		} else if constexpr( Field.encoding == WIRE_FIXED_INT16 ) {
+			*( (int16_t *)to ) = MSG_ReadInt16( msg );
+		} else if constexpr( Field.encoding == WIRE_FIXED_INT32 ) {
+			*( (int32_t *)to ) = MSG_ReadInt32( msg );
+		} else if constexpr( Field.encoding == WIRE_FIXED_INT64 ) {
+			*( (int64_t *)to ) = MSG_ReadInt64( msg );
+		} else if constexpr( Field.encoding == WIRE_FLOAT ) {
+			*( (float *)to ) = MSG_ReadFloat( msg );
+		} else if constexpr( Field.encoding == WIRE_HALF_FLOAT || Field.encoding == WIRE_ANGLE ) {
+			*( (float *)to ) = MSG_ReadHalfFloat( msg );
+		} else if constexpr( Field.encoding == WIRE_BASE128 ) {
+			if constexpr( Field.bits == 8 ) {
+				*( (int8_t *)to ) = MSG_ReadInt8( msg );
+			} else {
+				*( (typename Types::Signed *)to ) = MSG_ReadIntBase128( msg );
+			}
+		} else if constexpr( Field.encoding == WIRE_UBASE128 ) {
+			if constexpr( Field.bits == 8 ) {
+				*( (uint8_t *)to ) = MSG_ReadUint8( msg );
+			} else {
+				*( (typename Types::Unsigned *)to ) = MSG_ReadUintBase128( msg );
+			}
+		} else {
+			static_assert( Field.encoding < 0, "Unknown encoding type" );
+		}
+	}
+
+	static bool compare( const uint8_t *from, const uint8_t *to ) {
+		from += Field.offset;
+		to += Field.offset;
+		for( size_t i = 0; i < kNumElems; ++i ) {
+			if( compareElem( from + i * kElemBytes, to + i * kElemBytes ) ) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Bitwise equal float values are still considered changed by MSG_CompareField() if these are NaNs
+	static bool hasNaNs( const uint8_t *to ) {
+		if constexpr( Field.bits == 0 ) {
+			to += Field.offset;
+			for( size_t i = 0; i < kNumElems; ++i ) {
+				const float value = *( (const float *)( to + i * kElemBytes ) );
+				if( value != value ) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	static void write( msg_t *msg, const uint8_t *from, const uint8_t *to ) {
+		if constexpr( kNumElems == 1 ) {
+			writeElem( msg, to + Field.offset );
+		} else {
+			writeDeltaArray( msg, from + Field.offset, to + Field.offset );
+		}
+	}
+
+	static void read( msg_t *msg, uint8_t *to ) {
+		if constexpr( kNumElems == 1 ) {
+			readElem( msg, to + Field.offset );
+		} else {
+			readDeltaArray( msg, to + Field.offset );
+		}
+	}
+
+	/*
+	* writeDeltaArray
+	*
+	* Must produce exactly the same output as MSG_WriteDeltaArray()
+	*/
+	static void writeDeltaArray( msg_t *msg, const uint8_t *from, const uint8_t *to ) {
+		uint8_t elemMask[32] = { 0 };
+		uint64_t elemBits = 0;
+		unsigned byteMask = 0;
+
+		for( size_t i = 0; i < kNumElems; ++i ) {
+			if( compareElem( from + i * kElemBytes, to + i * kElemBytes ) ) {
+				elemMask[i >> 3] |= ( 1 << ( i & 7 ) );
+				elemBits |= (uint64_t)1 << i;
+				byteMask |= ( 1 << ( i >> 3 ) );
+			}
+		}
+
+		if constexpr( kNumElems <= 8 ) {
+			// we don't need the byteMask in case all field bits fit a single byte
+			byteMask = 1;
+		} else {
+			MSG_WriteUintBase128( msg, byteMask );
+		}
+
+		MSG_WriteFieldMask( msg, elemMask, byteMask );
+
+		for(; elemBits; elemBits &= elemBits - 1 ) {
+			writeElem( msg, to + std::countr_zero( elemBits ) * kElemBytes );
+		}
+	}
+
+	/*
+	* readDeltaArray
+	*
+	* Must accept exactly the same input as MSG_ReadDeltaArray()
+	*/
+	static void readDeltaArray( msg_t *msg, uint8_t *to ) {
+		unsigned byteMask;
+		uint8_t elemMask[32] = { 0 };
+
+		if constexpr( kNumElems <= 8 ) {
+			// we don't need the byteMask in case all field bits fit a single byte
+			byteMask = 1;
+		} else {
+			byteMask = MSG_ReadUintBase128( msg );
+		}
+
+		MSG_ReadFieldMask( msg, elemMask, sizeof( elemMask ), byteMask );
+
+		for( size_t b = 0; byteMask; b++, byteMask >>= 1 ) {
+			if( byteMask & 1 ) {
+				for( unsigned fm = elemMask[b]; fm; fm &= fm - 1 ) {
+					const size_t fn = ( b << 3 ) + std::countr_zero( fm );
+					if( fn >= kNumElems ) {
+						Com_Error( ERR_FATAL, "MSG_ReadArrayElems: fn >= maxElems" );
+					}
+					readElem( msg, to + fn * kElemBytes );
+				}
+			}
+		}
+	}
+};
+
+/*
+* DeltaStructCodec
+*
+* A specialization of MSG_CompareStructs(), MSG_WriteStructFields() and MSG_ReadStructFields()
+* for a fields table known at compile time. The output is bit-identical to the interpreter one.
+*/
+template <typename Struct, const auto &Fields>
+class DeltaStructCodec {
+	static constexpr size_t kNumFields = std::size( Fields );
+
+	// Byte masks are assumed to fit a single byte
+	// (MSG_CompareStructs() wraps byte mask bits for larger tables)
+	static_assert( kNumFields >= 1 && kNumFields <= 64 );
+
+	using WriteFn = void (*)( msg_t *, const uint8_t *, const uint8_t * );
+	using ReadFn = void (*)( msg_t *, uint8_t * );
+
+	template <size_t... I>
+	static constexpr auto makeWriteFns( std::index_sequence<I...> ) {
+		return std::array<WriteFn, kNumFields> { &DeltaFieldCodec<Fields[I]>::write... };
+	}
+
+	template <size_t... I>
+	static constexpr auto makeReadFns( std::index_sequence<I...> ) {
+		return std::array<ReadFn, kNumFields> { &DeltaFieldCodec<Fields[I]>::read... };
+	}
+
+	static constexpr std::array<WriteFn, kNumFields> kWriteFns { makeWriteFns( std::make_index_sequence<kNumFields>() ) };
+	static constexpr std::array<ReadFn, kNumFields> kReadFns { makeReadFns( std::make_index_sequence<kNumFields>() ) };
+
+	static constexpr size_t fieldBegin( const msg_field_t &field ) {
+		return (size_t)field.offset;
+	}
+
+	static constexpr size_t fieldEnd( const msg_field_t &field ) {
+		const size_t elemBytes = field.bits == 0 ? sizeof( float ) : field.bits == 1 ? sizeof( bool ) : (size_t)( field.bits >> 3 );
+		return (size_t)field.offset + elemBytes * (size_t)field.count;
+	}
+
+	static constexpr size_t computeSpanBegin() {
+		size_t result = sizeof( Struct );
+		for( const msg_field_t &field: Fields ) {
+			result = std::min( result, fieldBegin( field ) );
+		}
+		return result;
+	}
+
+	static constexpr size_t computeSpanEnd() {
+		size_t result = 0;
+		for( const msg_field_t &field: Fields ) {
+			result = std::max( result, fieldEnd( field ) );
+		}
+		return result;
+	}
+
+	static constexpr bool computeHasFloatFields() {
+		for( const msg_field_t &field: Fields ) {
+			if( field.bits == 0 ) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static constexpr size_t kSpanBegin = computeSpanBegin();
+	static constexpr size_t kSpanEnd = computeSpanEnd();
+	static_assert( kSpanBegin < kSpanEnd && kSpanEnd <= sizeof( Struct ) );
+
+	static constexpr bool kHasFloatFields = computeHasFloatFields();
+
+	// Fields are first tested for bitwise equality using 16-byte chunks of the fields span.
+	// A field that overlaps only with unchanged chunks is unchanged (modulo float NaNs).
+	static constexpr size_t kNumChunks = ( kSpanEnd - kSpanBegin + 15 ) / 16;
+#ifdef WSW_USE_SSE2
+	static constexpr bool kUseChunks = kNumChunks <= 64 && sizeof( Struct ) >= 16;
+#else
+	static constexpr bool kUseChunks = false;
+#endif
+
+	static constexpr size_t chunkOffset( size_t chunkNum ) {
+		// The last chunk gets shifted back so it does not cross the struct boundary
+		return std::min( kSpanBegin + 16 * chunkNum, sizeof( Struct ) - 16 );
+	}
+
+	static constexpr auto makeFieldChunkMasks() {
+		std::array<uint64_t, kNumFields> result {};
+		if constexpr( kUseChunks ) {
+			for( size_t i = 0; i < kNumFields; ++i ) {
+				const size_t firstChunk = ( fieldBegin( Fields[i] ) - kSpanBegin ) / 16;
+				const size_t lastChunk = std::min( ( fieldEnd( Fields[i] ) - 1 - kSpanBegin ) / 16, kNumChunks - 1 );
+				for( size_t chunkNum = firstChunk; chunkNum <= lastChunk; ++chunkNum ) {
+					result[i] |= (uint64_t)1 << chunkNum;
+				}
+			}
+		}
+		return result;
+	}
+
+	static constexpr std::array<uint64_t, kNumFields> kFieldChunkMasks { makeFieldChunkMasks() };
+
+	static uint64_t findChangedChunks( const uint8_t *from, const uint8_t *to ) {
+		uint64_t result = 0;
+#ifdef WSW_USE_SSE2
+		for( size_t chunkNum = 0; chunkNum < kNumChunks; ++chunkNum ) {
+			const size_t offset = chunkOffset( chunkNum );
+			const __m128i xmmFrom = _mm_loadu_si128( (const __m128i *)( from + offset ) );
+			const __m128i xmmTo = _mm_loadu_si128( (const __m128i *)( to + offset ) );
+			if( _mm_movemask_epi8( _mm_cmpeq_epi8( xmmFrom, xmmTo ) ) != 0xFFFF ) {
+				result |= (uint64_t)1 << chunkNum;
+			}
+		}
+#endif
+		return result;
+	}
+
+	template <size_t I>
+	static bool isFieldChanged( const uint8_t *from, const uint8_t *to, uint64_t changedChunks ) {
+		if constexpr( kUseChunks ) {
+			if( !( changedChunks & kFieldChunkMasks[I] ) ) {
+				return DeltaFieldCodec<Fields[I]>::hasNaNs( to );
+			}
+		}
+		return DeltaFieldCodec<Fields[I]>::compare( from, to );
+	}
+
+	template <size_t... I>
+	static uint64_t findChangedFields( const uint8_t *from, const uint8_t *to, uint64_t changedChunks, std::index_sequence<I...> ) {
+		return ( ( (uint64_t)isFieldChanged<I>( from, to, changedChunks ) << I ) | ... );
+	}
+public:
+	/*
+	* compare
+	*
+	* Must produce exactly the same results as MSG_CompareStructs()
+	*/
+	static unsigned compare( const void *from, const void *to, uint8_t *fieldMask ) {
+		const auto *bfrom = (const uint8_t *)from, *bto = (const uint8_t *)to;
+
+		uint64_t changedChunks = 0;
+		if constexpr( kUseChunks ) {
+			changedChunks = findChangedChunks( bfrom, bto );
+			if constexpr( !kHasFloatFields ) {
+				if( !changedChunks ) {
+					return 0;
+				}
+			}
+		}
+
+		const uint64_t changedFields = findChangedFields( bfrom, bto, changedChunks, std::make_index_sequence<kNumFields>() );
+
+		unsigned byteMask = 0;
+		for( size_t b = 0; b < ( kNumFields + 7 ) / 8; ++b ) {
+			if( const auto bits = (uint8_t)( changedFields >> ( b << 3 ) ) ) {
+				fieldMask[b] |= bits;
+				byteMask |= ( 1 << b );
+			}
+		}
+
+		return byteMask;
+	}
+
+	/*
+	* writeFields
+	*
+	* Must produce exactly the same output as MSG_WriteStructFields()
+	*/
+	static void writeFields( msg_t *msg, const void *from, const void *to, const uint8_t *fieldMask, unsigned byteMask ) {
+		for( size_t b = 0; byteMask; b++, byteMask >>= 1 ) {
+			if( byteMask & 1 ) {
+				for( unsigned fm = fieldMask[b]; fm; fm &= fm - 1 ) {
+					const size_t fn = ( b << 3 ) + std::countr_zero( fm );
+					if( fn >= kNumFields ) {
+						return;
+					}
+					kWriteFns[fn]( msg, (const uint8_t *)from, (const uint8_t *)to );
+				}
+			}
+		}
+	}
+
+	/*
+	* readFields
+	*
+	* Must accept exactly the same input as MSG_ReadStructFields()
+	*/
+	static void readFields( msg_t *msg, void *to, const uint8_t *fieldMask, size_t maskSize, unsigned byteMask ) {
+		for( size_t b = 0; byteMask; b++, byteMask >>= 1 ) {
+			if( byteMask & 1 ) {
+				if( b >= maskSize ) {
+					Com_Error( ERR_FATAL, "MSG_ReadStructFields: b >= maxSize" );
+				}
+				for( unsigned fm = fieldMask[b]; fm; fm &= fm - 1 ) {
+					const size_t fn = ( b << 3 ) + std::countr_zero( fm );
+					if( fn >= kNumFields ) {
+						Com_Error( ERR_FATAL, "MSG_ReadStructFields: f >= numFields" );
+					}
+					kReadFns[fn]( msg, (uint8_t *)to );
+				}
+			}
+		}
+	}
+
+	/*
+	* writeDelta
+	*
+	* A counterpart of MSG_WriteDeltaStruct()
+	*/
+	static void writeDelta( msg_t *msg, const Struct *from, const Struct *to ) {
+		uint8_t fieldMask[32] = { 0 };
+		unsigned byteMask = compare( from, to, fieldMask );
+
+		if constexpr( kNumFields <= 8 ) {
+			// we don't need the byteMask in case all field bits fit a single byte
+			byteMask = 1;
+		} else {
+			MSG_WriteUintBase128( msg, byteMask );
+		}
+
+		MSG_WriteFieldMask( msg, fieldMask, byteMask );
+
+		writeFields( msg, from, to, fieldMask, byteMask );
+	}
+
+	/*
+	* readDelta
+	*
+	* A counterpart of MSG_ReadDeltaStruct()
+	*/
+	static void readDelta( msg_t *msg, const Struct *from, Struct *to ) {
+		uint8_t fieldMask[32] = { 0 };
+		unsigned byteMask;
+
+		// set everything to the state we are delta'ing from
+		memcpy( to, from, sizeof( Struct ) );
+
+		if constexpr( kNumFields <= 8 ) {
+			// we don't need the byteMask in case all field bits fit a single byte
+			byteMask = 1;
+		} else {
+			byteMask = MSG_ReadUintBase128( msg );
+		}
+
+		MSG_ReadFieldMask( msg, fieldMask, sizeof( fieldMask ), byteMask );
+
+		readFields( msg, to, fieldMask, sizeof( fieldMask ), byteMask );
+	}
+
+#ifndef PUBLIC_BUILD
+	/*
+	* matchesInterpreter
+	*
+	* Encodes and decodes the delta using both the codec and the interpreter and compares results.
+	* Decoded states are stored in the supplied ones.
+	*/
+	static bool matchesInterpreter( const Struct *from, const Struct *to, Struct *codecResult, Struct *interpreterResult ) {
+		uint8_t fieldMask[32] = { 0 }, interpreterFieldMask[32] = { 0 };
+		const unsigned byteMask = compare( from, to, fieldMask );
+		const unsigned interpreterByteMask = MSG_CompareStructs( from, to, Fields, kNumFields,
+																 interpreterFieldMask, sizeof( interpreterFieldMask ) );
+		if( byteMask != interpreterByteMask || memcmp( fieldMask, interpreterFieldMask, sizeof( fieldMask ) ) != 0 ) {
+			Com_Printf( "DeltaStructCodec: byteMask=%u does not match interpreter byteMask=%u\n", byteMask, interpreterByteMask );
+			return false;
+		}
+
+		static uint8_t codecBuffer[MAX_MSGLEN], interpreterBuffer[MAX_MSGLEN];
+		msg_t codecMsg, interpreterMsg;
+		MSG_Init( &codecMsg, codecBuffer, sizeof( codecBuffer ) );
+		MSG_Init( &interpreterMsg, interpreterBuffer, sizeof( interpreterBuffer ) );
+
+		writeDelta( &codecMsg, from, to );
+		MSG_WriteDeltaStruct( &interpreterMsg, from, to, Fields, kNumFields );
+		if( codecMsg.cursize != interpreterMsg.cursize || memcmp( codecBuffer, interpreterBuffer, codecMsg.cursize ) != 0 ) {
+			Com_Printf( "DeltaStructCodec: written %d bytes do not match %d interpreter ones\n",
+						(int)codecMsg.cursize, (int)interpreterMsg.cursize );
+			return false;
+		}
+
+		MSG_BeginReading( &codecMsg );
+		MSG_BeginReading( &interpreterMsg );
+		readDelta( &codecMsg, from, codecResult );
+		MSG_ReadDeltaStruct( &interpreterMsg, from, interpreterResult, sizeof( Struct ), Fields, kNumFields );
+		if( codecMsg.readcount != interpreterMsg.readcount || memcmp( codecResult, interpreterResult, sizeof( Struct ) ) != 0 ) {
+			Com_Printf( "DeltaStructCodec: read %d bytes do not match %d interpreter ones\n",
+						(int)codecMsg.readcount, (int)interpreterMsg.readcount );
+			return false;
+		}
+
+		return true;
+	}
+#endif
+};
+
 //==================================================
 // DELTA ENTITIES
 //==================================================
 
 #define ESOFS( x ) offsetof( entity_state_t,x )
 
-static const msg_field_t ent_state_fields[] = {
+static constexpr msg_field_t ent_state_fields[] = {
 	{ ESOFS( events[0] ), 32, 1, WIRE_UBASE128 },
 	{ ESOFS( eventParms[0] ), 32, 1, WIRE_BASE128 },
 
@@ -974,6 +1477,8 @@ static const msg_field_t ent_state_fields[] = {
 	{ ESOFS( light ), 32, 1, WIRE_FIXED_INT32 },
 };
 
+using EntityStateCodec = DeltaStructCodec<entity_state_t, ent_state_fields>;
+
 /*
 * MSG_WriteEntityNumber
 */
@@ -992,13 +1497,6 @@ void MSG_WriteDeltaEntity( msg_t *msg, const entity_state_t *from, const entity_
 	int number;
 	unsigned byteMask;
 	uint8_t fieldMask[32] = { 0 };
-	const msg_field_t *fields = ent_state_fields;
-	int numFields = sizeof( ent_state_fields ) / sizeof( ent_state_fields[0] );
-
-	assert( numFields < 256 );
-	if( numFields > 256 ) {
-		Com_Error( ERR_FATAL, "MSG_WriteDeltaEntity: numFields == %i", numFields );
-	}
 
 	if( !to ) {
 		if( !from )
@@ -1022,7 +1520,7 @@ void MSG_WriteDeltaEntity( msg_t *msg, const entity_state_t *from, const entity_
 		return;
 	}
 
-	byteMask = MSG_CompareStructs( from, to, fields, numFields, fieldMask, sizeof( fieldMask ) );
+	byteMask = EntityStateCodec::compare( from, to, fieldMask );
 	if( !byteMask && !force ) {
 		// no changes
 		return;
@@ -1032,7 +1530,7 @@ void MSG_WriteDeltaEntity( msg_t *msg, const entity_state_t *from, const entity_
 
 	MSG_WriteFieldMask( msg, fieldMask, byteMask );
 
-	MSG_WriteStructFields( msg, from, to, fields, numFields, fieldMask, byteMask );
+	EntityStateCodec::writeFields( msg, from, to, fieldMask, byteMask );
 }
 
 /*
@@ -1058,8 +1556,6 @@ int MSG_ReadEntityNumber( msg_t *msg, bool *remove, unsigned *byteMask ) {
 */
 void MSG_ReadDeltaEntity( msg_t *msg, const entity_state_t *from, entity_state_t *to, int number, unsigned byteMask ) {
 	uint8_t fieldMask[32] = { 0 };
-	const msg_field_t *fields = ent_state_fields;
-	int numFields = sizeof( ent_state_fields ) / sizeof( ent_state_fields[0] );
 
 	// set everything to the state we are delta'ing from
 	*to = *from;
@@ -1067,7 +1563,7 @@ void MSG_ReadDeltaEntity( msg_t *msg, const entity_state_t *from, entity_state_t
 	
 	MSG_ReadFieldMask( msg, fieldMask, sizeof( fieldMask ), byteMask );
 
-	MSG_ReadStructFields( msg, from, to, fields, numFields, fieldMask, sizeof( fieldMask ), byteMask );
+	EntityStateCodec::readFields( msg, to, fieldMask, sizeof( fieldMask ), byteMask );
 }
 
 //==================================================
@@ -1076,7 +1572,7 @@ void MSG_ReadDeltaEntity( msg_t *msg, const entity_state_t *from, entity_state_t
 
 #define UCOFS( x ) offsetof( usercmd_t,x )
 
-static const msg_field_t usercmd_fields[] = {
+static constexpr msg_field_t usercmd_fields[] = {
 	{ UCOFS( angles[0] ), 16, 1, WIRE_FIXED_INT16 },
 	{ UCOFS( angles[1] ), 16, 1, WIRE_FIXED_INT16 },
 	{ UCOFS( angles[2] ), 16, 1, WIRE_FIXED_INT16 },
@@ -1088,14 +1584,13 @@ static const msg_field_t usercmd_fields[] = {
 	{ UCOFS( buttons ), 32, 1, WIRE_UBASE128 },
 };
 
+using UsercmdCodec = DeltaStructCodec<usercmd_t, usercmd_fields>;
+
 /*
 * MSG_WriteDeltaUsercmd
 */
 void MSG_WriteDeltaUsercmd( msg_t *msg, const usercmd_t *from, usercmd_t *cmd ) {
-	int numFields = sizeof( usercmd_fields ) / sizeof( usercmd_fields[0] );
-	const msg_field_t *fields = usercmd_fields;
-
-	MSG_WriteDeltaStruct( msg, from, cmd, fields, numFields );
+	UsercmdCodec::writeDelta( msg, from, cmd );
 
 	MSG_WriteIntBase128( msg, cmd->serverTimeStamp );
 }
@@ -1104,10 +1599,7 @@ void MSG_WriteDeltaUsercmd( msg_t *msg, const usercmd_t *from, usercmd_t *cmd )
 * MSG_ReadDeltaUsercmd
 */
 void MSG_ReadDeltaUsercmd( msg_t *msg, const usercmd_t *from, usercmd_t *move ) {
-	int numFields = sizeof( usercmd_fields ) / sizeof( usercmd_fields[0] );
-	const msg_field_t *fields = usercmd_fields;
-
-	MSG_ReadDeltaStruct( msg, from, move, sizeof( usercmd_t ), fields, numFields );
+	UsercmdCodec::readDelta( msg, from, move );
 
 	move->serverTimeStamp = MSG_ReadIntBase128( msg );
 }
@@ -1118,7 +1610,7 @@ void MSG_ReadDeltaUsercmd( msg_t *msg, const usercmd_t *from, usercmd_t *move )
 
 #define PSOFS( x ) offsetof( player_state_t,x )
 
-static const msg_field_t player_state_msg_fields[] = {
+static constexpr msg_field_t player_state_msg_fields[] = {
 	{ PSOFS( pmove.pm_type ), 32, 1, WIRE_UBASE128 },
 
 	{ PSOFS( pmove.origin[0] ), 0, 1, WIRE_FLOAT },
@@ -1169,27 +1661,25 @@ static const msg_field_t player_state_msg_fields[] = {
 	{ PSOFS( inventory ), 32, MAX_ITEMS, WIRE_UBASE128 },
 };
 
+using PlayerStateCodec = DeltaStructCodec<player_state_t, player_state_msg_fields>;
+
 /*
 * MSG_WriteDeltaPlayerstate
 */
 void MSG_WriteDeltaPlayerState( msg_t *msg, const player_state_t *ops, const player_state_t *ps ) {
-	int numFields = sizeof( player_state_msg_fields ) / sizeof( player_state_msg_fields[0] );
-	const msg_field_t *fields = player_state_msg_fields;
 	static player_state_t dummy;
 
 	if( !ops ) {
 		ops = &dummy;
 	}
 
-	MSG_WriteDeltaStruct( msg, ops, ps, fields, numFields );
+	PlayerStateCodec::writeDelta( msg, ops, ps );
 }
 
 /*
 * MSG_ReadDeltaPlayerstate
 */
 void MSG_ReadDeltaPlayerState( msg_t *msg, const player_state_t *ops, player_state_t *ps ) {
-	int numFields = sizeof( player_state_msg_fields ) / sizeof( player_state_msg_fields[0] );
-	const msg_field_t *fields = player_state_msg_fields;
 	static player_state_t dummy;
 
 	if( !ops ) {
@@ -1197,7 +1687,7 @@ void MSG_ReadDeltaPlayerState( msg_t *msg, const player_state_t *ops, player_sta
 	}
 	memcpy( ps, ops, sizeof( player_state_t ) );
 
-	MSG_ReadDeltaStruct( msg, ops, ps, sizeof( player_state_t ), fields, numFields );
+	PlayerStateCodec::readDelta( msg, ops, ps );
 }
 
 //==================================================
@@ -1206,41 +1696,39 @@ void MSG_ReadDeltaPlayerState( msg_t *msg, const player_state_t *ops, player_sta
 
 #define GSOFS( x ) offsetof( game_state_t,x )
 
-static const msg_field_t game_state_msg_fields[] = {
+static constexpr msg_field_t game_state_msg_fields[] = {
 	{ GSOFS( stats ), 64, MAX_GAME_STATS, WIRE_BASE128 },
 };
 
+using GameStateCodec = DeltaStructCodec<game_state_t, game_state_msg_fields>;
+
 /*
 * MSG_WriteDeltaGameState
 */
 void MSG_WriteDeltaGameState( msg_t *msg, const game_state_t *from, const game_state_t *to ) {
-	int numFields = sizeof( game_state_msg_fields ) / sizeof( game_state_msg_fields[0] );
-	const msg_field_t *fields = game_state_msg_fields;
 	static game_state_t dummy;
 
 	if( !from ) {
 		from = &dummy;
 	}
 
-	MSG_WriteDeltaStruct( msg, from, to, fields, numFields );
+	GameStateCodec::writeDelta( msg, from, to );
 }
 
 /*
 * MSG_ReadDeltaGameState
 */
 void MSG_ReadDeltaGameState( msg_t *msg, const game_state_t *from, game_state_t *to ) {
-	int numFields = sizeof( game_state_msg_fields ) / sizeof( game_state_msg_fields[0] );
-	const msg_field_t *fields = game_state_msg_fields;
 	static game_state_t dummy;
 
 	if( !from ) {
 		from = &dummy;
 	}
 
-	MSG_ReadDeltaStruct( msg, from, to, sizeof( game_state_t ), fields, numFields );
+	GameStateCodec::readDelta( msg, from, to );
 }
 
-static const msg_field_t raw_scoreboard_msg_fields[] = {
+static constexpr msg_field_t raw_scoreboard_msg_fields[] = {
 	{
 		offsetof( ReplicatedScoreboardData, playersTeamMask ),
 		64, 1, WIRE_BASE128
@@ -1279,16 +1767,98 @@ static const msg_field_t raw_scoreboard_msg_fields[] = {
 	{ offsetof( ReplicatedScoreboardData, pingSlot ), 8, 1, WIRE_FIXED_INT8 },
 };
 
+using ScoreboardDataCodec = DeltaStructCodec<ReplicatedScoreboardData, raw_scoreboard_msg_fields>;
+
 static const ReplicatedScoreboardData scoreboardBaseline {};
 
 void MSG_WriteDeltaScoreboardData( msg_t *msg, const ReplicatedScoreboardData *from, const ReplicatedScoreboardData *to ) {
-	const int numFields = (int)( std::end( raw_scoreboard_msg_fields ) - std::begin( raw_scoreboard_msg_fields ) );
 	from = from ? from : &scoreboardBaseline;
-	MSG_WriteDeltaStruct( msg, from, to, raw_scoreboard_msg_fields, numFields );
+	ScoreboardDataCodec::writeDelta( msg, from, to );
 }
 
 void MSG_ReadDeltaScoreboardData( msg_t *msg, const ReplicatedScoreboardData *from, ReplicatedScoreboardData *to ) {
-	const int numFields = (int)( std::end( raw_scoreboard_msg_fields ) - std::begin( raw_scoreboard_msg_fields ) );
 	from = from ? from : &scoreboardBaseline;
-	MSG_ReadDeltaStruct( msg, from, to, sizeof( ReplicatedScoreboardData ), raw_scoreboard_msg_fields, numFields );
-}
\ No newline at end of file
+	ScoreboardDataCodec::readDelta( msg, from, to );
+}
+
+#ifndef PUBLIC_BUILD
+
+//==================================================
+// DELTA CODECS SELF-CHECK
+//==================================================
+
+/*
+* MSG_RandomizeFields
+*
+* Assigns random values to fields of the struct, every field gets changed with the given probability
+*/
+static void MSG_RandomizeFields( wsw::RandomGenerator *rng, void *to, const msg_field_t *fields, size_t numFields, unsigned changeChance ) {
+	for( size_t i = 0; i < numFields; ++i ) {
+		const msg_field_t *f = &fields[i];
+		if( rng->nextBounded( 100 ) >= changeChance ) {
+			continue;
+		}
+		uint8_t *elems = (uint8_t *)to + f->offset;
+		for( int j = 0; j < f->count; ++j ) {
+			if( f->bits == 1 ) {
+				( (bool *)elems )[j] = ( rng->next() & 1 ) != 0;
+			} else if( f->bits == 0 ) {
+				float value;
+				switch( rng->nextBounded( 4 ) ) {
+					case 0: value = 0.0f; break;
+					case 1: value = (float)(int)rng->nextBounded( 512 ) - 256.0f; break;
+					case 2: value = rng->nextFloat( -8192.0f, +8192.0f ); break;
+					default: value = rng->nextFloat( -1.0f, +1.0f ); break;
+				}
+				( (float *)elems )[j] = value;
+			} else {
+				// Make small values that have short base128 encodings likely
+				const unsigned shift = rng->nextBounded( 64 );
+				const uint64_t bits = ( ( (uint64_t)rng->next() << 32 ) | rng->next() ) >> shift;
+				const uint64_t value = rng->next() & 1 ? ~bits : bits;
+				const size_t elemBytes = MSG_FieldBytes( f );
+				memcpy( elems + j * elemBytes, &value, elemBytes );
+			}
+		}
+	}
+}
+
+/*
+* MSG_CheckDeltaCodec
+*/
+template <typename Codec, typename Struct, size_t N>
+static bool MSG_CheckDeltaCodec( wsw::RandomGenerator *rng, const char *name, const msg_field_t ( &fields )[N], unsigned numIterations ) {
+	// Some of states are too large to be put on stack
+	auto states = std::make_unique<Struct[]>( 4 );
+	Struct *const from = &states[0], *const to = &states[1];
+	for( unsigned i = 0; i < numIterations; ++i ) {
+		MSG_RandomizeFields( rng, from, fields, N, 100 );
+		memcpy( (void *)to, from, sizeof( Struct ) );
+		// Check unchanged, sparsely changed and densely changed states
+		MSG_RandomizeFields( rng, to, fields, N, i % 3 == 0 ? 0 : i % 3 == 1 ? 10 : 75 );
+		if( !Codec::matchesInterpreter( from, to, &states[2], &states[3] ) ) {
+			Com_Printf( S_COLOR_RED "The %s codec does not match the interpreter at iteration %u\n", name, i );
+			return false;
+		}
+	}
+	Com_Printf( "The %s codec matches the interpreter\n", name );
+	return true;
+}
+
+/*
+* MSG_CheckDeltaCodecs
+*
+* Checks that generated codecs of every fields table produce and accept the same data as the interpreter
+*/
+bool MSG_CheckDeltaCodecs( unsigned numIterations ) {
+	wsw::RandomGenerator rng;
+	bool result = true;
+	result &= MSG_CheckDeltaCodec<EntityStateCodec, entity_state_t>( &rng, "entity state", ent_state_fields, numIterations );
+	result &= MSG_CheckDeltaCodec<UsercmdCodec, usercmd_t>( &rng, "usercmd", usercmd_fields, numIterations );
+	result &= MSG_CheckDeltaCodec<PlayerStateCodec, player_state_t>( &rng, "player state", player_state_msg_fields, numIterations );
+	result &= MSG_CheckDeltaCodec<GameStateCodec, game_state_t>( &rng, "game state", game_state_msg_fields, numIterations );
+	result &= MSG_CheckDeltaCodec<ScoreboardDataCodec, ReplicatedScoreboardData>( &rng, "scoreboard", raw_scoreboard_msg_fields, numIterations );
+	return result;
+}
+
+#endif
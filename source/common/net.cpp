@@ -43,6 +43,11 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <sys/time.h>
 #endif
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+#include <atomic>
 #include <utility>
 #include <tuple>
 
@@ -80,6 +85,57 @@ static bool net_initialized = false;
 static int numIP;
 static uint8_t localIP[MAX_IPS][4];
 
+// Gets incremented on closing network sockets, so cached sets of socket handles could be invalidated
+static std::atomic<unsigned> socketsCloseCounter;
+
+#ifdef __linux__
+
+#define MAX_BATCHED_PACKETS 64
+
+typedef struct {
+	socket_handle_t handle;
+	struct sockaddr_storage address;
+	socklen_t addrlen;
+	size_t length;
+	uint8_t data[MAX_PACKETLEN];
+} queued_packet_t;
+
+// Only a single thread may batch sends at the same time
+static queued_packet_t *queuedPackets;
+static int numQueuedPackets;
+static thread_local bool isBatchingSends;
+
+#define MAX_SLEEP_SOCKETS 16
+
+/*
+* A persistent epoll set of sockets that is used for sleeping.
+* Every thread that sleeps on sockets has its own set.
+*/
+class SleepSocketsSet {
+public:
+	~SleepSocketsSet() {
+		if( m_epollFd >= 0 ) {
+			close( m_epollFd );
+		}
+	}
+
+	bool sync( socket_t *sockets[] );
+
+	int wait( int msec ) {
+		struct epoll_event events[MAX_SLEEP_SOCKETS];
+		return epoll_wait( m_epollFd, events, MAX_SLEEP_SOCKETS, msec );
+	}
+private:
+	int m_epollFd { -1 };
+	int m_numHandles { 0 };
+	unsigned m_closeCounter { 0 };
+	socket_handle_t m_handles[MAX_SLEEP_SOCKETS];
+};
+
+static thread_local SleepSocketsSet sleepSocketsSet;
+
+#endif
+
 /*
 =============================================================================
 PRIVATE FUNCTIONS
@@ -376,6 +432,130 @@ static int NET_UDP_GetPacket( const socket_t *socket, netadr_t *address, msg_t *
 	return 1;
 }
 
+#ifdef __linux__
+/*
+* NET_UDP_GetPackets
+*/
+static int NET_UDP_GetPackets( const socket_t *socket, netadr_t *addresses, msg_t *messages, int maxPackets ) {
+	struct mmsghdr headers[MAX_BATCHED_PACKETS];
+	struct iovec iovecs[MAX_BATCHED_PACKETS];
+	struct sockaddr_storage from[MAX_BATCHED_PACKETS];
+	int i, ret;
+
+	assert( socket && socket->open && socket->type == SOCKET_UDP );
+	assert( addresses );
+	assert( messages );
+	assert( maxPackets > 0 );
+
+	maxPackets = wsw::min( maxPackets, MAX_BATCHED_PACKETS );
+	for( i = 0; i < maxPackets; i++ ) {
+		assert( messages[i].data );
+		assert( messages[i].maxsize > 0 );
+		iovecs[i].iov_base = messages[i].data;
+		iovecs[i].iov_len = messages[i].maxsize;
+		memset( &headers[i], 0, sizeof( headers[i] ) );
+		headers[i].msg_hdr.msg_name = &from[i];
+		headers[i].msg_hdr.msg_namelen = sizeof( from[i] );
+		headers[i].msg_hdr.msg_iov = &iovecs[i];
+		headers[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	ret = recvmmsg( socket->handle, headers, maxPackets, 0, NULL );
+	if( ret == SOCKET_ERROR ) {
+		net_error_t err;
+
+		NET_SetErrorStringFromLastError( "recvmmsg" );
+
+		err = Sys_NET_GetLastError();
+		if( err == NET_ERR_WOULDBLOCK || err == NET_ERR_CONNRESET ) { // would block
+			return 0;
+		}
+
+		return -1;
+	}
+
+	for( i = 0; i < ret; i++ ) {
+		messages[i].readcount = 0;
+		messages[i].cursize = 0;
+
+		if( !SockaddressToAddress( (struct sockaddr*)&from[i], &addresses[i] ) ) {
+			continue;
+		}
+
+		if( headers[i].msg_len == messages[i].maxsize || ( headers[i].msg_hdr.msg_flags & MSG_TRUNC ) ) {
+			NET_SetErrorString( "Oversized packet" );
+			continue;
+		}
+
+		messages[i].cursize = headers[i].msg_len;
+	}
+
+	return ret;
+}
+
+/*
+* NET_FlushQueuedPackets
+*/
+static void NET_FlushQueuedPackets( void ) {
+	struct mmsghdr headers[MAX_BATCHED_PACKETS];
+	struct iovec iovecs[MAX_BATCHED_PACKETS];
+	int i, start, end, ret;
+
+	for( i = 0; i < numQueuedPackets; i++ ) {
+		queued_packet_t *packet = &queuedPackets[i];
+		iovecs[i].iov_base = packet->data;
+		iovecs[i].iov_len = packet->length;
+		memset( &headers[i], 0, sizeof( headers[i] ) );
+		headers[i].msg_hdr.msg_name = &packet->address;
+		headers[i].msg_hdr.msg_namelen = packet->addrlen;
+		headers[i].msg_hdr.msg_iov = &iovecs[i];
+		headers[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	// send spans of packets that go to the same socket
+	for( start = 0; start < numQueuedPackets; start = end ) {
+		for( end = start + 1; end < numQueuedPackets; end++ ) {
+			if( queuedPackets[end].handle != queuedPackets[start].handle ) {
+				break;
+			}
+		}
+		while( start < end ) {
+			ret = sendmmsg( queuedPackets[start].handle, headers + start, end - start, 0 );
+			if( ret == SOCKET_ERROR ) {
+				NET_SetErrorStringFromLastError( "sendmmsg" );
+				Com_Printf( "NET_FlushQueuedPackets: Error: %s\n", NET_ErrorString() );
+				// skip the failed packet
+				ret = 1;
+			}
+			start += wsw::max( ret, 1 );
+		}
+	}
+
+	numQueuedPackets = 0;
+}
+
+/*
+* NET_UDP_QueuePacket
+*/
+static void NET_UDP_QueuePacket( const socket_t *socket, const void *data, size_t length,
+								 const struct sockaddr_storage *addr, socklen_t addrlen ) {
+	queued_packet_t *packet;
+
+	assert( isBatchingSends && length <= MAX_PACKETLEN );
+
+	if( numQueuedPackets == MAX_BATCHED_PACKETS ) {
+		NET_FlushQueuedPackets();
+	}
+
+	packet = &queuedPackets[numQueuedPackets++];
+	packet->handle = socket->handle;
+	packet->address = *addr;
+	packet->addrlen = addrlen;
+	packet->length = length;
+	memcpy( packet->data, data, length );
+}
+#endif
+
 /*
 * NET_UDP_SendPacket
 */
@@ -394,6 +574,13 @@ static bool NET_UDP_SendPacket( const socket_t *socket, const void *data, size_t
 
 	addrlen = ( addr.ss_family == AF_INET6 ? sizeof( struct sockaddr_in6 ) : sizeof( struct sockaddr_in ) );
 
+#ifdef __linux__
+	if( isBatchingSends && length <= MAX_PACKETLEN ) {
+		NET_UDP_QueuePacket( socket, data, length, &addr, addrlen );
+		return true;
+	}
+#endif
+
 #ifndef _WIN32
 	ssize_t res = ::sendto( socket->handle, data, length, 0, (struct sockaddr *)&addr, addrlen );
 #else
@@ -524,6 +711,12 @@ static int NET_TCP_Get( const socket_t *socket, netadr_t *address, void *data, s
 		return -1;
 	}
 
+	// the connection has been closed on the other end (don't confuse it with a would-block condition)
+	if( ret == 0 ) {
+		NET_SetErrorString( "Connection closed" );
+		return -1;
+	}
+
 	if( address ) {
 		*address = socket->remoteAddress;
 	}
@@ -1005,6 +1198,76 @@ int NET_GetPacket( const socket_t *socket, netadr_t *address, msg_t *message ) {
 	}
 }
 
+/*
+* NET_GetPackets
+*
+* Reads up to maxPackets packets using as few system calls as possible.
+* Returns the number of read packets, 0 if there's nothing ready, or -1 on error.
+* Packets that have been read but could not be accepted have zero cursize.
+*/
+int NET_GetPackets( const socket_t *socket, netadr_t *addresses, msg_t *messages, int maxPackets ) {
+	int i, ret;
+
+	assert( socket->open );
+
+	if( !socket->open ) {
+		return -1;
+	}
+
+#ifdef __linux__
+	if( socket->type == SOCKET_UDP ) {
+		return NET_UDP_GetPackets( socket, addresses, messages, maxPackets );
+	}
+#endif
+
+	for( i = 0; i < maxPackets; i++ ) {
+		ret = NET_GetPacket( socket, &addresses[i], &messages[i] );
+		if( ret == 0 ) {
+			break;
+		}
+		if( ret < 0 ) {
+			if( !i ) {
+				return -1;
+			}
+			messages[i].readcount = 0;
+			messages[i].cursize = 0;
+		}
+	}
+
+	return i;
+}
+
+/*
+* NET_BeginSendBatch
+*
+* Makes UDP packets sent by this thread get queued until NET_FlushSendBatch() is called.
+* Send errors of queued packets are not reported to callers of NET_SendPacket().
+*/
+void NET_BeginSendBatch( void ) {
+#ifdef __linux__
+	assert( !isBatchingSends );
+	assert( !numQueuedPackets );
+
+	if( !queuedPackets ) {
+		queuedPackets = (queued_packet_t *)Q_malloc( sizeof( queued_packet_t ) * MAX_BATCHED_PACKETS );
+	}
+
+	isBatchingSends = true;
+#endif
+}
+
+/*
+* NET_FlushSendBatch
+*/
+void NET_FlushSendBatch( void ) {
+#ifdef __linux__
+	assert( isBatchingSends );
+
+	NET_FlushQueuedPackets();
+	isBatchingSends = false;
+#endif
+}
+
 /*
 * NET_Get
 *
@@ -1739,11 +2002,13 @@ void NET_CloseSocket( socket_t *socket ) {
 
 		case SOCKET_UDP:
 			NET_UDP_CloseSocket( socket );
+			socketsCloseCounter++;
 			break;
 
 #ifdef TCP_SUPPORT
 		case SOCKET_TCP:
 			NET_TCP_CloseSocket( socket );
+			socketsCloseCounter++;
 			break;
 #endif
 
@@ -1775,6 +2040,68 @@ int NET_SetSocketNoDelay( socket_t *socket, int nodelay ) {
 	return 0;
 }
 
+#ifdef __linux__
+/*
+* SleepSocketsSet::sync
+*
+* Updates the epoll set if sockets differ from the last call.
+* Returns false if the set cannot be used for given sockets.
+*/
+bool SleepSocketsSet::sync( socket_t *sockets[] ) {
+	int i, numSockets;
+	bool isUpToDate;
+
+	for( numSockets = 0; sockets[numSockets]; numSockets++ ) {
+		if( numSockets == MAX_SLEEP_SOCKETS ) {
+			return false;
+		}
+		switch( sockets[numSockets]->type ) {
+			case SOCKET_UDP:
+#ifdef TCP_SUPPORT
+			case SOCKET_TCP:
+#endif
+				break;
+			default:
+				return false;
+		}
+	}
+
+	// closed handles get removed from the set by the kernel, and might be reused by new sockets
+	isUpToDate = m_epollFd >= 0 && numSockets == m_numHandles && m_closeCounter == socketsCloseCounter;
+	for( i = 0; i < numSockets && isUpToDate; i++ ) {
+		isUpToDate = sockets[i]->handle == m_handles[i];
+	}
+	if( isUpToDate ) {
+		return true;
+	}
+
+	if( m_epollFd >= 0 ) {
+		close( m_epollFd );
+	}
+	m_numHandles = 0;
+	m_closeCounter = socketsCloseCounter;
+	m_epollFd = epoll_create1( EPOLL_CLOEXEC );
+	if( m_epollFd < 0 ) {
+		return false;
+	}
+
+	for( i = 0; i < numSockets; i++ ) {
+		struct epoll_event event;
+		memset( &event, 0, sizeof( event ) );
+		event.events = EPOLLIN;
+		event.data.fd = sockets[i]->handle;
+		if( epoll_ctl( m_epollFd, EPOLL_CTL_ADD, sockets[i]->handle, &event ) < 0 ) {
+			close( m_epollFd );
+			m_epollFd = -1;
+			return false;
+		}
+		m_handles[m_numHandles++] = sockets[i]->handle;
+	}
+
+	return true;
+}
+#endif
+
 /*
 * NET_Sleep
 */
@@ -1787,6 +2114,13 @@ void NET_Sleep( int msec, socket_t *sockets[] ) {
 		return;
 	}
 
+#ifdef __linux__
+	if( sleepSocketsSet.sync( sockets ) ) {
+		sleepSocketsSet.wait( msec );
+		return;
+	}
+#endif
+
 	FD_ZERO( &fdset );
 
 	for( i = 0; sockets[i]; i++ ) {
@@ -1902,6 +2236,201 @@ int NET_Monitor( int msec, socket_t *sockets[], void ( *read_cb )( socket_t *, v
 	return ret;
 }
 
+#define MAX_POLLED_EVENTS 64
+
+/*
+* A persistent set of TCP/UDP sockets that are watched for readiness.
+* It's backed by an edge-triggered epoll set on Linux, so callers must
+* read/write until the socket would block before expecting further events.
+* Elsewhere, the set is checked using select() on every NET_Poll() call.
+*/
+struct net_poller_s {
+#ifdef __linux__
+	int epollFd;
+#else
+	int numSockets;
+	socket_t *sockets[FD_SETSIZE];
+	void *privatep[FD_SETSIZE];
+	bool wantWrite[FD_SETSIZE];
+#endif
+};
+
+/*
+* NET_CreatePoller
+*/
+net_poller_t *NET_CreatePoller( void ) {
+	auto *poller = (net_poller_t *)Q_malloc( sizeof( net_poller_t ) );
+#ifdef __linux__
+	poller->epollFd = epoll_create1( EPOLL_CLOEXEC );
+	if( poller->epollFd < 0 ) {
+		NET_SetErrorStringFromLastError( "epoll_create1" );
+		Q_free( poller );
+		return NULL;
+	}
+#endif
+	return poller;
+}
+
+/*
+* NET_DestroyPoller
+*/
+void NET_DestroyPoller( net_poller_t *poller ) {
+#ifdef __linux__
+	close( poller->epollFd );
+#endif
+	Q_free( poller );
+}
+
+/*
+* NET_AddToPoller
+*
+* The socket must stay at the same address until it gets removed from the poller
+*/
+bool NET_AddToPoller( net_poller_t *poller, socket_t *socket, void *privatep ) {
+	assert( socket->open && socket->type != SOCKET_LOOPBACK );
+#ifdef __linux__
+	struct epoll_event event;
+	memset( &event, 0, sizeof( event ) );
+	event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+	event.data.ptr = privatep;
+	if( epoll_ctl( poller->epollFd, EPOLL_CTL_ADD, socket->handle, &event ) < 0 ) {
+		NET_SetErrorStringFromLastError( "epoll_ctl" );
+		return false;
+	}
+#else
+	if( poller->numSockets == FD_SETSIZE ) {
+		NET_SetErrorString( "Too many polled sockets" );
+		return false;
+	}
+	poller->sockets[poller->numSockets] = socket;
+	poller->privatep[poller->numSockets] = privatep;
+	poller->wantWrite[poller->numSockets] = false;
+	poller->numSockets++;
+#endif
+	return true;
+}
+
+/*
+* NET_RemoveFromPoller
+*
+* Should be called before closing the socket
+*/
+void NET_RemoveFromPoller( net_poller_t *poller, socket_t *socket ) {
+#ifdef __linux__
+	if( socket->open ) {
+		epoll_ctl( poller->epollFd, EPOLL_CTL_DEL, socket->handle, NULL );
+	}
+#else
+	for( int i = 0; i < poller->numSockets; i++ ) {
+		if( poller->sockets[i] == socket ) {
+			const int last = --poller->numSockets;
+			poller->sockets[i] = poller->sockets[last];
+			poller->privatep[i] = poller->privatep[last];
+			poller->wantWrite[i] = poller->wantWrite[last];
+			break;
+		}
+	}
+#endif
+}
+
+/*
+* NET_SetPollerWriteInterest
+*
+* Edge-triggered pollers always report transitions to the writable state,
+* others report writability of a socket only if it has been requested.
+*/
+void NET_SetPollerWriteInterest( net_poller_t *poller, socket_t *socket, bool wantWrite ) {
+#ifndef __linux__
+	for( int i = 0; i < poller->numSockets; i++ ) {
+		if( poller->sockets[i] == socket ) {
+			poller->wantWrite[i] = wantWrite;
+			break;
+		}
+	}
+#endif
+}
+
+/*
+* NET_Poll
+*
+* Waits for readiness of sockets of the poller for the given timeout in milliseconds
+* and calls the callback with the private pointer of each ready socket and NET_POLL_* flags.
+* Hang-ups and errors are reported as readability, so a subsequent read fails.
+* Returns the number of ready sockets or -1 on error.
+*/
+int NET_Poll( net_poller_t *poller, int msec, void ( *event_cb )( void *privatep, int events ) ) {
+#ifdef __linux__
+	struct epoll_event events[MAX_POLLED_EVENTS];
+	const int ret = epoll_wait( poller->epollFd, events, MAX_POLLED_EVENTS, msec );
+	if( ret < 0 ) {
+		if( errno != EINTR ) {
+			NET_SetErrorStringFromLastError( "epoll_wait" );
+			return -1;
+		}
+		return 0;
+	}
+
+	for( int i = 0; i < ret; i++ ) {
+		int flags = 0;
+		if( events[i].events & ( EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR ) ) {
+			flags |= NET_POLL_READ;
+		}
+		if( events[i].events & EPOLLOUT ) {
+			flags |= NET_POLL_WRITE;
+		}
+		event_cb( events[i].data.ptr, flags );
+	}
+	return ret;
+#else
+	struct timeval timeout;
+	fd_set fdsetr, fdsetw;
+	int fdmax = 0;
+
+	FD_ZERO( &fdsetr );
+	FD_ZERO( &fdsetw );
+
+	for( int i = 0; i < poller->numSockets; i++ ) {
+		const socket_t *socket = poller->sockets[i];
+		fdmax = wsw::max( (int)socket->handle, fdmax );
+		FD_SET( socket->handle, &fdsetr );
+		if( poller->wantWrite[i] ) {
+			FD_SET( socket->handle, &fdsetw );
+		}
+	}
+
+	timeout.tv_sec = msec / 1000;
+	timeout.tv_usec = ( msec % 1000 ) * 1000;
+	const int ret = select( fdmax + 1, &fdsetr, &fdsetw, NULL, &timeout );
+	if( ret <= 0 ) {
+		return ret;
+	}
+
+	// Callbacks may modify the set, collect ready sockets first
+	int numReady = 0;
+	int readyFlags[FD_SETSIZE];
+	void *readyPrivatep[FD_SETSIZE];
+	for( int i = 0; i < poller->numSockets; i++ ) {
+		int flags = 0;
+		if( FD_ISSET( poller->sockets[i]->handle, &fdsetr ) ) {
+			flags |= NET_POLL_READ;
+		}
+		if( FD_ISSET( poller->sockets[i]->handle, &fdsetw ) ) {
+			flags |= NET_POLL_WRITE;
+		}
+		if( flags ) {
+			readyFlags[numReady] = flags;
+			readyPrivatep[numReady] = poller->privatep[i];
+			numReady++;
+		}
+	}
+
+	for( int i = 0; i < numReady; i++ ) {
+		event_cb( readyPrivatep[i], readyFlags[i] );
+	}
+	return numReady;
+#endif
+}
+
 /*
 * NET_SendFile
 */
@@ -1964,6 +2493,11 @@ void NET_Shutdown( void ) {
 
 	errorstring[0] = '\0';
 
+#ifdef __linux__
+	Q_free( queuedPackets );
+	queuedPackets = NULL;
+#endif
+
 	Sys_NET_Shutdown();
 
 	net_initialized = false;
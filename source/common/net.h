@@ -94,8 +94,12 @@ int         NET_Accept( const socket_t *socket, socket_t *newsocket, netadr_t *a
 #endif
 
 int         NET_GetPacket( const socket_t *socket, netadr_t *address, struct msg_s *message );
+int         NET_GetPackets( const socket_t *socket, netadr_t *addresses, struct msg_s *messages, int maxPackets );
 bool        NET_SendPacket( const socket_t *socket, const void *data, size_t length, const netadr_t *address );
 
+void        NET_BeginSendBatch( void );
+void        NET_FlushSendBatch( void );
+
 int         NET_Get( const socket_t *socket, netadr_t *address, void *data, size_t length );
 int         NET_Send( const socket_t *socket, const void *data, size_t length, const netadr_t *address );
 int64_t     NET_SendFile( const socket_t *socket, int file, size_t offset, size_t count, const netadr_t *address );
@@ -105,6 +109,19 @@ int         NET_Monitor( int msec, socket_t *sockets[],
 						 void ( *read_cb )( socket_t *socket, void* ),
 						 void ( *write_cb )( socket_t *socket, void* ),
 						 void ( *exception_cb )( socket_t *socket, void* ), void *privatep[] );
+
+#define NET_POLL_READ   1
+#define NET_POLL_WRITE  2
+
+typedef struct net_poller_s net_poller_t;
+
+net_poller_t *NET_CreatePoller( void );
+void        NET_DestroyPoller( net_poller_t *poller );
+bool        NET_AddToPoller( net_poller_t *poller, socket_t *socket, void *privatep );
+void        NET_RemoveFromPoller( net_poller_t *poller, socket_t *socket );
+void        NET_SetPollerWriteInterest( net_poller_t *poller, socket_t *socket, bool wantWrite );
+int         NET_Poll( net_poller_t *poller, int msec, void ( *event_cb )( void *privatep, int events ) );
+
 const char *NET_ErrorString( void );
 
 #ifndef _MSC_VER
@@ -127,6 +144,7 @@ void            NET_SetAddressPort( netadr_t *address, unsigned short port );
 
 bool    NET_CompareAddress( const netadr_t *a, const netadr_t *b );
 bool    NET_CompareBaseAddress( const netadr_t *a, const netadr_t *b );
+uint32_t NET_AddressHash( const netadr_t &address );
 bool    NET_IsLANAddress( const netadr_t *address );
 bool    NET_IsLocalAddress( const netadr_t *address );
 bool    NET_IsAnyAddress( const netadr_t *address );
@@ -12,6 +12,8 @@ using wsw::operator""_asView;
 const BoolConfigVar v_evolution { "ai_evolution"_asView, { .byDefault = false, .flags = 0, } };
 const BoolConfigVar v_debugOutput { "ai_debugOutput"_asView, { .byDefault = false, .flags = 0, } };
 const BoolConfigVar v_shareRoutingCache { "ai_shareRoutingCache"_asView, { .byDefault = true, .flags = 0, } };
+const BoolConfigVar v_parallelThinking { "ai_parallelThinking"_asView, { .byDefault = false, .flags = 0, } };
+const UnsignedConfigVar v_routeCacheBudget { "ai_routeCacheBudget"_asView, { .byDefault = 64, .min = inclusive( 4u ), .flags = 0, } };
 const StringConfigVar v_forceWeapon { "ai_forceWeapon"_asView, { .byDefault = {}, .flags = CVAR_CHEAT, } };
 
 ai_weapon_aim_type BuiltinWeaponAimType( int builtinWeapon, int fireMode ) {
@@ -141,6 +143,16 @@ void AI_FailWithv( const char *tag, const char *format, va_list va ) {
 	abort();
 }
 
+unsigned AI_SuggestNumExtraThreadsForComputations() {
+	unsigned numPhysicalProcessors = 0, numLogicalProcessors = 0;
+	if( Sys_GetNumberOfProcessors( &numPhysicalProcessors, &numLogicalProcessors ) && numPhysicalProcessors ) {
+		// Take the current thread (which also acts as a worker thread for the task system) into account.
+		return numPhysicalProcessors - 1;
+	}
+	// Use only the current thread.
+	return 0;
+}
+
 void AITools_DrawLine( const vec3_t origin, const vec3_t dest ) {
 	edict_t *event;
 
@@ -415,6 +427,10 @@ void AI_RemoveBots() {
 	AiManager::Instance()->AfterLevelScriptShutdown();
 }
 
+void AI_PrintRouteCacheStats() {
+	AiAasRouteCache::PrintStats();
+}
+
 void AI_Cheat_NoTarget( edict_t *ent, const CmdArgs & ) {
 	if( !sv_cheats->integer ) {
 		return;
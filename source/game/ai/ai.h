@@ -101,5 +101,6 @@ void        AI_RemoveBots();
 void        AI_Respawn( edict_t *ent );
 
 void        AI_Cheat_NoTarget( edict_t *ent, const CmdArgs & );
+void        AI_PrintRouteCacheStats();
 
 #endif
\ No newline at end of file
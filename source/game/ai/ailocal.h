@@ -132,6 +132,11 @@ __declspec( noreturn ) void AI_FailWith( const char *tag, _Printf_format_string_
 __declspec( noreturn ) void AI_FailWithv( const char *tag, const char *format, va_list va );
 #endif
 
+/**
+ * Suggests a number of threads in addition to the current one for precomputation of navigation data.
+ */
+unsigned AI_SuggestNumExtraThreadsForComputations();
+
 inline float Clamp( float value ) {
 	Q_clamp( value, 0.0f, 1.0f );
 	return value;
@@ -348,6 +353,8 @@ public:
 extern const BoolConfigVar v_evolution;
 extern const BoolConfigVar v_debugOutput;
 extern const BoolConfigVar v_shareRoutingCache;
+extern const BoolConfigVar v_parallelThinking;
+extern const UnsignedConfigVar v_routeCacheBudget;
 extern const StringConfigVar v_forceWeapon;
 
 #define aiDebug()   wsw::PendingOutputMessage( wsw::createMessageStream( wsw::MessageDomain::AI, wsw::MessageCategory::Debug ) ).getWriter()
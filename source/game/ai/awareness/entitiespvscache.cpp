@@ -1,5 +1,7 @@
 #include "entitiespvscache.h"
 
+#include <atomic>
+
 EntitiesPvsCache EntitiesPvsCache::instance;
 
 bool EntitiesPvsCache::AreInPvs( const edict_t *ent1, const edict_t *ent2 ) const {
@@ -13,7 +15,9 @@ bool EntitiesPvsCache::AreInPvs( const edict_t *ent1, const edict_t *ent2 ) cons
 	// An offset of entity bits inside a 32-bit array cell
 	unsigned ent2BitsOffset = ( entNum2 * 2 ) % 32;
 
-	unsigned ent2Bits = ( ent1Vis[ent2ArrayOffset] >> ent2BitsOffset ) & 0x3;
+	// Bots may think in parallel. Bits of a pair are only set once a frame and always to the same value,
+	// so relaxed atomic loads and ORs are sufficient for the concurrent access.
+	unsigned ent2Bits = ( std::atomic_ref<uint32_t>( ent1Vis[ent2ArrayOffset] ).load( std::memory_order_relaxed ) >> ent2BitsOffset ) & 0x3;
 	if( ent2Bits != 0 ) {
 		// If 2, return true, if 1, return false. Masking with & 1 should help a compiler to avoid branches here
 		return (bool)( ( ent2Bits - 1 ) & 1 );
@@ -33,12 +37,9 @@ bool EntitiesPvsCache::AreInPvs( const edict_t *ent1, const edict_t *ent2 ) cons
 	ent1Bits <<= ent1BitsOffset;
 	ent2Bits <<= ent2BitsOffset;
 
-	// Clear old bits in array cells
-	ent1Vis[ent2ArrayOffset] &= ~ent2Bits;
-	ent2Vis[ent1ArrayOffset] &= ~ent1Bits;
-	// Set new bits in array cells
-	ent1Vis[ent2ArrayOffset] |= ent2Bits;
-	ent2Vis[ent1ArrayOffset] |= ent1Bits;
+	// Set new bits in array cells (old bits are known to be cleared)
+	std::atomic_ref<uint32_t>( ent1Vis[ent2ArrayOffset] ).fetch_or( ent2Bits, std::memory_order_relaxed );
+	std::atomic_ref<uint32_t>( ent2Vis[ent1ArrayOffset] ).fetch_or( ent1Bits, std::memory_order_relaxed );
 
 	return result;
 }
@@ -299,7 +299,7 @@ void Bot::OnRespawn() {
 	m_selectedNavEntity = std::nullopt;
 }
 
-void Bot::Update() {
+void Bot::PrepareToThink() {
 	// We should update weapons status each frame since script weapons may be changed each frame.
 	// These statuses are used by firing methods, so actual weapon statuses are required.
 	weaponsUsageModule.UpdateScriptWeaponsStatus();
@@ -325,8 +325,32 @@ void Bot::Update() {
 	if( level.spawnedTimeStamp + 5000 > game.realtime || !level.canSpawnEntities ) {
 		self->nextThink = level.time + game.snapFrameTime;
 	}
+}
+
+void Bot::Think() {
+	assert( !G_ISGHOSTING( self ) );
+
+	awarenessModule.Update();
+	// Awareness stuff must be up-to date for planning.
+	planner->Update();
+
+	weaponsUsageModule.Frame( planningModule.CachedWorldState() );
+
+	m_pendingClientThinkInput = BotInput {};
+
+	// Might modify botInput
+	m_movementSubsystem.Frame( std::addressof( *m_pendingClientThinkInput ) );
+}
+
+void Bot::Update() {
+	const bool hasThoughtInParallel = m_thoughtInParallelAtFrame == level.framenum;
+	if( !hasThoughtInParallel ) {
+		PrepareToThink();
+	}
 
 	if( G_ISGHOSTING( self ) ) {
+		m_pendingClientThinkInput = std::nullopt;
+
 		m_selectedEnemy = std::nullopt;
 		m_lostEnemy     = std::nullopt;
 
@@ -366,16 +390,12 @@ void Bot::Update() {
 			G_Match_Ready( self, {} );
 		}
 
-		awarenessModule.Update();
-		// Awareness stuff must be up-to date for planning.
-		planner->Update();
-
-		weaponsUsageModule.Frame( planningModule.CachedWorldState() );
-
-		m_pendingClientThinkInput = BotInput {};
+		if( !hasThoughtInParallel ) {
+			Think();
+		}
 
 		// Might modify botInput
-		m_movementSubsystem.Frame( std::addressof( *m_pendingClientThinkInput ) );
+		m_movementSubsystem.ExecPendingActionRecord( std::addressof( *m_pendingClientThinkInput ) );
 
 		CheckTargetProximity();
 
@@ -491,6 +491,19 @@ public:
 
 	void Update();
 
+	/**
+	 * Performs a part of {@code Update()} that must be executed on the main thread before {@code Think()}.
+	 */
+	void PrepareToThink();
+	/**
+	 * Performs a part of {@code Update()} that does not modify the world and other bots,
+	 * so it may be executed by different threads for different bots.
+	 * The produced input gets applied by a subsequent {@code Update()} call.
+	 */
+	void Think();
+
+	void SetThoughtInParallel() { m_thoughtInParallelAtFrame = level.framenum; }
+
 	bool PermitsDistributedUpdateThisFrame() const {
 		// Don't even try this kind of updates during ghosting frames
 		assert( !G_ISGHOSTING( self ) );
@@ -595,6 +608,8 @@ private:
 	BotWeaponsUsageModule weaponsUsageModule;
 
 	std::optional<BotInput> m_pendingClientThinkInput;
+	// A number of the frame when PrepareToThink() and Think() were called by AiManager
+	int64_t m_thoughtInParallelAtFrame { -1 };
 
 	static constexpr float DEFAULT_YAW_SPEED = 330.0f;
 	static constexpr float DEFAULT_PITCH_SPEED = 170.0f;
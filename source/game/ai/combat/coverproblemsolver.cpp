@@ -253,12 +253,13 @@ bool CoverProblemSolver::castRay( const float *from, const float *to, int topNod
 	// Test against blocking view entities first.
 	// Either number of these entities is low or we can cut off expensive long raycasts in the static world.
 
+	CMHullModelStorage hullStorage;
 	const auto *const gameEdicts = game.edicts;
 	for( int entNum: entNums ) {
 		const auto *ent = gameEdicts + entNum;
 
 		// TODO: Optimize using AABB/line intersection
-		const auto *model = SV_ModelForBBox( ent->r.mins, ent->r.maxs );
+		const auto *model = SV_ModelForBBox( ent->r.mins, ent->r.maxs, &hullStorage );
 		SV_TransformedBoxTrace( &trace, from, to, vec3_origin, vec3_origin, model,
 			                         MASK_SHOT, ent->s.origin, ent->s.angles, topNode );
 
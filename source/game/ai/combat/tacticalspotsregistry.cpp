@@ -4,12 +4,23 @@
 #include "../bot.h"
 #include "../../../common/links.h"
 
+#include <memory>
+
 typedef TacticalSpotsRegistry::SpotsQueryVector SpotsQueryVector;
 
 TacticalSpotsRegistry *TacticalSpotsRegistry::instance = nullptr;
 // An actual storage for an instance
 static wsw::StaticVector<TacticalSpotsRegistry, 1> instanceHolder;
 
+auto TacticalSpotsRegistry::threadQueryBuffers() -> QueryBuffers & {
+	// Buffers are large, allocate these only for threads that actually perform queries
+	static thread_local std::unique_ptr<QueryBuffers> buffers;
+	if( !buffers ) [[unlikely]] {
+		buffers = std::make_unique<QueryBuffers>();
+	}
+	return *buffers;
+}
+
 bool TacticalSpotsRegistry::Init( const char *mapname ) {
 	if( instance ) {
 		AI_FailWith( "TacticalSpotsRegistry::Init()", "The instance has been already initialized\n" );
@@ -120,18 +131,32 @@ bool TacticalSpotsRegistry::TryLoadPrecomputedData( const char *mapName ) {
 	char filePath[MAX_QPATH];
 	MakePrecomputedFilePath( filePath, sizeof( filePath ), mapName );
 
-	constexpr const char *function = "TacticalSpotsRegistry::TryLoadPrecomputedData()";
-
 	AiPrecomputedFileReader reader( "PrecomputedFileReader@TacticalSpotsRegistry",
 									PRECOMPUTED_DATA_VERSION, SpotsAlloc, SpotsFree );
 
-	uint32_t dataLength;
-	uint8_t *data;
-
 	if( reader.BeginReading( filePath ) != AiPrecomputedFileReader::SUCCESS ) {
 		return false;
 	}
 
+	if( !LoadPrecomputedData( reader ) ) {
+		// Tables that point to the mapped data become invalid along with the reader
+		if( reader.IsMapped() ) {
+			spotsAndAreasTravelTimeTable = nullptr;
+			spotVisibilityTable = nullptr;
+		}
+		return false;
+	}
+
+	precomputedDataMapping = reader.ReleaseMapping();
+	return true;
+}
+
+bool TacticalSpotsRegistry::LoadPrecomputedData( AiPrecomputedFileReader &reader ) {
+	constexpr const char *function = "TacticalSpotsRegistry::LoadPrecomputedData()";
+
+	uint32_t dataLength;
+	uint8_t *data;
+
 	// Read spots
 	if( !reader.ReadLengthAndData( &data, &dataLength ) ) {
 		return false;
@@ -143,25 +168,28 @@ bool TacticalSpotsRegistry::TryLoadPrecomputedData( const char *mapName ) {
 	spots = (TacticalSpot *)data;
 	numSpots = dataLength / sizeof( TacticalSpot );
 
+	// Tables are large, use these in place if the file is mapped
+	const uint8_t *tableData;
+
 	// Read spots travel time table
-	if( !reader.ReadLengthAndData( &data, &dataLength ) ) {
+	if( !reader.MapLengthAndData( &tableData, &dataLength ) ) {
 		return false;
 	}
 
 	const auto numAasAreas = (int)AiAasWorld::instance()->getAreas().size();
 
-	spotsAndAreasTravelTimeTable = (uint16_t *)data;
+	spotsAndAreasTravelTimeTable = (const uint16_t *)tableData;
 	if( ( dataLength / sizeof( uint16_t ) ) != 2 * numSpots * numAasAreas ) {
 		G_Printf( S_COLOR_RED "%s: Travel time table size does not match the number of spots and areas\n", function );
 		return false;
 	}
 
 	// Read spots visibility table
-	if( !reader.ReadLengthAndData( &data, &dataLength ) ) {
+	if( !reader.MapLengthAndData( &tableData, &dataLength ) ) {
 		return false;
 	}
 
-	spotVisibilityTable = (uint8_t *)data;
+	spotVisibilityTable = tableData;
 	if( dataLength / sizeof( uint8_t ) != numSpots * numSpots ) {
 		G_Printf( S_COLOR_RED "%s: Spots visibility table size does not match the number of spots\n", function );
 		return false;
@@ -183,9 +211,12 @@ bool TacticalSpotsRegistry::TryLoadPrecomputedData( const char *mapName ) {
 		}
 	}
 
-	// Byte swap and travel times
-	for( unsigned i = 0; i < numSpots * numAasAreas; ++i ) {
-		spotsAndAreasTravelTimeTable[i] = LittleShort( spotsAndAreasTravelTimeTable[i] );
+	// Byte swap and travel times (the mapped data does not need that and is read-only)
+	if( !reader.IsMapped() ) {
+		auto *const travelTimes = const_cast<uint16_t *>( spotsAndAreasTravelTimeTable );
+		for( unsigned i = 0; i < numSpots * numAasAreas; ++i ) {
+			travelTimes[i] = LittleShort( travelTimes[i] );
+		}
 	}
 
 	// Spot visibility does not need neither byte swap nor validation being just an unsigned byte
@@ -291,10 +322,11 @@ void TacticalSpotsRegistry::SavePrecomputedData( const char *mapName ) {
 
 	const auto numAreas = (int)AiAasWorld::instance()->getAreas().size();
 
-	// Byte swap travel times
+	// Byte swap travel times (the saved table has been computed and is owned by this object)
 	static_assert( sizeof( *spotsAndAreasTravelTimeTable ) == 2, "LittleShort() is not applicable" );
+	auto *const travelTimes = const_cast<uint16_t *>( spotsAndAreasTravelTimeTable );
 	for( unsigned i = 0, end = 2 * numSpots * numAreas; i < end; ++i ) {
-		spotsAndAreasTravelTimeTable[i] = LittleShort( spotsAndAreasTravelTimeTable[i] );
+		travelTimes[i] = LittleShort( travelTimes[i] );
 	}
 
 	dataLength = 2 * numSpots * numAreas * sizeof( *spotsAndAreasTravelTimeTable );
@@ -303,7 +335,7 @@ void TacticalSpotsRegistry::SavePrecomputedData( const char *mapName ) {
 	}
 
 	// Prevent using byte-swapped travel times table
-	Q_free( spotsAndAreasTravelTimeTable );
+	Q_free( travelTimes );
 	spotsAndAreasTravelTimeTable = nullptr;
 
 	static_assert( sizeof( *spotVisibilityTable ) == 1, "Byte swapping is required" );
@@ -313,7 +345,7 @@ void TacticalSpotsRegistry::SavePrecomputedData( const char *mapName ) {
 	}
 
 	// Release the data for conformance with the rest of the saved data
-	Q_free( spotVisibilityTable );
+	Q_free( (void *)spotVisibilityTable );
 	spotVisibilityTable = nullptr;
 
 	spotsGrid.Save( writer );
@@ -367,6 +399,8 @@ void TacticalSpotsRegistry::Shutdown() {
 	instance = nullptr;
 }
 
+TacticalSpotsRegistry::TacticalSpotsRegistry(): spotsGrid( this ) {}
+
 TacticalSpotsRegistry::~TacticalSpotsRegistry() {
 	if( needsSavingPrecomputedData ) {
 		SavePrecomputedData( level.mapname );
@@ -377,11 +411,14 @@ TacticalSpotsRegistry::~TacticalSpotsRegistry() {
 	if( spots ) {
 		Q_free( spots );
 	}
-	if( spotVisibilityTable ) {
-		Q_free( spotVisibilityTable );
-	}
-	if( spotsAndAreasTravelTimeTable ) {
-		Q_free( spotsAndAreasTravelTimeTable );
+	// The tables are released along with the mapping otherwise
+	if( !precomputedDataMapping ) {
+		if( spotVisibilityTable ) {
+			Q_free( (void *)spotVisibilityTable );
+		}
+		if( spotsAndAreasTravelTimeTable ) {
+			Q_free( (void *)spotsAndAreasTravelTimeTable );
+		}
 	}
 }
 
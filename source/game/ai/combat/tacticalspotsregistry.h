@@ -8,6 +8,10 @@
 #include "../../../common/links.h"
 #include "../../../common/podbufferholder.h"
 
+#include <memory>
+
+class AiPrecomputedFileMapping;
+
 enum class SpotSortCriterion {
 	GenericScore,
 	OriginDistance,
@@ -144,31 +148,41 @@ public:
 	using CriteriaScoresVector = wsw::StaticVector<CriteriaScores, MAX_SPOTS>;
 
 	SpotsQueryVector &cleanAndGetSpotsQueryVector() const {
-		spotsQueryVectorHolder.clear();
-		return spotsQueryVectorHolder;
+		QueryBuffers &buffers = threadQueryBuffers();
+		buffers.spotsQueryVector.clear();
+		return buffers.spotsQueryVector;
 	}
 	SpotsAndScoreVector &cleanAndGetSpotsAndScoreVector() const {
-		spotsAndScoreVectorHolder.clear();
-		return spotsAndScoreVectorHolder;
+		QueryBuffers &buffers = threadQueryBuffers();
+		buffers.spotsAndScoreVector.clear();
+		return buffers.spotsAndScoreVector;
 	}
 	OriginAndScoreVector &cleanAndGetOriginAndScoreVector() const {
-		originAndScoreVectorHolder.clear();
-		return originAndScoreVectorHolder;
+		QueryBuffers &buffers = threadQueryBuffers();
+		buffers.originAndScoreVector.clear();
+		return buffers.originAndScoreVector;
 	}
 	CriteriaScoresVector &cleanAndGetCriteriaScoresVector() const {
-		criteriaScoresVectorHolder.clear();
-		return criteriaScoresVectorHolder;
+		QueryBuffers &buffers = threadQueryBuffers();
+		buffers.criteriaScoresVector.clear();
+		return buffers.criteriaScoresVector;
 	}
 	bool *cleanAndGetExcludedSpotsMask() const {
-		return excludedSpotsMaskHolder.reserveZeroedAndGet( MAX_SPOTS );
+		return threadQueryBuffers().excludedSpotsMask.reserveZeroedAndGet( MAX_SPOTS );
 	}
 private:
-	// TODO: Move all this stuff to some helper object?
-	mutable SpotsQueryVector spotsQueryVectorHolder;
-	mutable SpotsAndScoreVector spotsAndScoreVectorHolder;
-	mutable OriginAndScoreVector originAndScoreVectorHolder;
-	mutable CriteriaScoresVector criteriaScoresVectorHolder;
-	mutable PodBufferHolder<bool> excludedSpotsMaskHolder;
+	struct QueryBuffers {
+		SpotsQueryVector spotsQueryVector;
+		SpotsAndScoreVector spotsAndScoreVector;
+		OriginAndScoreVector originAndScoreVector;
+		CriteriaScoresVector criteriaScoresVector;
+		PodBufferHolder<bool> excludedSpotsMask;
+	};
+
+	/**
+	 * Bots may query spots while thinking in parallel, so every thread uses its own query temporaries.
+	 */
+	static QueryBuffers &threadQueryBuffers();
 
 	static constexpr uint16_t MAX_SPOTS_PER_QUERY = 768;
 	static constexpr uint16_t MIN_GRID_CELL_SIDE = 512;
@@ -180,7 +194,7 @@ private:
 	// 0 if spot origins and bounds are completely invisible for each other
 	// ...
 	// 255 if spot origins and bounds are completely visible for each other
-	uint8_t *spotVisibilityTable { nullptr };
+	const uint8_t *spotVisibilityTable { nullptr };
 	// Contains a 2-dimensional array of travel time pairs ("from spot to area", "from area to spot").
 	// An every cell has two values and the total number of short elements is 2 * numAreas * numSpots.
 	// An outer index corresponds to an area number.
@@ -189,7 +203,10 @@ private:
 	// Thus a path might not exist for a particular bot as individual route caches usually have additional restrictions.
 	// Regardless of that values of this table are very useful for cutting off
 	// non-feasible spots/areas before making expensive actual routing calls.
-	uint16_t *spotsAndAreasTravelTimeTable { nullptr };
+	const uint16_t *spotsAndAreasTravelTimeTable { nullptr };
+
+	// Owns the tables above if these are used in place of the loaded file
+	std::unique_ptr<AiPrecomputedFileMapping> precomputedDataMapping;
 
 	unsigned numSpots { 0 };
 
@@ -297,7 +314,7 @@ private:
 
 	static TacticalSpotsRegistry *instance;
 
-	TacticalSpotsRegistry(): spotsGrid( this ) {}
+	TacticalSpotsRegistry();
 public:
 
 	~TacticalSpotsRegistry();
@@ -306,6 +323,7 @@ public:
 
 private:
 	bool TryLoadPrecomputedData( const char *mapname );
+	bool LoadPrecomputedData( class AiPrecomputedFileReader &reader );
 	void SavePrecomputedData( const char *mapname );
 
 	SpotsQueryVector &FindSpotsInRadius( const OriginParams &originParams, uint16_t *insideSpotNum ) const {
@@ -1,6 +1,7 @@
 #include "groundtracecache.h"
 #include "../../common/wswstaticvector.h"
 #include "ailocal.h"
+#include "../../common/qthreads.h"
 
 struct CachedTrace {
 	trace_t trace;
@@ -34,71 +35,84 @@ void AiGroundTraceCache::Shutdown() {
 	}
 }
 
-void AiGroundTraceCache::GetGroundTrace( const edict_s *ent, float depth, trace_t *trace, uint64_t maxMillisAgo ) {
+/**
+ * Bots may think in parallel, so cache entries are accessed under the lock.
+ * Traces are computed outside of it, a concurrent computation just yields the same result.
+ */
+static wsw::Mutex groundTraceCacheMutex;
+
+static bool FetchCachedTrace( const CachedTrace *cachedTraces, int entNum, float depth,
+							  uint64_t maxMillisAgo, CachedTrace *result ) {
+	[[maybe_unused]] wsw::ScopedLock<wsw::Mutex> lock( &groundTraceCacheMutex );
+	const CachedTrace &cachedTrace = cachedTraces[entNum];
+	if( (int64_t)( cachedTrace.computedAt + maxMillisAgo ) >= level.time && cachedTrace.depth >= depth ) {
+		*result = cachedTrace;
+		return true;
+	}
+	return false;
+}
+
+static void ComputeAndCacheTrace( CachedTrace *cachedTraces, const edict_t *ent, float depth, CachedTrace *result ) {
 	edict_t *entRef = const_cast<edict_t *>( ent );
-	CachedTrace *cachedTrace = (CachedTrace *)data + ENTNUM( entRef );
-
-	if( (int64_t)( cachedTrace->computedAt + maxMillisAgo ) >= level.time ) {
-		if( cachedTrace->depth >= depth ) {
-			trace->startsolid = cachedTrace->trace.startsolid;
-			if( cachedTrace->trace.fraction == 1.0f ) {
-				trace->fraction = 1.0f;
-				return;
-			}
-			float cachedHitDepth = cachedTrace->depth * cachedTrace->trace.fraction;
-			if( cachedHitDepth > depth ) {
-				trace->fraction = 1.0f;
-				return;
-			}
-			// Copy trace data
-			*trace = cachedTrace->trace;
-			// Recalculate result fraction
-			trace->fraction = cachedHitDepth / depth;
+	vec3_t end = { ent->s.origin[0], ent->s.origin[1], ent->s.origin[2] - depth };
+	G_Trace( &result->trace, entRef->s.origin, nullptr, nullptr, end, entRef, MASK_AISOLID );
+	result->depth = depth;
+	result->computedAt = level.time;
+
+	[[maybe_unused]] wsw::ScopedLock<wsw::Mutex> lock( &groundTraceCacheMutex );
+	cachedTraces[ENTNUM( entRef )] = *result;
+}
+
+void AiGroundTraceCache::GetGroundTrace( const edict_s *ent, float depth, trace_t *trace, uint64_t maxMillisAgo ) {
+	CachedTrace cachedTrace;
+	if( FetchCachedTrace( (CachedTrace *)data, ENTNUM( ent ), depth, maxMillisAgo, &cachedTrace ) ) {
+		trace->startsolid = cachedTrace.trace.startsolid;
+		if( cachedTrace.trace.fraction == 1.0f ) {
+			trace->fraction = 1.0f;
+			return;
+		}
+		float cachedHitDepth = cachedTrace.depth * cachedTrace.trace.fraction;
+		if( cachedHitDepth > depth ) {
+			trace->fraction = 1.0f;
 			return;
 		}
+		// Copy trace data
+		*trace = cachedTrace.trace;
+		// Recalculate result fraction
+		trace->fraction = cachedHitDepth / depth;
+		return;
 	}
 
-	vec3_t end = { ent->s.origin[0], ent->s.origin[1], ent->s.origin[2] - depth };
-	G_Trace( &cachedTrace->trace, entRef->s.origin, nullptr, nullptr, end, entRef, MASK_AISOLID );
+	ComputeAndCacheTrace( (CachedTrace *)data, ent, depth, &cachedTrace );
 	// Copy trace data
-	*trace = cachedTrace->trace;
-	cachedTrace->depth = depth;
-	cachedTrace->computedAt = level.time;
-	return;
+	*trace = cachedTrace.trace;
 }
 
-// Uses the same algorithm as GetGroundTrace() but avoids trace result copying and thus a is a bit faster.
+// Uses the same algorithm as GetGroundTrace() but yields just a point above the floor.
 bool AiGroundTraceCache::TryDropToFloor( const struct edict_s *ent, float depth, vec3_t result, uint64_t maxMillisAgo ) {
-	edict_t *entRef = const_cast<edict_t *>( ent );
-	CachedTrace *cachedTrace = (CachedTrace *)data + ENTNUM( entRef );
-
 	VectorCopy( ent->s.origin, result );
 
-	if( (int64_t)( cachedTrace->computedAt + maxMillisAgo ) >= level.time ) {
-		if( cachedTrace->depth >= depth ) {
-			if( cachedTrace->trace.fraction == 1.0f ) {
-				return false;
-			}
-			float cachedHitDepth = cachedTrace->depth * cachedTrace->trace.fraction;
-			if( cachedHitDepth > depth ) {
-				return false;
-			}
-
-			VectorCopy( cachedTrace->trace.endpos, result );
-			result[2] += 16.0f; // Add some delta
-			return true;
+	CachedTrace cachedTrace;
+	if( FetchCachedTrace( (CachedTrace *)data, ENTNUM( ent ), depth, maxMillisAgo, &cachedTrace ) ) {
+		if( cachedTrace.trace.fraction == 1.0f ) {
+			return false;
+		}
+		float cachedHitDepth = cachedTrace.depth * cachedTrace.trace.fraction;
+		if( cachedHitDepth > depth ) {
+			return false;
 		}
+
+		VectorCopy( cachedTrace.trace.endpos, result );
+		result[2] += 16.0f; // Add some delta
+		return true;
 	}
 
-	vec3_t end = { ent->s.origin[0], ent->s.origin[1], ent->s.origin[2] - depth };
-	G_Trace( &cachedTrace->trace, entRef->s.origin, nullptr, nullptr, end, entRef, MASK_AISOLID );
-	cachedTrace->depth = depth;
-	cachedTrace->computedAt = level.time;
-	if( cachedTrace->trace.fraction == 1.0f ) {
+	ComputeAndCacheTrace( (CachedTrace *)data, ent, depth, &cachedTrace );
+	if( cachedTrace.trace.fraction == 1.0f ) {
 		return false;
 	}
 
-	VectorCopy( cachedTrace->trace.endpos, result );
+	VectorCopy( cachedTrace.trace.endpos, result );
 	result[2] += 16.0f;
 	return true;
 }
@@ -7,6 +7,7 @@
 #include "../../common/links.h"
 #include "../../common/wswstringview.h"
 #include "../../common/wswalgorithm.h"
+#include "../../common/tasksystem.h"
 
 #include <algorithm>
 
@@ -48,6 +49,8 @@ AiManager::AiManager( const char *gametype, const char *mapname ) {
 	std::fill_n( teams, MAX_CLIENTS, TEAM_SPECTATOR );
 }
 
+AiManager::~AiManager() = default;
+
 void AiManager::notifyOfNavEntitySignaledAsReached( const NavEntity *navEntity ) {
 	assert( navEntity );
 	// find all bots which have this node as goal and tell them their goal is reached
@@ -269,7 +272,7 @@ void AiManager::SetupBotForEntity( edict_t *ent ) {
 
 	ent->think = nullptr;
 	ent->nextThink = level.time + 1;
-	ent->classname = "bot";
+	G_SetClassname( ent, "bot" );
 	ent->die = player_die;
 }
 
@@ -342,16 +345,107 @@ void AiManager::SetupBotGoalsAndActions( edict_t *ent ) {
 }
 
 void AiManager::Update() {
-	globalCpuQuota.Update( botHandlesHead );
-	thinkQuota[level.framenum % 4].Update( botHandlesHead );
+	SelectBotsToThinkInParallel();
+
+	unsigned numExtraQuotaOwners = 0;
+	if( !m_botsToThinkInParallel.empty() ) {
+		numExtraQuotaOwners = std::min( m_taskSystem->getNumberOfWorkers() - 1, kMaxExtraQuotaOwners );
+	}
+
+	globalCpuQuota.Update( botHandlesHead, numExtraQuotaOwners );
+	thinkQuota[level.framenum % 4].Update( botHandlesHead, numExtraQuotaOwners );
 
 	if( !GS_TeamBasedGametype( *ggs ) ) {
 		AiBaseTeam::GetTeamForNum( TEAM_PLAYERS )->Update();
+	} else {
+		for( int team = TEAM_ALPHA; team < GS_MAX_TEAMS; ++team ) {
+			AiBaseTeam::GetTeamForNum( team )->Update();
+		}
+	}
+
+	ThinkBotsInParallel();
+}
+
+void AiManager::SelectBotsToThinkInParallel() {
+	m_botsToThinkInParallel.clear();
+
+	if( !v_parallelThinking.get() ) {
+		m_taskSystem.reset();
 		return;
 	}
 
-	for( int team = TEAM_ALPHA; team < GS_MAX_TEAMS; ++team ) {
-		AiBaseTeam::GetTeamForNum( team )->Update();
+	// Entity queries are not reentrant otherwise
+	if( !GClip_SupportsConcurrentQueries() ) {
+		return;
+	}
+
+	for( Bot *bot = botHandlesHead; bot; bot = bot->NextInAIList() ) {
+		const edict_t *ent = bot->self;
+		// Check conditions of calling AI_Think() in G_ClientThink()
+		if( ent->r.inuse && !ent->think && !G_ISGHOSTING( ent ) ) {
+			m_botsToThinkInParallel.push_back( bot );
+		}
+	}
+
+	if( m_botsToThinkInParallel.size() < 2 ) {
+		m_botsToThinkInParallel.clear();
+		return;
+	}
+
+	if( !m_taskSystem ) {
+		unsigned numPhysicalProcessors = 0, numLogicalProcessors = 0;
+		unsigned numExtraThreads = 3;
+		if( Sys_GetNumberOfProcessors( &numPhysicalProcessors, &numLogicalProcessors ) && numLogicalProcessors > 1 ) {
+			numExtraThreads = std::min( numLogicalProcessors - 1, kMaxExtraQuotaOwners );
+		}
+		try {
+			m_taskSystem = std::make_unique<TaskSystem>( TaskSystem::CtorArgs { .numExtraThreads = numExtraThreads } );
+		} catch( ... ) {
+			aiWarning() << "Failed to create a task system for thinking of bots in parallel";
+			m_botsToThinkInParallel.clear();
+			return;
+		}
+	}
+}
+
+void AiManager::ThinkBotsInParallel() {
+	if( m_botsToThinkInParallel.empty() ) {
+		return;
+	}
+
+	// Make sure lazily computed data is ready before it gets accessed from different threads
+	if( !numHubAreas ) {
+		FindHubAreas();
+	}
+
+	for( Bot *bot: m_botsToThinkInParallel ) {
+		bot->PrepareToThink();
+	}
+
+	// Let plans be built by different threads
+	PredictionContext::InstallInterceptors();
+
+	bool succeeded = false;
+	try {
+		auto fn = [&]( unsigned, unsigned botIndex ) {
+			m_botsToThinkInParallel[botIndex]->Think();
+		};
+		const TaskSystem::ExecutionHandle executionHandle = m_taskSystem->startExecution();
+		(void)m_taskSystem->addForIndicesInRange( { 0u, (unsigned)m_botsToThinkInParallel.size() },
+												  std::span<const TaskHandle>(), std::move( fn ) );
+		succeeded = m_taskSystem->awaitCompletion( executionHandle );
+	} catch( ... ) {
+	}
+
+	PredictionContext::UninstallInterceptors();
+
+	if( succeeded ) {
+		// The rest of Update() gets performed by AI_Think() calls on the main thread
+		for( Bot *bot: m_botsToThinkInParallel ) {
+			bot->SetThoughtInParallel();
+		}
+	} else {
+		aiWarning() << "Failed to think in parallel, bots are going to think serially this frame";
 	}
 }
 
@@ -469,7 +563,30 @@ bool AiManager::ThinkQuota::Fits( const Bot *bot ) const {
 	return bot->m_frameAffinityOffset == affinityOffset;
 }
 
-void AiManager::Quota::Update( const Bot *aiHandlesHead ) {
+void AiManager::Quota::Update( const Bot *aiHandlesHead, unsigned numExtraOwners ) {
+	UpdateOwner( aiHandlesHead );
+
+	extraOwners.clear();
+	if( !owner ) {
+		return;
+	}
+
+	// Give the quota to bots that follow the owner in the list
+	const Bot *bot = owner;
+	while( extraOwners.size() < numExtraOwners ) {
+		if( !( bot = bot->NextInAIList() ) ) {
+			bot = aiHandlesHead;
+		}
+		if( bot == owner ) {
+			break;
+		}
+		if( Fits( bot ) ) {
+			extraOwners.push_back( ExtraOwner { .givenAt = 0, .bot = bot } );
+		}
+	}
+}
+
+void AiManager::Quota::UpdateOwner( const Bot *aiHandlesHead ) {
 	if( !owner ) {
 		owner = aiHandlesHead;
 		while( owner && !Fits( owner ) ) {
@@ -522,17 +639,28 @@ bool AiManager::TryGetExpensiveThinkCallQuota( const Bot *bot ) {
 }
 
 bool AiManager::Quota::TryAcquire( const Bot *bot ) {
-	if( bot != owner ) {
-		return false;
+	int64_t *givenAtRef = nullptr;
+	if( bot == owner ) {
+		givenAtRef = &givenAt;
+	} else {
+		for( ExtraOwner &extraOwner: extraOwners ) {
+			if( bot == extraOwner.bot ) {
+				givenAtRef = &extraOwner.givenAt;
+				break;
+			}
+		}
+		if( !givenAtRef ) {
+			return false;
+		}
 	}
 
 	auto levelTime = level.time;
 	// Allow expensive computations only once per frame
-	if( givenAt == levelTime ) {
+	if( *givenAtRef == levelTime ) {
 		return false;
 	}
 
 	// Mark it
-	givenAt = levelTime;
+	*givenAtRef = levelTime;
 	return true;
 }
\ No newline at end of file
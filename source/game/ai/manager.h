@@ -6,7 +6,10 @@
 #include "planning/goalentities.h"
 #include "../../common/wswstaticvector.h"
 
+#include <memory>
+
 class Bot;
+class TaskSystem;
 
 class AiManager {
 	static const unsigned MAX_ACTIONS = AiPlanner::MAX_ACTIONS;
@@ -18,19 +21,36 @@ protected:
 	int teams[MAX_CLIENTS];
 	Bot *botHandlesHead { nullptr };
 
+	static constexpr unsigned kMaxExtraQuotaOwners = 7;
+
 	struct Quota {
 		int64_t givenAt { 0 };
 		const Bot *owner { nullptr };
 
+		// Bots that are allowed to acquire the quota in the same frame in addition to the owner.
+		// These are used only if bots think in parallel, so expensive computations get spread over threads.
+		// Each owner writes only its own givenAt field, so acquiring the quota from different threads is safe.
+		struct ExtraOwner {
+			int64_t givenAt { 0 };
+			const Bot *bot { nullptr };
+		};
+		wsw::StaticVector<ExtraOwner, kMaxExtraQuotaOwners> extraOwners;
+
 		virtual bool Fits( const Bot *ai ) const = 0;
 
 		bool TryAcquire( const Bot *ai );
-		void Update( const Bot *botHandlesHead );
+		void Update( const Bot *botHandlesHead, unsigned numExtraOwners );
+		void UpdateOwner( const Bot *botHandlesHead );
 
 		void OnRemoved( const Bot *bot ) {
 			if( bot == owner ) {
 				owner = nullptr;
 			}
+			for( ExtraOwner &extraOwner: extraOwners ) {
+				if( bot == extraOwner.bot ) {
+					extraOwner.bot = nullptr;
+				}
+			}
 		}
 	};
 
@@ -52,6 +72,9 @@ protected:
 	int hubAreas[16];
 	int numHubAreas { 0 };
 
+	std::unique_ptr<TaskSystem> m_taskSystem;
+	wsw::StaticVector<Bot *, MAX_CLIENTS> m_botsToThinkInParallel;
+
 	static AiManager *instance;
 
 	bool CheckCanSpawnBots();
@@ -67,7 +90,12 @@ protected:
 	void SetupBotGoalsAndActions( edict_t *ent );
 
 	void FindHubAreas();
+
+	void SelectBotsToThinkInParallel();
+	void ThinkBotsInParallel();
 public:
+	~AiManager();
+
 	void Update();
 
 	void LinkBot( Bot *bot );
@@ -103,7 +131,8 @@ public:
 	 * If somebody has already requested an operation, returns false.
 	 * Otherwise, sets some internal lock and returns true.
 	 * @note Subsequent calls in the same frame fail even for the same client
-	 * (only a single expensive operation is allowed per frame globally).
+	 * (only a single expensive operation is allowed per frame globally,
+	 * unless bots think in parallel, and the quota is given to few bots at once).
 	 */
 	bool TryGetExpensiveComputationQuota( const Bot *bot );
 
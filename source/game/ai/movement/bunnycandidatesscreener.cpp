@@ -0,0 +1,108 @@
+#include "bunnycandidatesscreener.h"
+#include "movementlocal.h"
+
+class ScreenerShapeListHolder {
+	CMShapeList *m_list { nullptr };
+public:
+	~ScreenerShapeListHolder() {
+		if( m_list ) {
+			SV_FreeShapeList( m_list );
+		}
+	}
+
+	[[nodiscard]]
+	auto build( const float *mins, const float *maxs ) -> const CMShapeList * {
+		if( !m_list ) {
+			m_list = SV_AllocShapeList();
+		}
+		return SV_BuildShapeList( m_list, mins, maxs, MASK_PLAYERSOLID );
+	}
+};
+
+// Bots may think in parallel (see AiManager), so lists are kept per a thread
+static thread_local ScreenerShapeListHolder screenerShapeListHolder;
+
+// A candidate is considered blocked if it hits a wall at a sharper angle
+static constexpr float kHeadOnDotThreshold = -0.7f;
+
+void BunnyCandidatesScreener::run( const AiEntityPhysicsState &physicsState, float minSpeed2D ) {
+	const float *__restrict origin = physicsState.Origin();
+	const float speed2D = wsw::max( physicsState.Speed2D(), minSpeed2D );
+	constexpr float stepSeconds = 0.001f * (float)kStepMillis;
+	const float stepDistance = speed2D * stepSeconds;
+
+	// Candidates do not need to test obstacles that could be just stepped over
+	vec3_t boxMins, boxMaxs;
+	VectorCopy( playerbox_stand_mins, boxMins );
+	VectorCopy( playerbox_stand_maxs, boxMaxs );
+	boxMins[2] += AI_STEPSIZE;
+
+	// Make a shape list that covers trajectories of all candidates
+	const float radius = stepDistance * (float)kNumSteps;
+	const vec3_t regionMins { origin[0] - radius + boxMins[0], origin[1] - radius + boxMins[1], origin[2] + boxMins[2] };
+	const vec3_t regionMaxs { origin[0] + radius + boxMaxs[0], origin[1] + radius + boxMaxs[1], origin[2] + boxMaxs[2] };
+	const CMShapeList *shapeList = screenerShapeListHolder.build( regionMins, regionMaxs );
+
+	const unsigned numCandidates = m_numCandidates;
+	static_assert( kMaxCandidates <= 64 );
+	uint64_t activeMask = 0;
+	for( unsigned i = 0; i < numCandidates; ++i ) {
+		m_originsX[i] = origin[0];
+		m_originsY[i] = origin[1];
+		m_blockedAtMillis[i] = 0;
+		activeMask |= (uint64_t)1 << i;
+	}
+
+	const float z = origin[2];
+	trace_t trace;
+	for( unsigned step = 0; step < kNumSteps && activeMask; ++step ) {
+		const float *__restrict lookDirsX = m_lookDirsX[step];
+		const float *__restrict lookDirsY = m_lookDirsY[step];
+		for( unsigned i = 0; i < numCandidates; ++i ) {
+			if( !( activeMask & ( (uint64_t)1 << i ) ) ) {
+				continue;
+			}
+
+			const vec3_t start { m_originsX[i], m_originsY[i], z };
+			const vec3_t end { start[0] + lookDirsX[i] * stepDistance, start[1] + lookDirsY[i] * stepDistance, z };
+			SV_ClipToShapeList( shapeList, &trace, start, end, boxMins, boxMaxs, MASK_PLAYERSOLID );
+			if( trace.fraction == 1.0f ) {
+				m_originsX[i] = end[0];
+				m_originsY[i] = end[1];
+				continue;
+			}
+
+			// The simplified model is not applicable, stop advancing the candidate without marking it as blocked
+			if( trace.startsolid || trace.allsolid ) {
+				activeMask &= ~( (uint64_t)1 << i );
+				continue;
+			}
+
+			const float *__restrict normal = trace.plane.normal;
+			// Vertical movement is not modeled, so the candidate cannot be advanced over a ramp
+			if( ISWALKABLEPLANE( &trace.plane ) ) {
+				activeMask &= ~( (uint64_t)1 << i );
+				continue;
+			}
+
+			// The normal is not normalized in 2D but this is fine for a rough threshold test
+			const float dot = lookDirsX[i] * normal[0] + lookDirsY[i] * normal[1];
+			if( dot < kHeadOnDotThreshold ) {
+				m_blockedAtMillis[i] = (uint16_t)( ( step + 1 ) * kStepMillis );
+				activeMask &= ~( (uint64_t)1 << i );
+				continue;
+			}
+
+			// Slide along the wall for the rest of the step distance
+			const float restFrac = 1.0f - trace.fraction;
+			const vec3_t slideStart { trace.endpos[0], trace.endpos[1], z };
+			const vec3_t slideEnd {
+				slideStart[0] + ( lookDirsX[i] - dot * normal[0] ) * stepDistance * restFrac,
+				slideStart[1] + ( lookDirsY[i] - dot * normal[1] ) * stepDistance * restFrac, z
+			};
+			SV_ClipToShapeList( shapeList, &trace, slideStart, slideEnd, boxMins, boxMaxs, MASK_PLAYERSOLID );
+			m_originsX[i] = trace.endpos[0];
+			m_originsY[i] = trace.endpos[1];
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#ifndef WSW_9fc25f2f_f7c5_4bba_9f43_884d25c862a3_H
+#define WSW_9fc25f2f_f7c5_4bba_9f43_884d25c862a3_H
+
+#include "../ailocal.h"
+
+class AiEntityPhysicsState;
+
+/**
+ * Advances simplified trajectories of multiple bunny-hopping candidates (look dirs or turns) in lockstep
+ * so candidates that bump into obstacles head-on could be deferred prior to running full predictions for them.
+ * States of candidates are kept in SoA arrays, and all candidates are tested against a single shape list
+ * that covers the entire screened region. Candidates get excluded from further steps as soon as they are blocked.
+ * @note The trajectory model is very basic (the 2D speed is kept, vertical movement is not modeled),
+ * so screening results are hints for ordering of candidates and not a substitute of the actual prediction.
+ */
+class BunnyCandidatesScreener {
+public:
+	static constexpr unsigned kMaxCandidates = 48;
+	static constexpr unsigned kStepMillis = 48;
+	static constexpr unsigned kNumSteps = 8;
+private:
+	// Look dirs of candidates for every step
+	float m_lookDirsX[kNumSteps][kMaxCandidates];
+	float m_lookDirsY[kNumSteps][kMaxCandidates];
+
+	float m_originsX[kMaxCandidates];
+	float m_originsY[kMaxCandidates];
+	uint16_t m_blockedAtMillis[kMaxCandidates];
+
+	unsigned m_numCandidates { 0 };
+public:
+	explicit BunnyCandidatesScreener( unsigned numCandidates ) : m_numCandidates( numCandidates ) {
+		assert( numCandidates <= kMaxCandidates );
+	}
+
+	/**
+	 * Sets a 2D look dir of a candidate for the step.
+	 * @note the dir must be normalized.
+	 */
+	void setLookDir( unsigned step, unsigned candidateNum, float dirX, float dirY ) {
+		assert( step < kNumSteps && candidateNum < m_numCandidates );
+		assert( std::fabs( dirX * dirX + dirY * dirY - 1.0f ) < 0.01f );
+		m_lookDirsX[step][candidateNum] = dirX;
+		m_lookDirsY[step][candidateNum] = dirY;
+	}
+
+	/**
+	 * Sets the same look dir of a candidate for all steps.
+	 * @note the dir must be normalized.
+	 */
+	void setFixedLookDir( unsigned candidateNum, float dirX, float dirY ) {
+		for( unsigned step = 0; step < kNumSteps; ++step ) {
+			setLookDir( step, candidateNum, dirX, dirY );
+		}
+	}
+
+	/**
+	 * Advances all candidates starting from the physics state.
+	 * Look dirs of all candidates for all steps must be set at this moment.
+	 * @param minSpeed2D a speed that is assumed if the actual 2D speed is lower (e.g. prior to the first hop)
+	 */
+	void run( const AiEntityPhysicsState &physicsState, float minSpeed2D );
+
+	/**
+	 * @return the time of the step when the candidate has been blocked, or zero if it has not been blocked.
+	 */
+	[[nodiscard]]
+	unsigned blockedAtMillis( unsigned candidateNum ) const {
+		assert( candidateNum < m_numCandidates );
+		return m_blockedAtMillis[candidateNum];
+	}
+};
+
+#endif
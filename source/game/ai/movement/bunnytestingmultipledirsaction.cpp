@@ -1,5 +1,6 @@
 #include "bunnytestingmultipledirsaction.h"
 #include "movementlocal.h"
+#include "bunnycandidatesscreener.h"
 #include "../../../common/wswalgorithm.h"
 
 void BunnyTestingMultipleLookDirsAction::BeforePlanning() {
@@ -18,6 +19,12 @@ void BunnyTestingSavedLookDirsAction::OnApplicationSequenceStarted( PredictionCo
 		// TODO: Could be better if this gets implemented individually by each descendant.
 		// The generic version is used now just to provide a generic solution quickly at cost of being suboptimal.
 		DeriveMoreDirsFromSavedDirs();
+		for( unsigned i = 0; i < suggestedLookDirs.size(); ++i ) {
+			suggestedLookDirs[i].originalNum = i;
+		}
+	} else if( currSuggestedLookDirNum == 1 ) {
+		// The first dir has failed, the context has been rolled back to the start of the sequence at this moment
+		DeferBlockedLookDirs( context );
 	}
 	if( currSuggestedLookDirNum >= suggestedLookDirs.size() ) {
 		return;
@@ -43,6 +50,20 @@ void BunnyTestingSavedLookDirsAction::OnApplicationSequenceFailed( PredictionCon
 	context->SaveSuggestedActionForNextFrame( this );
 }
 
+void BunnyTestingSavedLookDirsAction::OnApplicationSequenceStopped( PredictionContext *context,
+																	SequenceStopReason stopReason,
+																	unsigned stoppedAtFrameIndex ) {
+	BunnyTestingMultipleLookDirsAction::OnApplicationSequenceStopped( context, stopReason, stoppedAtFrameIndex );
+
+	if( stopReason == SUCCEEDED && currSuggestedLookDirNum < suggestedLookDirs.size() ) {
+		// Report how many full predictions the screener has saved (a negative value means it has made things worse)
+		const int originalNum = (int)suggestedLookDirs[currSuggestedLookDirNum].originalNum;
+		if( const int numSavedAttempts = originalNum - (int)currSuggestedLookDirNum ) {
+			Debug( "The screener has saved %d full predictions\n", numSavedAttempts );
+		}
+	}
+}
+
 void BunnyTestingMultipleLookDirsAction::OnApplicationSequenceStopped( PredictionContext *context,
 																	   SequenceStopReason stopReason,
 																	   unsigned stoppedAtFrameIndex ) {
@@ -230,6 +251,50 @@ void BunnyTestingSavedLookDirsAction::DeriveMoreDirsFromSavedDirs() {
 	}
 }
 
+void BunnyTestingSavedLookDirsAction::DeferBlockedLookDirs( PredictionContext *context ) {
+	const unsigned firstDirNum = currSuggestedLookDirNum;
+	if( firstDirNum + 2 > suggestedLookDirs.size() ) {
+		return;
+	}
+
+	static_assert( kMaxSuggestedLookDirs <= BunnyCandidatesScreener::kMaxCandidates );
+	BunnyCandidatesScreener screener( suggestedLookDirs.size() - firstDirNum );
+	for( unsigned i = firstDirNum; i < suggestedLookDirs.size(); ++i ) {
+		Vec3 dir2D( suggestedLookDirs[i].dir );
+		dir2D.Z() = 0;
+		const float squareLength = dir2D.SquaredLength();
+		// Dirs that are almost vertical can't be blocked in the screener model
+		if( squareLength < 0.01f ) {
+			return;
+		}
+		dir2D *= Q_RSqrt( squareLength );
+		screener.setFixedLookDir( i - firstDirNum, dir2D.X(), dir2D.Y() );
+	}
+
+	screener.run( context->movementState->entityPhysicsState, context->GetRunSpeed() );
+
+	wsw::StaticVector<SuggestedDir, kMaxSuggestedLookDirs> blockedDirs;
+	unsigned numFeasibleDirs = firstDirNum;
+	for( unsigned i = firstDirNum; i < suggestedLookDirs.size(); ++i ) {
+		if( screener.blockedAtMillis( i - firstDirNum ) ) {
+			blockedDirs.push_back( suggestedLookDirs[i] );
+		} else {
+			suggestedLookDirs[numFeasibleDirs++] = suggestedLookDirs[i];
+		}
+	}
+
+	// Keep the original order if all dirs are blocked (the array has not been modified in this case)
+	if( numFeasibleDirs == firstDirNum || blockedDirs.empty() ) {
+		return;
+	}
+
+	Debug( "%d of %d remaining look dirs have been deferred\n",
+		   (int)blockedDirs.size(), (int)( suggestedLookDirs.size() - firstDirNum ) );
+	for( const SuggestedDir &dir: blockedDirs ) {
+		suggestedLookDirs[numFeasibleDirs++] = dir;
+	}
+}
+
 AreaAndScore *BunnyTestingSavedLookDirsAction::TakeBestCandidateAreas( AreaAndScore *inputBegin,
 																	   AreaAndScore *inputEnd,
 																	   unsigned maxAreas ) {
@@ -31,6 +31,8 @@ protected:
 		Vec3 dir;
 		int area;
 		unsigned pathPenalty { 0 };
+		// The index of the dir prior to reordering by the screener
+		unsigned originalNum { 0 };
 
 		SuggestedDir( const Vec3 &dir_, int area_ )
 			: dir( dir_ ), area( area_ ) {}
@@ -54,6 +56,10 @@ protected:
 
 	void OnApplicationSequenceFailed( PredictionContext *context, unsigned stoppedAtFrameIndex ) final;
 
+	void OnApplicationSequenceStopped( PredictionContext *context,
+									   SequenceStopReason stopReason,
+									   unsigned stoppedAtFrameIndex ) override;
+
 	virtual void SaveSuggestedLookDirs( PredictionContext *context ) = 0;
 
 	/**
@@ -66,6 +72,15 @@ protected:
 	 */
 	void DeriveMoreDirsFromSavedDirs();
 
+	/**
+	 * Screens look dirs that have not been tested yet all at once using a simplified lockstep prediction
+	 * and moves dirs that bump into obstacles head-on to the end of the list preserving the relative order.
+	 * This helps to avoid testing full predictions of likely failing dirs prior to feasible ones.
+	 * @note This is called only after the full prediction for the first dir has failed,
+	 * so the common case of the first dir being feasible does not pay for screening.
+	 */
+	void DeferBlockedLookDirs( PredictionContext *context );
+
 	/**
 	 * A helper method to select best N areas that is optimized for small areas count.
 	 * Modifies the collection in-place putting best areas at its beginning.
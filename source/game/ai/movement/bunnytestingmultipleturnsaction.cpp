@@ -1,6 +1,7 @@
 #include "bunnytestingmultipleturnsaction.h"
 #include "movementlocal.h"
 #include "movementsubsystem.h"
+#include "bunnycandidatesscreener.h"
 
 static constexpr float kMinAngularSpeed = 120.0f;
 static constexpr float kMaxAngularSpeed = 270.0f;
@@ -38,32 +39,17 @@ void BunnyTestingMultipleTurnsAction::PlanPredictionStep( PredictionContext *con
 				}
 			}
 
-			static_assert( kMaxAttempts == 2 * kMaxAngles );
-			const float sign = ( attemptNum % 2 ) ? +1.0f : -1.0f;
-
-			const float attemptAngularSpeed = kAngularSpeed[attemptNum / 2];
-			constexpr const float invAngularSpeedRange = 1.0f / ( kMaxAngularSpeed - kMinAngularSpeed );
-			// Defines how close the angular speed is to the max angular speed
-			const float fracOfMaxSpeed = ( attemptAngularSpeed - kMinAngularSpeed ) * invAngularSpeedRange;
-
-			const float timeSeconds = 0.001f * (float)context->totalMillisAhead;
-			// Hack, scale the time prior to checks (this yields better results)
-			float timeLike = 0.75f * timeSeconds;
-			if( timeLike < 1.0f ) {
-				// Change the angle slower for larger resulting turns
-				timeLike = std::pow( timeLike, 0.5f + 0.5f * fracOfMaxSpeed );
-			}
-
-			mat3_t m;
-			const float angle = ( sign * attemptAngularSpeed ) * timeLike;
-			Matrix3_Rotate( axis_identity, angle, 0.0f, 0.0f, 1.0f, m );
-			Matrix3_TransformVector( m, initialDir.Data(), lookDir );
+			MakeTurnedLookDir( initialDir, turnNumsForAttempts[attemptNum], context->totalMillisAhead, lookDir );
 		}
 	} else {
 		Vec3 forwardDir( entityPhysicsState.ForwardDir() );
 		if( !attemptNum ) {
 			// Save the initial look dir for this bot and game frame
 			forwardDir.CopyTo( initialDir );
+		} else if( !hasScreenedTurns ) {
+			// The first attempt has failed, the context has been rolled back to the start of the sequence
+			DeferBlockedTurns( context );
+			hasScreenedTurns = true;
 		}
 		forwardDir.CopyTo( lookDir );
 	}
@@ -73,10 +59,82 @@ void BunnyTestingMultipleTurnsAction::PlanPredictionStep( PredictionContext *con
 	}
 }
 
+void BunnyTestingMultipleTurnsAction::MakeTurnedLookDir( const Vec3 &initialDir, int turnNum,
+														 unsigned millisAhead, vec3_t lookDir ) {
+	static_assert( kMaxAttempts == 2 * kMaxAngles );
+	const float sign = ( turnNum % 2 ) ? +1.0f : -1.0f;
+
+	const float turnAngularSpeed = kAngularSpeed[turnNum / 2];
+	constexpr const float invAngularSpeedRange = 1.0f / ( kMaxAngularSpeed - kMinAngularSpeed );
+	// Defines how close the angular speed is to the max angular speed
+	const float fracOfMaxSpeed = ( turnAngularSpeed - kMinAngularSpeed ) * invAngularSpeedRange;
+
+	const float timeSeconds = 0.001f * (float)millisAhead;
+	// Hack, scale the time prior to checks (this yields better results)
+	float timeLike = 0.75f * timeSeconds;
+	if( timeLike < 1.0f ) {
+		// Change the angle slower for larger resulting turns
+		timeLike = std::pow( timeLike, 0.5f + 0.5f * fracOfMaxSpeed );
+	}
+
+	mat3_t m;
+	const float angle = ( sign * turnAngularSpeed ) * timeLike;
+	Matrix3_Rotate( axis_identity, angle, 0.0f, 0.0f, 1.0f, m );
+	Matrix3_TransformVector( m, initialDir.Data(), lookDir );
+}
+
+void BunnyTestingMultipleTurnsAction::DeferBlockedTurns( PredictionContext *context ) {
+	Vec3 initialDir2D( initialDir );
+	initialDir2D.Z() = 0;
+	const float squareLength = initialDir2D.SquaredLength();
+	// The bot looks almost vertically, turns can't be screened in this case
+	if( squareLength < 0.01f ) {
+		return;
+	}
+	initialDir2D *= Q_RSqrt( squareLength );
+
+	// Turns of attempts that have been already tested are kept in place
+	const int firstAttemptNum = attemptNum;
+	BunnyCandidatesScreener screener( kMaxAttempts - firstAttemptNum );
+	for( int i = firstAttemptNum; i < kMaxAttempts; ++i ) {
+		for( unsigned step = 0; step < BunnyCandidatesScreener::kNumSteps; ++step ) {
+			vec3_t lookDir;
+			// Use look dirs for the middle of steps
+			const unsigned millisAhead = step * BunnyCandidatesScreener::kStepMillis + BunnyCandidatesScreener::kStepMillis / 2;
+			MakeTurnedLookDir( initialDir2D, turnNumsForAttempts[i], millisAhead, lookDir );
+			screener.setLookDir( step, (unsigned)( i - firstAttemptNum ), lookDir[0], lookDir[1] );
+		}
+	}
+
+	screener.run( context->movementState->entityPhysicsState, context->GetRunSpeed() );
+
+	uint8_t blockedTurnNums[kMaxAttempts];
+	int numBlockedTurns = 0, numFeasibleTurns = firstAttemptNum;
+	for( int i = firstAttemptNum; i < kMaxAttempts; ++i ) {
+		if( screener.blockedAtMillis( (unsigned)( i - firstAttemptNum ) ) ) {
+			blockedTurnNums[numBlockedTurns++] = turnNumsForAttempts[i];
+		} else {
+			turnNumsForAttempts[numFeasibleTurns++] = turnNumsForAttempts[i];
+		}
+	}
+
+	if( numBlockedTurns ) {
+		Debug( "%d of %d remaining turns have been deferred\n", numBlockedTurns, kMaxAttempts - firstAttemptNum );
+		std::copy( blockedTurnNums, blockedTurnNums + numBlockedTurns, turnNumsForAttempts + numFeasibleTurns );
+	}
+}
+
 void BunnyTestingMultipleTurnsAction::OnApplicationSequenceStopped( PredictionContext *context,
 																	SequenceStopReason stopReason,
 																	unsigned stoppedAtFrameIndex ) {
 	BunnyHopAction::OnApplicationSequenceStopped( context, stopReason, stoppedAtFrameIndex );
+	if( stopReason == SUCCEEDED ) {
+		// Turn numbers match attempt numbers of the original order.
+		// Report how many full predictions the screener has saved (a negative value means it has made things worse).
+		if( const int numSavedAttempts = (int)turnNumsForAttempts[attemptNum] - attemptNum ) {
+			Debug( "The screener has saved %d full predictions\n", numSavedAttempts );
+		}
+	}
 	if( stopReason != FAILED ) {
 		return;
 	}
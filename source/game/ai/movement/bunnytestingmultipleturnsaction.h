@@ -7,11 +7,25 @@ class BunnyTestingMultipleTurnsAction : public BunnyHopAction {
 	Vec3 initialDir { 0, 0, 0 };
 	int attemptNum { 0 };
 	bool hasWalljumped { false };
+	bool hasScreenedTurns { false };
 
 	static constexpr const auto kMaxAngles = 4;
 	static constexpr const auto kMaxAttempts = 2 * kMaxAngles;
 
 	static const float kAngularSpeed[kMaxAngles];
+
+	// Turns that are tested by attempts in their order
+	uint8_t turnNumsForAttempts[kMaxAttempts];
+
+	static void MakeTurnedLookDir( const Vec3 &initialDir, int turnNum, unsigned millisAhead, vec3_t lookDir );
+
+	/**
+	 * Screens turns of remaining attempts at once using a simplified lockstep prediction
+	 * and makes turns that bump into obstacles head-on to be tested by last attempts.
+	 * @note This is called only after the full prediction of the first attempt has failed,
+	 * so the common case of the first attempt being successful does not pay for screening.
+	 */
+	void DeferBlockedTurns( PredictionContext *context );
 public:
 	explicit BunnyTestingMultipleTurnsAction( MovementSubsystem *subsystem )
 		: BunnyHopAction( subsystem, "BunnyTestingMultipleTurnsAction", COLOR_RGB( 255, 0, 0 ) ) {}
@@ -21,6 +35,10 @@ public:
 	void BeforePlanning() override {
 		BunnyHopAction::BeforePlanning();
 		attemptNum = 0;
+		hasScreenedTurns = false;
+		for( int i = 0; i < kMaxAttempts; ++i ) {
+			turnNumsForAttempts[i] = (uint8_t)i;
+		}
 	}
 
 	void OnApplicationSequenceStarted( PredictionContext *context ) override {
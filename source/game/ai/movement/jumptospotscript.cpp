@@ -231,7 +231,7 @@ public:
 	}
 };
 
-static BestAreaCenterJumpableSpotDetector bestAreaCenterJumpableSpotDetector;
+static thread_local BestAreaCenterJumpableSpotDetector bestAreaCenterJumpableSpotDetector;
 
 inline bool BestAreaCenterJumpableSpotDetector::TestAreaSettings( const aas_areasettings_t &areaSettings ) {
 	if( !( areaSettings.areaflags & ( AREA_GROUNDED ) ) ) {
@@ -555,7 +555,7 @@ public:
 	}
 };
 
-static BestConnectedToHubAreasJumpableSpotDetector bestConnectedToHubAreasJumpableSpotDetector;
+static thread_local BestConnectedToHubAreasJumpableSpotDetector bestConnectedToHubAreasJumpableSpotDetector;
 
 MovementScript *FallbackAction::TryFindLostNavTargetFallback( PredictionContext *context ) {
 	Assert( !context->NavTargetAasAreaNum() );
@@ -38,7 +38,8 @@ int CollisionTopNodeCache::getTopNode( const float *absMins, const float *absMax
 	return *cachedZeroStepNode;
 }
 
-CollisionTopNodeCache collisionTopNodeCache;
+// Bots may think in parallel (see AiManager), so these caches are kept per a thread
+thread_local CollisionTopNodeCache collisionTopNodeCache;
 
 static const float kShapesListCacheAddToMins[] = { -64, -64, -32 };
 static const float kShapesListCacheAddToMaxs[] = { +64, +64, +32 };
@@ -54,7 +55,7 @@ CollisionShapesListCache::~CollisionShapesListCache() {
 	SV_FreeShapeList( zeroStepClippedList );
 }
 
-CollisionShapesListCache shapesListCache;
+thread_local CollisionShapesListCache shapesListCache;
 
 constexpr auto kListClipMask = MASK_PLAYERSOLID | MASK_WATER | CONTENTS_TRIGGER | CONTENTS_JUMPPAD | CONTENTS_TELEPORTER;
 
@@ -17,7 +17,7 @@
 #if !defined( PUBLIC_BUILD )
 #define CHECK_ACTION_SUGGESTION_LOOPS
 #define CHECK_INFINITE_NEXT_STEP_LOOPS
-extern int nextStepIterationsCounter;
+extern thread_local int nextStepIterationsCounter;
 static constexpr int NEXT_STEP_INFINITE_LOOP_THRESHOLD = 10000;
 #endif
 
@@ -492,7 +492,7 @@ public:
 	int getTopNode( const float *absMins, const float *absMaxs, bool izZeroStep ) const;
 };
 
-extern CollisionTopNodeCache collisionTopNodeCache;
+extern thread_local CollisionTopNodeCache collisionTopNodeCache;
 
 class CollisionShapesListCache {
 	mutable CMShapeList *activeCachedList { nullptr };
@@ -511,7 +511,7 @@ public:
 	const CMShapeList *prepareList( const float *mins, const float *maxs, bool isZeroStep ) const;
 };
 
-extern CollisionShapesListCache shapesListCache;
+extern thread_local CollisionShapesListCache shapesListCache;
 
 class ReachChainWalker {
 protected:
@@ -82,10 +82,13 @@ void MovementSubsystem::Frame( BotInput *input ) {
 		activeMovementScript = nullptr;
 	}
 
-	MovementActionRecord movementActionRecord;
-	BaseAction *movementAction = predictionContext.GetActionAndRecordForCurrTime( &movementActionRecord );
+	pendingAction = predictionContext.GetActionAndRecordForCurrTime( &pendingActionRecord );
+}
 
-	movementAction->ExecActionRecord( &movementActionRecord, input, nullptr );
+void MovementSubsystem::ExecPendingActionRecord( BotInput *input ) {
+	assert( pendingAction );
+	pendingAction->ExecActionRecord( &pendingActionRecord, input, nullptr );
+	pendingAction = nullptr;
 }
 
 void MovementSubsystem::CheckBlockingDueToInputRotation() {
@@ -165,6 +165,9 @@ class MovementSubsystem {
 
 	MovementScript *activeMovementScript { nullptr };
 
+	BaseAction *pendingAction { nullptr };
+	MovementActionRecord pendingActionRecord;
+
 	int64_t nextRotateInputAttemptAt { 0 };
 	int64_t inputRotationBlockingTimer { 0 };
 	int64_t lastInputRotationFailureAt { 0 };
@@ -228,7 +231,13 @@ public:
 
 	bool CanInterruptMovement() const;
 
+	/**
+	 * Predicts the movement and selects an action for the current frame.
+	 * Does not modify the bot entity, so bots may do that in parallel.
+	 * {@code ExecPendingActionRecord()} must be called on the main thread afterwards.
+	 */
 	void Frame( BotInput *input );
+	void ExecPendingActionRecord( BotInput *input );
 	void ApplyInput( BotInput *input, PredictionContext *context = nullptr );
 };
 
@@ -269,22 +269,47 @@ void PredictionContext::ShowBuiltPlanPath( bool useActionsColor ) const {
 	}
 }
 
+// Module functions that were set before installing interceptors.
+// Interceptors fall back to these functions if there is no prediction being performed by the current thread.
+static struct {
+	decltype( gs_state_t::Trace ) trace;
+	decltype( gs_state_t::PointContents ) pointContents;
+	decltype( gs_state_t::PredictedEvent ) predictedEvent;
+	decltype( gs_state_t::PMoveTouchTriggers ) pmoveTouchTriggers;
+} generalModuleFuncs;
+
+static bool areInterceptorsInstalled;
+
+// Bots may think in parallel (see AiManager), so the prediction state is kept per a thread
+static thread_local PredictionContext *currPredictionContext;
+
+static thread_local const CMShapeList *pmoveShapeList;
+static thread_local bool pmoveShouldTestContents;
+static thread_local bool isInterceptingPMoveCollision;
+
 static void Intercepted_PredictedEvent( int entNum, int ev, int parm ) {
+	if( !currPredictionContext ) {
+		generalModuleFuncs.predictedEvent( entNum, ev, parm );
+		return;
+	}
 	game.edicts[entNum].bot->OnInterceptedPredictedEvent( ev, parm );
 }
 
 static void Intercepted_PMoveTouchTriggers( pmove_t *pm, const vec3_t previous_origin ) {
+	if( !currPredictionContext ) {
+		generalModuleFuncs.pmoveTouchTriggers( pm, previous_origin );
+		return;
+	}
 	game.edicts[pm->playerState->playerNum + 1].bot->OnInterceptedPMoveTouchTriggers( pm, previous_origin );
 }
 
-static PredictionContext *currPredictionContext;
-
-static const CMShapeList *pmoveShapeList;
-static bool pmoveShouldTestContents;
-
 static void Intercepted_Trace( trace_t *t, const vec3_t start, const vec3_t mins,
 							   const vec3_t maxs, const vec3_t end,
 							   int ignore, int contentmask, int timeDelta ) {
+	if( !isInterceptingPMoveCollision ) {
+		generalModuleFuncs.trace( t, start, mins, maxs, end, ignore, contentmask, timeDelta );
+		return;
+	}
 	// TODO: Check whether contentmask is compatible
 	SV_ClipToShapeList( pmoveShapeList, t, start, end, mins, maxs, contentmask );
 	if( !currPredictionContext->m_platformTriggerEntNumsToUseDuringPrediction.empty() ) [[unlikely]] {
@@ -314,6 +339,9 @@ static void Intercepted_Trace( trace_t *t, const vec3_t start, const vec3_t mins
 }
 
 static int Intercepted_PointContents( const vec3_t p, int timeDelta ) {
+	if( !isInterceptingPMoveCollision ) {
+		return generalModuleFuncs.pointContents( p, timeDelta );
+	}
 	if( pmoveShouldTestContents ) [[unlikely]] {
 		int topNodeHint = ::collisionTopNodeCache.getTopNode( p, p, !currPredictionContext->topOfStackIndex );
 		return SV_TransformedPointContents( p, nullptr, nullptr, nullptr, topNodeHint );
@@ -321,6 +349,29 @@ static int Intercepted_PointContents( const vec3_t p, int timeDelta ) {
 	return 0;
 }
 
+void PredictionContext::InstallInterceptors() {
+	assert( !areInterceptorsInstalled );
+	generalModuleFuncs.trace              = ggs->Trace;
+	generalModuleFuncs.pointContents      = ggs->PointContents;
+	generalModuleFuncs.predictedEvent     = ggs->PredictedEvent;
+	generalModuleFuncs.pmoveTouchTriggers = ggs->PMoveTouchTriggers;
+
+	ggs->Trace              = Intercepted_Trace;
+	ggs->PointContents      = Intercepted_PointContents;
+	ggs->PredictedEvent     = Intercepted_PredictedEvent;
+	ggs->PMoveTouchTriggers = Intercepted_PMoveTouchTriggers;
+	areInterceptorsInstalled = true;
+}
+
+void PredictionContext::UninstallInterceptors() {
+	assert( areInterceptorsInstalled );
+	ggs->Trace              = generalModuleFuncs.trace;
+	ggs->PointContents      = generalModuleFuncs.pointContents;
+	ggs->PredictedEvent     = generalModuleFuncs.predictedEvent;
+	ggs->PMoveTouchTriggers = generalModuleFuncs.pmoveTouchTriggers;
+	areInterceptorsInstalled = false;
+}
+
 void PredictionContext::OnInterceptedPredictedEvent( int ev, int parm ) {
 	switch( ev ) {
 		case EV_JUMP:
@@ -973,12 +1024,14 @@ void PredictionContext::BuildPlan() {
 	for( auto *movementAction: m_subsystem->movementActions )
 		movementAction->BeforePlanning();
 
-	// Intercept these calls implicitly performed by PMove()
-	const auto general_PMoveTouchTriggers = ggs->PMoveTouchTriggers;
-	const auto general_PredictedEvent = ggs->PredictedEvent;
+	// Intercept these calls implicitly performed by PMove().
+	// Interceptors are installed in advance if bots think in parallel.
+	const bool shouldInstallInterceptors = !areInterceptorsInstalled;
+	if( shouldInstallInterceptors ) {
+		InstallInterceptors();
+	}
 
-	ggs->PMoveTouchTriggers = &Intercepted_PMoveTouchTriggers;
-	ggs->PredictedEvent = &Intercepted_PredictedEvent;
+	::currPredictionContext = this;
 
 	edict_t *const self = game.edicts + bot->EntNum();
 
@@ -1087,8 +1140,11 @@ void PredictionContext::BuildPlan() {
 	Assert( VectorCompare( self->s.origin, self->bot->entityPhysicsState->Origin() ) );
 	Assert( VectorCompare( self->velocity, self->bot->entityPhysicsState->Velocity() ) );
 
-	ggs->PMoveTouchTriggers = general_PMoveTouchTriggers;
-	ggs->PredictedEvent = general_PredictedEvent;
+	::currPredictionContext = nullptr;
+
+	if( shouldInstallInterceptors ) {
+		UninstallInterceptors();
+	}
 
 	for( auto *movementAction: m_subsystem->movementActions )
 		movementAction->AfterPlanning();
@@ -1197,29 +1253,17 @@ void PredictionContext::NextMovementStep() {
 		pm.skipCollision = true;
 	}
 
-	::currPredictionContext = this;
-
 	// We currently test collisions only against a solid world on each movement step and the corresponding PMove() call.
 	// Touching trigger entities is handled by Intercepted_PMoveTouchTriggers(), also we use AAS sampling for it.
 	// Actions that involve touching trigger entities currently are never predicted ahead.
 	// If an action really needs to test against entities, a corresponding prediction step flag
 	// should be added and this interception of the module_Trace() should be skipped if the flag is set.
-
-	// Save the G_GS_Trace() pointer
-	auto oldModuleTrace = ggs->Trace;
-	ggs->Trace = Intercepted_Trace;
-
-	// Do not test entities contents for same reasons
-	// Save the G_PointContents4D() pointer
-	auto oldModulePointContents = ggs->PointContents;
-	ggs->PointContents = Intercepted_PointContents;
+	// Do not test entities contents for same reasons.
+	::isInterceptingPMoveCollision = true;
 
 	Pmove( ggs, &pm );
 
-	// Restore the G_GS_Trace() pointer
-	ggs->Trace = oldModuleTrace;
-	// Restore the G_PointContents4D() pointer
-	ggs->PointContents = oldModulePointContents;
+	::isInterceptingPMoveCollision = false;
 
 	// Update the saved player state for using in the next prediction frame
 	currMinimalPlayerState->pmove      = playerStateForPmove.pmove;
@@ -1233,7 +1277,7 @@ void PredictionContext::NextMovementStep() {
 }
 
 #ifdef CHECK_INFINITE_NEXT_STEP_LOOPS
-int nextStepIterationsCounter;
+thread_local int nextStepIterationsCounter;
 #endif
 
 void PredictionContext::Debug( const char *format, ... ) const {
@@ -285,6 +285,15 @@ public:
 
 	explicit PredictionContext( MovementSubsystem *m_subsystem );
 
+	/**
+	 * Replaces module functions that are called by {@code Pmove()} by ones that are aware of the prediction.
+	 * This is performed by {@code BuildPlan()} itself, unless interceptors are already installed.
+	 * Installing interceptors in advance allows building plans in parallel.
+	 * Interceptors forward calls to original functions if a thread does not build a plan.
+	 */
+	static void InstallInterceptors();
+	static void UninstallInterceptors();
+
 	void BuildPlan();
 	bool NextPredictionStep();
 	void SetupStackForStep();
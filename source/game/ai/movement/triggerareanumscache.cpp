@@ -14,6 +14,11 @@ void TriggerAreaNumsCache::clear() {
 }
 
 auto TriggerAreaNumsCache::getAreaNum( int entNum ) const -> int {
+	[[maybe_unused]] wsw::ScopedLock<wsw::Mutex> lock( &m_mutex );
+	return findAreaNum( entNum );
+}
+
+auto TriggerAreaNumsCache::findAreaNum( int entNum ) const -> int {
 	int *const __restrict areaNumRef = &m_areaNums[entNum];
 	// Put the likely case first
 	if( *areaNumRef ) {
@@ -90,6 +95,8 @@ auto TriggerAreaNumsCache::getAreaNum( int entNum ) const -> int {
 }
 
 auto TriggerAreaNumsCache::getTriggersForArea( int areaNum ) const -> const ClassTriggerNums * {
+	[[maybe_unused]] wsw::ScopedLock<wsw::Mutex> lock( &m_mutex );
+
 	const auto *const __restrict aasWorld = AiAasWorld::instance();
 
 	if( m_testedTriggersForArea[areaNum] ) {
@@ -142,7 +149,9 @@ auto TriggerAreaNumsCache::getTriggersForArea( int areaNum ) const -> const Clas
 }
 
 auto TriggerAreaNumsCache::getJumppadAreaNumAndTargetAreaNums( int entNum ) const -> std::pair<int, std::span<const int>> {
-	const int jumppadAreaNum = getAreaNum( entNum );
+	[[maybe_unused]] wsw::ScopedLock<wsw::Mutex> lock( &m_mutex );
+
+	const int jumppadAreaNum = findAreaNum( entNum );
 	if( const auto it = m_jumppadTargetAreaNums.find( entNum ); it != m_jumppadTargetAreaNums.end() ) {
 		return { jumppadAreaNum, it->second };
 	}
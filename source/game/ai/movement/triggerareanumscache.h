@@ -4,6 +4,7 @@
 #include "../../../common/q_shared.h"
 #include "../../../common/wswbasicmath.h"
 #include "../../../common/wswpodvector.h"
+#include "../../../common/qthreads.h"
 
 #include <bitset>
 #include <cstdlib>
@@ -56,6 +57,11 @@ private:
 	mutable std::bitset<std::numeric_limits<uint16_t>::max()> m_testedTriggersForArea;
 	// TODO: Fuse with the set above into a 2-bit set
 	mutable std::bitset<std::numeric_limits<uint16_t>::max()> m_hasTriggersForArea;
+	// Entries are added lazily, and bots may think in parallel
+	mutable wsw::Mutex m_mutex;
+
+	[[nodiscard]]
+	auto findAreaNum( int entNum ) const -> int;
 
 	static void findJumppadTargetAreaNums( const struct edict_s *jumppadEntity, int jumppadAreaNum, wsw::PodVector<int> *targetAreaNums );
 public:
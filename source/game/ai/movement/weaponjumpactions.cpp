@@ -53,7 +53,7 @@ public:
 	bool Exec( PredictionContext *context, ScheduleWeaponJumpAction *action );
 };
 
-static WeaponJumpWeaponsTester weaponJumpWeaponsTester;
+static thread_local WeaponJumpWeaponsTester weaponJumpWeaponsTester;
 
 static void PrepareAnglesAndWeapon( PredictionContext *context ) {
 	const auto &weaponJumpState = context->movementState->weaponJumpMovementState;
@@ -81,7 +81,14 @@ static void PrepareAnglesAndWeapon( PredictionContext *context ) {
 	context->record->pendingWeapon = weaponJumpState.weapon;
 }
 
-int ScheduleWeaponJumpAction::dummyTravelTimes[ScheduleWeaponJumpAction::MAX_AREAS];
+constinit const std::array<int, ScheduleWeaponJumpAction::MAX_AREAS> ScheduleWeaponJumpAction::dummyTravelTimes = []() {
+	std::array<int, MAX_AREAS> result {};
+	for( int i = 0; i < MAX_AREAS; ++i ) {
+		// Make sure every travel time is a feasible AAS time (>0)
+		result[i] = i + 1;
+	}
+	return result;
+}();
 
 void ScheduleWeaponJumpAction::PlanPredictionStep( PredictionContext *context ) {
 	auto *const defaultAction = context->SuggestDefaultAction();
@@ -180,14 +187,7 @@ void ScheduleWeaponJumpAction::PlanPredictionStep( PredictionContext *context )
 }
 
 const int *ScheduleWeaponJumpAction::GetTravelTimesForReachChainShortcut() {
-	if( !dummyTravelTimes[0] ) {
-		for( int i = 0; i < MAX_AREAS; ++i ) {
-			// Make sure every travel time is a feasible AAS time (>0)
-			dummyTravelTimes[i] = i + 1;
-		}
-	}
-
-	return dummyTravelTimes;
+	return dummyTravelTimes.data();
 }
 
 bool ScheduleWeaponJumpAction::TryGetComputationQuota() const {
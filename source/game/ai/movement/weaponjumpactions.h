@@ -3,6 +3,8 @@
 
 #include "baseaction.h"
 
+#include <array>
+
 class ScheduleWeaponJumpAction: public BaseAction {
 	friend class WeaponJumpWeaponsTester;
 
@@ -28,7 +30,8 @@ class ScheduleWeaponJumpAction: public BaseAction {
 	// Used for providing travel times for reach chain shortcut.
 	// Areas in a reach chain are already ordered.
 	// Using real travel times complicates interfaces in this case.
-	static int dummyTravelTimes[MAX_AREAS];
+	// The table is initialized statically as actions may be planned by parallel worker threads.
+	static const std::array<int, MAX_AREAS> dummyTravelTimes;
 
 	mutable bool hasTestedComputationQuota { false };
 	mutable bool hasAcquiredComputationQuota { false };
@@ -1,49 +1,84 @@
 #include "aasworld.h"
 #include "aaselementsmask.h"
 
-BitVector *AasElementsMask::areasMask = nullptr;
-BitVector *AasElementsMask::facesMask = nullptr;
-
-static wsw::StaticVector<BitVector, 2> bitVectorsHolder;
-bool *AasElementsMask::tmpAreasVisRow = nullptr;
-bool *AasElementsMask::blockedAreasTable = nullptr;
+#include <memory>
 
 int AasElementsMask::numAreas = 0;
+int AasElementsMask::numFaces = 0;
+unsigned AasElementsMask::worldGeneration = 0;
 
-void AasElementsMask::Init( AiAasWorld *aasWorld ) {
-	assert( bitVectorsHolder.empty() );
-	const auto worldAreas = aasWorld->getAreas();
-	const auto worldFaces = aasWorld->getFaces();
+struct AasElementsMask::ThreadBuffers {
+	unsigned worldGeneration { 0 };
 
-	assert( !worldAreas.empty() );
-	assert( !worldFaces.empty() );
+	wsw::StaticVector<BitVector, 2> bitVectors;
+	std::unique_ptr<uint32_t[]> areasMaskWords;
+	std::unique_ptr<uint32_t[]> facesMaskWords;
+
+	std::unique_ptr<bool[]> tmpAreasVisRow;
+	std::unique_ptr<bool[]> blockedAreasTable;
+};
+
+auto AasElementsMask::ForCurrentThread() -> ThreadBuffers * {
+	// Buffers of the main thread live till the process exit, so don't use the level pool
+	static thread_local ThreadBuffers buffers;
+	assert( worldGeneration );
+	if( buffers.worldGeneration == worldGeneration ) [[likely]] {
+		return &buffers;
+	}
+
+	buffers.bitVectors.clear();
 
 	// Every item corresponds to a single bit.
 	// We can allocate only with a byte granularity so add one byte for every item.
-	const size_t numAreasBytes = ( worldAreas.size() / 8 ) + 4u;
-	areasMask = new( bitVectorsHolder.unsafe_grow_back() )BitVector( (uint8_t *)Q_malloc( numAreasBytes ), numAreasBytes );
-
-	const size_t numFacesBytes = ( worldFaces.size() / 8 ) + 4u;
-	facesMask = new( bitVectorsHolder.unsafe_grow_back() )BitVector( (uint8_t *)Q_malloc( numFacesBytes ), numFacesBytes );
+	const size_t numAreasBytes = ( (size_t)numAreas / 8 ) + 4u;
+	buffers.areasMaskWords.reset( new uint32_t[( numAreasBytes + 3 ) / 4] );
+	new( buffers.bitVectors.unsafe_grow_back() )BitVector( (uint8_t *)buffers.areasMaskWords.get(), numAreasBytes );
 
-	numAreas = (int)worldAreas.size();
+	const size_t numFacesBytes = ( (size_t)numFaces / 8 ) + 4u;
+	buffers.facesMaskWords.reset( new uint32_t[( numFacesBytes + 3 ) / 4] );
+	new( buffers.bitVectors.unsafe_grow_back() )BitVector( (uint8_t *)buffers.facesMaskWords.get(), numFacesBytes );
 
-	tmpAreasVisRow = (bool *)Q_malloc( sizeof( bool ) * numAreas * TMP_ROW_REDUNDANCY_SCALE );
+	buffers.tmpAreasVisRow.reset( new bool[(size_t)numAreas * TMP_ROW_REDUNDANCY_SCALE] );
 	// Don't share these buffers even it looks doable.
 	// It could lead to nasty reentrancy bugs especially considering that
 	// both buffers are very likely to be used in blocked areas status determination.
-	blockedAreasTable = (bool *)Q_malloc( sizeof( bool ) * numAreas );
+	buffers.blockedAreasTable.reset( new bool[numAreas] );
+
+	buffers.worldGeneration = worldGeneration;
+	return &buffers;
+}
+
+void AasElementsMask::Init( AiAasWorld *aasWorld ) {
+	const auto worldAreas = aasWorld->getAreas();
+	const auto worldFaces = aasWorld->getFaces();
+
+	assert( !worldAreas.empty() );
+	assert( !worldFaces.empty() );
+
+	numAreas = (int)worldAreas.size();
+	numFaces = (int)worldFaces.size();
+	// Invalidates buffers of all threads
+	worldGeneration++;
 }
 
 void AasElementsMask::Shutdown() {
-	::bitVectorsHolder.clear();
-	// Vectors do not manage the lifetime of supplied scratchpad but the level pool should take care of this
-	areasMask = nullptr;
-	facesMask = nullptr;
+	numAreas = 0;
+	numFaces = 0;
+	worldGeneration++;
+}
+
+BitVector *AasElementsMask::AreasMask() {
+	return &ForCurrentThread()->bitVectors[0];
+}
 
-	Q_free( tmpAreasVisRow );
-	tmpAreasVisRow = nullptr;
+BitVector *AasElementsMask::FacesMask() {
+	return &ForCurrentThread()->bitVectors[1];
+}
 
-	Q_free( blockedAreasTable );
-	blockedAreasTable = nullptr;
-}
\ No newline at end of file
+bool *AasElementsMask::TmpAreasVisRow() {
+	return ForCurrentThread()->tmpAreasVisRow.get();
+}
+
+bool *AasElementsMask::BlockedAreasTable() {
+	return ForCurrentThread()->blockedAreasTable.get();
+}
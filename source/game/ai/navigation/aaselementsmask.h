@@ -72,13 +72,16 @@ public:
 class AasElementsMask {
 	friend class AiAasWorld;
 
-	static BitVector *areasMask;
-	static BitVector *facesMask;
-
-	static bool *tmpAreasVisRow;
-	static bool *blockedAreasTable;
+	/**
+	 * Bots may think in parallel, so every thread uses its own masks and temporaries.
+	 * These are (re)allocated lazily if the world has been (re)loaded since the last access by the thread.
+	 */
+	struct ThreadBuffers;
+	static ThreadBuffers *ForCurrentThread();
 
 	static int numAreas;
+	static int numFaces;
+	static unsigned worldGeneration;
 
 	/**
  	 * Managed by {@code AiAasWorld} as its initialization requires these masks.
@@ -95,16 +98,16 @@ public:
 	 */
 	static constexpr unsigned TMP_ROW_REDUNDANCY_SCALE = 8;
 
-	static BitVector *AreasMask() { return areasMask; }
-	static BitVector *FacesMask() { return facesMask; }
+	static BitVector *AreasMask();
+	static BitVector *FacesMask();
 
 	static bool *TmpAreasVisRow( int instanceNum ) {
 		assert( (unsigned)instanceNum < (unsigned)TMP_ROW_REDUNDANCY_SCALE );
-		return tmpAreasVisRow + instanceNum * numAreas;
+		return TmpAreasVisRow() + instanceNum * numAreas;
 	}
 
-	static bool *TmpAreasVisRow() { return tmpAreasVisRow; }
-	static bool *BlockedAreasTable() { return blockedAreasTable; }
+	static bool *TmpAreasVisRow();
+	static bool *BlockedAreasTable();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -24,8 +24,11 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "../../../common/links.h"
 #include "../../../common/md5.h"
+#include "../../../common/qthreads.h"
 
 #include <cstdlib>
+#include <cinttypes>
+#include <optional>
 #include <limits>
 #include <cmath>
 #include <algorithm>
@@ -45,6 +48,21 @@ AiAasRouteCache *AiAasRouteCache::shared = nullptr;
 AiAasRouteCache *AiAasRouteCache::instancesHead = nullptr;
 uint64_t AiAasRouteCache::defaultBlockedAreasDigest[2];
 
+// Instances share cache tables and allocators, and the shared instance is used by many bots.
+// Bots may think in parallel, so every routing query and update of disabled zones is serialized.
+static wsw::Mutex routingMutex;
+
+// Cache tables of regular instances are allocated in a global arena and evicted in a global LRU order.
+static class AreaAndPortalCacheArena *pooledCacheArena;
+static size_t pooledCacheBytesInUse;
+// Gets incremented on every access to a table of a regular instance
+static uint64_t cacheUseCounter;
+// A value of the use counter at the start of the current routing query of a regular instance
+static uint64_t currQueryStartedAt;
+
+static AreaAndPortalCacheArena *NewCacheArena();
+static void DeleteCacheArena( AreaAndPortalCacheArena *arena );
+
 // TODO: We can and should eliminate access to this lookup table
 // along with necessity to maintain it
 // if AAS file representation is decoupled from the memory one
@@ -65,9 +83,15 @@ void AiAasRouteCache::Init( const AiAasWorld &aasWorld ) {
 	// Prepare the default blocked areas digest
 	InitDefaultBlockedAreasDigest( aasWorld );
 
+	pooledCacheArena = NewCacheArena();
+	pooledCacheBytesInUse = 0;
+	cacheUseCounter = 0;
+	currQueryStartedAt = 0;
+
 	// AiAasRouteCache is quite large, so it should be allocated on heap
 	shared = (AiAasRouteCache *)Q_malloc( sizeof( AiAasRouteCache ) );
 	new( shared )AiAasRouteCache( *AiAasWorld::instance() );
+	shared->cacheArena = pooledCacheArena;
 
 	instancesHead = shared;
 }
@@ -82,6 +106,8 @@ void AiAasRouteCache::Shutdown() {
 
 	shared->~AiAasRouteCache();
 	Q_free( shared );
+	DeleteCacheArena( pooledCacheArena );
+	pooledCacheArena = nullptr;
 	// Allow the pointer to be reused, otherwise an assertion will fail on a next Init() call
 	shared = nullptr;
 	instancesHead = nullptr;
@@ -89,17 +115,46 @@ void AiAasRouteCache::Shutdown() {
 
 AiAasRouteCache *AiAasRouteCache::NewInstance() {
 	auto *instance = new( Q_malloc( sizeof( AiAasRouteCache ) ) )AiAasRouteCache( Shared() );
+	instance->cacheArena = pooledCacheArena;
+	[[maybe_unused]] wsw::ScopedLock<wsw::Mutex> lock( &routingMutex );
 	wsw::link( instance, &AiAasRouteCache::instancesHead );
 	return instance;
 }
 
+void AiAasRouteCache::PrintStats() {
+	[[maybe_unused]] wsw::ScopedLock<wsw::Mutex> lock( &routingMutex );
+	if( !shared ) {
+		G_Printf( "The route cache is not initialized\n" );
+		return;
+	}
+
+	const unsigned budgetKiB = v_routeCacheBudget.get() * 1024;
+	G_Printf( "Cache tables: %u KiB in use, the budget is %u KiB\n", (unsigned)( pooledCacheBytesInUse / 1024 ), budgetKiB );
+
+	int instanceNum = 0;
+	for( const AiAasRouteCache *that = instancesHead; that; that = that->next ) {
+		const Stats &stats = that->m_stats;
+		G_Printf( "#%-2d %-8s results: %" PRIu64 " hits, %" PRIu64 " misses; tables: %" PRIu64 " hits, %" PRIu64
+				  " computed, %" PRIu64 " shared; %u KiB\n", instanceNum, that == shared ? "shared" : "regular",
+				  stats.numResultsCacheHits, stats.numResultsCacheMisses, stats.numTableHits,
+				  stats.numTablesComputed, stats.numTablesShared, (unsigned)( stats.numBytesInUse / 1024 ) );
+		instanceNum++;
+	}
+}
+
 void AiAasRouteCache::ReleaseInstance( AiAasRouteCache *instance ) {
 	if( instance == Shared() ) {
 		AI_FailWith( "AiAasRouteCache::ReleaseInstance()", "Attempt to release the shared instance\n" );
 	}
 
-	wsw::unlink( instance, &AiAasRouteCache::instancesHead );
-	instance->~AiAasRouteCache();
+	if( !instance->isPrivate ) {
+		// Tables of the instance belong to the global arena and may be referred by other instances
+		[[maybe_unused]] wsw::ScopedLock<wsw::Mutex> lock( &routingMutex );
+		wsw::unlink( instance, &AiAasRouteCache::instancesHead );
+		instance->~AiAasRouteCache();
+	} else {
+		instance->~AiAasRouteCache();
+	}
 	Q_free( instance );
 }
 
@@ -169,7 +224,13 @@ AiAasRouteCache::~AiAasRouteCache() {
 	FreeRefCountedMemory( reachPathFindingData );
 	FreeMemory( areaPathFindingData );
 
-	FreeAreaAndPortalMemoryPools();
+	if( isPrivate ) {
+		DeleteCacheArena( cacheArena );
+	}
+
+	if( privateHeap ) {
+		Q_free( privateHeap );
+	}
 }
 
 /**
@@ -251,14 +312,36 @@ void AiAasRouteCache::LinkCache( AreaOrPortalCacheTable *cache ) {
 	}
 	cache->time_next = nullptr;
 	newestCache = cache;
+	// Private instances are not evicted globally and may be used by different threads
+	if( !isPrivate ) {
+		cache->lastUsedAt = ++cacheUseCounter;
+	}
 }
 
 void AiAasRouteCache::FreeRoutingCache( AreaOrPortalCacheTable *cache ) {
 	UnlinkCache( cache );
-	FreeAreaAndPortalCacheMemory( cache );
+	ReleaseCacheTable( cache );
+}
+
+void AiAasRouteCache::ReleaseCacheTable( AreaOrPortalCacheTable *cache ) {
+	m_stats.numBytesInUse -= cache->size;
+	do {
+		AreaOrPortalCacheTable *const dataOwner = cache->dataOwner;
+		// The data is still referred by tables of other instances
+		if( --cache->numRefs ) {
+			break;
+		}
+		if( !isPrivate ) {
+			pooledCacheBytesInUse -= cache->size;
+		}
+		FreeAreaAndPortalCacheMemory( cache );
+		cache = dataOwner;
+	} while( cache );
 }
 
 void AiAasRouteCache::SetDisabledZones( DisableZoneRequest **requests, int numRequests ) {
+	[[maybe_unused]] wsw::ScopedLock<wsw::Mutex> lock( &routingMutex );
+
 	// Copy the reference to a local var for faster access
 	AreaPathFindingData *const areaPathFindingData = this->areaPathFindingData;
 	const auto aasAreaSettings = aasWorld.getAreaSettings();
@@ -874,56 +957,96 @@ void AreaAndPortalCacheAllocatorBin::Free( void *ptr ) {
 	usedSingleBlock = nullptr;
 }
 
-void *AiAasRouteCache::GetClearedMemory( size_t size ) {
-	void *mem = Q_malloc( size );
-	::memset( mem, 0, size );
-	return mem;
-}
+class AreaAndPortalCacheArena {
+	// A linked list for bins of relatively large size
+	AreaAndPortalCacheAllocatorBin *binsHead { nullptr };
+	// A table of small size bins addressed by bin size
+	AreaAndPortalCacheAllocatorBin *smallBinsTable[128] { nullptr };
 
-void AiAasRouteCache::FreeMemory( void *ptr ) {
-	Q_free( ptr );
+	static AreaAndPortalCacheAllocatorBin *NewBin( size_t size ) {
+		void *mem = Q_malloc( sizeof( AreaAndPortalCacheAllocatorBin ) );
+		memset( mem, 0, sizeof( AreaAndPortalCacheAllocatorBin ) );
+		return new( mem )AreaAndPortalCacheAllocatorBin( size );
+	}
+
+	static void DeleteBin( AreaAndPortalCacheAllocatorBin *bin ) {
+		bin->~AreaAndPortalCacheAllocatorBin();
+		Q_free( bin );
+	}
+public:
+	~AreaAndPortalCacheArena();
+
+	AreaAndPortalCacheAllocatorBin *FindOrCreateBinForSize( size_t size );
+};
+
+AreaAndPortalCacheArena::~AreaAndPortalCacheArena() {
+	auto *bin = binsHead;
+	while( bin ) {
+		// Don't trigger "use after free"
+		auto *nextBin = bin->next;
+		DeleteBin( bin );
+		bin = nextBin;
+	}
+
+	for( AreaAndPortalCacheAllocatorBin *smallBin: smallBinsTable ) {
+		if( smallBin ) {
+			DeleteBin( smallBin );
+		}
+	}
 }
 
-void *AiAasRouteCache::AllocAreaAndPortalCacheMemory( size_t size ) {
+AreaAndPortalCacheAllocatorBin *AreaAndPortalCacheArena::FindOrCreateBinForSize( size_t size ) {
 	// Check whether the corresponding bin chunk size is small enough
 	// to allow the bin to be addressed directly by size.
-	if( size < sizeof( areaAndPortalSmallBinsTable ) / sizeof( *areaAndPortalSmallBinsTable ) ) {
-		if( auto *bin = areaAndPortalSmallBinsTable[size] ) {
-			assert( bin->FitsSize( size ) );
-			if( bin->NeedsCleanup() ) {
-				FreeOldestCache();
-			}
-			return bin->Alloc( size );
+	if( size < std::size( smallBinsTable ) ) {
+		if( !smallBinsTable[size] ) {
+			smallBinsTable[size] = NewBin( size );
 		}
-
-		// Create a new bin for the size
-		void *mem = Q_malloc( sizeof( AreaAndPortalCacheAllocatorBin ) );
-		memset( mem, 0, sizeof( AreaAndPortalCacheAllocatorBin ) );
-		auto *newBin = new( mem )AreaAndPortalCacheAllocatorBin( size );
-		areaAndPortalSmallBinsTable[size] = newBin;
-		return newBin->Alloc( size );
+		assert( smallBinsTable[size]->FitsSize( size ) );
+		return smallBinsTable[size];
 	}
 
 	// Check whether there are bins able to handle the request in the common bins list
-	for( AreaAndPortalCacheAllocatorBin *bin = areaAndPortalCacheHead; bin; bin = bin->next ) {
+	for( AreaAndPortalCacheAllocatorBin *bin = binsHead; bin; bin = bin->next ) {
 		if( bin->FitsSize( size ) ) {
-			if( bin->NeedsCleanup() ) {
-				FreeOldestCache();
-			}
-			return bin->Alloc( size );
+			return bin;
 		}
 	}
 
-	// Create a new bin for the size
-	void *mem = Q_malloc( sizeof( AreaAndPortalCacheAllocatorBin ) );
-	memset( mem, 0, sizeof( AreaAndPortalCacheAllocatorBin ) );
-	auto *newBin = new( mem )AreaAndPortalCacheAllocatorBin( size );
+	// Create a new bin for the size and link it to the bins list head
+	auto *newBin = NewBin( size );
+	newBin->next = binsHead;
+	binsHead = newBin;
+	return newBin;
+}
+
+static AreaAndPortalCacheArena *NewCacheArena() {
+	return new( Q_malloc( sizeof( AreaAndPortalCacheArena ) ) )AreaAndPortalCacheArena;
+}
+
+static void DeleteCacheArena( AreaAndPortalCacheArena *arena ) {
+	arena->~AreaAndPortalCacheArena();
+	Q_free( arena );
+}
 
-	// Link it to the bins list head
-	newBin->next = areaAndPortalCacheHead;
-	areaAndPortalCacheHead = newBin;
+void *AiAasRouteCache::GetClearedMemory( size_t size ) {
+	void *mem = Q_malloc( size );
+	::memset( mem, 0, size );
+	return mem;
+}
 
-	return newBin->Alloc( size );
+void AiAasRouteCache::FreeMemory( void *ptr ) {
+	Q_free( ptr );
+}
+
+void *AiAasRouteCache::AllocAreaAndPortalCacheMemory( size_t size ) {
+	AreaAndPortalCacheAllocatorBin *const bin = cacheArena->FindOrCreateBinForSize( size );
+	// Regular instances are limited by the global budget instead.
+	// Bins of the global arena fall back to heap allocations if their pools get exhausted.
+	if( isPrivate && bin->NeedsCleanup() ) {
+		FreeOldestCache();
+	}
+	return bin->Alloc( size );
 }
 
 void AiAasRouteCache::FreeAreaAndPortalCacheMemory( void *ptr ) {
@@ -931,23 +1054,41 @@ void AiAasRouteCache::FreeAreaAndPortalCacheMemory( void *ptr ) {
 	AreaAndPortalCacheAllocatorBin::FreeTaggedBlock( ptr );
 }
 
-void AiAasRouteCache::FreeAreaAndPortalMemoryPools() {
-	auto *bin = areaAndPortalCacheHead;
-	while( bin ) {
-		// Don't trigger "use after free"
-		auto *nextBin = bin->next;
-		Q_free( bin );
-		bin = nextBin;
+void *AiAasRouteCache::AllocCacheTableMemory( size_t size ) {
+	if( !isPrivate ) {
+		EnforceCacheBudget( size );
+		pooledCacheBytesInUse += size;
 	}
+	m_stats.numBytesInUse += size;
+	return AllocAreaAndPortalCacheMemory( size );
+}
 
-	int binsTableCapacity = sizeof( areaAndPortalSmallBinsTable ) / sizeof( areaAndPortalSmallBinsTable[0] );
-	for( int i = 0; i < binsTableCapacity; ++i ) {
-		if( areaAndPortalSmallBinsTable[i] ) {
-			Q_free( areaAndPortalSmallBinsTable[i] );
+void AiAasRouteCache::EnforceCacheBudget( size_t size ) {
+	const size_t budget = (size_t)v_routeCacheBudget.get() * 1024 * 1024;
+	while( pooledCacheBytesInUse + size > budget ) {
+		// Tables of the current query are in use, so the budget is allowed to be exceeded temporarily
+		if( !FreeGloballyOldestCache() ) {
+			break;
 		}
 	}
 }
 
+bool AiAasRouteCache::FreeGloballyOldestCache() {
+	AiAasRouteCache *victim = nullptr;
+	uint64_t oldestUse = currQueryStartedAt;
+	// Time lists of instances are ordered by the use counter, so checking their heads is sufficient
+	for( AiAasRouteCache *that = instancesHead; that; that = that->next ) {
+		if( const AreaOrPortalCacheTable *cache = that->oldestCache ) {
+			if( cache->lastUsedAt < oldestUse ) {
+				oldestUse = cache->lastUsedAt;
+				victim = that;
+			}
+		}
+	}
+
+	return victim && victim->FreeOldestCache();
+}
+
 bool AiAasRouteCache::FreeOldestCache() {
 	const auto aasAreaSettings = aasWorld.getAreaSettings();
 	const auto aasPortals = aasWorld.getPortals();
@@ -974,16 +1115,31 @@ bool AiAasRouteCache::FreeOldestCache() {
 	return false;
 }
 
-AiAasRouteCache::AreaOrPortalCacheTable *AiAasRouteCache::AllocRoutingCache( int numTravelTimes, bool zeroMemory ) {
+AiAasRouteCache::AreaOrPortalCacheTable *AiAasRouteCache::AllocRoutingCache( int numTravelTimes ) {
 	size_t size = sizeof( AreaOrPortalCacheTable );
 	size += numTravelTimes * sizeof( uint16_t );
 	size += numTravelTimes * sizeof( uint8_t );
 
-	auto *const cache = (AreaOrPortalCacheTable *)AllocAreaAndPortalCacheMemory( size );
-	if( zeroMemory ) {
-		::memset( cache, 0, size );
-	}
+	auto *const cache = (AreaOrPortalCacheTable *)AllocCacheTableMemory( size );
+	::memset( cache, 0, size );
+	cache->FixVarLenDataRefs( numTravelTimes );
+	assert( cache->size == size );
+	cache->numRefs = 1;
+	return cache;
+}
 
+AiAasRouteCache::AreaOrPortalCacheTable *AiAasRouteCache::AllocSharedRoutingCache( AreaOrPortalCacheTable *siblingCache ) {
+	AreaOrPortalCacheTable *const dataOwner = siblingCache->dataOwner ? siblingCache->dataOwner : siblingCache;
+	// Add the reference prior to the allocation as the sibling table may be evicted to fit the budget
+	dataOwner->numRefs++;
+
+	auto *const cache = (AreaOrPortalCacheTable *)AllocCacheTableMemory( sizeof( AreaOrPortalCacheTable ) );
+	::memset( cache, 0, sizeof( AreaOrPortalCacheTable ) );
+	cache->travelTimes = dataOwner->travelTimes;
+	cache->reachOffsets = dataOwner->reachOffsets;
+	cache->size = sizeof( AreaOrPortalCacheTable );
+	cache->numRefs = 1;
+	cache->dataOwner = dataOwner;
 	return cache;
 }
 
@@ -1007,7 +1163,7 @@ void AiAasRouteCache::ResetAllClusterAreaCache() {
 			AreaOrPortalCacheTable *nextCache;
 			for( auto *cache = clusterAreaCache[i][j]; cache; cache = nextCache ) {
 				nextCache = cache->next;
-				FreeAreaAndPortalCacheMemory( cache );
+				ReleaseCacheTable( cache );
 			}
 			clusterAreaCache[i][j] = nullptr;
 		}
@@ -1054,7 +1210,7 @@ void AiAasRouteCache::ResetAllPortalCache() {
 		AreaOrPortalCacheTable *nextCache;
 		for( auto *cache = portalCache[i]; cache; cache = nextCache ) {
 			nextCache = cache->next;
-			FreeAreaAndPortalCacheMemory( cache );
+			ReleaseCacheTable( cache );
 		}
 		portalCache[i] = nullptr;
 	}
@@ -1125,9 +1281,16 @@ struct MonotonicIntegerHeap {
 };
 
 // Let it be global for saving memory bandwidth when switching from bot to bot.
-// It's unlikely that routing is going performed from multiple threads simultaneously in foreseeable future.
+// Regular instances access it under the routing lock, private instances own separate heaps.
 static MonotonicIntegerHeap globalHeap;
 
+AiAasRouteCache *AiAasRouteCache::NewPrivateInstance() {
+	auto *instance = new( Q_malloc( sizeof( AiAasRouteCache ) ) )AiAasRouteCache( Shared() );
+	instance->isPrivate = true;
+	instance->privateHeap = new( Q_malloc( sizeof( MonotonicIntegerHeap ) ) )MonotonicIntegerHeap;
+	return instance;
+}
+
 void AiAasRouteCache::UpdateAreaRoutingCache( std::span<const aas_areasettings_t> aasAreaSettings,
 											  std::span<const aas_portal_t> aasPortals,
 											  AreaOrPortalCacheTable *areaCache ) const {
@@ -1156,7 +1319,7 @@ void AiAasRouteCache::UpdateAreaRoutingCache( std::span<const aas_areasettings_t
 		pathFindingNodes[i].dijkstraLabel = UNREACHED;
 	}
 
-	MonotonicIntegerHeap *const __restrict heap = &::globalHeap;
+	MonotonicIntegerHeap *const __restrict heap = privateHeap ? privateHeap : &::globalHeap;
 	heap->clear();
 
 	PathFinderNode *currAreaNode = &pathFindingNodes[clusterAreaNum];
@@ -1296,28 +1459,18 @@ AiAasRouteCache::GetAreaRoutingCache( std::span<const aas_areasettings_t> aasAre
 	}
 
 	if( !cache ) {
-		const int numTravelTimes = aasWorld.getClusters()[clusterNum].numreachabilityareas;
 		// Try checking whether siblings have a cache for this area
-		if( const auto *siblingCache = FindSiblingCache( clusterNum, clusterAreaNum, travelFlags ) ) {
-			// Allocate a raw memory chunk as we're about to overwrite it
-			cache = AllocRoutingCache( numTravelTimes, false );
-			// Copy the data behind the header
-			auto *const dest = (uint8_t *)cache + sizeof( AreaOrPortalCacheTable );
-			const auto *src = (uint8_t *)siblingCache + sizeof( AreaOrPortalCacheTable );
-			::memcpy( dest, src, siblingCache->size - sizeof( AreaOrPortalCacheTable ) );
-			// Prevent occasionally sharing sibling mutable data (pointers)
-			memset( cache, 0, sizeof( AreaOrPortalCacheTable ) );
-			// Fix header fields
-			cache->FixVarLenDataRefs( numTravelTimes );
-			// Make sure the sibling cache was valid
-			assert( cache->size == siblingCache->size );
+		if( auto *siblingCache = FindSiblingAreaCache( clusterNum, clusterAreaNum, travelFlags ) ) {
+			// Refer to the immutable sibling data
+			cache = AllocSharedRoutingCache( siblingCache );
 			cache->SetPathFindingProps( clusterNum, areaNum, travelFlags );
+			m_stats.numTablesShared++;
 		} else {
 			// Allocate a clean memory chunk
-			cache = AllocRoutingCache( numTravelTimes, true );
-			cache->FixVarLenDataRefs( numTravelTimes );
+			cache = AllocRoutingCache( aasWorld.getClusters()[clusterNum].numreachabilityareas );
 			cache->SetPathFindingProps( clusterNum, areaNum, travelFlags );
 			UpdateAreaRoutingCache( aasAreaSettings, aasPortals, cache );
+			m_stats.numTablesComputed++;
 		}
 
 		auto *oldCacheHead = clusterAreaCache[clusterNum][clusterAreaNum];
@@ -1329,6 +1482,7 @@ AiAasRouteCache::GetAreaRoutingCache( std::span<const aas_areasettings_t> aasAre
 		clusterAreaCache[clusterNum][clusterAreaNum] = cache;
 	} else {
 		UnlinkCache( cache );
+		m_stats.numTableHits++;
 	}
 
 	cache->type = CACHETYPE_AREA;
@@ -1336,11 +1490,11 @@ AiAasRouteCache::GetAreaRoutingCache( std::span<const aas_areasettings_t> aasAre
 	return cache;
 }
 
-const AiAasRouteCache::AreaOrPortalCacheTable *
-AiAasRouteCache::FindSiblingCache( int clusterNum, int clusterAreaNum, int travelFlags ) const {
+AiAasRouteCache::AreaOrPortalCacheTable *
+AiAasRouteCache::FindSiblingAreaCache( int clusterNum, int clusterAreaNum, int travelFlags ) const {
 	// We're not 100% confident yet whether the implementation is valid.
 	// Add an option to override the sharing behaviour if sharing cache for some maps lead to troubles.
-	if( !v_shareRoutingCache.get() ) {
+	if( !v_shareRoutingCache.get() || isPrivate ) {
 		return nullptr;
 	}
 
@@ -1351,7 +1505,7 @@ AiAasRouteCache::FindSiblingCache( int clusterNum, int clusterAreaNum, int trave
 			continue;
 		}
 
-		const AreaOrPortalCacheTable *cache = that->clusterAreaCache[clusterNum][clusterAreaNum];
+		AreaOrPortalCacheTable *cache = that->clusterAreaCache[clusterNum][clusterAreaNum];
 		for(; cache; cache = cache->next ) {
 			if( cache->travelFlags == travelFlags ) {
 				return cache;
@@ -1362,6 +1516,26 @@ AiAasRouteCache::FindSiblingCache( int clusterNum, int clusterAreaNum, int trave
 	return nullptr;
 }
 
+AiAasRouteCache::AreaOrPortalCacheTable *AiAasRouteCache::FindSiblingPortalCache( int areaNum, int travelFlags ) const {
+	if( !v_shareRoutingCache.get() || isPrivate ) {
+		return nullptr;
+	}
+
+	for( const auto *that = AiAasRouteCache::instancesHead; that; that = that->next ) {
+		if( !BlockedAreasDigestsMatch( that->blockedAreasDigest, this->blockedAreasDigest ) ) {
+			continue;
+		}
+
+		for( AreaOrPortalCacheTable *cache = that->portalCache[areaNum]; cache; cache = cache->next ) {
+			if( cache->travelFlags == travelFlags ) {
+				return cache;
+			}
+		}
+	}
+
+	return nullptr;
+}
+
 void AiAasRouteCache::UpdatePortalRoutingCache( AreaOrPortalCacheTable *portalCache ) {
 	const auto aasAreaSettings = aasWorld.getAreaSettings();
 	const auto aasPortalIndex = aasWorld.getPortalIndex();
@@ -1463,8 +1637,12 @@ AiAasRouteCache::GetPortalRoutingCache( std::span<const aas_areasettings_t> aasA
 	}
 	//if the portal routing isn't cached
 	if( !cache ) {
-		cache = AllocRoutingCache( aasWorld.getPortals().size() );
-		cache->FixVarLenDataRefs( aasWorld.getPortals().size() );
+		auto *const siblingCache = FindSiblingPortalCache( areaNum, travelFlags );
+		if( siblingCache ) {
+			cache = AllocSharedRoutingCache( siblingCache );
+		} else {
+			cache = AllocRoutingCache( aasWorld.getPortals().size() );
+		}
 		cache->SetPathFindingProps( clusterNum, areaNum, travelFlags );
 		//add the cache to the cache list
 		cache->prev = nullptr;
@@ -1476,10 +1654,16 @@ AiAasRouteCache::GetPortalRoutingCache( std::span<const aas_areasettings_t> aasA
 			oldCacheHead->prev = cache;
 		}
 		portalCache[areaNum] = cache;
-		//update the cache
-		UpdatePortalRoutingCache( cache );
+		if( siblingCache ) {
+			m_stats.numTablesShared++;
+		} else {
+			//update the cache
+			UpdatePortalRoutingCache( cache );
+			m_stats.numTablesComputed++;
+		}
 	} else {
 		UnlinkCache( cache );
+		m_stats.numTableHits++;
 	}
 	//the cache has been accessed
 	cache->type = CACHETYPE_PORTAL;
@@ -1539,14 +1723,23 @@ bool AiAasRouteCache::RoutingResultToGoalArea( int fromAreaNum, int toAreaNum,
 	}
 #endif
 
+	// Private instances are not accessed by different threads simultaneously
+	std::optional<wsw::ScopedLock<wsw::Mutex>> lock;
+	if( !isPrivate ) {
+		lock.emplace( &routingMutex );
+	}
+
 	const uint64_t key      = FastRoutingResultsCache::makeKey( fromAreaNum, toAreaNum, travelFlags );
 	const uint16_t binIndex = FastRoutingResultsCache::calcBinIndexForKey( key );
 	if( const FastRoutingResultsCache::Node *cacheNode = m_resultsCache.getCachedResultForKey( binIndex, key ) ) {
 		result->reachNum   = cacheNode->reachability;
 		result->travelTime = cacheNode->travelTime;
+		nonConstThis->m_stats.numResultsCacheHits++;
 		return cacheNode->reachability != 0;
 	}
 
+	nonConstThis->m_stats.numResultsCacheMisses++;
+
 	FastRoutingResultsCache::Node *const cacheNode = nonConstThis->m_resultsCache.allocAndRegisterForKey( binIndex, key );
 
 	// Don't try reading from the table if it explicitly blocks that
@@ -1568,6 +1761,11 @@ bool AiAasRouteCache::RoutingResultToGoalArea( int fromAreaNum, int toAreaNum,
 		}
 	}
 
+	// Make sure tables accessed by this query are not evicted till the query completion
+	if( !isPrivate ) {
+		currQueryStartedAt = cacheUseCounter + 1;
+	}
+
 	RoutingRequest request( fromAreaNum, toAreaNum, travelFlags );
 	// TODO: It's non-obvious that FindRoute() modifies `result`
 	if( nonConstThis->FindRoute( request, result ) ) {
@@ -54,6 +54,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define TFL_NOTTEAM1            0x08000000  //not team 1
 #define TFL_NOTTEAM2            0x10000000  //not team 2
 
+struct MonotonicIntegerHeap;
+
 class AiAasRouteCache {
 	template<typename T> friend auto wsw::link( T *, T ** ) -> T *;
 	template<typename T> friend auto wsw::unlink( T *, T ** ) -> T *;
@@ -120,6 +122,21 @@ class AiAasRouteCache {
 		 * @todo link area and cluster caches to different lists
 		*/
 		uint16_t type;
+		/**
+		 * A number of tables that refer to data of this table (including this table itself).
+		 * Tables are immutable once computed, so instances that have matching blocked areas digests
+		 * share data of tables instead of computing or copying it.
+		 */
+		uint32_t numRefs;
+		/**
+		 * A table that owns {@code travelTimes} and {@code reachOffsets} data if this table refers to data of another one.
+		 */
+		AreaOrPortalCacheTable *dataOwner;
+		/**
+		 * A value of the global use counter at the moment of the last access to this table.
+		 * Tables of regular instances are evicted in the order of this value regardless of their instance.
+		 */
+		uint64_t lastUsedAt;
 
 		/**
 		 * A helper low-level method for setting {@code travelTimes}, {@code reachOffsets} refs relative to {@code this}.
@@ -182,6 +199,12 @@ class AiAasRouteCache {
 
 	bool loaded { false };
 
+	/**
+	 * A private instance is not linked to other instances and owns its path-finding heap.
+	 */
+	bool isPrivate { false };
+	MonotonicIntegerHeap *privateHeap { nullptr };
+
 	/**
 	 * It is sufficient to fit all required info in 2 bits, but we should avoid using bitsets
 	 * since variable shifts are required for access patterns used by implemented algorithms
@@ -315,17 +338,33 @@ class AiAasRouteCache {
 		}
 	}
 
-	// A linked list for bins of relatively large size
-	class AreaAndPortalCacheAllocatorBin *areaAndPortalCacheHead { nullptr };
-	// A table of small size bins addressed by bin size
-	class AreaAndPortalCacheAllocatorBin *areaAndPortalSmallBinsTable[128] { nullptr };
+	/**
+	 * An allocator of cache tables.
+	 * Regular instances share a global arena which total size is limited by {@code ai_routeCacheBudget}.
+	 * Private instances own their arenas.
+	 */
+	class AreaAndPortalCacheArena *cacheArena { nullptr };
 
 	FastRoutingResultsCache m_resultsCache;
 
+	struct Stats {
+		uint64_t numResultsCacheHits { 0 };
+		uint64_t numResultsCacheMisses { 0 };
+		uint64_t numTableHits { 0 };
+		uint64_t numTablesComputed { 0 };
+		uint64_t numTablesShared { 0 };
+		size_t numBytesInUse { 0 };
+	} m_stats;
+
 	void LinkCache( AreaOrPortalCacheTable *cache );
 	void UnlinkCache( AreaOrPortalCacheTable *cache );
 
 	void FreeRoutingCache( AreaOrPortalCacheTable *cache );
+	/**
+	 * Releases a reference of this instance to a table.
+	 * The table memory is freed once there are no other tables referring to its data.
+	 */
+	void ReleaseCacheTable( AreaOrPortalCacheTable *cache );
 
 	void *GetClearedMemory( size_t size );
 	void FreeMemory( void *ptr );
@@ -333,11 +372,24 @@ class AiAasRouteCache {
 	void *AllocAreaAndPortalCacheMemory( size_t size );
 	void FreeAreaAndPortalCacheMemory( void *ptr );
 
-	void FreeAreaAndPortalMemoryPools();
+	/**
+	 * Allocates a table memory taking the memory budget of regular instances into account.
+	 */
+	void *AllocCacheTableMemory( size_t size );
+	void EnforceCacheBudget( size_t size );
 
 	bool FreeOldestCache();
+	/**
+	 * Frees the least recently used table of all regular instances.
+	 * Tables that were accessed during the current routing query are kept.
+	 */
+	static bool FreeGloballyOldestCache();
 
-	AreaOrPortalCacheTable *AllocRoutingCache( int numTravelTimes, bool zeroMemory = true );
+	AreaOrPortalCacheTable *AllocRoutingCache( int numTravelTimes );
+	/**
+	 * Allocates a table that refers to data of the supplied table of another instance.
+	 */
+	AreaOrPortalCacheTable *AllocSharedRoutingCache( AreaOrPortalCacheTable *siblingCache );
 
 	void UpdateAreaRoutingCache( std::span<const aas_areasettings_t> aasAreaSettings,
 								 std::span<const aas_portal_t> aasPortals,
@@ -351,7 +403,8 @@ class AiAasRouteCache {
 		return ( digest1[0] == digest2[0] ) & ( digest1[1] == digest2[1] );
 	}
 
-	const AreaOrPortalCacheTable *FindSiblingCache( int clusterNum, int clusterAreaNum, int travelFlags ) const;
+	AreaOrPortalCacheTable *FindSiblingAreaCache( int clusterNum, int clusterAreaNum, int travelFlags ) const;
+	AreaOrPortalCacheTable *FindSiblingPortalCache( int areaNum, int travelFlags ) const;
 
 	void UpdatePortalRoutingCache( AreaOrPortalCacheTable *portalCache );
 
@@ -412,8 +465,20 @@ public:
 
 	static AiAasRouteCache *Shared() { return shared; }
 	static AiAasRouteCache *NewInstance();
+	/**
+	 * Creates an instance that neither shares cache tables with other instances
+	 * nor uses global path-finding buffers, so queries to it are not serialized.
+	 * Different private instances may be used by different threads simultaneously.
+	 * The instance should be released by {@code ReleaseInstance()}.
+	 */
+	static AiAasRouteCache *NewPrivateInstance();
 	static void ReleaseInstance( AiAasRouteCache *instance );
 
+	/**
+	 * Prints memory usage and cache hits/misses of regular instances.
+	 */
+	static void PrintStats();
+
 	// A helper for emplace_back() calls on instances of this class
 	//AiAasRouteCache( AiAasRouteCache &&that );
 	~AiAasRouteCache();
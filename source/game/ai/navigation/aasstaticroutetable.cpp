@@ -5,6 +5,8 @@
 #include "../rewriteme.h"
 #include "../../../common/singletonholder.h"
 #include "../../../common/wswvector.h"
+#include "../../../common/tasksystem.h"
+#include <atomic>
 #include <cinttypes>
 
 #ifdef WSW_USE_SSE2
@@ -61,10 +63,16 @@ AasStaticRouteTable::AasStaticRouteTable( const char *mapName ) {
 }
 
 AasStaticRouteTable::~AasStaticRouteTable() {
-	Q_free( m_dataForAllowedFlags.entries );
-	Q_free( m_dataForAllowedFlags.areaNums );
+	// The data is released along with the mapping otherwise
+	if( !m_fileMapping ) {
+		Q_free( (void *)m_dataForAllowedFlags.entries );
+		Q_free( (void *)m_dataForAllowedFlags.areaNums );
 
-	Q_free( m_bufferSpans );
+		Q_free( (void *)m_walkingAreaNums );
+		Q_free( (void *)m_walkingTravelTimes );
+
+		Q_free( (void *)m_bufferSpans );
+	}
 }
 
 static constexpr const char *kFileTag   = "RouteTable";
@@ -76,41 +84,43 @@ bool AasStaticRouteTable::loadFromFile( const char *filePath ) {
 		return false;
 	}
 
-	uint16_t *allowedNums = nullptr;
-	AreaEntry *allowedEntries = nullptr;
-	uint16_t *walkingNums = nullptr, *walkingTimes = nullptr;
-	BufferSpansForFlags *spans = nullptr;
+	const uint16_t *allowedNums = nullptr;
+	const AreaEntry *allowedEntries = nullptr;
+	const uint16_t *walkingNums = nullptr, *walkingTimes = nullptr;
+	const BufferSpansForFlags *spans = nullptr;
 
 	uint32_t numAllowedNums = 0, numAllowedEntries = 0;
 	uint32_t numWalkingNums = 0, numWalkingTimes = 0;
 	uint32_t numSpans = 0;
 
-	wsw::StaticVector<void *, 5> allocatedData;
+	wsw::StaticVector<const void *, 5> retrievedData;
 
+	// The data is used in place if the file is mapped
 	// TODO: The reader is defined in "rewriteme.h" for a reason...
-	if( reader.ReadAsTypedBuffer( &allowedNums, &numAllowedNums ) ) {
-		allocatedData.push_back( allowedNums );
+	if( reader.MapAsTypedBuffer( &allowedNums, &numAllowedNums ) ) {
+		retrievedData.push_back( allowedNums );
 	}
-	if( reader.ReadAsTypedBuffer( &allowedEntries, &numAllowedEntries ) ) {
-		allocatedData.push_back( allowedEntries );
+	if( reader.MapAsTypedBuffer( &allowedEntries, &numAllowedEntries ) ) {
+		retrievedData.push_back( allowedEntries );
 	}
-	if( reader.ReadAsTypedBuffer( &walkingNums, &numWalkingNums ) ) {
-		allocatedData.push_back( walkingNums );
+	if( reader.MapAsTypedBuffer( &walkingNums, &numWalkingNums ) ) {
+		retrievedData.push_back( walkingNums );
 	}
-	if( reader.ReadAsTypedBuffer( &walkingTimes, &numWalkingTimes ) ) {
-		allocatedData.push_back( walkingTimes );
+	if( reader.MapAsTypedBuffer( &walkingTimes, &numWalkingTimes ) ) {
+		retrievedData.push_back( walkingTimes );
 	}
 
-	if( reader.ReadAsTypedBuffer( &spans, &numSpans ) ) {
-		allocatedData.push_back( spans );
+	if( reader.MapAsTypedBuffer( &spans, &numSpans ) ) {
+		retrievedData.push_back( spans );
 	}
 
-	// The second condition is a minimal validation.
-	// We should not really care about the latter once a proper checksum handling is implemented.
-	if( !allocatedData.full() || ( numSpans != AiAasWorld::instance()->getAreas().size() ) ) {
-		for( void *p : allocatedData ) {
-			assert( p );
-			Q_free( p );
+	// The second condition is a minimal validation (chunk checksums have been checked by the reader).
+	if( !retrievedData.full() || ( numSpans != AiAasWorld::instance()->getAreas().size() ) ) {
+		if( !reader.IsMapped() ) {
+			for( const void *p : retrievedData ) {
+				assert( p );
+				Q_free( (void *)p );
+			}
 		}
 		return false;
 	}
@@ -128,6 +138,8 @@ bool AasStaticRouteTable::loadFromFile( const char *filePath ) {
 	m_bufferSpans = spans;
 	m_numAreas    = numSpans;
 
+	m_fileMapping = reader.ReleaseMapping();
+
 	return true;
 }
 
@@ -265,6 +277,95 @@ struct NumsAndEntriesBuilder {
 	}
 };
 
+/**
+ * Routing results from an area which get computed independently from other areas
+ */
+struct AasStaticRouteTable::ComputedRow {
+	wsw::PodVector<uint16_t> allowedNums;
+	wsw::PodVector<AreaEntry> allowedEntries;
+	wsw::PodVector<uint16_t> walkingNums;
+	wsw::PodVector<uint16_t> walkingTravelTimes;
+};
+
+void AasStaticRouteTable::computeRow( AiAasRouteCache *routeCache, uint16_t fromAreaNum,
+									  uint16_t numAreas, ComputedRow *row ) {
+	const auto *aasWorld = AiAasWorld::instance();
+
+	row->allowedNums.clear();
+	row->allowedEntries.clear();
+	row->walkingNums.clear();
+	row->walkingTravelTimes.clear();
+
+	for( uint16_t toAreaNum = 1; toAreaNum < numAreas; ++toAreaNum ) {
+		if( fromAreaNum != toAreaNum ) {
+			// TODO: Add public getters to AiAasRouteCache that allow
+			// a simultaneous retrieval (existing private ones are very poor)
+			// TODO: We actually can read the entire Dijkstra's algorithm result for the given from area
+			// (Area-by-area retrieval still works fast due to internal caching in the route cache)
+			int reach = 0;
+			if( const int time = routeCache->FindRoute( fromAreaNum, toAreaNum, Bot::ALLOWED_TRAVEL_FLAGS, &reach ) ) {
+				row->allowedNums.push_back( toAreaNum );
+				row->allowedEntries.push_back( AreaEntry {
+					.reachNum = (uint16_t)reach, .travelTime = (uint16_t)time,
+				});
+			}
+			if( const int time = calcTravelTimeWalkingOrFallingShort( routeCache, aasWorld, fromAreaNum, toAreaNum ) ) {
+				assert( (unsigned)time <= (unsigned)std::numeric_limits<uint16_t>::max() );
+				row->walkingNums.push_back( toAreaNum );
+				row->walkingTravelTimes.push_back( (uint16_t)time );
+			}
+		}
+	}
+}
+
+bool AasStaticRouteTable::computeRowsInParallel( uint16_t numAreas, ComputedRow *rows ) {
+	wsw::PodVector<AiAasRouteCache *> routeCaches;
+
+	bool succeeded = false;
+	try {
+		TaskSystem taskSystem( { .numExtraThreads = AI_SuggestNumExtraThreadsForComputations() } );
+		// Computing using the shared route cache is preferred in this case
+		if( taskSystem.getNumberOfWorkers() < 2 ) {
+			return false;
+		}
+
+		// Routing via the shared route cache is serialized, use separate instances for workers
+		for( unsigned i = 0; i < taskSystem.getNumberOfWorkers(); ++i ) {
+			routeCaches.push_back( AiAasRouteCache::NewPrivateInstance() );
+		}
+
+		std::atomic<unsigned> numComputedRows { 0 };
+		std::atomic<unsigned> lastDisplayedProgress { 0 };
+		auto fn = [&]( unsigned workerIndex, unsigned beginAreaNum, unsigned endAreaNum ) {
+			for( unsigned fromAreaNum = beginAreaNum; fromAreaNum < endAreaNum; ++fromAreaNum ) {
+				computeRow( routeCaches[workerIndex], (uint16_t)fromAreaNum, numAreas, rows + fromAreaNum );
+			}
+			const unsigned totalComputedRows = numComputedRows.fetch_add( endAreaNum - beginAreaNum ) + ( endAreaNum - beginAreaNum );
+			const auto currProgress = (unsigned)std::floor( 100.0 * ( (double)totalComputedRows / (double)( numAreas - 1 ) ) );
+			unsigned displayedProgress = lastDisplayedProgress.load( std::memory_order_relaxed );
+			while( displayedProgress < currProgress ) {
+				if( lastDisplayedProgress.compare_exchange_weak( displayedProgress, currProgress ) ) {
+					Com_Printf( "Computing the static route table: %d%%\n", currProgress );
+					break;
+				}
+			}
+		};
+
+		const TaskSystem::ExecutionHandle executionHandle = taskSystem.startExecution();
+		(void)taskSystem.addForSubrangesInRange( { 1u, numAreas }, 4, {}, std::move( fn ) );
+		succeeded = taskSystem.awaitCompletion( executionHandle );
+	} catch( ... ) {
+		succeeded = false;
+	}
+
+	// Workers are terminated at this point
+	for( AiAasRouteCache *routeCache: routeCaches ) {
+		AiAasRouteCache::ReleaseInstance( routeCache );
+	}
+
+	return succeeded;
+}
+
 bool AasStaticRouteTable::compute() {
 	const auto *aasWorld = AiAasWorld::instance();
 	if( !aasWorld->isLoaded() ) {
@@ -273,8 +374,25 @@ bool AasStaticRouteTable::compute() {
 
 	assert( !s_isAccessibleForRouteCache );
 
-	auto *const routeCache = AiAasRouteCache::Shared();
-	const auto numAreas    = (uint16_t)aasWorld->getAreas().size();
+	const auto numAreas  = (uint16_t)aasWorld->getAreas().size();
+	const auto startedAt = Sys_Milliseconds();
+
+	// Rows are indexed by from area numbers
+	std::vector<ComputedRow> rows( numAreas );
+	if( !computeRowsInParallel( numAreas, rows.data() ) ) {
+		auto *const routeCache = AiAasRouteCache::Shared();
+		unsigned lastDisplayedProgress = 0;
+		for( uint16_t fromAreaNum = 1; fromAreaNum < numAreas; ++fromAreaNum ) {
+			const auto currProgress = (unsigned)std::floor( 100.0 * ( (double)( fromAreaNum - 1 ) / (double)( numAreas - 1 ) ) );
+			if( lastDisplayedProgress != currProgress ) {
+				lastDisplayedProgress = currProgress;
+				Com_Printf( "Computing the static route table: %d%%\n", lastDisplayedProgress );
+			}
+			computeRow( routeCache, fromAreaNum, numAreas, &rows[fromAreaNum] );
+		}
+	}
+
+	// Merge rows in the order of areas, so the result does not depend on the way rows were computed
 
 	NumsAndEntriesBuilder<AreaEntry> allowedBuilder;
 	NumsAndEntriesBuilder<uint16_t> walkingBuilder;
@@ -284,46 +402,29 @@ bool AasStaticRouteTable::compute() {
 	// Put dummy values for area 0, so we don't have to apply offsets to fromAreaNum during retrieval
 	spans.emplace_back( BufferSpansForFlags() );
 
-	unsigned lastDisplayedProgress = 0;
-	const unsigned totalWorkSize   = wsw::square( numAreas - 1 );
-
 	for( uint16_t fromAreaNum = 1; fromAreaNum < numAreas; ++fromAreaNum ) {
-		const unsigned currWorkSize = ( fromAreaNum - 1 ) * ( numAreas - 1 );
-		const auto currProgress     = (unsigned)std::floor( 100.0 * ( (double)currWorkSize / (double)totalWorkSize ) );
-		if( lastDisplayedProgress != currProgress ) {
-			lastDisplayedProgress = currProgress;
-			Com_Printf( "Computing the static route table: %d%%\n", lastDisplayedProgress );
-		}
+		ComputedRow &row = rows[fromAreaNum];
 
 		allowedBuilder.beginSpan();
-		walkingBuilder.beginSpan();
+		for( size_t i = 0; i < row.allowedNums.size(); ++i ) {
+			allowedBuilder.addNumAndEntry( row.allowedNums[i], AreaEntry( row.allowedEntries[i] ) );
+		}
 
-		for( uint16_t toAreaNum = 1; toAreaNum < numAreas; ++toAreaNum ) {
-			if( fromAreaNum != toAreaNum ) {
-				// TODO: Add public getters to AiAasRouteCache that allow
-				// a simultaneous retrieval (existing private ones are very poor)
-				// TODO: We actually can read the entire Dijkstra's algorithm result for the given from area
-				// (Area-by-area retrieval still works fast due to internal caching in the route cache)
-				int reach = 0;
-				if( const int time = routeCache->FindRoute( fromAreaNum, toAreaNum, Bot::ALLOWED_TRAVEL_FLAGS, &reach ) ) {
-					allowedBuilder.addNumAndEntry( toAreaNum, AreaEntry {
-						.reachNum = (uint16_t)reach, .travelTime = (uint16_t)time,
-					});
-				}
-				if( const int time = calcTravelTimeWalkingOrFallingShort( routeCache, aasWorld,
-																		  fromAreaNum, toAreaNum ) ) {
-					assert( (unsigned)time <= (unsigned)std::numeric_limits<uint16_t>::max() );
-					walkingBuilder.addNumAndEntry( toAreaNum, (uint16_t)time );
-				}
-			}
+		walkingBuilder.beginSpan();
+		for( size_t i = 0; i < row.walkingNums.size(); ++i ) {
+			walkingBuilder.addNumAndEntry( row.walkingNums[i], uint16_t( row.walkingTravelTimes[i] ) );
 		}
 
 		spans.emplace_back( BufferSpansForFlags {
 			.allowed               = allowedBuilder.endSpan(),
 			.walkingOrFallingShort = walkingBuilder.endSpan(),
 		});
+
+		// Release the memory early
+		row = ComputedRow();
 	}
 
+	Com_Printf( "Computed the static route table in %d millis\n", (int)( Sys_Milliseconds() - startedAt ) );
 	Com_Printf( "Num entries in spans   (for allowed flags): avg=%" PRIu64 ", max: %" PRIu64 "\n",
 				allowedBuilder.totalNumEntriesInSpans / ( numAreas - 1 ), allowedBuilder.maxNumEntriesInSpans );
 	Com_Printf( "Num entries in spans   (for walking flags): avg=%" PRIu64 ", max: %" PRIu64 "\n",
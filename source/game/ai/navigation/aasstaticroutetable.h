@@ -5,11 +5,14 @@
 #include <cstdint>
 #include <utility>
 #include <optional>
+#include <memory>
 
 #if 0
 #define CHECK_TABLE_MATCH_WITH_ROUTE_CACHE
 #endif
 
+class AiPrecomputedFileMapping;
+
 class AasStaticRouteTable {
 	template <typename> friend class SingletonHolder;
 	template <typename> friend struct NumsAndEntriesBuilder;
@@ -41,6 +44,12 @@ private:
 	[[nodiscard]]
 	bool saveToFile( const char *filePath );
 
+	struct ComputedRow;
+
+	static void computeRow( class AiAasRouteCache *routeCache, uint16_t fromAreaNum, uint16_t numAreas, ComputedRow *row );
+	[[nodiscard]]
+	static bool computeRowsInParallel( uint16_t numAreas, ComputedRow *rows );
+
 	struct BufferSpan;
 	struct DataForTravelFlags;
 
@@ -71,8 +80,8 @@ private:
 
 	struct DataForTravelFlags {
 		// TODO: Use our custom RAII buffers (using std::unique_ptr should be avoided)
-		AreaEntry *entries { nullptr };
-		uint16_t *areaNums { nullptr };
+		const AreaEntry *entries { nullptr };
+		const uint16_t *areaNums { nullptr };
 		unsigned entriesDataSizeInElems { 0 };
 		unsigned areaNumsDataSizeInElems { 0 };
 	};
@@ -80,13 +89,16 @@ private:
 	// We do not longer split flags to allowed/preferred, only allowed flags are left
 	DataForTravelFlags m_dataForAllowedFlags;
 
-	uint16_t *m_walkingAreaNums { nullptr };
-	uint16_t *m_walkingTravelTimes { nullptr };
+	const uint16_t *m_walkingAreaNums { nullptr };
+	const uint16_t *m_walkingTravelTimes { nullptr };
 	unsigned m_walkingTravelTimesDataSizeInElems { 0 };
 	unsigned m_walkingAreaNumsDataSizeInElems { 0 };
 
-	BufferSpansForFlags *m_bufferSpans { nullptr };
+	const BufferSpansForFlags *m_bufferSpans { nullptr };
 	unsigned m_numAreas { 0 };
+
+	// Owns the data if it is used in place of a loaded file
+	std::unique_ptr<AiPrecomputedFileMapping> m_fileMapping;
 };
 
 #endif
\ No newline at end of file
@@ -27,10 +27,13 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "../rewriteme.h"
 #include "../../../common/md5.h"
 #include "../../../common/base64.h"
+#include "../../../common/tasksystem.h"
 
+#include <atomic>
 #include <cmath>
 #include <cstdlib>
 #include <tuple>
+#include <vector>
 
 using wsw::operator""_asView;
 
@@ -1313,9 +1316,13 @@ AiAasWorld::~AiAasWorld() {
 	Q_free( m_face2DProjVertexNums );
 	Q_free( m_areaMapLeafListOffsets );
 	Q_free( m_areaMapLeafsData );
-	Q_free( m_areaVisDataOffsets );
-	Q_free( m_areaVisData );
-	Q_free( m_floorClustersVisTable );
+	if( !m_areaVisFileMapping ) {
+		Q_free( (void *)m_areaVisDataOffsets );
+		Q_free( (void *)m_areaVisData );
+	}
+	if( !m_floorClustersVisFileMapping ) {
+		Q_free( (void *)m_floorClustersVisTable );
+	}
 	Q_free( m_groundedPrincipalRoutingAreas );
 	Q_free( m_jumppadReachPassThroughAreas );
 	Q_free( m_ladderReachPassThroughAreas );
@@ -2173,14 +2180,17 @@ void AiAasWorld::loadFloorClustersVisibility( const wsw::StringView &baseMapName
 
 	const auto expectedSize = (uint32_t)( ( m_numFloorClusters - 1 ) * ( m_numFloorClusters - 1 ) * sizeof( bool ) );
 	if( reader.BeginReading( filePath.data() ) == AiPrecomputedFileReader::SUCCESS ) {
-		uint8_t *data;
+		const uint8_t *data;
 		uint32_t dataLength;
-		if( reader.ReadLengthAndData( &data, &dataLength )  ) {
+		if( reader.MapLengthAndData( &data, &dataLength )  ) {
 			if( dataLength == expectedSize ) {
-				this->m_floorClustersVisTable = (bool *)data;
+				this->m_floorClustersVisTable = (const bool *)data;
+				this->m_floorClustersVisFileMapping = reader.ReleaseMapping();
 				return;
 			}
-			Q_free( data );
+			if( !reader.IsMapped() ) {
+				Q_free( (void *)data );
+			}
 		}
 	}
 
@@ -2204,21 +2214,22 @@ uint32_t AiAasWorld::computeFloorClustersVisibility() {
 	const int stride = m_numFloorClusters - 1;
 	// Do not allocate data for the dummy zero cluster
 	const auto dataSizeInBytes = (uint32_t)( stride * stride * sizeof( bool ) );
-	m_floorClustersVisTable = (bool *)Q_malloc( dataSizeInBytes );
-	memset( m_floorClustersVisTable, 0, dataSizeInBytes );
+	auto *const table = (bool *)Q_malloc( dataSizeInBytes );
+	memset( table, 0, dataSizeInBytes );
 
 	// Start loops from 0 even if we skip the zero cluster for table addressing convenience
 	for( int i = 0; i < stride; ++i ) {
-		m_floorClustersVisTable[i * stride + i] = true;
+		table[i * stride + i] = true;
 		for( int j = i + 1; j < stride; ++j ) {
 			// We should shift indices to get actual cluster numbers
 			// (we use index 0 for a 1-st valid cluster)
 			bool visible = computeVisibilityForClustersPair( i + 1, j + 1 );
-			m_floorClustersVisTable[i * stride + j] = visible;
-			m_floorClustersVisTable[j * stride + i] = visible;
+			table[i * stride + j] = visible;
+			table[j * stride + i] = visible;
 		}
 	}
 
+	m_floorClustersVisTable = table;
 	return dataSizeInBytes;
 }
 
@@ -2300,28 +2311,34 @@ void AiAasWorld::loadAreaVisibility( const wsw::StringView &baseMapName ) {
 	wsw::StaticString<MAX_QPATH> filePath;
 	makeFileName( filePath, baseMapName, wsw::StringView( AREA_VIS_EXT ) );
 
-	uint8_t *data;
+	const uint8_t *data;
 	uint32_t dataLength;
 	const uint32_t expectedOffsetsDataSize = sizeof( int32_t ) * m_numareas;
 	if( reader.BeginReading( filePath.data() ) == AiPrecomputedFileReader::SUCCESS ) {
-		if( reader.ReadLengthAndData( &data, &dataLength ) ) {
+		if( reader.MapLengthAndData( &data, &dataLength ) ) {
 			// Sanity check. The number of offsets should match the number of areas
 			if( expectedOffsetsDataSize == dataLength ) {
-				m_areaVisDataOffsets = (int32_t *)data;
-				const char *tag = "AiAasWorld::LoadVisibility()/AiPrecomputedFileReader::ReadLengthAndData()";
-				constexpr const char *message = "G_Malloc() should return 16-byte aligned blocks";
+				m_areaVisDataOffsets = (const int32_t *)data;
+				const char *tag = "AiAasWorld::LoadVisibility()/AiPrecomputedFileReader::MapLengthAndData()";
+				constexpr const char *message = "Loaded data should be 16-byte aligned";
 				// Just to give vars above another usage so lifting it is required not only for fitting line limit.
 				if( ( (uintptr_t)m_areaVisDataOffsets ) % 16 ) {
 					AI_FailWith( tag, message );
 				}
-				if( reader.ReadLengthAndData( &data, &dataLength ) ) {
-					m_areaVisData = (uint16_t *)data;
+				if( reader.MapLengthAndData( &data, &dataLength ) ) {
+					m_areaVisData = (const uint16_t *)data;
 					// Having a proper alignment for area vis data is vital. Keep this assertion.
-					if( ( (uintptr_t)m_areaVisDataOffsets ) % 16 ) {
+					if( ( (uintptr_t)m_areaVisData ) % 16 ) {
 						AI_FailWith( tag, message );
 					}
+					m_areaVisFileMapping = reader.ReleaseMapping();
 					return;
 				}
+				data = (const uint8_t *)m_areaVisDataOffsets;
+				m_areaVisDataOffsets = nullptr;
+			}
+			if( !reader.IsMapped() ) {
+				Q_free( (void *)data );
 			}
 		}
 	}
@@ -2477,42 +2494,101 @@ public:
 	ptrdiff_t Offset() const { return listsPtr - listsData; }
 };
 
-void AiAasWorld::computeAreasVisibility( uint32_t *offsetsDataSize, uint32_t *listsDataSize ) {
+void AiAasWorld::computeVisibleAreasInRow( int areaNum, wsw::PodVector<uint16_t> *visibleAreaNums ) const {
 	const int numAreas = m_numareas;
-	// This also ensures we can use 32-bit indices for total number of areas
-	assert( numAreas && numAreas <= std::numeric_limits<uint16_t>::max() );
-	SparseVisTable table( numAreas );
+	const auto *const __restrict aasAreas = m_areas;
+	visibleAreaNums->clear();
+	for( int otherAreaNum = areaNum + 1; otherAreaNum < numAreas; ++otherAreaNum ) {
+		if( !areAreasInPvs( areaNum, otherAreaNum ) ) {
+			continue;
+		}
 
-	int numberSoFar = 0;
-	int lastReportedProgress = 0;
+		trace_t trace;
+		// TODO: Add and use an optimized version that uses an early exit
+		SolidWorldTrace( &trace, aasAreas[areaNum].center, aasAreas[otherAreaNum].center );
+		if( trace.fraction != 1.0f ) {
+			continue;
+		}
+
+		visibleAreaNums->push_back( (uint16_t)otherAreaNum );
+	}
+}
+
+bool AiAasWorld::computeVisibleAreasInParallel( std::vector<wsw::PodVector<uint16_t>> *rows ) const {
+	const int numAreas = m_numareas;
 	// Assuming side = numAreas - 1 the number of elements in the upper part is (side - 1) * side / 2
-	const double progressNormalizer = numAreas <= 1 ? 0 : 100.0 / ( ( numAreas - 2 ) * ( numAreas - 1 ) / 2.0 );
+	const double progressNormalizer = numAreas <= 2 ? 0 : 100.0 / ( ( numAreas - 2 ) * ( numAreas - 1 ) / 2.0 );
 
-	const auto *const __restrict aasAreas = m_areas;
-	for( int i = 1; i < numAreas; ++i ) {
-		for( int j = i + 1; j < numAreas; ++j ) {
-			numberSoFar++;
-			if( !areAreasInPvs( i, j ) ) {
-				continue;
+	try {
+		TaskSystem taskSystem( { .numExtraThreads = AI_SuggestNumExtraThreadsForComputations() } );
+		if( taskSystem.getNumberOfWorkers() < 2 ) {
+			return false;
+		}
+
+		std::atomic<uint64_t> numberSoFar { 0 };
+		std::atomic<int> lastReportedProgress { 0 };
+		// Rows differ in length (and in the number of traces), so keep subranges short for balancing the load
+		auto fn = [&, this]( unsigned, unsigned beginAreaNum, unsigned endAreaNum ) {
+			uint64_t numberInSubrange = 0;
+			for( unsigned areaNum = beginAreaNum; areaNum < endAreaNum; ++areaNum ) {
+				computeVisibleAreasInRow( (int)areaNum, &( *rows )[areaNum] );
+				numberInSubrange += (unsigned)numAreas - areaNum - 1;
+			}
+			const uint64_t totalNumber = numberSoFar.fetch_add( numberInSubrange ) + numberInSubrange;
+			const int maybeProgress = (int)( (double)totalNumber * progressNormalizer );
+			int reportedProgress = lastReportedProgress.load( std::memory_order_relaxed );
+			while( reportedProgress < maybeProgress ) {
+				if( lastReportedProgress.compare_exchange_weak( reportedProgress, maybeProgress ) ) {
+					G_Printf( "AiAasWorld::ComputeAreasVisibility(): %d%%\n", maybeProgress );
+					break;
+				}
 			}
+		};
+
+		const TaskSystem::ExecutionHandle executionHandle = taskSystem.startExecution();
+		(void)taskSystem.addForSubrangesInRange( { 1u, (unsigned)numAreas }, 2, {}, std::move( fn ) );
+		return taskSystem.awaitCompletion( executionHandle );
+	} catch( ... ) {
+		return false;
+	}
+}
+
+void AiAasWorld::computeAreasVisibility( uint32_t *offsetsDataSize, uint32_t *listsDataSize ) {
+	const int numAreas = m_numareas;
+	// This also ensures we can use 32-bit indices for total number of areas
+	assert( numAreas && numAreas <= std::numeric_limits<uint16_t>::max() );
+	SparseVisTable table( numAreas );
 
+	const auto startedAt = Sys_Milliseconds();
+
+	// Visible areas with greater numbers for every area
+	std::vector<wsw::PodVector<uint16_t>> rows( numAreas );
+	if( !computeVisibleAreasInParallel( &rows ) ) {
+		int numberSoFar = 0;
+		int lastReportedProgress = 0;
+		const double progressNormalizer = numAreas <= 2 ? 0 : 100.0 / ( ( numAreas - 2 ) * ( numAreas - 1 ) / 2.0 );
+		for( int i = 1; i < numAreas; ++i ) {
+			computeVisibleAreasInRow( i, &rows[i] );
+			numberSoFar += numAreas - i - 1;
 			int maybeProgress = (int)( numberSoFar * progressNormalizer );
 			if( maybeProgress != lastReportedProgress ) {
 				G_Printf( "AiAasWorld::ComputeAreasVisibility(): %d%%\n", maybeProgress );
 				lastReportedProgress = maybeProgress;
 			}
+		}
+	}
 
-			trace_t trace;
-			// TODO: Add and use an optimized version that uses an early exit
-			SolidWorldTrace( &trace, aasAreas[i].center, aasAreas[j].center );
-			if( trace.fraction != 1.0f ) {
-				continue;
-			}
-
+	// Fill the table in the same order regardless of the way rows were computed
+	for( int i = 1; i < numAreas; ++i ) {
+		for( const uint16_t j: rows[i] ) {
 			table.MarkAsVisible( i, j );
 		}
+		rows[i].clear();
+		rows[i].shrink_to_fit();
 	}
 
+	G_Printf( "AiAasWorld::ComputeAreasVisibility(): Done in %d millis\n", (int)( Sys_Milliseconds() - startedAt ) );
+
 	*listsDataSize = table.ComputeDataSize();
 	auto *const __restrict listsData = (uint16_t *)Q_malloc( *listsDataSize );
 
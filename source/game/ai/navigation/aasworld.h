@@ -26,8 +26,11 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "../../../common/common.h"
 #include "../../../common/wswstringview.h"
 #include "../../../common/wswstaticstring.h"
+#include "../../../common/wswpodvector.h"
 
+#include <memory>
 #include <span>
+#include <vector>
 
 //travel types
 #define MAX_TRAVELTYPES             32
@@ -216,6 +219,8 @@ typedef struct aas_node_s {
 	//when a child is zero it's a solid leaf
 } aas_node_t;
 
+class AiPrecomputedFileMapping;
+
 class alignas( 16 ) AiAasWorld {
 	friend class AasFileReader;
 
@@ -281,10 +286,14 @@ class alignas( 16 ) AiAasWorld {
 	// Contains area map (collision/vis) leafs lists, each one is prepended by the length
 	int *m_areaMapLeafsData { nullptr };
 
-	bool *m_floorClustersVisTable { nullptr };
+	const bool *m_floorClustersVisTable { nullptr };
+
+	const uint16_t *m_areaVisData { nullptr };
+	const int32_t *m_areaVisDataOffsets { nullptr };
 
-	uint16_t *m_areaVisData { nullptr };
-	int32_t *m_areaVisDataOffsets { nullptr };
+	// These mappings own visibility data if it is used in place of loaded files
+	std::unique_ptr<AiPrecomputedFileMapping> m_floorClustersVisFileMapping;
+	std::unique_ptr<AiPrecomputedFileMapping> m_areaVisFileMapping;
 
 	uint16_t *m_groundedPrincipalRoutingAreas { nullptr };
 	uint16_t *m_jumppadReachPassThroughAreas { nullptr };
@@ -335,6 +344,9 @@ class alignas( 16 ) AiAasWorld {
 
 	void loadAreaVisibility( const wsw::StringView &baseMapName );
 	void computeAreasVisibility( uint32_t *offsetsDataSize, uint32_t *listsDataSize );
+	void computeVisibleAreasInRow( int areaNum, wsw::PodVector<uint16_t> *visibleAreaNums ) const;
+	[[nodiscard]]
+	bool computeVisibleAreasInParallel( std::vector<wsw::PodVector<uint16_t>> *rows ) const;
 
 	void loadFloorClustersVisibility( const wsw::StringView &baseMapName );
 
@@ -1,4 +1,30 @@
 #include "rewriteme.h"
+#include "../../common/md5.h"
+
+static constexpr const char kFileMagic[4] { 'W', 'A', 'I', 'P' };
+// Gets bumped on changes of the layout of headers and chunks (data formats are versioned by users)
+static constexpr uint32_t kFileLayoutVersion = 1;
+
+struct alignas( 4 ) PrecomputedFileHeader {
+	char magic[4];
+	uint32_t layoutVersion;
+	uint32_t dataVersion;
+	uint32_t reserved;
+};
+
+struct alignas( 4 ) PrecomputedChunkHeader {
+	uint32_t length;
+	uint32_t checksum;
+	uint32_t reserved[2];
+};
+
+static_assert( sizeof( PrecomputedFileHeader ) == AiPrecomputedFileHandler::kChunkAlignment );
+static_assert( sizeof( PrecomputedChunkHeader ) == AiPrecomputedFileHandler::kChunkAlignment );
+
+static inline uint32_t chunkPaddingForLength( uint32_t length ) {
+	return ( AiPrecomputedFileHandler::kChunkAlignment - length % AiPrecomputedFileHandler::kChunkAlignment ) %
+		AiPrecomputedFileHandler::kChunkAlignment;
+}
 
 AiPrecomputedFileHandler::~AiPrecomputedFileHandler() {
 	if( data ) {
@@ -15,6 +41,17 @@ AiPrecomputedFileHandler::~AiPrecomputedFileHandler() {
 	}
 }
 
+uint32_t AiPrecomputedFileHandler::ComputeChunkChecksum( const uint8_t *data, uint32_t dataLength ) {
+	md5_byte_t digest[16];
+	md5_digest( data, (int)dataLength, digest );
+	return (uint32_t)digest[0] | ( (uint32_t)digest[1] << 8 ) | ( (uint32_t)digest[2] << 16 ) | ( (uint32_t)digest[3] << 24 );
+}
+
+AiPrecomputedFileMapping::~AiPrecomputedFileMapping() {
+	FS_UnMMapBaseFile( fp, data );
+	FS_FCloseFile( fp );
+}
+
 bool AiPrecomputedFileWriter::WriteString( const char *string ) {
 	uint32_t length = (uint32_t)strlen( string ) + 1;
 	return WriteLengthAndData( (const uint8_t *)string, length );
@@ -27,27 +64,105 @@ bool AiPrecomputedFileWriter::WriteString( const wsw::StringView &string ) {
 }
 
 bool AiPrecomputedFileWriter::WriteLengthAndData( const uint8_t *data, uint32_t dataLength ) {
-	if( FS_Write( &dataLength, 4, fp ) <= 0 ) {
+	PrecomputedChunkHeader header {};
+	header.length   = LittleLong( dataLength );
+	header.checksum = LittleLong( ComputeChunkChecksum( data, dataLength ) );
+	if( FS_Write( &header, sizeof( header ), fp ) <= 0 ) {
 		failedOnWrite = true;
 		return false;
 	}
 
-	if( FS_Write( data, dataLength, fp ) <= 0 ) {
+	if( dataLength && FS_Write( data, dataLength, fp ) <= 0 ) {
 		failedOnWrite = true;
 		return false;
 	}
 
+	// Make sure the next chunk data starts at the aligned offset
+	if( const uint32_t padding = chunkPaddingForLength( dataLength ) ) {
+		const uint8_t zeroes[kChunkAlignment] {};
+		if( FS_Write( zeroes, padding, fp ) <= 0 ) {
+			failedOnWrite = true;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+AiPrecomputedFileReader::~AiPrecomputedFileReader() {
+	// Unmap before closing the file in the parent destructor
+	if( mappedData ) {
+		FS_UnMMapBaseFile( fp, const_cast<uint8_t *>( mappedData ) );
+		mappedData = nullptr;
+	}
+}
+
+void AiPrecomputedFileReader::FreeChunkData( uint8_t *chunkData ) {
+	if( freeFn ) {
+		freeFn( chunkData );
+	} else {
+		Q_free( chunkData );
+	}
+}
+
+bool AiPrecomputedFileReader::ReadFileBytes( void *buffer, uint32_t numBytes ) {
+	if( !mappedData ) {
+		return FS_Read( buffer, numBytes, fp ) == (int)numBytes;
+	}
+	if( mappedDataSize - mappedDataOffset < numBytes ) {
+		return false;
+	}
+	memcpy( buffer, mappedData + mappedDataOffset, numBytes );
+	mappedDataOffset += numBytes;
+	return true;
+}
+
+bool AiPrecomputedFileReader::ReadChunkHeader( uint32_t *length, uint32_t *checksum ) {
+	PrecomputedChunkHeader header;
+	if( !ReadFileBytes( &header, sizeof( header ) ) ) {
+		G_Printf( S_COLOR_RED "%s: Can't read a chunk header\n", tag );
+		return false;
+	}
+
+	*length   = LittleLong( header.length );
+	*checksum = LittleLong( header.checksum );
+	return true;
+}
+
+bool AiPrecomputedFileReader::ReadChunkDataInPlace( uint32_t length, uint32_t checksum, const uint8_t **data ) {
+	assert( mappedData );
+	const uint32_t padding = chunkPaddingForLength( length );
+	// Make sure the chunk and its padding are within the file (note that the length is untrusted)
+	const uint32_t bytesLeft = mappedDataSize - mappedDataOffset;
+	if( bytesLeft < length || bytesLeft - length < padding ) {
+		G_Printf( S_COLOR_RED "%s: The chunk length %u is out of the file bounds\n", tag, length );
+		return false;
+	}
+
+	const uint8_t *chunkData = mappedData + mappedDataOffset;
+	if( ComputeChunkChecksum( chunkData, length ) != checksum ) {
+		G_Printf( S_COLOR_RED "%s: Chunk checksum mismatch\n", tag );
+		return false;
+	}
+
+	mappedDataOffset += length + padding;
+	*data = chunkData;
 	return true;
 }
 
 bool AiPrecomputedFileReader::ReadLengthAndData( uint8_t **data, uint32_t *dataLength ) {
-	uint32_t length;
-	if( FS_Read( &length, 4, fp ) <= 0 ) {
-		G_Printf( S_COLOR_RED "%s: Can't read a chunk length\n", tag );
+	uint32_t length, checksum;
+	if( !ReadChunkHeader( &length, &checksum ) ) {
 		return false;
 	}
 
-	length = LittleLong( length );
+	const uint8_t *mappedChunkData = nullptr;
+	if( mappedData ) {
+		if( !ReadChunkDataInPlace( length, checksum, &mappedChunkData ) ) {
+			return false;
+		}
+	}
+
 	uint8_t *mem;
 	if( allocFn ) {
 		mem = (uint8_t *)allocFn( length );
@@ -60,14 +175,27 @@ bool AiPrecomputedFileReader::ReadLengthAndData( uint8_t **data, uint32_t *dataL
 		return false;
 	}
 
-	if( FS_Read( mem, length, fp ) != (int)length ) {
-		G_Printf( S_COLOR_RED "%s: Can't read %d chunk bytes\n", tag, (int)length );
-		if( freeFn ) {
-			freeFn( mem );
-		} else {
-			Q_free( mem );
+	if( mappedChunkData ) {
+		memcpy( mem, mappedChunkData, length );
+	} else {
+		if( FS_Read( mem, length, fp ) != (int)length ) {
+			G_Printf( S_COLOR_RED "%s: Can't read %d chunk bytes\n", tag, (int)length );
+			FreeChunkData( mem );
+			return false;
+		}
+
+		uint8_t padding[kChunkAlignment];
+		if( !ReadFileBytes( padding, chunkPaddingForLength( length ) ) ) {
+			G_Printf( S_COLOR_RED "%s: Can't read the chunk padding\n", tag );
+			FreeChunkData( mem );
+			return false;
+		}
+
+		if( ComputeChunkChecksum( mem, length ) != checksum ) {
+			G_Printf( S_COLOR_RED "%s: Chunk checksum mismatch\n", tag );
+			FreeChunkData( mem );
+			return false;
 		}
-		return false;
 	}
 
 	*data = mem;
@@ -75,49 +203,117 @@ bool AiPrecomputedFileReader::ReadLengthAndData( uint8_t **data, uint32_t *dataL
 	return true;
 }
 
+bool AiPrecomputedFileReader::MapLengthAndData( const uint8_t **data, uint32_t *dataLength ) {
+	if( !mappedData ) {
+		uint8_t *mem;
+		if( !ReadLengthAndData( &mem, dataLength ) ) {
+			return false;
+		}
+		*data = mem;
+		return true;
+	}
+
+	uint32_t length, checksum;
+	if( !ReadChunkHeader( &length, &checksum ) ) {
+		return false;
+	}
+	if( !ReadChunkDataInPlace( length, checksum, data ) ) {
+		return false;
+	}
+
+	*dataLength = length;
+	return true;
+}
+
+auto AiPrecomputedFileReader::ReleaseMapping() -> std::unique_ptr<AiPrecomputedFileMapping> {
+	if( !mappedData ) {
+		return nullptr;
+	}
+
+	std::unique_ptr<AiPrecomputedFileMapping> result( new AiPrecomputedFileMapping( fp, const_cast<uint8_t *>( mappedData ) ) );
+	// The file must stay open while it's mapped
+	fp = -1;
+	mappedData = nullptr;
+	mappedDataSize = mappedDataOffset = 0;
+	return result;
+}
+
+void AiPrecomputedFileReader::TryMapFile( const char *filePath, int fileSize ) {
+	// The data is used as-is, so it's feasible only if the data does not need byte swapping
+#ifdef ENDIAN_LITTLE
+	if( fileSize <= 0 ) {
+		return;
+	}
+
+	// Files in paks are read (and possibly decompressed) to buffers
+	if( FS_PakNameForFile( filePath ) ) {
+		return;
+	}
+
+	size_t offsetInFile = 0;
+	if( FS_FileNo( fp, &offsetInFile ) < 0 || offsetInFile ) {
+		return;
+	}
+
+	// Mappings start at page boundaries, so aligned file offsets of chunks yield aligned addresses
+	if( void *data = FS_MMapBaseFile( fp, (size_t)fileSize, 0 ) ) {
+		mappedData = (const uint8_t *)data;
+		mappedDataSize = (uint32_t)fileSize;
+		mappedDataOffset = 0;
+	}
+#endif
+}
+
 AiPrecomputedFileReader::LoadingStatus AiPrecomputedFileReader::ExpectFileString( const wsw::StringView &expected,
 																				  const char *message ) {
 	uint32_t dataLength;
-	uint8_t *data;
+	const uint8_t *data;
 
-	if( !ReadLengthAndData( &data, &dataLength ) ) {
+	if( !MapLengthAndData( &data, &dataLength ) ) {
 		return FAILURE;
 	}
 
-	if( !dataLength ) {
-		return ( expected.empty() ) ? SUCCESS : VERSION_MISMATCH;
-	}
-
-	data[dataLength - 1] = 0;
-
+	// Strings are written with the trailing zero
 	LoadingStatus result = SUCCESS;
-	if( expected.equalsIgnoreCase( wsw::StringView( (const char *)data, dataLength ) ) ) {
+	if( !dataLength ) {
+		result = expected.empty() ? SUCCESS : VERSION_MISMATCH;
+	} else if( !expected.equalsIgnoreCase( wsw::StringView( (const char *)data, dataLength - 1 ) ) ) {
+		G_Printf( S_COLOR_YELLOW "%s: %s\n", tag, message );
 		result = VERSION_MISMATCH;
 	}
 
-	if( freeFn ) {
-		freeFn( data );
-	} else {
-		Q_free( data );
+	if( !mappedData ) {
+		FreeChunkData( const_cast<uint8_t *>( data ) );
 	}
 
 	return result;
 }
 
 AiPrecomputedFileReader::LoadingStatus AiPrecomputedFileReader::BeginReading( const char *filePath ) {
-	if( FS_FOpenFile( filePath, &fp, FS_READ ) < 0 ) {
+	const int fileSize = FS_FOpenFile( filePath, &fp, FS_READ );
+	if( fileSize < 0 ) {
 		G_Printf( S_COLOR_YELLOW "%s: Can't open file `%s` for reading\n", tag, filePath );
 		return MISSING;
 	}
 
-	uint32_t version;
-	if( FS_Read( &version, 4, fp ) != 4 ) {
-		G_Printf( S_COLOR_YELLOW "%s: Can't read the format version from the file\n", tag );
+	TryMapFile( filePath, fileSize );
+
+	PrecomputedFileHeader header;
+	if( !ReadFileBytes( &header, sizeof( header ) ) ) {
+		G_Printf( S_COLOR_YELLOW "%s: Can't read the file header\n", tag );
 		return FAILURE;
 	}
 
-	version = LittleLong( version );
-	if( version != expectedVersion ) {
+	// Files of older layouts get recomputed
+	if( memcmp( header.magic, kFileMagic, sizeof( kFileMagic ) ) != 0 ) {
+		G_Printf( S_COLOR_YELLOW "%s: The file has an unknown layout\n", tag );
+		return VERSION_MISMATCH;
+	}
+	if( LittleLong( header.layoutVersion ) != kFileLayoutVersion ) {
+		G_Printf( S_COLOR_YELLOW "%s: Expected and actual file layout versions differ\n", tag );
+		return VERSION_MISMATCH;
+	}
+	if( LittleLong( header.dataVersion ) != expectedVersion ) {
 		G_Printf( S_COLOR_YELLOW "%s: Expected and actual file format versions differ\n", tag );
 		return VERSION_MISMATCH;
 	}
@@ -145,50 +341,94 @@ AiPrecomputedFileReader::LoadingStatus AiPrecomputedFileReader::BeginReading( co
 }
 
 AiPrecomputedFileWriter::~AiPrecomputedFileWriter() {
-	if( fp < 0 || !failedOnWrite ) {
-		return;
+	if( fp >= 0 ) {
+		// Close the handle first so the file could be moved or removed.
+		// Avoid handling the file in the parent destructor.
+		FS_FCloseFile( fp );
+		fp = -1;
+		if( tmpFilePath ) {
+			if( failedOnWrite || !ReplaceFileByTmpFile() ) {
+				FS_RemoveFile( tmpFilePath );
+			}
+		}
 	}
 
-	// Avoid handling the file in the parent destructor
-	// in case when we have to remove the file
-	// (close the handle first, then remove the file)
+	FreePath( filePath );
+	FreePath( tmpFilePath );
+}
 
-	FS_FCloseFile( fp );
-	if( filePath ) {
-		FS_RemoveFile( filePath );
+auto AiPrecomputedFileWriter::CopyPath( const char *path ) -> char * {
+	const size_t pathLen = strlen( path );
+	char *copy;
+	if( allocFn ) {
+		copy = (char *)allocFn( pathLen + 1 );
+	} else {
+		copy = (char *)Q_malloc( pathLen + 1 );
+	}
+	if( copy ) {
+		memcpy( copy, path, pathLen + 1 );
+	}
+	return copy;
+}
+
+void AiPrecomputedFileWriter::FreePath( char *path ) {
+	if( path ) {
 		if( freeFn ) {
-			freeFn( filePath );
+			freeFn( path );
 		} else {
-			Q_free( filePath );
+			Q_free( path );
 		}
 	}
+}
 
-	fp = -1;
+bool AiPrecomputedFileWriter::ReplaceFileByTmpFile() {
+	// Renaming replaces the file atomically on POSIX systems.
+	// Mappings of the old file stay valid as these refer to the old inode.
+	if( FS_MoveFile( tmpFilePath, filePath ) ) {
+		return true;
+	}
+	// Existing files are not replaced by renaming on Windows (the removal fails if the file is in use)
+	if( FS_RemoveFile( filePath ) && FS_MoveFile( tmpFilePath, filePath ) ) {
+		return true;
+	}
+	G_Printf( S_COLOR_RED "%s: Can't replace the file %s by the written file\n", tag, filePath );
+	return false;
 }
 
 bool AiPrecomputedFileWriter::BeginWriting( const char *filePath_ ) {
-	// Try open file for writing
-	if( FS_FOpenFile( filePath_, &fp, FS_WRITE ) < 0 ) {
-		G_Printf( S_COLOR_RED "%s: Can't open file %s for writing\n", tag, filePath_ );
+	// Make copies of file paths to be able to move or remove files by path on completion
+	if( !( this->filePath = CopyPath( filePath_ ) ) ) {
+		G_Printf( S_COLOR_RED "%s: Can't allocate a buffer for storing a file path copy\n", tag );
 		return false;
 	}
 
-	// Make a copy of the file path to be able to remove it by path in case of failure
-	size_t pathLen = strlen( filePath_ );
-	if( allocFn ) {
-		this->filePath = (char *)allocFn( pathLen + 1 );
-	} else {
-		this->filePath = (char *)Q_malloc( pathLen + 1 );
+	// Make a name that is unique for the writer so concurrently running server processes do not share the file
+	char tmpFilePathBuffer[MAX_QPATH + 32];
+	const int tmpFilePathLen = Q_snprintfz( tmpFilePathBuffer, sizeof( tmpFilePathBuffer ), "%s.%" PRIx64 ".tmp",
+											filePath_, Sys_Microseconds() );
+	if( tmpFilePathLen < 0 || (size_t)tmpFilePathLen >= sizeof( tmpFilePathBuffer ) ) {
+		G_Printf( S_COLOR_RED "%s: The file path %s is too long\n", tag, filePath_ );
+		return false;
 	}
-	if( !this->filePath ) {
+	if( !( this->tmpFilePath = CopyPath( tmpFilePathBuffer ) ) ) {
 		G_Printf( S_COLOR_RED "%s: Can't allocate a buffer for storing a file path copy\n", tag );
 		return false;
 	}
-	memcpy( this->filePath, filePath_, pathLen + 1 );
 
-	uint32_t version = LittleLong( expectedVersion );
-	if( !FS_Write( &version, 4, fp ) ) {
-		G_Printf( S_COLOR_RED "%s: Can't write version to file\n", tag );
+	if( FS_FOpenFile( tmpFilePath, &fp, FS_WRITE ) < 0 ) {
+		G_Printf( S_COLOR_RED "%s: Can't open file %s for writing\n", tag, tmpFilePath );
+		return false;
+	}
+
+	// The file gets removed if it is not complete
+	failedOnWrite = true;
+
+	PrecomputedFileHeader header {};
+	memcpy( header.magic, kFileMagic, sizeof( kFileMagic ) );
+	header.layoutVersion = LittleLong( kFileLayoutVersion );
+	header.dataVersion   = LittleLong( expectedVersion );
+	if( !FS_Write( &header, sizeof( header ), fp ) ) {
+		G_Printf( S_COLOR_RED "%s: Can't write the header to file\n", tag );
 		return false;
 	}
 
@@ -211,5 +451,6 @@ bool AiPrecomputedFileWriter::BeginWriting( const char *filePath_ ) {
 		}
 	}
 
+	failedOnWrite = false;
 	return true;
 }
@@ -3,6 +3,13 @@
 
 #include "ailocal.h"
 
+#include <memory>
+
+/**
+ * Precomputed files consist of a header followed by length-prefixed chunks.
+ * Chunk data starts at 16-byte aligned offsets and is accompanied by a checksum,
+ * so the data of a file that is mapped to memory can be validated and used in place.
+ */
 class AiPrecomputedFileHandler {
 public:
 	typedef void *( *AllocFn )( size_t  );
@@ -34,6 +41,30 @@ public:
 		  useMapChecksum( true ) {}
 
 	virtual ~AiPrecomputedFileHandler();
+
+	static constexpr uint32_t kChunkAlignment = 16;
+
+	[[nodiscard]]
+	static uint32_t ComputeChunkChecksum( const uint8_t *data, uint32_t dataLength );
+};
+
+/**
+ * Keeps a read-only mapping of a precomputed file alive while its data is used in place.
+ * Pages of the mapping are backed by the page cache, so these are shared by server processes
+ * that load the same file.
+ */
+class AiPrecomputedFileMapping {
+	friend class AiPrecomputedFileReader;
+
+	int fp;
+	void *data;
+
+	AiPrecomputedFileMapping( int fp_, void *data_ ): fp( fp_ ), data( data_ ) {}
+public:
+	AiPrecomputedFileMapping( const AiPrecomputedFileMapping & ) = delete;
+	AiPrecomputedFileMapping &operator=( const AiPrecomputedFileMapping & ) = delete;
+
+	~AiPrecomputedFileMapping();
 };
 
 class AiPrecomputedFileReader: public virtual AiPrecomputedFileHandler {
@@ -45,18 +76,57 @@ public:
 		SUCCESS
 	};
 private:
+	const uint8_t *mappedData { nullptr };
+	uint32_t mappedDataSize { 0 };
+	uint32_t mappedDataOffset { 0 };
+
 	LoadingStatus ExpectFileString( const char *expected, const char *message ) {
 		return ExpectFileString( wsw::StringView( expected ), message );
 	}
 	LoadingStatus ExpectFileString( const wsw::StringView &expected, const char *message );
+
+	bool ReadFileBytes( void *buffer, uint32_t numBytes );
+	bool ReadChunkHeader( uint32_t *length, uint32_t *checksum );
+	bool ReadChunkDataInPlace( uint32_t length, uint32_t checksum, const uint8_t **data );
+
+	void TryMapFile( const char *filePath, int fileSize );
+	void FreeChunkData( uint8_t *chunkData );
 public:
 	AiPrecomputedFileReader( const char *tag_, uint32_t expectedVersion_, AllocFn allocFn_ = nullptr, FreeFn freeFn_ = nullptr )
 		: AiPrecomputedFileHandler( tag_, expectedVersion_, allocFn_, freeFn_ ) {}
 
+	~AiPrecomputedFileReader() override;
+
 	LoadingStatus BeginReading( const char *filePath );
 
+	/**
+	 * Reads a copy of a chunk data that is owned by the caller.
+	 */
 	bool ReadLengthAndData( uint8_t **data, uint32_t *dataLength );
 
+	/**
+	 * Returns whether the file is mapped to memory.
+	 * Loose files are mapped if the data does not need byte swapping, files in paks are always read.
+	 */
+	[[nodiscard]]
+	bool IsMapped() const { return mappedData != nullptr; }
+
+	/**
+	 * Reads a chunk data that is used in place if the file is mapped.
+	 * Otherwise, this is the same as {@code ReadLengthAndData()}
+	 * and the caller is responsible for freeing the returned data.
+	 * @note the mapped data is read-only.
+	 */
+	bool MapLengthAndData( const uint8_t **data, uint32_t *dataLength );
+
+	/**
+	 * Transfers the ownership of the file mapping to the caller.
+	 * Data that has been retrieved using {@code MapLengthAndData()} stays valid while the mapping is alive.
+	 * @return the mapping if the file is mapped, null otherwise.
+	 */
+	[[nodiscard]]
+	auto ReleaseMapping() -> std::unique_ptr<AiPrecomputedFileMapping>;
+
 	template <typename T>
 	bool ReadAsTypedBuffer( T **data, uint32_t *dataLength ) {
 		uint8_t *rawData;
@@ -65,22 +135,51 @@ public:
 			return false;
 		}
 		if( rawLength % sizeof( T ) ) {
-			Q_free( data );
+			FreeChunkData( rawData );
 			return false;
 		}
 		*data       = (T *)rawData;
 		*dataLength = rawLength / sizeof( T );
 		return true;
 	}
+
+	template <typename T>
+	bool MapAsTypedBuffer( const T **data, uint32_t *dataLength ) {
+		const uint8_t *rawData;
+		uint32_t rawLength;
+		if( !MapLengthAndData( &rawData, &rawLength ) ) {
+			return false;
+		}
+		if( rawLength % sizeof( T ) ) {
+			if( !IsMapped() ) {
+				FreeChunkData( const_cast<uint8_t *>( rawData ) );
+			}
+			return false;
+		}
+		*data       = (const T *)rawData;
+		*dataLength = rawLength / sizeof( T );
+		return true;
+	}
 };
 
+/**
+ * Writes a precomputed file to a temporary file that replaces the target file on completion.
+ * The target file is replaced by renaming, so processes that have the old file mapped keep using the old data.
+ */
 class AiPrecomputedFileWriter: public virtual AiPrecomputedFileHandler {
 	char *filePath;
+	char *tmpFilePath;
 	bool failedOnWrite;
+
+	[[nodiscard]]
+	auto CopyPath( const char *path ) -> char *;
+	void FreePath( char *path );
+	bool ReplaceFileByTmpFile();
 public:
 	AiPrecomputedFileWriter( const char *tag_, uint32_t expectedVersion_, AllocFn allocFn_ = nullptr, FreeFn freeFn_ = nullptr )
 		: AiPrecomputedFileHandler( tag_, expectedVersion_, allocFn_, freeFn_ ),
 		  filePath( nullptr ),
+		  tmpFilePath( nullptr ),
 		  failedOnWrite( false ) {}
 
 	~AiPrecomputedFileWriter() override;
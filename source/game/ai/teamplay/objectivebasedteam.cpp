@@ -932,7 +932,7 @@ edict_t *AiObjectiveBasedTeam::ObjectiveSpotImpl::AllocHelperEnt( const vec3_t o
 	}
 
 	ent = helperEnts[currHelperEnt] = G_Spawn();
-	ent->classname = "objective_helper_ent";
+	G_SetClassname( ent, "objective_helper_ent" );
 	VectorCopy( origin, ent->s.origin );
 	// Hack! We try to avoid Add/RemoveNavEntity() calls and reuse existing nav entities instead.
 	// Use MOVABLE flag so the area num gets updated automatically.
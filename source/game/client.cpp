@@ -198,7 +198,7 @@ void G_InitBodyQueue( void ) {
 	level.body_que = 0;
 	for( int i = 0; i < BODY_QUEUE_SIZE; i++ ) {
 		edict_t *ent = G_Spawn();
-		ent->classname = "bodyque";
+		G_SetClassname( ent, "bodyque" );
 	}
 }
 
@@ -278,7 +278,7 @@ static edict_t *CopyToBodyQue( edict_t *ent, edict_t *attacker, int damage ) {
 
 	//init body edict
 	G_InitEdict( body );
-	body->classname = "body";
+	G_SetClassname( body, "body" );
 	body->health = ent->health;
 	body->mass = ent->mass;
 	body->r.owner = ent->r.owner;
@@ -599,11 +599,11 @@ void G_ClientRespawn( edict_t *self, bool ghost ) {
 
 	if( self->bot ) {
 		self->think = NULL;
-		self->classname = "bot";
+		G_SetClassname( self, "bot" );
 	} else if( self->r.svflags & SVF_FAKECLIENT ) {
-		self->classname = "fakeclient";
+		G_SetClassname( self, "fakeclient" );
 	} else {
-		self->classname = "player";
+		G_SetClassname( self, "player" );
 	}
 
 	VectorCopy( playerbox_stand_mins, self->r.mins );
@@ -19,6 +19,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 #include "g_local.h"
 #include "../common/cvar.h"
+#include "../common/common.h"
+#include "../common/qthreads.h"
+
+#include <chrono>
 
 //
 // g_clip.c - entity contact detection. (high level object sorting to reduce interaction tests)
@@ -59,93 +63,188 @@ typedef struct
 
 static areagrid_t g_areagrid;
 
+#define LOOSEGRID_FINE_CELL_SIZE    128.0f
+#define LOOSEGRID_COARSE_CELL_SIZE  1024.0f
+#define LOOSEGRID_MAX_DIMENSION     1024    // cell coordinates must fit 10 bits of a key
+#define LOOSEGRID_HASH_SIZE         ( 4 * MAX_EDICTS )
+#define LOOSEGRID_HASH_MASK         ( LOOSEGRID_HASH_SIZE - 1 )
+#define LOOSEGRID_NO_CELL           -1
+#define LOOSEGRID_HUGE_CELL         -2
+
+// the maximal speed of a lag-compensated entity that is assumed for rewinding queries
+#define GCLIP_REWIND_MAX_SPEED      2000.0f
+
+// an entity in a loose grid cell, laid out so mins and maxs can be loaded as two SIMD vectors
+typedef struct {
+	float mins[3];
+	int entNum;
+	float maxs[3];
+	int padding;
+} loosegridentry_t;
+
+typedef struct {
+	uint32_t key;           // the level and coordinates of the cell
+	int liveIndex;          // the position of the cell in the list of live cells of its level
+	wsw::PodVector<loosegridentry_t> entries;
+} loosegridcell_t;
+
+// an entity is stored in a single cell of the finest level it fits,
+// the cell which contains the center of the entity.
+// its bounds may stick out of the cell by a half of the cell size at most,
+// so there are no duplicates and a query just has to look at cells of a box expanded by a half cell.
+typedef struct {
+	vec3_t mins;
+	float cellSizes[2];
+	int dims[2][3];
+
+	loosegridcell_t cells[MAX_EDICTS];  // every non-empty cell holds at least a single entity
+	int freeCells[MAX_EDICTS];
+	int numFreeCells;
+	int liveCells[2][MAX_EDICTS];
+	int numLiveCells[2];
+	int16_t cellsHash[LOOSEGRID_HASH_SIZE];
+
+	// entities that do not fit any level or are outside of the grid
+	wsw::PodVector<loosegridentry_t> hugeEntries;
+
+	struct {
+		int16_t cellNum;
+		int16_t entryNum;
+	} entLocations[MAX_EDICTS];
+} loosegrid_t;
+
+static loosegrid_t g_loosegrid;
+static bool g_useLooseGrid;
+
 extern cvar_t *g_antilag;
 extern cvar_t *g_antilag_maxtimedelta;
+extern cvar_t *g_clip_loosegrid;
 
-#define CFRAME_UPDATE_BACKUP    64  // copies of entity_state_t to keep buffered (1 second of backup at 62 fps).
+#define CFRAME_UPDATE_BACKUP    64  // backed up collision frames (1 second of backup at 62 fps).
 #define CFRAME_UPDATE_MASK  ( CFRAME_UPDATE_BACKUP - 1 )
 
+// the collision data of an entity at some time
 typedef struct c4clipedict_s {
-	entity_state_t s;
-	entity_shared_t r;
+	const edict_t *ent;     // the actual entity for the data that is not backed up
+	vec3_t origin;
+	vec3_t angles;
+	vec3_t mins, maxs;
+	vec3_t absmin, absmax;
 } c4clipedict_t;
 
-//backups of all server frames areas and edicts
+// backups of collision data of lag-compensated entities in a server frame.
+// only these entities are stored, the data is kept in separate arrays of xyz triples.
 typedef struct c4frame_s {
-	c4clipedict_t clipEdicts[MAX_EDICTS];   // fixme: there is a g_maxentities cvar. We have to adjust to it
-	int numedicts;
-
 	int64_t timestamp;
-	int64_t framenum;
+	int16_t slots[MAX_EDICTS];      // an index in data arrays for an entity, -1 if it has not been backed up
+
+	wsw::PodVector<int16_t> entNums;
+	wsw::PodVector<float> origins;
+	wsw::PodVector<float> angles;
+	wsw::PodVector<float> mins;
+	wsw::PodVector<float> maxs;
+	wsw::PodVector<float> absmins;
+	wsw::PodVector<float> absmaxs;
 } c4frame_t;
 
-c4frame_t sv_collisionframes[CFRAME_UPDATE_BACKUP];
+static c4frame_t sv_collisionframes[CFRAME_UPDATE_BACKUP];
 static int64_t sv_collisionFrameNum = 0;
 
+// the last frame an entity has been backed up in
+static int64_t sv_clipEdictLastFrameNum[MAX_EDICTS];
+// the oldest frame since which an entity has been continuously backed up with the same solid
+static int64_t sv_clipEdictValidSinceFrameNum[MAX_EDICTS];
+static int sv_clipEdictSolid[MAX_EDICTS];
+
+// a rewind of the collision world to a past time.
+// the frame lookup is shared by all entities clipped in a lagged query.
+typedef struct {
+	bool active;
+	int64_t targetTime;
+	int64_t frameNum;       // the newest frame not newer than the target time (or the oldest available one)
+} c4rewind_t;
+
+/*
+* GClip_IsLagCompensated
+*/
+static inline bool GClip_IsLagCompensated( const edict_t *ent, int entNum ) {
+	if( !entNum || !ent->r.inuse || ent->r.solid == SOLID_NOT ) {
+		return false;
+	}
+	return ent->r.solid != SOLID_TRIGGER || ( entNum >= 1 && entNum <= ggs->maxclients );
+}
+
+/*
+* GClip_ClearCollisionFrames
+*/
+static void GClip_ClearCollisionFrames( void ) {
+	sv_collisionFrameNum = 0;
+	for( int i = 0; i < MAX_EDICTS; i++ ) {
+		sv_clipEdictLastFrameNum[i] = -1;
+	}
+}
+
 void GClip_BackUpCollisionFrame( void ) {
 	c4frame_t *cframe;
-	edict_t *svedict;
-	int i;
+	const edict_t *svedict;
+	int i, slot;
 
 	if( !g_antilag->integer ) {
 		return;
 	}
 
-	// fixme: should check for any validation here?
-
-	cframe = &sv_collisionframes[sv_collisionFrameNum & CFRAME_UPDATE_MASK];
+	const int64_t framenum = sv_collisionFrameNum++;
+	cframe = &sv_collisionframes[framenum & CFRAME_UPDATE_MASK];
 	cframe->timestamp = game.serverTime;
-	cframe->framenum = sv_collisionFrameNum;
-	sv_collisionFrameNum++;
 
-	//memset( cframe->clipEdicts, 0, sizeof(cframe->clipEdicts) );
+	memset( cframe->slots, -1, sizeof( cframe->slots ) );
+	cframe->entNums.clear();
+	cframe->origins.clear();
+	cframe->angles.clear();
+	cframe->mins.clear();
+	cframe->maxs.clear();
+	cframe->absmins.clear();
+	cframe->absmaxs.clear();
 
 	//backup edicts
-	for( i = 0; i < game.numentities; i++ ) {
+	for( i = 1; i < game.numentities; i++ ) {
 		svedict = &game.edicts[i];
-
-		cframe->clipEdicts[i].r.inuse = svedict->r.inuse;
-		cframe->clipEdicts[i].r.solid = svedict->r.solid;
-		if( !svedict->r.inuse || svedict->r.solid == SOLID_NOT
-			|| ( svedict->r.solid == SOLID_TRIGGER && !( i >= 1 && i <= ggs->maxclients ) ) ) {
+		if( !GClip_IsLagCompensated( svedict, i ) ) {
 			continue;
 		}
 
-		cframe->clipEdicts[i].r = svedict->r;
-		cframe->clipEdicts[i].s = svedict->s;
+		slot = (int)cframe->entNums.size();
+		cframe->slots[i] = (int16_t)slot;
+		cframe->entNums.push_back( (int16_t)i );
+		cframe->origins.append( svedict->s.origin, 3 );
+		cframe->angles.append( svedict->s.angles, 3 );
+		cframe->mins.append( svedict->r.mins, 3 );
+		cframe->maxs.append( svedict->r.maxs, 3 );
+		cframe->absmins.append( svedict->r.absmin, 3 );
+		cframe->absmaxs.append( svedict->r.absmax, 3 );
+
+		// if solid has changed, we can't move backwards past this frame
+		if( sv_clipEdictLastFrameNum[i] != framenum - 1 || sv_clipEdictSolid[i] != svedict->r.solid ) {
+			sv_clipEdictValidSinceFrameNum[i] = framenum;
+			sv_clipEdictSolid[i] = svedict->r.solid;
+		}
+		sv_clipEdictLastFrameNum[i] = framenum;
 	}
-	cframe->numedicts = game.numentities;
 }
 
-static c4clipedict_t *GClip_GetClipEdictForDeltaTime( int entNum, int deltaTime ) {
-	static int index = 0;
-	static c4clipedict_t clipEnts[8];
-	static c4clipedict_t *clipent;
-	static c4clipedict_t clipentNewer; // for interpolation
-	c4frame_t *cframe = NULL;
-	int64_t backTime, cframenum;
-	unsigned bf, i;
-	edict_t *ent = game.edicts + entNum;
-
-	// pick one of the 8 slots to prevent overwritings
-	clipent = &clipEnts[index];
-	index = ( index + 1 ) & 7;
-
-	if( !entNum || deltaTime >= 0 || !g_antilag->integer ) { // current time entity
-		clipent->r = ent->r;
-		clipent->s = ent->s;
-		return clipent;
-	}
+/*
+* GClip_SetupRewind
+*/
+static void GClip_SetupRewind( c4rewind_t *rewind, int timeDelta ) {
+	int64_t backTime, lo, hi;
 
-	if( !ent->r.inuse || ent->r.solid == SOLID_NOT
-		|| ( ent->r.solid == SOLID_TRIGGER && !( entNum >= 1 && entNum <= ggs->maxclients ) ) ) {
-		clipent->r = ent->r;
-		clipent->s = ent->s;
-		return clipent;
+	rewind->active = false;
+	if( timeDelta >= 0 || !g_antilag->integer || !sv_collisionFrameNum ) {
+		return;
 	}
 
 	// clamp delta time inside the backed up limits
-	backTime = abs( deltaTime );
+	backTime = abs( timeDelta );
 	if( g_antilag_maxtimedelta->integer ) {
 		if( g_antilag_maxtimedelta->integer < 0 ) {
 			Cvar_SetValue( "g_antilag_maxtimedelta", abs( g_antilag_maxtimedelta->integer ) );
@@ -155,77 +254,125 @@ static c4clipedict_t *GClip_GetClipEdictForDeltaTime( int entNum, int deltaTime
 		}
 	}
 
-	// find the first snap with timestamp < than realtime - backtime
-	cframenum = sv_collisionFrameNum;
-	for( bf = 1; bf < CFRAME_UPDATE_BACKUP && bf < sv_collisionFrameNum; bf++ ) { // never overpass limits
-		cframe = &sv_collisionframes[( cframenum - bf ) & CFRAME_UPDATE_MASK];
-
-		// if solid has changed, we can't keep moving backwards
-		if( ent->r.solid != cframe->clipEdicts[entNum].r.solid
-			|| ent->r.inuse != cframe->clipEdicts[entNum].r.inuse ) {
-			bf--;
-			if( bf == 0 ) {
-				// we can't step back from first
-				cframe = NULL;
-			} else {
-				cframe = &sv_collisionframes[( cframenum - bf ) & CFRAME_UPDATE_MASK];
-			}
-			break;
-		}
-
-		if( game.serverTime >= cframe->timestamp + backTime ) {
-			break;
+	rewind->active = true;
+	rewind->targetTime = game.serverTime - backTime;
+
+	// find the newest frame with timestamp <= the target time.
+	// timestamps are monotonic, so binary search the range of backed up frames.
+	lo = wsw::max( (int64_t)0, sv_collisionFrameNum - ( CFRAME_UPDATE_BACKUP - 1 ) );
+	hi = sv_collisionFrameNum - 1;
+	rewind->frameNum = lo;
+	while( lo <= hi ) {
+		const int64_t mid = lo + ( hi - lo ) / 2;
+		if( sv_collisionframes[mid & CFRAME_UPDATE_MASK].timestamp <= rewind->targetTime ) {
+			rewind->frameNum = mid;
+			lo = mid + 1;
+		} else {
+			hi = mid - 1;
 		}
 	}
+}
+
+/*
+* GClip_CurrentClipEdict
+*/
+static void GClip_CurrentClipEdict( const edict_t *ent, c4clipedict_t *clipEnt ) {
+	clipEnt->ent = ent;
+	VectorCopy( ent->s.origin, clipEnt->origin );
+	VectorCopy( ent->s.angles, clipEnt->angles );
+	VectorCopy( ent->r.mins, clipEnt->mins );
+	VectorCopy( ent->r.maxs, clipEnt->maxs );
+	VectorCopy( ent->r.absmin, clipEnt->absmin );
+	VectorCopy( ent->r.absmax, clipEnt->absmax );
+}
 
-	if( !cframe ) {
+/*
+* GClip_RewindEntity
+*/
+static void GClip_RewindEntity( const c4rewind_t *rewind, int entNum, c4clipedict_t *clipEnt ) {
+	const edict_t *ent = game.edicts + entNum;
+	const c4frame_t *cframe;
+	int64_t framenum, newestFramenum;
+	int i, slot;
+
+	newestFramenum = sv_collisionFrameNum - 1;
+	// the entity must have been backed up with the same solid in the newest frame
+	if( !rewind->active || !GClip_IsLagCompensated( ent, entNum )
+		|| sv_clipEdictLastFrameNum[entNum] != newestFramenum || sv_clipEdictSolid[entNum] != ent->r.solid ) {
 		// current time entity
-		clipent->r = ent->r;
-		clipent->s = ent->s;
-		return clipent;
+		GClip_CurrentClipEdict( ent, clipEnt );
+		return;
 	}
 
+	// don't go back past the frame where the entity has appeared or changed its solid
+	framenum = wsw::max( rewind->frameNum, sv_clipEdictValidSinceFrameNum[entNum] );
+	cframe = &sv_collisionframes[framenum & CFRAME_UPDATE_MASK];
+	slot = 3 * cframe->slots[entNum];
+
 	// setup with older for the data that is not interpolated
-	*clipent = cframe->clipEdicts[entNum];
+	clipEnt->ent = ent;
+	VectorCopy( &cframe->origins[slot], clipEnt->origin );
+	VectorCopy( &cframe->angles[slot], clipEnt->angles );
+	VectorCopy( &cframe->mins[slot], clipEnt->mins );
+	VectorCopy( &cframe->maxs[slot], clipEnt->maxs );
+	VectorCopy( &cframe->absmins[slot], clipEnt->absmin );
+	VectorCopy( &cframe->absmaxs[slot], clipEnt->absmax );
 
 	// if we found an older than desired backtime frame, interpolate to find a more precise position.
-	if( game.serverTime > cframe->timestamp + backTime ) {
+	if( cframe->timestamp < rewind->targetTime ) {
 		float lerpFrac;
+		const float *origin, *angles, *mins, *maxs, *absmin, *absmax;
 
-		if( bf == 1 ) {
+		if( framenum == newestFramenum ) {
 			// interpolate from 1st backed up to current
-			lerpFrac = (float)( ( game.serverTime - backTime ) - cframe->timestamp )
-					   / (float)( game.serverTime - cframe->timestamp );
-			clipentNewer.r = ent->r;
-			clipentNewer.s = ent->s;
+			lerpFrac = (float)( rewind->targetTime - cframe->timestamp ) / (float)( game.serverTime - cframe->timestamp );
+			origin = ent->s.origin;
+			angles = ent->s.angles;
+			mins = ent->r.mins;
+			maxs = ent->r.maxs;
+			absmin = ent->r.absmin;
+			absmax = ent->r.absmax;
 		} else {
 			// interpolate between 2 backed up
-			c4frame_t *cframeNewer = &sv_collisionframes[( cframenum - ( bf - 1 ) ) & CFRAME_UPDATE_MASK];
-			lerpFrac = (float)( ( game.serverTime - backTime ) - cframe->timestamp )
-					   / (float)( cframeNewer->timestamp - cframe->timestamp );
-			clipentNewer = cframeNewer->clipEdicts[entNum];
+			const c4frame_t *cframeNewer = &sv_collisionframes[( framenum + 1 ) & CFRAME_UPDATE_MASK];
+			const int newerSlot = 3 * cframeNewer->slots[entNum];
+			lerpFrac = (float)( rewind->targetTime - cframe->timestamp ) / (float)( cframeNewer->timestamp - cframe->timestamp );
+			origin = &cframeNewer->origins[newerSlot];
+			angles = &cframeNewer->angles[newerSlot];
+			mins = &cframeNewer->mins[newerSlot];
+			maxs = &cframeNewer->maxs[newerSlot];
+			absmin = &cframeNewer->absmins[newerSlot];
+			absmax = &cframeNewer->absmaxs[newerSlot];
 		}
 
-#if 0
-		G_Printf( "backTime:%i cframeBackTime:%i backFrames:%i lerfrac:%f\n",
-				  backTime, game.serverTime - cframe->timestamp, backframes, lerpFrac );
-#endif
-
-		// interpolate
-		VectorLerp( clipent->s.origin, lerpFrac, clipentNewer.s.origin, clipent->s.origin );
-		VectorLerp( clipent->r.mins, lerpFrac, clipentNewer.r.mins, clipent->r.mins );
-		VectorLerp( clipent->r.maxs, lerpFrac, clipentNewer.r.maxs, clipent->r.maxs );
+		VectorLerp( clipEnt->origin, lerpFrac, origin, clipEnt->origin );
+		VectorLerp( clipEnt->mins, lerpFrac, mins, clipEnt->mins );
+		VectorLerp( clipEnt->maxs, lerpFrac, maxs, clipEnt->maxs );
+		VectorLerp( clipEnt->absmin, lerpFrac, absmin, clipEnt->absmin );
+		VectorLerp( clipEnt->absmax, lerpFrac, absmax, clipEnt->absmax );
 		for( i = 0; i < 3; i++ )
-			clipent->s.angles[i] = LerpAngle( clipent->s.angles[i], clipentNewer.s.angles[i], lerpFrac );
+			clipEnt->angles[i] = LerpAngle( clipEnt->angles[i], angles[i], lerpFrac );
 	}
+}
 
-#if 0
-	G_Printf( "backTime:%i cframeBackTime:%i backFrames:%i\n", backTime,
-			  game.serverTime - cframe->timestamp, backframes );
-#endif
+/*
+* GClip_RewindEntities
+*
+* Fills clip edicts of the listed entities at the rewind time
+*/
+static void GClip_RewindEntities( const c4rewind_t *rewind, const int *entNums, int numEnts, c4clipedict_t *clipEnts ) {
+	int i;
 
-	// back time entity
-	return clipent;
+	if( !rewind->active ) {
+		for( i = 0; i < numEnts; i++ ) {
+			GClip_CurrentClipEdict( game.edicts + entNums[i], &clipEnts[i] );
+		}
+		return;
+	}
+
+	for( i = 0; i < numEnts; i++ ) {
+		GClip_RewindEntity( rewind, entNums[i], &clipEnts[i] );
+	}
 }
 
 // ClearLink is used for new headnodes
@@ -350,14 +497,31 @@ static void GClip_LinkEntity_AreaGrid( areagrid_t *areagrid, edict_t *ent ) {
 }
 
 /*
-* GClip_EntitiesInBox_AreaGrid
+* GClip_EntityMatchesAreaType
+*/
+static inline bool GClip_EntityMatchesAreaType( const edict_t *ent, int areatype ) {
+	if( !ent->r.inuse ) {
+		return false; // deactivated
+	}
+	if( areatype == AREA_TRIGGERS && ent->r.solid != SOLID_TRIGGER ) {
+		return false;
+	}
+	if( areatype == AREA_SOLID && ( ent->r.solid == SOLID_TRIGGER || ent->r.solid == SOLID_NOT ) ) {
+		return false;
+	}
+	return true;
+}
+
+/*
+* GClip_GatherCandidates_AreaGrid
+*
+* Lists entities of cells the box touches, these are not tested against the box yet
 */
-static int GClip_EntitiesInBox_AreaGrid( areagrid_t *areagrid, const vec3_t mins, const vec3_t maxs,
-										 int *list, int maxcount, int areatype, int timeDelta ) {
-	int numlist;
+static int GClip_GatherCandidates_AreaGrid( areagrid_t *areagrid, const vec3_t mins, const vec3_t maxs,
+											int areatype, int *candidates ) {
+	int numCandidates;
 	link_t *grid;
 	link_t *l;
-	c4clipedict_t *clipEnt;
 	vec3_t paddedmins, paddedmaxs;
 	int igrid[3], igridmins[3], igridmaxs[3];
 
@@ -392,36 +556,20 @@ static int GClip_EntitiesInBox_AreaGrid( areagrid_t *areagrid, const vec3_t mins
 	// paranoid debugging
 	//VectorSet( igridmins, 0, 0, 0 );VectorSet( igridmaxs, AREA_GRID, AREA_GRID, AREA_GRID );
 
-	numlist = 0;
+	numCandidates = 0;
 
 	// add entities not linked into areagrid because they are too big or
 	// outside the grid bounds
 	if( areagrid->outside.next ) {
 		grid = &areagrid->outside;
 		for( l = grid->next; l != grid; l = l->next ) {
-			clipEnt = GClip_GetClipEdictForDeltaTime( l->entNum, timeDelta );
-
 			if( areagrid->entmarknumber[l->entNum] == areagrid->marknumber ) {
 				continue;
 			}
 			areagrid->entmarknumber[l->entNum] = areagrid->marknumber;
 
-			if( !clipEnt->r.inuse ) {
-				continue; // deactivated
-			}
-			if( areatype == AREA_TRIGGERS && clipEnt->r.solid != SOLID_TRIGGER ) {
-				continue;
-			}
-			if( areatype == AREA_SOLID &&
-				( clipEnt->r.solid == SOLID_TRIGGER || clipEnt->r.solid == SOLID_NOT ) ) {
-				continue;
-			}
-
-			if( BoundsIntersect( paddedmins, paddedmaxs, clipEnt->r.absmin, clipEnt->r.absmax ) ) {
-				if( numlist < maxcount ) {
-					list[numlist] = l->entNum;
-				}
-				numlist++;
+			if( GClip_EntityMatchesAreaType( EDICT_NUM( l->entNum ), areatype ) ) {
+				candidates[numCandidates++] = l->entNum;
 			}
 		}
 	}
@@ -436,30 +584,384 @@ static int GClip_EntitiesInBox_AreaGrid( areagrid_t *areagrid, const vec3_t mins
 			}
 
 			for( l = grid->next; l != grid; l = l->next ) {
-				clipEnt = GClip_GetClipEdictForDeltaTime( l->entNum, timeDelta );
-
 				if( areagrid->entmarknumber[l->entNum] == areagrid->marknumber ) {
 					continue;
 				}
 				areagrid->entmarknumber[l->entNum] = areagrid->marknumber;
 
-				if( !clipEnt->r.inuse ) {
-					continue; // deactivated
+				if( GClip_EntityMatchesAreaType( EDICT_NUM( l->entNum ), areatype ) ) {
+					candidates[numCandidates++] = l->entNum;
 				}
-				if( areatype == AREA_TRIGGERS && clipEnt->r.solid != SOLID_TRIGGER ) {
+			}
+		}
+	}
+
+	return numCandidates;
+}
+
+/*
+* GClip_LooseGridKey
+*/
+static inline uint32_t GClip_LooseGridKey( int level, int x, int y, int z ) {
+	return ( (uint32_t)level << 30 ) | ( (uint32_t)z << 20 ) | ( (uint32_t)y << 10 ) | (uint32_t)x;
+}
+
+/*
+* GClip_LooseGridHash
+*/
+static inline unsigned GClip_LooseGridHash( uint32_t key ) {
+	// Fibonacci hashing
+	return ( ( key * 2654435769u ) >> 16 ) & LOOSEGRID_HASH_MASK;
+}
+
+/*
+* GClip_Init_LooseGrid
+*/
+static void GClip_Init_LooseGrid( loosegrid_t *grid, const vec3_t world_mins, const vec3_t world_maxs ) {
+	int i, level;
+
+	VectorCopy( world_mins, grid->mins );
+	grid->cellSizes[0] = LOOSEGRID_FINE_CELL_SIZE;
+	grid->cellSizes[1] = LOOSEGRID_COARSE_CELL_SIZE;
+	for( level = 0; level < 2; level++ ) {
+		for( i = 0; i < 3; i++ ) {
+			const float size = world_maxs[i] - world_mins[i];
+			// make cells larger for huge worlds so the coordinates fit the key
+			grid->cellSizes[level] = wsw::max( grid->cellSizes[level], size / ( LOOSEGRID_MAX_DIMENSION - 1 ) );
+		}
+		for( i = 0; i < 3; i++ ) {
+			const int dim = (int)ceilf( ( world_maxs[i] - world_mins[i] ) / grid->cellSizes[level] );
+			grid->dims[level][i] = wsw::max( 1, wsw::min( dim, LOOSEGRID_MAX_DIMENSION ) );
+		}
+		grid->numLiveCells[level] = 0;
+	}
+
+	for( i = 0; i < MAX_EDICTS; i++ ) {
+		grid->cells[i].entries.clear();
+		grid->freeCells[i] = MAX_EDICTS - 1 - i;
+		grid->entLocations[i].cellNum = LOOSEGRID_NO_CELL;
+		grid->entLocations[i].entryNum = -1;
+	}
+	grid->numFreeCells = MAX_EDICTS;
+	grid->hugeEntries.clear();
+	memset( grid->cellsHash, -1, sizeof( grid->cellsHash ) );
+
+	if( developer->integer ) {
+		Com_Printf( "loosegrid settings: divisions %ix%ix%i, %ix%ix%i : cells %f, %f\n",
+					grid->dims[0][0], grid->dims[0][1], grid->dims[0][2],
+					grid->dims[1][0], grid->dims[1][1], grid->dims[1][2],
+					grid->cellSizes[0], grid->cellSizes[1] );
+	}
+}
+
+/*
+* GClip_FindLooseGridCell
+*/
+static int GClip_FindLooseGridCell( const loosegrid_t *grid, uint32_t key ) {
+	for( unsigned slot = GClip_LooseGridHash( key ); grid->cellsHash[slot] >= 0; slot = ( slot + 1 ) & LOOSEGRID_HASH_MASK ) {
+		if( grid->cells[grid->cellsHash[slot]].key == key ) {
+			return grid->cellsHash[slot];
+		}
+	}
+	return LOOSEGRID_NO_CELL;
+}
+
+/*
+* GClip_AllocLooseGridCell
+*/
+static int GClip_AllocLooseGridCell( loosegrid_t *grid, uint32_t key ) {
+	unsigned slot;
+	int cellNum, level;
+
+	// a free cell must exist as every live one holds an entity
+	assert( grid->numFreeCells > 0 );
+	cellNum = grid->freeCells[--grid->numFreeCells];
+	level = (int)( key >> 30 );
+
+	grid->cells[cellNum].key = key;
+	grid->cells[cellNum].liveIndex = grid->numLiveCells[level];
+	grid->liveCells[level][grid->numLiveCells[level]++] = cellNum;
+
+	for( slot = GClip_LooseGridHash( key ); grid->cellsHash[slot] >= 0; slot = ( slot + 1 ) & LOOSEGRID_HASH_MASK );
+	grid->cellsHash[slot] = (int16_t)cellNum;
+	return cellNum;
+}
+
+/*
+* GClip_FreeLooseGridCell
+*/
+static void GClip_FreeLooseGridCell( loosegrid_t *grid, int cellNum ) {
+	loosegridcell_t *cell = &grid->cells[cellNum];
+	const int level = (int)( cell->key >> 30 );
+	unsigned slot, next;
+
+	// swap the cell with the last live one
+	const int lastCellNum = grid->liveCells[level][--grid->numLiveCells[level]];
+	grid->liveCells[level][cell->liveIndex] = lastCellNum;
+	grid->cells[lastCellNum].liveIndex = cell->liveIndex;
+
+	for( slot = GClip_LooseGridHash( cell->key ); grid->cellsHash[slot] != cellNum; slot = ( slot + 1 ) & LOOSEGRID_HASH_MASK );
+
+	// shift back entries of the probe sequence, so there's no need in tombstones
+	for( next = ( slot + 1 ) & LOOSEGRID_HASH_MASK; grid->cellsHash[next] >= 0; next = ( next + 1 ) & LOOSEGRID_HASH_MASK ) {
+		const unsigned home = GClip_LooseGridHash( grid->cells[grid->cellsHash[next]].key );
+		// check whether the home slot of the next entry is cyclically outside of ( slot, next ]
+		if( ( ( next - home ) & LOOSEGRID_HASH_MASK ) >= ( ( next - slot ) & LOOSEGRID_HASH_MASK ) ) {
+			grid->cellsHash[slot] = grid->cellsHash[next];
+			slot = next;
+		}
+	}
+	grid->cellsHash[slot] = -1;
+
+	grid->freeCells[grid->numFreeCells++] = cellNum;
+}
+
+/*
+* GClip_UnlinkEntity_LooseGrid
+*/
+static void GClip_UnlinkEntity_LooseGrid( loosegrid_t *grid, const edict_t *ent ) {
+	const int entNum = NUM_FOR_EDICT( ent );
+	const int cellNum = grid->entLocations[entNum].cellNum;
+	const int entryNum = grid->entLocations[entNum].entryNum;
+	wsw::PodVector<loosegridentry_t> *entries;
+
+	if( cellNum == LOOSEGRID_NO_CELL ) {
+		return;
+	}
+
+	entries = cellNum == LOOSEGRID_HUGE_CELL ? &grid->hugeEntries : &grid->cells[cellNum].entries;
+
+	// swap the entry with the last one
+	const loosegridentry_t &lastEntry = entries->back();
+	grid->entLocations[lastEntry.entNum].entryNum = (int16_t)entryNum;
+	( *entries )[entryNum] = lastEntry;
+	entries->pop_back();
+
+	if( entries->empty() && cellNum != LOOSEGRID_HUGE_CELL ) {
+		GClip_FreeLooseGridCell( grid, cellNum );
+	}
+
+	grid->entLocations[entNum].cellNum = LOOSEGRID_NO_CELL;
+	grid->entLocations[entNum].entryNum = -1;
+}
+
+/*
+* GClip_LinkEntity_LooseGrid
+*/
+static void GClip_LinkEntity_LooseGrid( loosegrid_t *grid, const edict_t *ent ) {
+	wsw::PodVector<loosegridentry_t> *entries;
+	loosegridentry_t entry;
+	int i, level, coords[3], cellNum;
+	float extent = 0.0f;
+
+	const int entNum = NUM_FOR_EDICT( ent );
+	if( entNum <= 0 || entNum >= game.maxentities || EDICT_NUM( entNum ) != ent ) {
+		Com_Printf( "GClip_LinkEntity_LooseGrid: invalid edict %p "
+					"(edicts is %p, edict compared to prog->edicts is %i)\n",
+					(void *)ent, game.edicts, entNum );
+		return;
+	}
+
+	VectorCopy( ent->r.absmin, entry.mins );
+	VectorCopy( ent->r.absmax, entry.maxs );
+	entry.entNum = entNum;
+	entry.padding = 0;
+
+	for( i = 0; i < 3; i++ ) {
+		extent = wsw::max( extent, ent->r.absmax[i] - ent->r.absmin[i] );
+	}
+
+	cellNum = LOOSEGRID_HUGE_CELL;
+	for( level = 0; level < 2; level++ ) {
+		if( extent > grid->cellSizes[level] ) {
+			continue;
+		}
+		for( i = 0; i < 3; i++ ) {
+			const float center = 0.5f * ( ent->r.absmin[i] + ent->r.absmax[i] );
+			coords[i] = (int)floorf( ( center - grid->mins[i] ) / grid->cellSizes[level] );
+			if( coords[i] < 0 || coords[i] >= grid->dims[level][i] ) {
+				break;
+			}
+		}
+		if( i == 3 ) {
+			const uint32_t key = GClip_LooseGridKey( level, coords[0], coords[1], coords[2] );
+			cellNum = GClip_FindLooseGridCell( grid, key );
+			if( cellNum == LOOSEGRID_NO_CELL ) {
+				cellNum = GClip_AllocLooseGridCell( grid, key );
+			}
+		}
+		// an entity that is outside of the fine level is outside of the coarse one too
+		break;
+	}
+
+	entries = cellNum == LOOSEGRID_HUGE_CELL ? &grid->hugeEntries : &grid->cells[cellNum].entries;
+	grid->entLocations[entNum].cellNum = (int16_t)cellNum;
+	grid->entLocations[entNum].entryNum = (int16_t)entries->size();
+	entries->push_back( entry );
+}
+
+/*
+* GClip_AddLooseGridCandidates
+*/
+static int GClip_AddLooseGridCandidates( const loosegridentry_t *entries, int numEntries,
+										 const vec3_t mins, const vec3_t maxs, int areatype,
+										 int *candidates, int numCandidates ) {
+#ifdef WSW_USE_SSE2
+	const __m128 xmmMins = _mm_setr_ps( mins[0], mins[1], mins[2], 0 );
+	const __m128 xmmMaxs = _mm_setr_ps( maxs[0], maxs[1], maxs[2], 0 );
+#endif
+
+	for( int i = 0; i < numEntries; i++ ) {
+		const loosegridentry_t *entry = &entries[i];
+#ifdef WSW_USE_SSE2
+		const __m128 entMins = _mm_loadu_ps( entry->mins );
+		const __m128 entMaxs = _mm_loadu_ps( entry->maxs );
+		// the last lanes hold the entity number and padding, ignore them
+		const __m128 cmp = _mm_or_ps( _mm_cmpgt_ps( entMins, xmmMaxs ), _mm_cmplt_ps( entMaxs, xmmMins ) );
+		if( _mm_movemask_ps( cmp ) & 7 ) {
+			continue;
+		}
+#else
+		if( !BoundsIntersect( mins, maxs, entry->mins, entry->maxs ) ) {
+			continue;
+		}
+#endif
+		if( GClip_EntityMatchesAreaType( EDICT_NUM( entry->entNum ), areatype ) ) {
+			candidates[numCandidates++] = entry->entNum;
+		}
+	}
+
+	return numCandidates;
+}
+
+/*
+* GClip_GatherCandidates_LooseGrid
+*
+* Lists entities which bounds intersect the box
+*/
+static int GClip_GatherCandidates_LooseGrid( const loosegrid_t *grid, const vec3_t mins, const vec3_t maxs,
+											 int areatype, int *candidates ) {
+	int i, level, x, y, z, imins[3], imaxs[3];
+	int numCandidates;
+
+	numCandidates = GClip_AddLooseGridCandidates( grid->hugeEntries.data(), (int)grid->hugeEntries.size(),
+												  mins, maxs, areatype, candidates, 0 );
+
+	for( level = 0; level < 2; level++ ) {
+		const float cellSize = grid->cellSizes[level];
+		const int *dims = grid->dims[level];
+		int numRangeCells = 1;
+
+		if( !grid->numLiveCells[level] ) {
+			continue;
+		}
+
+		for( i = 0; i < 3; i++ ) {
+			// entities may stick out of their cells by a half of the cell size
+			imins[i] = (int)floorf( ( mins[i] - 0.5f * cellSize - grid->mins[i] ) / cellSize );
+			imaxs[i] = (int)floorf( ( maxs[i] + 0.5f * cellSize - grid->mins[i] ) / cellSize );
+			imins[i] = wsw::max( imins[i], 0 );
+			imaxs[i] = wsw::min( imaxs[i], dims[i] - 1 );
+			if( imins[i] > imaxs[i] ) {
+				break;
+			}
+			numRangeCells *= imaxs[i] - imins[i] + 1;
+		}
+		if( i != 3 ) {
+			continue;
+		}
+
+		if( numRangeCells > grid->numLiveCells[level] ) {
+			// it's cheaper to check coordinates of live cells than to look up every cell in the range
+			for( i = 0; i < grid->numLiveCells[level]; i++ ) {
+				const loosegridcell_t *cell = &grid->cells[grid->liveCells[level][i]];
+				x = (int)( cell->key & 1023 );
+				y = (int)( ( cell->key >> 10 ) & 1023 );
+				z = (int)( ( cell->key >> 20 ) & 1023 );
+				if( x < imins[0] || x > imaxs[0] || y < imins[1] || y > imaxs[1] || z < imins[2] || z > imaxs[2] ) {
 					continue;
 				}
-				if( areatype == AREA_SOLID &&
-					( clipEnt->r.solid == SOLID_TRIGGER || clipEnt->r.solid == SOLID_NOT ) ) {
-					continue;
+				numCandidates = GClip_AddLooseGridCandidates( cell->entries.data(), (int)cell->entries.size(),
+															  mins, maxs, areatype, candidates, numCandidates );
+			}
+			continue;
+		}
+
+		for( z = imins[2]; z <= imaxs[2]; z++ ) {
+			for( y = imins[1]; y <= imaxs[1]; y++ ) {
+				for( x = imins[0]; x <= imaxs[0]; x++ ) {
+					const int cellNum = GClip_FindLooseGridCell( grid, GClip_LooseGridKey( level, x, y, z ) );
+					if( cellNum != LOOSEGRID_NO_CELL ) {
+						const loosegridcell_t *cell = &grid->cells[cellNum];
+						numCandidates = GClip_AddLooseGridCandidates( cell->entries.data(), (int)cell->entries.size(),
+																	  mins, maxs, areatype, candidates, numCandidates );
+					}
 				}
+			}
+		}
+	}
+
+	return numCandidates;
+}
 
-				if( BoundsIntersect( paddedmins, paddedmaxs, clipEnt->r.absmin, clipEnt->r.absmax ) ) {
-					if( numlist < maxcount ) {
-						list[numlist] = l->entNum;
+/*
+* GClip_EntitiesInBox
+*
+* Lagged entities are rewound all at once after the candidates are gathered.
+* A rewound entity has the same inuse/solid state as the current one,
+* so only bounds of candidates depend on the rewind time.
+* Clip edicts of listed entities are written to clipList if it's specified.
+*/
+static int GClip_EntitiesInBox( const vec3_t mins, const vec3_t maxs, int *list, c4clipedict_t *clipList,
+								int maxcount, int areatype, const c4rewind_t *rewind ) {
+	// bots may query the loose grid from worker threads
+	static thread_local int candidates[MAX_EDICTS];
+	static thread_local c4clipedict_t rewoundEnts[MAX_EDICTS];
+	int i, numlist, numCandidates;
+
+	if( g_useLooseGrid ) {
+		if( rewind->active ) {
+			// the loose grid tests current bounds, so expand the box by the distance rewound entities could pass
+			const int64_t oldestTime = wsw::min( rewind->targetTime, sv_collisionframes[rewind->frameNum & CFRAME_UPDATE_MASK].timestamp );
+			const float margin = GCLIP_REWIND_MAX_SPEED * 0.001f * (float)( game.serverTime - oldestTime );
+			vec3_t gathermins, gathermaxs;
+			VectorSet( gathermins, mins[0] - margin, mins[1] - margin, mins[2] - margin );
+			VectorSet( gathermaxs, maxs[0] + margin, maxs[1] + margin, maxs[2] + margin );
+			numCandidates = GClip_GatherCandidates_LooseGrid( &g_loosegrid, gathermins, gathermaxs, areatype, candidates );
+		} else {
+			numCandidates = GClip_GatherCandidates_LooseGrid( &g_loosegrid, mins, maxs, areatype, candidates );
+		}
+	} else {
+		numCandidates = GClip_GatherCandidates_AreaGrid( &g_areagrid, mins, maxs, areatype, candidates );
+	}
+
+	numlist = 0;
+
+	if( rewind->active ) {
+		GClip_RewindEntities( rewind, candidates, numCandidates, rewoundEnts );
+		for( i = 0; i < numCandidates; i++ ) {
+			const c4clipedict_t *clipEnt = &rewoundEnts[i];
+			if( BoundsIntersect( mins, maxs, clipEnt->absmin, clipEnt->absmax ) ) {
+				if( numlist < maxcount ) {
+					list[numlist] = candidates[i];
+					if( clipList ) {
+						clipList[numlist] = *clipEnt;
 					}
-					numlist++;
 				}
+				numlist++;
+			}
+		}
+	} else {
+		for( i = 0; i < numCandidates; i++ ) {
+			const edict_t *ent = EDICT_NUM( candidates[i] );
+			if( BoundsIntersect( mins, maxs, ent->r.absmin, ent->r.absmax ) ) {
+				if( numlist < maxcount ) {
+					list[numlist] = candidates[i];
+					if( clipList ) {
+						GClip_CurrentClipEdict( ent, &clipList[numlist] );
+					}
+				}
+				numlist++;
 			}
 		}
 	}
@@ -479,7 +981,36 @@ void GClip_ClearWorld( void ) {
 	world_model = SV_InlineModel( 0 );
 	SV_InlineModelBounds( world_model, world_mins, world_maxs );
 
-	GClip_Init_AreaGrid( &g_areagrid, world_mins, world_maxs );
+#ifndef PUBLIC_BUILD
+	// captured traces are bound to the map
+	GClip_StopTraceCapture();
+#endif
+
+	// entities are unlinked after that, make sure no stale links into the previous grid are followed
+	for( int i = 0; i < game.maxentities; i++ ) {
+		memset( game.edicts[i].areagrid, 0, sizeof( game.edicts[i].areagrid ) );
+	}
+
+	// the index is switched only here as entities must be unlinked from the one they were linked to
+	g_useLooseGrid = g_clip_loosegrid->integer != 0;
+	if( g_useLooseGrid ) {
+		GClip_Init_LooseGrid( &g_loosegrid, world_mins, world_maxs );
+	} else {
+		GClip_Init_AreaGrid( &g_areagrid, world_mins, world_maxs );
+	}
+
+	// server time may go backwards on a map change
+	GClip_ClearCollisionFrames();
+}
+
+/*
+* GClip_SupportsConcurrentQueries
+*
+* Traces, point contents and area queries may be performed from multiple threads
+* as long as entities are not linked meanwhile. The area grid marks visited entities, so only the loose grid fits.
+*/
+bool GClip_SupportsConcurrentQueries( void ) {
+	return g_useLooseGrid;
 }
 
 /*
@@ -491,7 +1022,11 @@ void GClip_UnlinkEntity( edict_t *ent ) {
 	if( !ent->linked ) {
 		return; // not linked in anywhere
 	}
-	GClip_UnlinkEntity_AreaGrid( ent );
+	if( g_useLooseGrid ) {
+		GClip_UnlinkEntity_LooseGrid( &g_loosegrid, ent );
+	} else {
+		GClip_UnlinkEntity_AreaGrid( ent );
+	}
 	ent->linked = false;
 }
 
@@ -646,7 +1181,11 @@ void GClip_LinkEntity( edict_t *ent ) {
 	ent->linkcount++;
 	ent->linked = true;
 
-	GClip_LinkEntity_AreaGrid( &g_areagrid, ent );
+	if( g_useLooseGrid ) {
+		GClip_LinkEntity_LooseGrid( &g_loosegrid, ent );
+	} else {
+		GClip_LinkEntity_AreaGrid( &g_areagrid, ent );
+	}
 }
 
 /*
@@ -679,9 +1218,10 @@ void GClip_SetAreaPortalState( edict_t *ent, bool open ) {
 int GClip_AreaEdicts( const vec3_t mins, const vec3_t maxs,
 					  int *list, int maxcount, int areatype, int timeDelta ) {
 	int count;
+	c4rewind_t rewind;
 
-	count = GClip_EntitiesInBox_AreaGrid( &g_areagrid, mins, maxs,
-										  list, maxcount, areatype, timeDelta );
+	GClip_SetupRewind( &rewind, timeDelta );
+	count = GClip_EntitiesInBox( mins, maxs, list, NULL, maxcount, areatype, &rewind );
 
 	return wsw::min( count, maxcount );
 }
@@ -690,9 +1230,10 @@ int GClip_AreaEdicts( const vec3_t mins, const vec3_t maxs,
 * GClip_CollisionModelForEntity
 *
 * Returns a collision model that can be used for testing or clipping an
-* object of mins/maxs size.
+* object of mins/maxs size. A temporary hull is built in the caller-supplied storage.
 */
-static struct cmodel_s *GClip_CollisionModelForEntity( entity_state_t *s, entity_shared_t *r ) {
+static struct cmodel_s *GClip_CollisionModelForEntity( const entity_state_t *s, const vec3_t mins, const vec3_t maxs,
+													   CMHullModelStorage *hullStorage ) {
 	struct cmodel_s *model;
 
 	if( ISBRUSHMODEL( s->modelindex ) ) {
@@ -707,10 +1248,10 @@ static struct cmodel_s *GClip_CollisionModelForEntity( entity_state_t *s, entity
 
 	// create a temp hull from bounding box sizes
 	if( s->type != ET_PLAYER && s->type != ET_CORPSE ) {
-		return SV_ModelForBBox( r->mins, r->maxs );
+		return SV_ModelForBBox( mins, maxs, hullStorage );
 	}
 
-	return SV_OctagonModelForBBox( r->mins, r->maxs );
+	return SV_OctagonModelForBBox( mins, maxs, hullStorage );
 }
 
 
@@ -720,25 +1261,30 @@ static struct cmodel_s *GClip_CollisionModelForEntity( entity_state_t *s, entity
 * Quake 2 extends this to also check entities, to allow moving liquids
 */
 static int GClip_PointContents( const vec3_t p, int timeDelta ) {
-	c4clipedict_t *clipEnt;
+	static thread_local c4clipedict_t clipEnts[MAX_EDICTS];
+	const c4clipedict_t *clipEnt;
+	CMHullModelStorage hullStorage;
 	int touch[MAX_EDICTS];
 	int i, num;
 	int contents, c2;
 	struct cmodel_s *cmodel;
+	c4rewind_t rewind;
 
 	// get base contents from world
 	contents = SV_TransformedPointContents( p, NULL, NULL, NULL );
 
 	// or in contents from all the other entities
-	num = GClip_AreaEdicts( p, p, touch, MAX_EDICTS, AREA_SOLID, timeDelta );
+	GClip_SetupRewind( &rewind, timeDelta );
+	num = GClip_EntitiesInBox( p, p, touch, clipEnts, MAX_EDICTS, AREA_SOLID, &rewind );
+	num = wsw::min( num, MAX_EDICTS );
 
 	for( i = 0; i < num; i++ ) {
-		clipEnt = GClip_GetClipEdictForDeltaTime( touch[i], timeDelta );
+		clipEnt = &clipEnts[i];
 
 		// might intersect, so do an exact clip
-		cmodel = GClip_CollisionModelForEntity( &clipEnt->s, &clipEnt->r );
+		cmodel = GClip_CollisionModelForEntity( &clipEnt->ent->s, clipEnt->mins, clipEnt->maxs, &hullStorage );
 
-		c2 = SV_TransformedPointContents( p, cmodel, clipEnt->s.origin, clipEnt->s.angles );
+		c2 = SV_TransformedPointContents( p, cmodel, clipEnt->origin, clipEnt->angles );
 		contents |= c2;
 	}
 
@@ -769,57 +1315,66 @@ typedef struct {
 * GClip_ClipMoveToEntities
 */
 /*static*/ void GClip_ClipMoveToEntities( moveclip_t *clip, int timeDelta ) {
+	static thread_local c4clipedict_t touchClipEnts[MAX_EDICTS];
+	CMHullModelStorage hullStorage;
 	int i, num;
-	c4clipedict_t *touch;
+	const c4clipedict_t *touch;
+	const edict_t *touchEnt;
 	int touchlist[MAX_EDICTS];
 	trace_t trace;
 	struct cmodel_s *cmodel;
 	const float *angles;
+	c4rewind_t rewind;
 
-	num = GClip_AreaEdicts( clip->boxmins, clip->boxmaxs, touchlist, MAX_EDICTS, AREA_SOLID, timeDelta );
+	// all touched entities get rewound at once for lagged traces
+	GClip_SetupRewind( &rewind, timeDelta );
+	num = GClip_EntitiesInBox( clip->boxmins, clip->boxmaxs, touchlist, touchClipEnts,
+							   MAX_EDICTS, AREA_SOLID, &rewind );
+	num = wsw::min( num, MAX_EDICTS );
 
 	// be careful, it is possible to have an entity in this
 	// list removed before we get to it (killtriggered)
 	for( i = 0; i < num; i++ ) {
-		touch = GClip_GetClipEdictForDeltaTime( touchlist[i], timeDelta );
+		touch = &touchClipEnts[i];
+		touchEnt = touch->ent;
 		if( clip->passent >= 0 ) {
 			// when they are offseted in time, they can be a different pointer but be the same entity
-			if( touch->s.number == clip->passent ) {
+			if( touchEnt->s.number == clip->passent ) {
 				continue;
 			}
-			if( touch->r.owner && ( touch->r.owner->s.number == clip->passent ) ) {
+			if( touchEnt->r.owner && ( touchEnt->r.owner->s.number == clip->passent ) ) {
 				continue;
 			}
 			if( game.edicts[clip->passent].r.owner
-				&& ( game.edicts[clip->passent].r.owner->s.number == touch->s.number ) ) {
+				&& ( game.edicts[clip->passent].r.owner->s.number == touchEnt->s.number ) ) {
 				continue;
 			}
 
 			// wsw : jal : never clipmove against SVF_PROJECTILE entities
-			if( touch->r.svflags & SVF_PROJECTILE ) {
+			if( touchEnt->r.svflags & SVF_PROJECTILE ) {
 				continue;
 			}
 		}
 
-		if( ( touch->r.svflags & SVF_CORPSE ) && !( clip->contentmask & CONTENTS_CORPSE ) ) {
+		if( ( touchEnt->r.svflags & SVF_CORPSE ) && !( clip->contentmask & CONTENTS_CORPSE ) ) {
 			continue;
 		}
 
 		// might intersect, so do an exact clip
-		cmodel = GClip_CollisionModelForEntity( &touch->s, &touch->r );
+		cmodel = GClip_CollisionModelForEntity( &touchEnt->s, touch->mins, touch->maxs, &hullStorage );
 
-		if( ISBRUSHMODEL( touch->s.modelindex ) ) {
-			angles = touch->s.angles;
+		if( ISBRUSHMODEL( touchEnt->s.modelindex ) ) {
+			angles = touch->angles;
 		} else {
 			angles = vec3_origin; // boxes don't rotate
 
 		}
 		SV_TransformedBoxTrace( &trace, clip->start, clip->end,
 									 clip->mins, clip->maxs, cmodel, clip->contentmask,
-									 touch->s.origin, angles );
+									 touch->origin, angles );
 
 		if( trace.allsolid || trace.fraction < clip->trace->fraction ) {
-			trace.ent = touch->s.number;
+			trace.ent = touchEnt->s.number;
 			*( clip->trace ) = trace;
 		} else if( trace.startsolid ) {
 			clip->trace->startsolid = true;
@@ -849,6 +1404,98 @@ static void GClip_TraceBounds( const vec3_t start, const vec3_t mins, const vec3
 	}
 }
 
+#ifndef PUBLIC_BUILD
+
+#define MAX_TRACE_CAPTURE_BUFFERED  1024
+
+static int g_traceCaptureFile;
+static CMTraceCaptureRecord g_traceCaptureBuffer[MAX_TRACE_CAPTURE_BUFFERED];
+static unsigned g_numTraceCaptureBuffered;
+static unsigned g_numTracesCaptured, g_maxTracesCaptured;
+// bots may trace from worker threads
+static wsw::Mutex g_traceCaptureMutex;
+
+/*
+* GClip_FlushTraceCapture
+*/
+static void GClip_FlushTraceCapture( void ) {
+	if( g_numTraceCaptureBuffered ) {
+		FS_Write( g_traceCaptureBuffer, g_numTraceCaptureBuffered * sizeof( CMTraceCaptureRecord ), g_traceCaptureFile );
+		g_numTraceCaptureBuffered = 0;
+	}
+}
+
+/*
+* GClip_StartTraceCapture
+*
+* Starts writing arguments of G_Trace() calls to the file so they can be replayed by the cmbench command
+*/
+bool GClip_StartTraceCapture( const char *filename, unsigned maxTraces ) {
+	GClip_StopTraceCapture();
+
+	if( FS_FOpenFile( filename, &g_traceCaptureFile, FS_WRITE ) == -1 ) {
+		g_traceCaptureFile = 0;
+		return false;
+	}
+
+	CMTraceCaptureHeader header;
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, CM_TRACE_CAPTURE_MAGIC, sizeof( header.magic ) );
+	header.version = CM_TRACE_CAPTURE_VERSION;
+	Q_strncpyz( header.mapName, level.mapname, sizeof( header.mapName ) );
+	FS_Write( &header, sizeof( header ), g_traceCaptureFile );
+
+	g_numTraceCaptureBuffered = 0;
+	g_numTracesCaptured = 0;
+	g_maxTracesCaptured = maxTraces;
+	return true;
+}
+
+/*
+* GClip_StopTraceCapture
+*/
+void GClip_StopTraceCapture( void ) {
+	if( !g_traceCaptureFile ) {
+		return;
+	}
+
+	GClip_FlushTraceCapture();
+	FS_FCloseFile( g_traceCaptureFile );
+	g_traceCaptureFile = 0;
+
+	G_Printf( "Captured %u traces\n", g_numTracesCaptured );
+}
+
+/*
+* GClip_CaptureTrace
+*/
+static void GClip_CaptureTrace( const vec3_t start, const vec3_t mins, const vec3_t maxs,
+								const vec3_t end, const edict_t *passedict, int contentmask ) {
+	[[maybe_unused]] wsw::ScopedLock<wsw::Mutex> lock( &g_traceCaptureMutex );
+	if( !g_traceCaptureFile ) {
+		return;
+	}
+
+	CMTraceCaptureRecord *record = &g_traceCaptureBuffer[g_numTraceCaptureBuffered++];
+	VectorCopy( start, record->start );
+	VectorCopy( end, record->end );
+	VectorCopy( mins, record->mins );
+	VectorCopy( maxs, record->maxs );
+	record->contentMask = contentmask;
+	record->passEntNum = passedict ? ENTNUM( passedict ) : -1;
+
+	if( g_numTraceCaptureBuffered == MAX_TRACE_CAPTURE_BUFFERED ) {
+		GClip_FlushTraceCapture();
+	}
+
+	g_numTracesCaptured++;
+	if( g_maxTracesCaptured && g_numTracesCaptured >= g_maxTracesCaptured ) {
+		GClip_StopTraceCapture();
+	}
+}
+
+#endif
+
 /*
 * G_Trace
 *
@@ -881,6 +1528,12 @@ static void GClip_Trace( trace_t *tr, const vec3_t start, const vec3_t mins, con
 		maxs = vec3_origin;
 	}
 
+#ifndef PUBLIC_BUILD
+	if( g_traceCaptureFile ) {
+		GClip_CaptureTrace( start, mins, maxs, end, passedict, contentmask );
+	}
+#endif
+
 	if( passedict == world ) {
 		memset( tr, 0, sizeof( trace_t ) );
 		tr->fraction = 1;
@@ -1166,24 +1819,27 @@ int GClip_FindInRadius( const vec3_t org, float rad, int *list, int maxcount ) {
 
 void G_SplashFrac( int entNum, const vec3_t hitpoint, float maxradius, vec3_t pushdir,
 					 float *kickFrac, float *dmgFrac ) {
-	c4clipedict_t *clipEnt;
+	const edict_t *ent = game.edicts + entNum;
 
-	clipEnt = GClip_GetClipEdictForDeltaTime( entNum, 0 );
-	G_SplashFrac( clipEnt->s.origin, clipEnt->r.mins, clipEnt->r.maxs, hitpoint,
+	G_SplashFrac( ent->s.origin, ent->r.mins, ent->r.maxs, hitpoint,
 				  maxradius, pushdir, kickFrac, dmgFrac );
 }
 
 void RS_SplashFrac( int entNum, const vec3_t hitpoint, float maxradius, vec3_t pushdir,
 					  float *kickFrac, float *dmgFrac, float splashFrac ) {
-	c4clipedict_t *clipEnt;
+	const edict_t *ent = game.edicts + entNum;
 
-	clipEnt = GClip_GetClipEdictForDeltaTime( entNum, 0 );
-	RS_SplashFrac( clipEnt->s.origin, clipEnt->r.mins, clipEnt->r.maxs, hitpoint,
+	RS_SplashFrac( ent->s.origin, ent->r.mins, ent->r.maxs, hitpoint,
 				   maxradius, pushdir, kickFrac, dmgFrac, splashFrac );
 }
 
 entity_state_t *G_GetEntityStateForDeltaTime( int entNum, int deltaTime ) {
-	c4clipedict_t *clipEnt;
+	// pick one of the 8 slots to prevent overwritings
+	static int index = 0;
+	static entity_state_t states[8];
+	entity_state_t *state;
+	c4clipedict_t clipEnt;
+	c4rewind_t rewind;
 
 	if( entNum == -1 ) {
 		return NULL;
@@ -1191,7 +1847,76 @@ entity_state_t *G_GetEntityStateForDeltaTime( int entNum, int deltaTime ) {
 
 	assert( entNum >= 0 && entNum < MAX_EDICTS );
 
-	clipEnt = GClip_GetClipEdictForDeltaTime( entNum, deltaTime );
+	GClip_SetupRewind( &rewind, deltaTime );
+	GClip_RewindEntity( &rewind, entNum, &clipEnt );
 
-	return &clipEnt->s;
+	state = &states[index];
+	index = ( index + 1 ) & 7;
+
+	// only the position and orientation are backed up
+	*state = game.edicts[entNum].s;
+	VectorCopy( clipEnt.origin, state->origin );
+	VectorCopy( clipEnt.angles, state->angles );
+	return state;
 }
+
+#ifndef PUBLIC_BUILD
+
+/*
+* GClip_RunBenchmark
+*
+* Times box queries of various sizes and traces between linked entities using the current spatial index
+*/
+void GClip_RunBenchmark( int numIterations ) {
+	static const float kBoxHalfSizes[] = { 16.0f, 64.0f, 256.0f, 1024.0f };
+	static int entNums[MAX_EDICTS];
+	static int list[MAX_EDICTS];
+	int i, j, k, numEnts = 0;
+	int64_t numQueries = 0, numTraces = 0, numListed = 0;
+	vec3_t mins, maxs;
+	trace_t tr;
+
+	for( i = 1; i < game.numentities; i++ ) {
+		if( game.edicts[i].r.inuse && game.edicts[i].linked ) {
+			entNums[numEnts++] = i;
+		}
+	}
+	if( !numEnts ) {
+		G_Printf( "There are no linked entities\n" );
+		return;
+	}
+
+	const auto startTime = std::chrono::steady_clock::now();
+	for( i = 0; i < numIterations; i++ ) {
+		for( j = 0; j < numEnts; j++ ) {
+			const float *origin = game.edicts[entNums[j]].s.origin;
+			for( const float halfSize: kBoxHalfSizes ) {
+				VectorSet( mins, origin[0] - halfSize, origin[1] - halfSize, origin[2] - halfSize );
+				VectorSet( maxs, origin[0] + halfSize, origin[1] + halfSize, origin[2] + halfSize );
+				numListed += GClip_AreaEdicts( mins, maxs, list, MAX_EDICTS, AREA_ALL, 0 );
+				numQueries++;
+			}
+		}
+	}
+
+	const auto boxesEndTime = std::chrono::steady_clock::now();
+	for( i = 0; i < numIterations; i++ ) {
+		for( j = 0; j < numEnts; j++ ) {
+			const edict_t *ent = game.edicts + entNums[j];
+			k = ( j + 1 + i ) % numEnts;
+			G_Trace( &tr, ent->s.origin, vec3_origin, vec3_origin, game.edicts[entNums[k]].s.origin, ent, MASK_SHOT );
+			numTraces++;
+		}
+	}
+	const auto tracesEndTime = std::chrono::steady_clock::now();
+
+	const auto boxesMicros = std::chrono::duration_cast<std::chrono::microseconds>( boxesEndTime - startTime ).count();
+	const auto tracesMicros = std::chrono::duration_cast<std::chrono::microseconds>( tracesEndTime - boxesEndTime ).count();
+	G_Printf( "%s, %d linked entities\n", g_useLooseGrid ? "Loose grid" : "Area grid", numEnts );
+	G_Printf( "%d box queries: %.3f ms, %.3f us per query, %.1f entities per query\n", (int)numQueries,
+			  1e-3 * (double)boxesMicros, (double)boxesMicros / (double)numQueries, (double)numListed / (double)numQueries );
+	G_Printf( "%d traces: %.3f ms, %.3f us per trace\n", (int)numTraces,
+			  1e-3 * (double)tracesMicros, (double)tracesMicros / (double)numTraces );
+}
+
+#endif
@@ -1276,7 +1276,9 @@ static void G_CheckNumBots( void ) {
 			Cvar_Set( "g_numbots", "0" );
 		}
 
-		const int maxNumBots = developer->integer ? ggs->maxclients : wsw::min( 11, ggs->maxclients );
+		// Server benchmarks are allowed to fill all slots
+		const bool isUnlimited = developer->integer || Cvar_Value( "sv_benchmark" ) != 0.0f;
+		const int maxNumBots = isUnlimited ? ggs->maxclients : wsw::min( 11, ggs->maxclients );
 		if( g_numbots->integer > maxNumBots ) {
 			Cvar_Set( "g_numbots", va( "%i", maxNumBots ) );
 		}
@@ -596,6 +596,9 @@ bool Add_Armor( edict_t *ent, edict_t *other, bool pick_it );
 
 bool KillBox( edict_t *ent );
 float LookAtKillerYAW( edict_t *self, edict_t *inflictor, edict_t *attacker );
+void G_ClearEntityNameIndices( void );
+void G_SetClassname( edict_t *ent, const char *classname );
+void G_SetTargetname( edict_t *ent, const char *targetname );
 edict_t *G_Find( edict_t *from, size_t fieldofs, const char *match );
 edict_t *G_PickTarget( const char *targetname );
 void G_UseTargets( edict_t *ent, edict_t *activator );
@@ -751,6 +754,12 @@ int GClip_FindInRadius( const vec3_t org, float rad, int *list, int maxcount );
 #define AREA_TRIGGERS   2
 int GClip_AreaEdicts( const vec3_t mins, const vec3_t maxs, int *list, int maxcount, int areatype, int timeDelta );
 bool GClip_EntityContact( const vec3_t mins, const vec3_t maxs, const edict_t *ent );
+bool GClip_SupportsConcurrentQueries( void );
+#ifndef PUBLIC_BUILD
+void GClip_RunBenchmark( int numIterations );
+bool GClip_StartTraceCapture( const char *filename, unsigned maxTraces );
+void GClip_StopTraceCapture( void );
+#endif
 
 //
 // g_combat.c
@@ -71,6 +71,7 @@ cvar_t *g_maxtimeouts;
 cvar_t *g_antilag;
 cvar_t *g_antilag_maxtimedelta;
 cvar_t *g_antilag_timenudge;
+cvar_t *g_clip_loosegrid;
 cvar_t *g_autorecord;
 cvar_t *g_autorecord_maxdemos;
 
@@ -304,6 +305,8 @@ void G_Init( unsigned int seed, unsigned int framemsec, int protocol, const char
 	g_antilag_maxtimedelta->modified = true;
 	g_antilag_timenudge = Cvar_Get( "g_antilag_timenudge", "0", CVAR_ARCHIVE );
 	g_antilag_timenudge->modified = true;
+	// the spatial index of entities is switched on a map change only
+	g_clip_loosegrid = Cvar_Get( "g_clip_loosegrid", "1", CVAR_ARCHIVE | CVAR_LATCH );
 
 	g_allow_spectator_voting = Cvar_Get( "g_allow_spectator_voting", "1", CVAR_ARCHIVE );
 
@@ -361,6 +364,7 @@ void G_Init( unsigned int seed, unsigned int framemsec, int protocol, const char
 	g_maxentities = Cvar_Get( "sv_maxentities", "1024", CVAR_LATCH );
 	game.maxentities = g_maxentities->integer;
 	game.edicts = ( edict_t * )Q_malloc( game.maxentities * sizeof( game.edicts[0] ) );
+	G_ClearEntityNameIndices();
 
 	// initialize all clients for this game
 	game.clients = ( Client * )Q_malloc( ggs->maxclients * sizeof( game.clients[0] ) );
@@ -415,6 +419,10 @@ void G_Shutdown( void ) {
 
 	AI_Shutdown();
 
+#ifndef PUBLIC_BUILD
+	GClip_StopTraceCapture();
+#endif
+
 	G_RemoveCommands();
 
 	G_FreeCallvotes();
@@ -449,7 +457,7 @@ static edict_t *CreateTargetChangeLevel( const char *map ) {
 	edict_t *ent;
 
 	ent = G_Spawn();
-	ent->classname = "target_changelevel";
+	G_SetClassname( ent, "target_changelevel" );
 	Q_strncpyz( level.nextmap, map, sizeof( level.nextmap ) );
 	ent->map = level.nextmap;
 	return ent;
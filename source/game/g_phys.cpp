@@ -503,7 +503,7 @@ static bool SV_Push( edict_t *pusher, vec3_t move, vec3_t amove ) {
 			continue;
 		}
 
-		if( !check->areagrid[0].prev ) {
+		if( !check->linked ) {
 			continue; // not linked in anywhere
 
 		}
@@ -66,6 +66,7 @@ typedef struct {
 } entity_shared_t;
 
 struct CMShapeList;
+struct CMHullModelStorage;
 
 struct CmdArgs;
 
@@ -138,6 +139,9 @@ struct cmodel_s *SV_InlineModel( int num );
 void SV_InlineModelBounds( const struct cmodel_s *cmodel, vec3_t mins, vec3_t maxs );
 struct cmodel_s *SV_ModelForBBox( const vec3_t mins, const vec3_t maxs );
 struct cmodel_s *SV_OctagonModelForBBox( const vec3_t mins, const vec3_t maxs );
+// These overloads use caller-owned storage and are safe to call from worker threads
+struct cmodel_s *SV_ModelForBBox( const vec3_t mins, const vec3_t maxs, CMHullModelStorage *storage );
+struct cmodel_s *SV_OctagonModelForBBox( const vec3_t mins, const vec3_t maxs, CMHullModelStorage *storage );
 void SV_SetAreaPortalState( int area, int otherarea, bool open );
 
 int SV_BoxLeafnums( const vec3_t mins, const vec3_t maxs, int *list, int listsize, int *topnode, int topNodeHint = 0 );
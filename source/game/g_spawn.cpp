@@ -483,7 +483,11 @@ static char *ED_ParseEdict( char *data, edict_t *ent ) {
 	}
 
 	if( !init ) {
-		ent->classname = NULL;
+		G_SetClassname( ent, NULL );
+	} else {
+		// the fields have been written by ED_ParseField() directly
+		G_SetClassname( ent, ent->classname );
+		G_SetTargetname( ent, ent->targetname );
 	}
 	if( ent->classname && ent->helpmessage ) {
 		ent->mapmessage_index = G_RegisterHelpMessage( ent->helpmessage );
@@ -701,6 +705,7 @@ static void G_FreeEntities( void ) {
 
 	if( !level.time ) {
 		memset( game.edicts, 0, game.maxentities * sizeof( game.edicts[0] ) );
+		G_ClearEntityNameIndices();
 	} else {
 		G_FreeEdict( world );
 		for( i = ggs->maxclients + 1; i < game.maxentities; i++ ) {
@@ -781,7 +786,7 @@ static void G_SpawnEntities( void ) {
 			if( item->flags & ITFLAG_PICKABLE ) {
 				if( G_Gametype_CanSpawnItem( item ) ) {
 					// override entity's classname with whatever item specifies
-					ent->classname = item->classname;
+					G_SetClassname( ent, item->classname );
 					PrecacheItem( item );
 					continue;
 				}
@@ -1236,6 +1236,13 @@ static void Cmd_WriteIP_f( const CmdArgs & ) {
 	SV_WriteIPList();
 }
 
+/*
+* Cmd_RouteCacheStats_f
+*/
+static void Cmd_RouteCacheStats_f( const CmdArgs & ) {
+	AI_PrintRouteCacheStats();
+}
+
 #ifndef PUBLIC_BUILD
 /*
 * Cmd_Match_IP_f()
@@ -1254,6 +1261,62 @@ static void Cmd_MatchIP_f( const CmdArgs &cmdArgs ) {
 		G_Printf( "No match or malformed input. %s\n", usage );
 	}
 }
+
+/*
+* Cmd_ClipBenchmark_f
+*/
+static void Cmd_ClipBenchmark_f( const CmdArgs &cmdArgs ) {
+	int numIterations = 100;
+	if( Cmd_Argc() > 1 ) {
+		numIterations = atoi( Cmd_Argv( 1 ) );
+		if( numIterations <= 0 ) {
+			G_Printf( "Usage: clipbenchmark [<iterations>]\n" );
+			return;
+		}
+	}
+
+	GClip_RunBenchmark( numIterations );
+}
+
+/*
+* Cmd_TraceCapture_f
+*/
+static void Cmd_TraceCapture_f( const CmdArgs &cmdArgs ) {
+	if( Cmd_Argc() < 2 ) {
+		G_Printf( "Usage: tracecapture <filename> [<maxtraces>] or tracecapture stop\n" );
+		return;
+	}
+
+	if( !Q_stricmp( Cmd_Argv( 1 ), "stop" ) ) {
+		GClip_StopTraceCapture();
+		return;
+	}
+
+	int maxTraces = 0;
+	if( Cmd_Argc() > 2 ) {
+		maxTraces = atoi( Cmd_Argv( 2 ) );
+		if( maxTraces <= 0 ) {
+			G_Printf( "Usage: tracecapture <filename> [<maxtraces>] or tracecapture stop\n" );
+			return;
+		}
+	}
+
+	char filename[MAX_QPATH];
+	Q_strncpyz( filename, Cmd_Argv( 1 ), sizeof( filename ) );
+	COM_SanitizeFilePath( filename );
+	if( !COM_ValidateRelativeFilename( filename ) ) {
+		G_Printf( "Invalid filename: %s\n", filename );
+		return;
+	}
+	COM_DefaultExtension( filename, ".cmt", sizeof( filename ) );
+
+	if( !GClip_StartTraceCapture( filename, (unsigned)maxTraces ) ) {
+		G_Printf( "Failed to open %s for writing\n", filename );
+		return;
+	}
+
+	G_Printf( "Capturing traces to %s\n", filename );
+}
 #endif
 
 /*
@@ -1275,8 +1338,12 @@ void G_AddServerCommands( void ) {
 	SV_Cmd_Register( "writeip", Cmd_WriteIP_f );
 #ifndef PUBLIC_BUILD
 	SV_Cmd_Register( "matchip", Cmd_MatchIP_f );
+	SV_Cmd_Register( "clipbenchmark", Cmd_ClipBenchmark_f );
+	SV_Cmd_Register( "tracecapture", Cmd_TraceCapture_f );
 #endif
 
+	SV_Cmd_Register( "routecachestats", Cmd_RouteCacheStats_f );
+
 	SV_Cmd_Register( "dumpASapi", G_asDumpAPI_f );
 }
 
@@ -1299,7 +1366,11 @@ void G_RemoveCommands( void ) {
 	SV_Cmd_Unregister( "writeip" );
 #ifndef PUBLIC_BUILD
 	SV_Cmd_Unregister( "matchip" );
+	SV_Cmd_Unregister( "clipbenchmark" );
+	SV_Cmd_Unregister( "tracecapture" );
 #endif
 
+	SV_Cmd_Unregister( "routecachestats" );
+
 	SV_Cmd_Unregister( "dumpASapi" );
 }
@@ -148,6 +148,156 @@ void G_ProjectSource( vec3_t point, vec3_t distance, vec3_t forward, vec3_t righ
 }
 
 
+#define ENTNAMES_HASH_SIZE  1024
+#define ENTNAMES_HASH_MASK  ( ENTNAMES_HASH_SIZE - 1 )
+
+// a hashed multimap of entity names to entity numbers.
+// chains are kept sorted by entity numbers, so lookups visit entities in the G_Find() order
+typedef struct {
+	int16_t heads[ENTNAMES_HASH_SIZE];
+	int16_t next[MAX_EDICTS];
+	int16_t prev[MAX_EDICTS];
+	uint32_t hashes[MAX_EDICTS];    // a case-insensitive hash of the name the entity has been indexed with
+	bool indexed[MAX_EDICTS];
+} g_entnameindex_t;
+
+static g_entnameindex_t g_classnameIndex;
+static g_entnameindex_t g_targetnameIndex;
+
+/*
+* G_EntityNameHash
+*/
+static uint32_t G_EntityNameHash( const char *name ) {
+	uint32_t hash = 2166136261u;
+	for(; *name; name++ ) {
+		hash = ( hash ^ (uint8_t)tolower( *name ) ) * 16777619u;
+	}
+	return hash;
+}
+
+/*
+* G_ClearEntityNameIndex
+*/
+static void G_ClearEntityNameIndex( g_entnameindex_t *index ) {
+	memset( index->heads, -1, sizeof( index->heads ) );
+	memset( index->indexed, 0, sizeof( index->indexed ) );
+}
+
+/*
+* G_UnindexEntityName
+*/
+static void G_UnindexEntityName( g_entnameindex_t *index, int entNum ) {
+	if( !index->indexed[entNum] ) {
+		return;
+	}
+
+	const int prev = index->prev[entNum];
+	const int next = index->next[entNum];
+	if( prev >= 0 ) {
+		index->next[prev] = (int16_t)next;
+	} else {
+		index->heads[index->hashes[entNum] & ENTNAMES_HASH_MASK] = (int16_t)next;
+	}
+	if( next >= 0 ) {
+		index->prev[next] = (int16_t)prev;
+	}
+	index->indexed[entNum] = false;
+}
+
+/*
+* G_IndexEntityName
+*/
+static void G_IndexEntityName( g_entnameindex_t *index, int entNum, const char *name ) {
+	int prev, next;
+
+	G_UnindexEntityName( index, entNum );
+	if( !name ) {
+		return;
+	}
+
+	const uint32_t hash = G_EntityNameHash( name );
+	int16_t *head = &index->heads[hash & ENTNAMES_HASH_MASK];
+
+	prev = -1;
+	for( next = *head; next >= 0 && next < entNum; next = index->next[next] ) {
+		prev = next;
+	}
+
+	index->prev[entNum] = (int16_t)prev;
+	index->next[entNum] = (int16_t)next;
+	if( prev >= 0 ) {
+		index->next[prev] = (int16_t)entNum;
+	} else {
+		*head = (int16_t)entNum;
+	}
+	if( next >= 0 ) {
+		index->prev[next] = (int16_t)entNum;
+	}
+	index->hashes[entNum] = hash;
+	index->indexed[entNum] = true;
+}
+
+/*
+* G_FindInEntityNameIndex
+*/
+static edict_t *G_FindInEntityNameIndex( const g_entnameindex_t *index, edict_t *from, size_t fieldofs, const char *match ) {
+	const uint32_t hash = G_EntityNameHash( match );
+	const int fromNum = from ? ENTNUM( from ) : -1;
+	int entNum;
+
+	if( from && index->indexed[fromNum] && index->hashes[fromNum] == hash ) {
+		// continuing an iteration, from is in the chain
+		entNum = index->next[fromNum];
+	} else {
+		for( entNum = index->heads[hash & ENTNAMES_HASH_MASK]; entNum >= 0 && entNum <= fromNum; entNum = index->next[entNum] ) {}
+	}
+
+	for(; entNum >= 0; entNum = index->next[entNum] ) {
+		if( index->hashes[entNum] != hash ) {
+			continue;
+		}
+		edict_t *ent = game.edicts + entNum;
+		if( !ent->r.inuse ) {
+			continue;
+		}
+		// make sure the name has not been modified bypassing the index
+		const char *s = *(char **) ( (uint8_t *)ent + fieldofs );
+		if( s && !Q_stricmp( s, match ) ) {
+			return ent;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+* G_ClearEntityNameIndices
+*/
+void G_ClearEntityNameIndices( void ) {
+	G_ClearEntityNameIndex( &g_classnameIndex );
+	G_ClearEntityNameIndex( &g_targetnameIndex );
+}
+
+/*
+* G_SetClassname
+*
+* Classnames must be set using this call, so G_Find() by classnames can use the index
+*/
+void G_SetClassname( edict_t *ent, const char *classname ) {
+	ent->classname = classname;
+	G_IndexEntityName( &g_classnameIndex, ENTNUM( ent ), classname );
+}
+
+/*
+* G_SetTargetname
+*
+* Targetnames must be set using this call, so G_Find() by targetnames can use the index
+*/
+void G_SetTargetname( edict_t *ent, const char *targetname ) {
+	ent->targetname = targetname;
+	G_IndexEntityName( &g_targetnameIndex, ENTNUM( ent ), targetname );
+}
+
 /*
 * G_Find
 *
@@ -157,10 +307,18 @@ void G_ProjectSource( vec3_t point, vec3_t distance, vec3_t forward, vec3_t righ
 * Searches beginning at the edict after from, or the beginning if NULL
 * NULL will be returned if the end of the list is reached.
 *
+* Classnames and targetnames are looked up in the index.
 */
 edict_t *G_Find( edict_t *from, size_t fieldofs, const char *match ) {
 	char *s;
 
+	if( fieldofs == FOFS( classname ) ) {
+		return G_FindInEntityNameIndex( &g_classnameIndex, from, fieldofs, match );
+	}
+	if( fieldofs == FOFS( targetname ) ) {
+		return G_FindInEntityNameIndex( &g_targetnameIndex, from, fieldofs, match );
+	}
+
 	if( !from ) {
 		from = world;
 	} else {
@@ -254,7 +412,7 @@ void G_UseTargets( edict_t *ent, edict_t *activator ) {
 	if( ent->delay ) {
 		// create a temp object to fire at a later time
 		t = G_Spawn();
-		t->classname = "delayed_use";
+		G_SetClassname( t, "delayed_use" );
 		t->nextThink = level.time + 1000 * ent->delay;
 		t->think = Think_Delay;
 		t->activator = activator;
@@ -380,6 +538,9 @@ void G_FreeEdict( edict_t *ed ) {
 
 	GClip_UnlinkEntity( ed );   // unlink from world
 
+	G_UnindexEntityName( &g_classnameIndex, ENTNUM( ed ) );
+	G_UnindexEntityName( &g_targetnameIndex, ENTNUM( ed ) );
+
 	AI_RemoveNavEntity( ed );
 	G_FreeAI( ed );
 
@@ -401,7 +562,7 @@ void G_FreeEdict( edict_t *ed ) {
 */
 void G_InitEdict( edict_t *e ) {
 	e->r.inuse = true;
-	e->classname = NULL;
+	G_SetClassname( e, NULL );
 	e->gravity = 1.0;
 	e->timeDelta = 0;
 	e->deadflag = DEAD_NO;
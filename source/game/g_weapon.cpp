@@ -265,7 +265,7 @@ static edict_t *W_Fire_LinearProjectile( edict_t *self, vec3_t start, vec3_t ang
 	projectile->touch = W_Touch_Projectile; //generic one. Should be replaced after calling this func
 	projectile->nextThink = level.time + timeout;
 	projectile->think = G_FreeEdict;
-	projectile->classname = NULL; // should be replaced after calling this func.
+	G_SetClassname( projectile, NULL ); // should be replaced after calling this func.
 	projectile->style = 0;
 	projectile->s.sound = 0;
 	projectile->timeStamp = level.time;
@@ -329,7 +329,7 @@ static edict_t *W_Fire_TossProjectile( edict_t *self, vec3_t start, vec3_t angle
 	projectile->nextThink = level.time + timeout;
 	projectile->timeout = level.time + timeout;
 	projectile->think = G_FreeEdict;
-	projectile->classname = NULL; // should be replaced after calling this func.
+	G_SetClassname( projectile, NULL ); // should be replaced after calling this func.
 	projectile->style = 0;
 	projectile->s.sound = 0;
 	projectile->timeStamp = level.time;
@@ -459,7 +459,7 @@ edict_t *W_Fire_GunbladeBlast( edict_t *self, vec3_t start, vec3_t angles, float
 	blast->s.type = ET_BLASTER;
 	blast->s.effects |= EF_STRONG_WEAPON;
 	blast->touch = W_Touch_GunbladeBlast;
-	blast->classname = "gunblade_blast";
+	G_SetClassname( blast, "gunblade_blast" );
 	blast->style = mod;
 
 	blast->s.sound = SV_SoundIndex( S_WEAPON_PLASMAGUN_S_FLY );
@@ -817,7 +817,7 @@ edict_t *W_Fire_Grenade( edict_t *self, vec3_t start, vec3_t angles, int speed,
 	grenade->use = NULL;
 	grenade->think = W_Grenade_Explode;
 	grenade->stop = W_Grenade_Stop;
-	grenade->classname = "grenade";
+	G_SetClassname( grenade, "grenade" );
 	grenade->enemy = NULL;
 	if( GS_RaceGametype( *ggs ) ) {
 		const gs_weapon_definition_t *weapondef = GS_GetWeaponDef( ggs, WEAP_GRENADELAUNCHER );
@@ -937,7 +937,7 @@ edict_t *W_Fire_Rocket( edict_t *self, vec3_t start, vec3_t angles, int speed, f
 
 	rocket->s.attenuation = ATTN_STATIC;
 	rocket->touch = W_Touch_Rocket;
-	rocket->classname = "rocket";
+	G_SetClassname( rocket, "rocket" );
 	rocket->style = mod;
 	// Set it for strong projectile as well for consistency
 	rocket->timeout = level.time + timeout;
@@ -1088,7 +1088,7 @@ edict_t *W_Fire_Plasma( edict_t *self, vec3_t start, vec3_t angles, float damage
 	plasma = W_Fire_LinearProjectile( self, start, angles, speed, damage, minKnockback, maxKnockback, stun, minDamage, radius, timeout, timeDelta );
 
 	plasma->s.type = ET_PLASMA;
-	plasma->classname = "plasma";
+	G_SetClassname( plasma, "plasma" );
 	plasma->style = mod;
 
 	plasma->touch = W_AutoTouch_Plasma;
@@ -1442,7 +1442,7 @@ edict_t *W_Fire_Electrobolt_Weak( edict_t *self, vec3_t start, vec3_t angles, fl
 	bolt->s.type = ET_ELECTRO_WEAK; //add particle trail and light
 	bolt->s.ownerNum = ENTNUM( self );
 	bolt->touch = W_Touch_Bolt;
-	bolt->classname = "bolt";
+	G_SetClassname( bolt, "bolt" );
 	bolt->style = mod;
 	bolt->s.effects &= ~EF_STRONG_WEAPON;
 
@@ -1610,7 +1610,7 @@ edict_t *W_Fire_Shockwave( edict_t *self, vec3_t start, vec3_t angles, int speed
 	}
 
 	wave->s.type = ET_WAVE;
-	wave->classname = "wave";
+	G_SetClassname( wave, "wave" );
 	wave->style = mod;
 	wave->s.ownerNum = ENTNUM( self );
 
@@ -103,6 +103,16 @@ typedef struct {
 	char command[MAX_STRING_CHARS];
 } game_command_t;
 
+// A pending reliable command is either a reference to an entry of the shared log of broadcast commands
+// or a command that is stored in the client's own buffer of local (client-specific) commands
+typedef struct {
+	int64_t broadcastNum;           // a number of the shared broadcast log entry, zero for local commands
+	int64_t localOffset;            // an offset of the local command data (grows monotonically)
+	unsigned localLength;           // a length of the local command excluding the trailing zero
+} reliable_command_t;
+
+#define LOCAL_COMMANDS_BUFFER_SIZE ( MAX_RELIABLE_COMMANDS * MAX_STRING_CHARS / 4 )
+
 #define LATENCY_COUNTS  16
 
 #define HTTP_CLIENT_SESSION_SIZE 16
@@ -116,7 +126,9 @@ typedef struct client_s {
 
 	bool reliable;                  // no need for acks, connection is reliable
 
-	wsw::StaticString<MAX_STRING_CHARS> reliableCommands[MAX_RELIABLE_COMMANDS];
+	reliable_command_t reliableCommands[MAX_RELIABLE_COMMANDS];
+	char localCommandsData[LOCAL_COMMANDS_BUFFER_SIZE];
+	int64_t localCommandsHead;     // an offset for the next local command data
 	int64_t reliableSequence;      // last added reliable message, not necesarily sent or acknowledged yet
 	int64_t reliableAcknowledge;   // last acknowledged reliable message
 	int64_t reliableSent;          // last sent reliable message, not necesarily acknowledged yet
@@ -242,13 +254,13 @@ void SV_Cmd_ExecuteNow2( const wsw::PodVector<char> &text );
 
 void SV_Cbuf_AppendCommand( const char *text );
 
-bool SV_Netchan_Transmit( netchan_t *netchan, msg_t *msg );
+bool SV_Netchan_Transmit( netchan_t *netchan, msg_t *msg, bool compress = true );
 void SV_SendServerCommand( client_t *cl, const char *format, ... );
 void SV_AddGameCommand( client_t *client, const char *cmd );
 void SV_AddReliableCommandsToMessage( client_t *client, msg_t *msg );
 bool SV_SendClientsFragments( void );
 void SV_InitClientMessage( client_t *client, msg_t *msg, uint8_t *data, size_t size );
-bool SV_SendMessageToClient( client_t *client, msg_t *msg );
+bool SV_SendMessageToClient( client_t *client, msg_t *msg, bool compress = true );
 void SV_ResetClientFrameCounters( void );
 void SV_AddServerCommand( client_t *client, const wsw::StringView &cmd );
 void SV_SendConfigString( client_t *cl, int index, const wsw::StringView &string );
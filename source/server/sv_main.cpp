@@ -26,15 +26,22 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "../common/compression.h"
 #include "../common/demometadata.h"
 #include "../common/profilerscope.h"
+#include "../common/wswprofiler.h"
+#include "../common/tasksystem.h"
 #include "../common/wswtonum.h"
+#include "../common/randomgenerator.h"
 #include "../common/wswfs.h"
 #include "../common/wswalgorithm.h"
 #include "../common/wswstringsplitter.h"
 #include "../common/gs_public.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <variant>
 #include <string>
 #include <span>
+#include <vector>
 
 using wsw::operator""_asView;
 
@@ -62,9 +69,12 @@ typedef struct {
 	char *tempname;
 	time_t localtime;
 	int64_t basetime, duration;
+	int64_t keyframetime;           // time of the last non-delta frame, demo players may seek to it
 	client_t client;                // special client for writing the messages
 } server_static_demo_t;
 
+#define SV_DEMO_KEYFRAME_INTERVAL 10000
+
 static struct {
 	bool initialized;               // sv_init has completed
 	int64_t realtime;               // real world time - always increasing, no clamping, etc
@@ -175,6 +185,171 @@ private:
 	const Params m_params;
 };
 
+/*
+* ClientsByAddressTable
+*
+* An open addressing hash table that maps (base address, game port) pairs
+* of connected non-fake clients to their slots.
+* The key does not include the UDP port, so fixing up a translated port does not invalidate entries.
+*/
+class ClientsByAddressTable {
+public:
+	ClientsByAddressTable() { clear(); }
+
+	void clear() {
+		std::fill( std::begin( m_clientNums ), std::end( m_clientNums ), -1 );
+	}
+
+	void add( const client_t *client );
+	void remove( const client_t *client );
+
+	[[nodiscard]]
+	auto find( const netadr_t *address, int gamePort ) -> client_t *;
+private:
+	static constexpr unsigned kNumSlots = 128;
+	static constexpr unsigned kSlotMask = kNumSlots - 1;
+	// Keep the load factor low for any number of clients
+	static_assert( kNumSlots >= 4 * MAX_CLIENTS && !( kNumSlots & kSlotMask ) );
+
+	[[nodiscard]]
+	static auto hashOf( const netadr_t *address, int gamePort ) -> uint32_t {
+		const uint32_t hash = NET_AddressHash( *address ) * 31 + (uint32_t)gamePort;
+		// Fibonacci hashing
+		return ( hash * 2654435769u ) >> 16;
+	}
+
+	[[nodiscard]]
+	static bool matches( const client_t *client, const netadr_t *address, int gamePort ) {
+		return client->netchan.game_port == gamePort && NET_CompareBaseAddress( address, &client->netchan.remoteAddress );
+	}
+
+	int m_clientNums[kNumSlots];
+	uint32_t m_hashes[kNumSlots] {};
+};
+
+static ClientsByAddressTable g_clientsByAddressTable;
+
+void ClientsByAddressTable::add( const client_t *client ) {
+	assert( !client->isAFakeClient() );
+	const int clientNum           = (int)( client - svs.clients );
+	const netadr_t *const address = &client->netchan.remoteAddress;
+	const int gamePort            = client->netchan.game_port;
+	const uint32_t hash           = hashOf( address, gamePort );
+	for( unsigned slot = hash & kSlotMask;; slot = ( slot + 1 ) & kSlotMask ) {
+		if( m_clientNums[slot] < 0 || matches( svs.clients + m_clientNums[slot], address, gamePort ) ) {
+			// Newer connections with the same key override older ones
+			m_clientNums[slot] = clientNum;
+			m_hashes[slot]     = hash;
+			return;
+		}
+	}
+}
+
+void ClientsByAddressTable::remove( const client_t *client ) {
+	const int clientNum = (int)( client - svs.clients );
+	const uint32_t hash = hashOf( &client->netchan.remoteAddress, client->netchan.game_port );
+	unsigned slot = hash & kSlotMask;
+	for(;; slot = ( slot + 1 ) & kSlotMask ) {
+		if( m_clientNums[slot] < 0 ) {
+			return;
+		}
+		if( m_clientNums[slot] == clientNum ) {
+			break;
+		}
+	}
+
+	// Shift back entries of the probe sequence, so there's no need in tombstones
+	for( unsigned next = ( slot + 1 ) & kSlotMask; m_clientNums[next] >= 0; next = ( next + 1 ) & kSlotMask ) {
+		const unsigned home = m_hashes[next] & kSlotMask;
+		// Check whether the home slot of the next entry is cyclically outside of ( slot, next ]
+		if( ( ( next - home ) & kSlotMask ) >= ( ( next - slot ) & kSlotMask ) ) {
+			m_clientNums[slot] = m_clientNums[next];
+			m_hashes[slot]     = m_hashes[next];
+			slot = next;
+		}
+	}
+	m_clientNums[slot] = -1;
+}
+
+auto ClientsByAddressTable::find( const netadr_t *address, int gamePort ) -> client_t * {
+	const uint32_t hash = hashOf( address, gamePort );
+	for( unsigned slot = hash & kSlotMask; m_clientNums[slot] >= 0; slot = ( slot + 1 ) & kSlotMask ) {
+		if( m_hashes[slot] == hash ) {
+			client_t *const client = svs.clients + m_clientNums[slot];
+			if( matches( client, address, gamePort ) ) {
+				return client->state >= CS_CONNECTING ? client : nullptr;
+			}
+		}
+	}
+	return nullptr;
+}
+
+/*
+* InfoQueryLimiter
+*
+* Limits connectionless info queries using token buckets by base address and a global one.
+* Buckets are kept in a fixed direct-mapped table, so spoofing many addresses
+* just evicts buckets of others, while the global bucket still caps the total reply rate.
+*/
+class InfoQueryLimiter {
+public:
+	[[nodiscard]]
+	bool tryAcquire( const netadr_t *address, int64_t millis );
+private:
+	static constexpr unsigned kNumSlots = 1024;
+	static constexpr unsigned kSlotMask = kNumSlots - 1;
+	static_assert( !( kNumSlots & kSlotMask ) );
+
+	static constexpr int64_t kAddressRefillMillis = 250;
+	static constexpr int64_t kAddressBurst = 8;
+	static constexpr int64_t kGlobalRefillMillis = 2;
+	static constexpr int64_t kGlobalBurst = 256;
+
+	/*
+	* A bucket stores the time when it is going to be full again instead of a number of tokens,
+	* so no periodic refill is needed and an idle bucket is just a stale timestamp.
+	*/
+	struct Bucket {
+		netadr_t address;
+		int64_t fullAt { 0 };
+	};
+
+	[[nodiscard]]
+	static bool tryAcquire( Bucket *bucket, int64_t millis, int64_t refillMillis, int64_t burst );
+
+	Bucket m_buckets[kNumSlots] {};
+	Bucket m_globalBucket;
+};
+
+static InfoQueryLimiter g_infoQueryLimiter;
+
+bool InfoQueryLimiter::tryAcquire( Bucket *bucket, int64_t millis, int64_t refillMillis, int64_t burst ) {
+	const int64_t fullAt = wsw::max( bucket->fullAt, millis ) + refillMillis;
+	// The bucket would have been emptied by this token
+	if( fullAt - millis > refillMillis * burst ) {
+		return false;
+	}
+	bucket->fullAt = fullAt;
+	return true;
+}
+
+bool InfoQueryLimiter::tryAcquire( const netadr_t *address, int64_t millis ) {
+	if( NET_IsLocalAddress( address ) ) {
+		return true;
+	}
+
+	Bucket *const bucket = m_buckets + ( ( ( NET_AddressHash( *address ) * 2654435769u ) >> 16 ) & kSlotMask );
+	if( !NET_CompareBaseAddress( address, &bucket->address ) ) {
+		bucket->address = *address;
+		bucket->fullAt  = 0;
+	}
+
+	if( !tryAcquire( bucket, millis, kAddressRefillMillis, kAddressBurst ) ) {
+		return false;
+	}
+	return tryAcquire( &m_globalBucket, millis, kGlobalRefillMillis, kGlobalBurst );
+}
+
 // IPv4
 cvar_t *sv_ip;
 cvar_t *sv_port;
@@ -227,6 +402,7 @@ static cvar_t *sv_skilllevel;
 
 // wsw : debug netcode
 static cvar_t *sv_debug_serverCmd;
+static cvar_t *sv_parallelSnapshots;
 
 static cvar_t *sv_MOTD;
 static cvar_t *sv_MOTDFile;
@@ -291,6 +467,8 @@ int G_GetClientState( int clientNum ) {
 * Note: These commands are unreliable (the order is guaranteed to be preserved
 * but commands may be legitimately dropped due to server time adjustments on clients)
 */
+static void SV_AddBroadcastServerCommand( const wsw::StringView &cmd, int minAcceptableState, bool includeDemo );
+
 void SV_DispatchGameCmd( const edict_t *ent, const char *cmd ) {
 	if( cmd && cmd[0] ) {
 		if( !ent ) {
@@ -350,11 +528,7 @@ void SV_DispatchServerCmd( const edict_t *ent, const char *cmd ) {
 				}
 			}
 			if( !ent ) {
-				for( int clientNum = 0; clientNum < sv_maxclients->integer; ++clientNum ) {
-					if( client_t *client = svs.clients + clientNum; client->state >= CS_SPAWNED ) {
-						SV_AddServerCommand( client, buffer.asView() );
-					}
-				}
+				SV_AddBroadcastServerCommand( buffer.asView(), CS_SPAWNED, false );
 			} else {
 				const int entNum = NUM_FOR_EDICT( ent );
 				if( entNum >= 1 && entNum <= sv_maxclients->integer ) {
@@ -620,6 +794,14 @@ struct cmodel_s *SV_OctagonModelForBBox( const vec3_t mins, const vec3_t maxs )
 	return CM_OctagonModelForBBox( svs.cms, mins, maxs );
 }
 
+struct cmodel_s *SV_ModelForBBox( const vec3_t mins, const vec3_t maxs, CMHullModelStorage *storage ) {
+	return CM_ModelForBBox( svs.cms, mins, maxs, storage );
+}
+
+struct cmodel_s *SV_OctagonModelForBBox( const vec3_t mins, const vec3_t maxs, CMHullModelStorage *storage ) {
+	return CM_OctagonModelForBBox( svs.cms, mins, maxs, storage );
+}
+
 bool SV_AreasConnected( int area1, int area2 ) {
 	return CM_AreasConnected( svs.cms, area1, area2 );
 }
@@ -733,59 +915,68 @@ static bool SV_ProcessPacket( netchan_t *netchan, msg_t *msg ) {
 	return true;
 }
 
+#define SV_MAX_BATCHED_PACKETS 16
+
 static void SV_ReadPackets() {
 	WSW_PROFILER_SCOPE();
 
-	msg_t msg;
-	uint8_t msgData[MAX_MSGLEN];
+	// Preallocated buffers for receiving packets in batches
+	static uint8_t msgData[SV_MAX_BATCHED_PACKETS][MAX_MSGLEN];
+	msg_t messages[SV_MAX_BATCHED_PACKETS];
+	netadr_t addresses[SV_MAX_BATCHED_PACKETS];
 
-	MSG_Init( &msg, msgData, sizeof( msgData ) );
+	for( int i = 0; i < SV_MAX_BATCHED_PACKETS; ++i ) {
+		MSG_Init( &messages[i], msgData[i], sizeof( msgData[i] ) );
+	}
 
 	for( socket_t *socket: { &svs.socket_loopback, &svs.socket_udp, &svs.socket_udp6 } ) {
 		if( socket->open ) {
-			netadr_t address;
-			int ret = 0;
-			while( ( ret = NET_GetPacket( socket, &address, &msg ) ) != 0 ) {
+			for(;; ) {
+				const int ret = NET_GetPackets( socket, addresses, messages, SV_MAX_BATCHED_PACKETS );
+				if( ret == 0 ) {
+					break;
+				}
 				if( ret == -1 ) {
-					Com_Printf( "NET_GetPacket: Error: %s\n", NET_ErrorString() );
-				} else {
+					Com_Printf( "NET_GetPackets: Error: %s\n", NET_ErrorString() );
+					continue;
+				}
+				for( int packetNum = 0; packetNum < ret; ++packetNum ) {
+					netadr_t *const address = &addresses[packetNum];
+					msg_t *const msg        = &messages[packetNum];
+					if( !msg->cursize ) {
+						Com_Printf( "NET_GetPackets: Error: %s\n", NET_ErrorString() );
+						continue;
+					}
 					// check for connectionless packet (0xffffffff) first
-					if( *(int *)msg.data == -1 ) {
-						SV_ConnectionlessPacket( socket, &address, &msg );
+					if( *(int *)msg->data == -1 ) {
+						SV_ConnectionlessPacket( socket, address, msg );
 					} else {
 						// read the game port out of the message so we can fix up
 						// stupid address translating routers
-						MSG_BeginReading( &msg );
-						MSG_ReadInt32( &msg ); // sequence number
-						MSG_ReadInt32( &msg ); // sequence number
-						const int game_port = MSG_ReadInt16( &msg ) & 0xffff;
+						MSG_BeginReading( msg );
+						MSG_ReadInt32( msg ); // sequence number
+						MSG_ReadInt32( msg ); // sequence number
+						const int game_port = MSG_ReadInt16( msg ) & 0xffff;
 						// data follows
 
-						client_t *matchingClient = nullptr;
-						IteratorOverClients iteratorOverClients( { .minAcceptableState = CS_CONNECTING } );
-						while( client_t *const client = iteratorOverClients.getNext() ) {
-							if( NET_CompareBaseAddress( &address, &client->netchan.remoteAddress ) ) {
-								if( client->netchan.game_port == game_port ) {
-									matchingClient = client;
-									break;
-								}
-							}
-						}
-
-						if( matchingClient ) {
-							const unsigned short addr_port = NET_GetAddressPort( &address );
+						if( client_t *const matchingClient = g_clientsByAddressTable.find( address, game_port ) ) {
+							const unsigned short addr_port = NET_GetAddressPort( address );
 							if( NET_GetAddressPort( &matchingClient->netchan.remoteAddress ) != addr_port ) {
 								svNotice() << "SV_ReadPackets: fixing up a translated port";
 								NET_SetAddressPort( &matchingClient->netchan.remoteAddress, addr_port );
 							}
 							// This is a valid, sequenced packet, so process it
-							if( SV_ProcessPacket( &matchingClient->netchan, &msg ) ) {
+							if( SV_ProcessPacket( &matchingClient->netchan, msg ) ) {
 								matchingClient->lastPacketReceivedTime = svs.realtime;
-								SV_ParseClientMessage( matchingClient, &msg );
+								SV_ParseClientMessage( matchingClient, msg );
 							}
 						}
 					}
 				}
+				// The socket has been drained
+				if( ret < SV_MAX_BATCHED_PACKETS ) {
+					break;
+				}
 			}
 		}
 	}
@@ -855,6 +1046,9 @@ static void SV_CheckLatchedUserinfoChanges() {
 
 #define WORLDFRAMETIME 16 // 62.5fps
 
+class ServerBenchmark;
+static ServerBenchmark *g_serverBenchmark;
+
 static bool SV_RunGameFrame( int msec ) {
 	WSW_PROFILER_SCOPE();
 
@@ -876,8 +1070,8 @@ static bool SV_RunGameFrame( int msec ) {
 		refreshGameModule = true;
 	}
 
-	// if there aren't pending packets to be sent, we can sleep
-	if( dedicated->integer && !sentFragments && !refreshSnapshot ) {
+	// if there aren't pending packets to be sent, we can sleep (unless running a benchmark)
+	if( dedicated->integer && !g_serverBenchmark && !sentFragments && !refreshSnapshot ) {
 		const int sleeptime = wsw::min( (int)( WORLDFRAMETIME - ( accTime + 1 ) ), (int)( sv.nextSnapTime - ( svs.gametime + 1 ) ) );
 
 		if( sleeptime > 0 ) {
@@ -944,6 +1138,266 @@ void SV_UpdateActivity( void ) {
 	//Com_Printf( "Server activity\n" );
 }
 
+static void SV_BeginDeltaEntitiesCache();
+static void SV_EndDeltaEntitiesCache();
+static void SV_UpdateInfoVersions();
+
+/*
+* SV_RunFrame
+*/
+static void SV_RunFrame( unsigned realmsec, unsigned gamemsec ) {
+	svs.realtime += realmsec;
+	svs.gametime += gamemsec;
+
+	// check timeouts
+	SV_CheckTimeouts();
+
+	// get packets from clients
+	SV_ReadPackets();
+
+	// apply latched userinfo changes
+	SV_CheckLatchedUserinfoChanges();
+
+	// let everything in the world think and move
+	if( SV_RunGameFrame( gamemsec ) ) {
+		// encoded entity deltas are shared by snapshots of this frame
+		SV_BeginDeltaEntitiesCache();
+
+		// send messages back to the clients that had packets read this frame
+		SV_SendClientMessages();
+
+		// write snap to server demo file
+		SV_Demo_WriteSnap();
+
+		SV_EndDeltaEntitiesCache();
+
+		// send a heartbeat to info servers if needed
+		SV_InfoServerHeartbeat();
+
+		// clear teleport flags, etc for next frame
+		G_ClearSnap();
+	}
+
+	// invalidate cached replies to info queries
+	SV_UpdateInfoVersions();
+}
+
+/*
+* ServerBenchmark
+*
+* Loads a map, waits for bots to get spawned and runs a fixed number of server frames
+* back-to-back with a fixed time step, writing a JSON report of frame times.
+* The profiler tracks a single scope per frame, so scopes get sampled in a round-robin fashion
+* and per-scope totals are extrapolated from the sampled frames.
+*/
+class ServerBenchmark final : public wsw::ProfilerArgsSupplier, public wsw::ProfilerResultSink {
+public:
+	ServerBenchmark( const wsw::StringView &mapName, unsigned numBots, unsigned numFrames, const wsw::StringView &reportName )
+		: m_mapName( mapName ), m_reportName( reportName ), m_numBots( numBots ), m_numFrames( numFrames ) {}
+
+	void run();
+
+	void beginSupplyingArgs() override {}
+	[[nodiscard]]
+	auto getArgs( wsw::ProfilingSystem::FrameGroup group ) -> wsw::ProfilerArgs override;
+	void endSupplyingArgs() override {}
+
+	void beginAcceptingResults( wsw::ProfilingSystem::FrameGroup ) override {}
+	void endAcceptingResults( wsw::ProfilingSystem::FrameGroup ) override;
+	void addDiscoveredRoot( uint64_t, unsigned ) override {}
+	void addCallStats( uint64_t threadId, unsigned callScopeId, const CallStats &callStats ) override;
+	void addCallChildStats( uint64_t, unsigned, const CallStats & ) override {}
+
+	[[nodiscard]]
+	auto getMapName() const -> wsw::StringView { return m_mapName.asView(); }
+private:
+	static constexpr unsigned kMaxWarmupMillis = 10 * 1000;
+
+	[[nodiscard]]
+	auto countSpawnedBots() const -> unsigned;
+	void writeReport();
+
+	struct ScopeStats {
+		uint64_t totalTime { 0 };
+		uint64_t enterCount { 0 };
+		unsigned numSampledFrames { 0 };
+	};
+
+	wsw::StaticString<MAX_QPATH> m_mapName;
+	wsw::StaticString<MAX_QPATH> m_reportName;
+	const unsigned m_numBots;
+	const unsigned m_numFrames;
+	unsigned m_numSnapFrames { 0 };
+	unsigned m_profiledScopeIndex { 0 };
+	bool m_isProfiling { false };
+
+	wsw::PodVector<uint64_t> m_frameTimes;
+	wsw::PodVector<ScopeStats> m_scopeStats;
+};
+
+auto ServerBenchmark::countSpawnedBots() const -> unsigned {
+	unsigned result = 0;
+	IteratorOverClients iteratorOverClients( { .minAcceptableState = CS_SPAWNED, .includeFakeClients = true } );
+	while( client_t *client = iteratorOverClients.getNext() ) {
+		if( client->edict && ( client->edict->r.svflags & SVF_FAKECLIENT ) ) {
+			result++;
+		}
+	}
+	return result;
+}
+
+auto ServerBenchmark::getArgs( wsw::ProfilingSystem::FrameGroup ) -> wsw::ProfilerArgs {
+	if( m_isProfiling && !m_scopeStats.empty() ) {
+		return { .args = wsw::ProfilerArgs::ProfileCall { .scopeIndex = m_profiledScopeIndex } };
+	}
+	return { .args = std::monostate {} };
+}
+
+void ServerBenchmark::addCallStats( uint64_t, unsigned callScopeId, const CallStats &callStats ) {
+	assert( callScopeId < m_scopeStats.size() );
+	m_scopeStats[callScopeId].totalTime += callStats.totalTime;
+	m_scopeStats[callScopeId].enterCount += (unsigned)callStats.enterCount;
+}
+
+void ServerBenchmark::endAcceptingResults( wsw::ProfilingSystem::FrameGroup ) {
+	if( m_isProfiling && !m_scopeStats.empty() ) {
+		m_scopeStats[m_profiledScopeIndex].numSampledFrames++;
+		m_profiledScopeIndex = ( m_profiledScopeIndex + 1 ) % m_scopeStats.size();
+	}
+}
+
+void ServerBenchmark::run() {
+	// The main thread of a dedicated server is not attached to the profiler otherwise
+	[[maybe_unused]] volatile wsw::ThreadProfilingAttachment profilingAttachment( wsw::ProfilingSystem::ServerGroup );
+
+	// Bots are spawned by the game module once per second after a delay in real time (according to g_numbots).
+	// Run frames at the regular pace while waiting, so the match does not progress too far.
+	const int64_t warmupTimeout = Sys_Milliseconds() + kMaxWarmupMillis + 1000 * m_numBots;
+	while( countSpawnedBots() < m_numBots ) {
+		if( Sys_Milliseconds() > warmupTimeout ) {
+			Com_Printf( S_COLOR_YELLOW "Benchmark: Only %u of %u bots have been spawned\n", countSpawnedBots(), m_numBots );
+			break;
+		}
+		SV_RunFrame( WORLDFRAMETIME, WORLDFRAMETIME );
+		Sys_Sleep( WORLDFRAMETIME );
+	}
+
+	m_scopeStats.resize( wsw::ProfilingSystem::getRegisteredScopes().size() );
+	m_frameTimes.reserve( m_numFrames );
+	m_isProfiling = true;
+
+	Com_Printf( "Benchmark: Running %u frames with %u bots on %s\n", m_numFrames, countSpawnedBots(), m_mapName.data() );
+
+	for( unsigned frameNum = 0; frameNum < m_numFrames; ++frameNum ) {
+		wsw::ProfilingSystem::beginFrame( wsw::ProfilingSystem::ServerGroup, this );
+		const int64_t oldFrameNum = sv.framenum;
+		const uint64_t startTime = Sys_Microseconds();
+		SV_RunFrame( WORLDFRAMETIME, WORLDFRAMETIME );
+		m_frameTimes.push_back( Sys_Microseconds() - startTime );
+		m_numSnapFrames += ( sv.framenum != oldFrameNum );
+		wsw::ProfilingSystem::endFrame( wsw::ProfilingSystem::ServerGroup, this );
+	}
+
+	// Disable profiling
+	m_isProfiling = false;
+	wsw::ProfilingSystem::beginFrame( wsw::ProfilingSystem::ServerGroup, this );
+	wsw::ProfilingSystem::endFrame( wsw::ProfilingSystem::ServerGroup, this );
+
+	writeReport();
+}
+
+static void SV_AppendJsonString( wsw::PodVector<char> *buffer, const wsw::StringView &string ) {
+	buffer->push_back( '"' );
+	for( const char ch: string ) {
+		if( ch == '"' || ch == '\\' ) {
+			buffer->push_back( '\\' );
+		}
+		buffer->push_back( ch );
+	}
+	buffer->push_back( '"' );
+}
+
+void ServerBenchmark::writeReport() {
+	wsw::PodVector<uint64_t> sortedFrameTimes( m_frameTimes );
+	std::sort( sortedFrameTimes.begin(), sortedFrameTimes.end() );
+
+	uint64_t totalTime = 0;
+	for( const uint64_t frameTime: m_frameTimes ) {
+		totalTime += frameTime;
+	}
+
+	const auto getPercentile = [&]( unsigned percent ) -> uint64_t {
+		if( sortedFrameTimes.empty() ) {
+			return 0;
+		}
+		const size_t index = ( sortedFrameTimes.size() * percent + 99 ) / 100;
+		return sortedFrameTimes[wsw::max<size_t>( index, 1 ) - 1];
+	};
+
+	const unsigned numFrames = m_frameTimes.size();
+	const uint64_t meanTime  = numFrames ? totalTime / numFrames : 0;
+
+	wsw::PodVector<char> report;
+	report.append( wsw::StringView( "{\n\t\"map\": " ) );
+	SV_AppendJsonString( &report, m_mapName.asView() );
+	report.append( wsw::StringView( va( ",\n\t\"bots\": %u,\n\t\"frames\": %u,\n\t\"snapFrames\": %u,\n\t\"frameMillis\": %u,\n",
+										countSpawnedBots(), numFrames, m_numSnapFrames, WORLDFRAMETIME ) ) );
+	report.append( wsw::StringView( va( "\t\"frameMicros\": { \"total\": %" PRIu64 ", \"mean\": %" PRIu64 ", ",
+										totalTime, meanTime ) ) );
+	report.append( wsw::StringView( va( "\"p50\": %" PRIu64 ", \"p90\": %" PRIu64 ", \"p99\": %" PRIu64 ", \"max\": %" PRIu64 " },\n",
+										getPercentile( 50 ), getPercentile( 90 ), getPercentile( 99 ), getPercentile( 100 ) ) ) );
+	report.append( wsw::StringView( "\t\"scopes\": [" ) );
+
+	const std::span<const wsw::ProfilingSystem::RegisteredScope> scopes = wsw::ProfilingSystem::getRegisteredScopes();
+	bool isFirstScope = true;
+	for( unsigned scopeIndex = 0; scopeIndex < m_scopeStats.size(); ++scopeIndex ) {
+		const ScopeStats &stats = m_scopeStats[scopeIndex];
+		if( !stats.enterCount ) {
+			continue;
+		}
+		const double meanFrameTime = (double)stats.totalTime / (double)stats.numSampledFrames;
+		report.append( wsw::StringView( isFirstScope ? "\n\t\t{ \"function\": " : ",\n\t\t{ \"function\": " ) );
+		SV_AppendJsonString( &report, scopes[scopeIndex].readableFunction );
+		report.append( wsw::StringView( ", \"file\": " ) );
+		SV_AppendJsonString( &report, scopes[scopeIndex].file );
+		report.append( wsw::StringView( va( ", \"line\": %d, \"sampledFrames\": %u, \"callsPerFrame\": %.3f, "
+											"\"meanFrameMicros\": %.3f, \"estimatedTotalMicros\": %.0f }",
+											scopes[scopeIndex].line, stats.numSampledFrames,
+											(double)stats.enterCount / (double)stats.numSampledFrames,
+											meanFrameTime, meanFrameTime * numFrames ) ) );
+		isFirstScope = false;
+	}
+
+	report.append( wsw::StringView( "\n\t]\n}\n" ) );
+
+	Com_Printf( "Benchmark: %u frames, mean %" PRIu64 "us, p50 %" PRIu64 "us, p90 %" PRIu64 "us, p99 %" PRIu64 "us, max %" PRIu64 "us\n",
+				numFrames, meanTime, getPercentile( 50 ), getPercentile( 90 ), getPercentile( 99 ), getPercentile( 100 ) );
+
+	const wsw::StaticString<MAX_QPATH> path( "benchmarks/%s.json", m_reportName.data() );
+	if( auto maybeHandle = wsw::fs::openAsWriteHandle( path.asView() ) ) {
+		if( maybeHandle->write( report.data(), report.size() ) ) {
+			Com_Printf( "Benchmark: Wrote the report to %s\n", path.data() );
+		} else {
+			Com_Printf( S_COLOR_YELLOW "Benchmark: Failed to write %s\n", path.data() );
+		}
+	} else {
+		Com_Printf( S_COLOR_YELLOW "Benchmark: Failed to open %s\n", path.data() );
+	}
+}
+
+/*
+* SV_RunBenchmark
+*/
+static void SV_RunBenchmark() {
+	g_serverBenchmark->run();
+
+	delete g_serverBenchmark;
+	g_serverBenchmark = nullptr;
+
+	Cvar_ForceSet( "sv_benchmark", "0" );
+	SV_Cbuf_AppendCommand( "quit\n" );
+}
+
 void SV_Frame( unsigned realmsec, unsigned gamemsec ) {
 	WSW_PROFILER_SCOPE();
 
@@ -957,33 +1411,10 @@ void SV_Frame( unsigned realmsec, unsigned gamemsec ) {
 				}
 			}
 		}
+	} else if( g_serverBenchmark && sv.state == ss_game && g_serverBenchmark->getMapName().equalsIgnoreCase( wsw::StringView( sv.mapname ) ) ) {
+		SV_RunBenchmark();
 	} else {
-		svs.realtime += realmsec;
-		svs.gametime += gamemsec;
-
-		// check timeouts
-		SV_CheckTimeouts();
-
-		// get packets from clients
-		SV_ReadPackets();
-
-		// apply latched userinfo changes
-		SV_CheckLatchedUserinfoChanges();
-
-		// let everything in the world think and move
-		if( SV_RunGameFrame( gamemsec ) ) {
-			// send messages back to the clients that had packets read this frame
-			SV_SendClientMessages();
-
-			// write snap to server demo file
-			SV_Demo_WriteSnap();
-
-			// send a heartbeat to info servers if needed
-			SV_InfoServerHeartbeat();
-
-			// clear teleport flags, etc for next frame
-			G_ClearSnap();
-		}
+		SV_RunFrame( realmsec, gamemsec );
 	}
 }
 
@@ -1167,6 +1598,7 @@ void SV_InitGame() {
 
 	svs.spawncount = ::rand();
 	svs.clients = (client_t *)Q_malloc( sizeof( client_t ) * sv_maxclients->integer );
+	g_clientsByAddressTable.clear();
 	svs.client_entities.num_entities = sv_maxclients->integer * UPDATE_BACKUP * MAX_SNAP_ENTITIES;
 	svs.client_entities.entities = (entity_state_t *)Q_malloc( sizeof( entity_state_t ) * svs.client_entities.num_entities );
 
@@ -1443,6 +1875,7 @@ void SV_Init() {
 
 	Cvar_Get( "sv_cheats", "0", CVAR_SERVERINFO | CVAR_LATCH );
 	Cvar_Get( "protocol", va( "%i", APP_PROTOCOL_VERSION ), CVAR_SERVERINFO | CVAR_NOSET );
+	Cvar_Get( "sv_benchmark", "0", CVAR_READONLY );
 
 	sv_ip =             Cvar_Get( "sv_ip", "", CVAR_ARCHIVE | CVAR_LATCH );
 	sv_port =           Cvar_Get( "sv_port", va( "%i", PORT_SERVER ), CVAR_ARCHIVE | CVAR_LATCH );
@@ -1518,6 +1951,8 @@ void SV_Init() {
 
 	sv_debug_serverCmd =        Cvar_Get( "sv_debug_serverCmd", "0", CVAR_ARCHIVE );
 
+	sv_parallelSnapshots = Cvar_Get( "sv_parallelSnapshots", "0", CVAR_ARCHIVE );
+
 	sv_MOTD = Cvar_Get( "sv_MOTD", "0", CVAR_ARCHIVE );
 	sv_MOTDFile = Cvar_Get( "sv_MOTDFile", "", CVAR_ARCHIVE );
 	sv_MOTDString = Cvar_Get( "sv_MOTDString", "", CVAR_ARCHIVE );
@@ -1562,6 +1997,9 @@ void SV_Init() {
 	sv_initialized = true;
 }
 
+static void SV_ShutdownParallelSnapshots();
+static void SV_ShutdownDeltaEntitiesCache();
+
 /*
 * SV_Shutdown
 *
@@ -1576,6 +2014,9 @@ void SV_Shutdown( const char *finalmsg ) {
 
 		SV_ShutdownGame( finalmsg, false );
 
+		SV_ShutdownParallelSnapshots();
+		SV_ShutdownDeltaEntitiesCache();
+
 		SV_ShutdownOperatorCommands();
 	}
 }
@@ -1587,8 +2028,9 @@ void SV_ClientResetCommandBuffers( client_t *client ) {
 	client->reliableSequence = 0;
 	client->reliableSent = 0;
 	for( auto &cmd: client->reliableCommands ) {
-		cmd.clear();
+		cmd = reliable_command_t {};
 	}
+	client->localCommandsHead = 0;
 
 	// reset the usercommands buffer(clc_move)
 	client->UcmdTime = 0;
@@ -1646,6 +2088,11 @@ bool SV_ClientConnect( const socket_t *socket, const netadr_t *address,
 	const int clientNum = (int)( client - svs.clients );
 	edict_t *const ent  = EDICT_NUM( clientNum + 1 );
 
+	// the slot could be reused by a reconnecting client
+	if( client->state >= CS_CONNECTING && !client->isAFakeClient() ) {
+		g_clientsByAddressTable.remove( client );
+	}
+
 	// make sure the client state is reset before an mm connection callback gets called
 	memset( client, 0, sizeof( *client ) );
 
@@ -1696,6 +2143,7 @@ bool SV_ClientConnect( const socket_t *socket, const netadr_t *address,
 			client->netchan.remoteAddress.type = NA_NOTRANSMIT; // fake-clients can't transmit
 		} else {
 			Netchan_Setup( &client->netchan, socket, address, game_port );
+			g_clientsByAddressTable.add( client );
 		}
 
 		// parse some info from the info strings
@@ -1769,6 +2217,10 @@ void SV_DropClient( client_t *drop, ReconnectBehaviour reconnectBehaviour, const
 		SV_ClientCloseDownload( drop );
 	}
 
+	if( !drop->isAFakeClient() ) {
+		g_clientsByAddressTable.remove( drop );
+	}
+
 	drop->state = CS_ZOMBIE;    // become free in a few seconds
 	drop->name[0] = 0;
 }
@@ -1823,6 +2275,7 @@ static void HandleClientCommand_New( client_t *client, const CmdArgs & ) {
 		if( client->reliable ) {
 			sv_bitflags |= SV_BITFLAGS_RELIABLE;
 		}
+		sv_bitflags |= SV_BITFLAGS_GAMESTATE;
 		if( SV_Web_Running() ) {
 			const char *baseurl = SV_Web_UpstreamBaseUrl();
 			sv_bitflags |= SV_BITFLAGS_HTTP;
@@ -1863,6 +2316,8 @@ static void HandleClientCommand_New( client_t *client, const CmdArgs & ) {
 	client->state = CS_CONNECTING;
 }
 
+static size_t SV_GetFreeLocalCommandsSpace( const client_t *client );
+
 static void HandleClientCommand_Configstrings( client_t *client, const CmdArgs &cmdArgs ) {
 	if( client->state == CS_CONNECTING ) {
 		svDebug() << "Start Configstrings() from" << wsw::StringView( client->name );
@@ -1892,6 +2347,14 @@ static void HandleClientCommand_Configstrings( client_t *client, const CmdArgs &
 					break;
 				}
 				if( const auto maybeConfigString = sv.configStrings.get( start ) ) {
+					// leave space for fragments of the string, a buffer wrap and the next command
+					// (a string that would not fit even the empty buffer is sent anyway)
+					const size_t numFragments = maybeConfigString->length() / kMaxConfigStringFragmentLen + 1;
+					const size_t requiredSpace = maybeConfigString->length() + numFragments * 64 + 2 * MAX_STRING_CHARS;
+					const size_t freeSpace = SV_GetFreeLocalCommandsSpace( client );
+					if( requiredSpace > freeSpace && freeSpace < LOCAL_COMMANDS_BUFFER_SIZE ) {
+						break;
+					}
 					SV_SendConfigString( client, start, *maybeConfigString );
 				}
 				start++;
@@ -1950,45 +2413,227 @@ static void HandleClientCommand_Baselines( client_t *client, const CmdArgs &cmdA
 	}
 }
 
-static void HandleClientCommand_Begin( client_t *client, const CmdArgs &cmdArgs ) {
-	svDebug() << "Begin() from" << wsw::StringView( client->name );
+/*
+* Gamestate chunks
+*
+* Configstrings and baselines of the current level are sent to connecting clients
+* in chunks of svc_servercs and svc_spawnbaseline commands that are deflated once.
+* Chunks are cached by their first item until the level or configstrings change,
+* so every client that connects after a map change gets the same precompressed data.
+* Chunks are sent unreliably, and the client requests the next chunk once it has parsed the current one.
+*/
+#define SV_GAMESTATE_CHUNK_SIZE         ( MAX_MSGLEN / 2 )      // uncompressed data limit
+#define SV_GAMESTATE_MAX_CACHED_CHUNKS  16
 
-	if( client->state != CS_CONNECTED ) {
-		if( dedicated->integer ) {
-			svWarning() << "HandleClientCommand_Begin: 'Begin' from already spawned client" << wsw::StringView( client->name );
+// the bound of the deflated data size (see compressBound())
+#define SV_GAMESTATE_CHUNK_DATA_SIZE \
+	( SV_GAMESTATE_CHUNK_SIZE + ( SV_GAMESTATE_CHUNK_SIZE >> 12 ) + ( SV_GAMESTATE_CHUNK_SIZE >> 14 ) + \
+	  ( SV_GAMESTATE_CHUNK_SIZE >> 25 ) + 13 )
+
+typedef struct {
+	int start;                      // the first item of the chunk
+	int next;                       // the item that follows the last one of the chunk
+	int reliableConfigString;       // a config string that is too long for the chunk and gets sent reliably, or -1
+	size_t uncompressedSize;
+	size_t compressedSize;          // zero if the data is stored uncompressed
+	uint8_t data[SV_GAMESTATE_CHUNK_DATA_SIZE];
+} sv_gamestate_chunk_t;
+
+static struct {
+	int spawncount;
+	unsigned configStringsModificationCount;
+	int numChunks;
+	sv_gamestate_chunk_t chunks[SV_GAMESTATE_MAX_CACHED_CHUNKS];
+	sv_gamestate_chunk_t uncachedChunk;
+} g_gamestateCache;
+
+static void SV_WriteGamestateConfigString( msg_t *msg, int index, const wsw::StringView &string );
+
+/*
+* SV_GamestateConfigStringSizeBound
+*
+* Returns an upper bound of the size of commands of a config string in a gamestate chunk
+*/
+static size_t SV_GamestateConfigStringSizeBound( const wsw::StringView &string ) {
+	const size_t numFragments = string.length() / kMaxConfigStringFragmentLen + 1;
+	// a command prefix, a svc byte and a zero terminator per fragment
+	return string.length() + numFragments * 64;
+}
+
+/*
+* SV_WriteGamestateItem
+*
+* Returns false if the item is a config string that does not fit a chunk
+*/
+static bool SV_WriteGamestateItem( msg_t *msg, int item ) {
+	if( item < MAX_CONFIGSTRINGS ) {
+		if( const auto maybeConfigString = sv.configStrings.get( item ) ) {
+			if( SV_GamestateConfigStringSizeBound( *maybeConfigString ) > SV_GAMESTATE_CHUNK_SIZE ) {
+				return false;
+			}
+			SV_WriteGamestateConfigString( msg, item, *maybeConfigString );
 		}
-		SV_DropClient( client, ReconnectBehaviour::OfUserChoice, "Error: Begin while connected" );
 	} else {
-		// handle the case of a level changing while a client was connecting
-		if( atoi( Cmd_Argv( 1 ) ) != svs.spawncount ) {
-			svWarning() << "HandleClientCommand_Begin from different level";
-			SV_SendServerCommand( client, "changing" );
-			SV_SendServerCommand( client, "reconnect" );
-		} else {
-			client->state = CS_SPAWNED;
-			// call the game begin function
-			G_ClientBegin( client->edict );
+		if( const entity_state_t *base = &sv.baselines[item - MAX_CONFIGSTRINGS]; base->number ) {
+			entity_state_t nullstate;
+			memset( &nullstate, 0, sizeof( nullstate ) );
+			MSG_WriteUint8( msg, svc_spawnbaseline );
+			MSG_WriteDeltaEntity( msg, &nullstate, base, true );
 		}
 	}
+	return true;
 }
 
 /*
-* SV_NextDownload_f
-*
-* Responds to reliable nextdl packet with unreliable download packet
-* If nextdl packet's offet information is negative, download will be stopped
+* SV_GetGamestateChunk
 */
-static void HandleClientCommand_NextDownload( client_t *client, const CmdArgs &cmdArgs ) {
-	if( !client->download.name ) {
-		Com_Printf( "nextdl message for client with no download active, from: %s\n", client->name );
-	} else if( Q_stricmp( client->download.name, Cmd_Argv( 1 ) ) ) {
-		Com_Printf( "nextdl message for wrong filename, from: %s\n", client->name );
-	} else {
-		const int offset = atoi( Cmd_Argv( 2 ) );
+static const sv_gamestate_chunk_t *SV_GetGamestateChunk( int start ) {
+	// a written item may exceed the chunk size limit before it gets rolled back
+	static uint8_t uncompressedData[SV_GAMESTATE_CHUNK_SIZE * 2];
 
-		if( offset > client->download.size ) {
-			Com_Printf( "nextdl message with too big offset, from: %s\n", client->name );
-		} else if( offset < 0 ) {
+	if( g_gamestateCache.spawncount != svs.spawncount ||
+		g_gamestateCache.configStringsModificationCount != sv.configStrings.getModificationCount() ) {
+		g_gamestateCache.spawncount = svs.spawncount;
+		g_gamestateCache.configStringsModificationCount = sv.configStrings.getModificationCount();
+		g_gamestateCache.numChunks = 0;
+	}
+
+	for( int i = 0; i < g_gamestateCache.numChunks; i++ ) {
+		if( g_gamestateCache.chunks[i].start == start ) {
+			return &g_gamestateCache.chunks[i];
+		}
+	}
+
+	sv_gamestate_chunk_t *chunk;
+	if( g_gamestateCache.numChunks < SV_GAMESTATE_MAX_CACHED_CHUNKS ) {
+		chunk = &g_gamestateCache.chunks[g_gamestateCache.numChunks];
+	} else {
+		chunk = &g_gamestateCache.uncachedChunk;
+	}
+
+	msg_t msg;
+	MSG_Init( &msg, uncompressedData, sizeof( uncompressedData ) );
+
+	chunk->reliableConfigString = -1;
+
+	int item = start;
+	for(; item < SV_GAMESTATE_NUM_ITEMS; item++ ) {
+		const size_t oldSize = msg.cursize;
+		if( !SV_WriteGamestateItem( &msg, item ) ) {
+			// make the config string the last item of the chunk, it gets sent reliably along with the chunk
+			chunk->reliableConfigString = item++;
+			break;
+		}
+		// leave the item for the next chunk
+		if( msg.cursize > SV_GAMESTATE_CHUNK_SIZE ) {
+			assert( oldSize );
+			msg.cursize = oldSize;
+			break;
+		}
+	}
+
+	chunk->start = start;
+	chunk->next = item;
+	chunk->uncompressedSize = msg.cursize;
+	chunk->compressedSize = sizeof( chunk->data );
+	// send incompressible data as it is
+	if( !SV_CompressBytes( chunk->data, &chunk->compressedSize, uncompressedData, msg.cursize ) ||
+		chunk->compressedSize >= chunk->uncompressedSize ) {
+		memcpy( chunk->data, uncompressedData, msg.cursize );
+		chunk->compressedSize = 0;
+	}
+
+	if( chunk != &g_gamestateCache.uncachedChunk ) {
+		g_gamestateCache.numChunks++;
+	}
+
+	return chunk;
+}
+
+static void HandleClientCommand_Gamestate( client_t *client, const CmdArgs &cmdArgs ) {
+	if( client->state == CS_CONNECTING ) {
+		svDebug() << "Start Gamestate() from" << wsw::StringView( client->name );
+		client->state = CS_CONNECTED;
+	} else {
+		svDebug() << "Gamestate() from" << wsw::StringView( client->name );
+	}
+
+	if( client->state != CS_CONNECTED ) {
+		svWarning() << "gamestate not valid -- already spawned";
+	} else {
+		// handle the case of a level changing while a client was connecting
+		if( atoi( Cmd_Argv( 1 ) ) != svs.spawncount ) {
+			svWarning() << "HandleClientCommand_Gamestate from different level";
+			SV_SendServerCommand( client, "reconnect" );
+		} else {
+			const int start = wsw::min( wsw::max( atoi( Cmd_Argv( 2 ) ), 0 ), SV_GAMESTATE_NUM_ITEMS );
+			// the client has parsed all chunks
+			if( start == SV_GAMESTATE_NUM_ITEMS ) {
+				SV_SendServerCommand( client, "precache %i", svs.spawncount );
+				return;
+			}
+
+			const sv_gamestate_chunk_t *chunk = SV_GetGamestateChunk( start );
+			if( chunk->reliableConfigString >= 0 ) {
+				SV_SendConfigString( client, chunk->reliableConfigString, *sv.configStrings.get( chunk->reliableConfigString ) );
+			}
+
+			SV_InitClientMessage( client, &tmpMessage, NULL, 0 );
+
+			const size_t dataSize = chunk->compressedSize ? chunk->compressedSize : chunk->uncompressedSize;
+			MSG_WriteUint8( &tmpMessage, svc_gamestate );
+			MSG_WriteInt32( &tmpMessage, chunk->start );
+			MSG_WriteInt32( &tmpMessage, chunk->next );
+			MSG_WriteInt32( &tmpMessage, (int)chunk->uncompressedSize );
+			MSG_WriteInt32( &tmpMessage, (int)chunk->compressedSize );
+			MSG_WriteData( &tmpMessage, chunk->data, dataSize );
+
+			SV_AddReliableCommandsToMessage( client, &tmpMessage );
+			// the bulk of the message is compressed already
+			SV_SendMessageToClient( client, &tmpMessage, false );
+		}
+	}
+}
+
+static void HandleClientCommand_Begin( client_t *client, const CmdArgs &cmdArgs ) {
+	svDebug() << "Begin() from" << wsw::StringView( client->name );
+
+	if( client->state != CS_CONNECTED ) {
+		if( dedicated->integer ) {
+			svWarning() << "HandleClientCommand_Begin: 'Begin' from already spawned client" << wsw::StringView( client->name );
+		}
+		SV_DropClient( client, ReconnectBehaviour::OfUserChoice, "Error: Begin while connected" );
+	} else {
+		// handle the case of a level changing while a client was connecting
+		if( atoi( Cmd_Argv( 1 ) ) != svs.spawncount ) {
+			svWarning() << "HandleClientCommand_Begin from different level";
+			SV_SendServerCommand( client, "changing" );
+			SV_SendServerCommand( client, "reconnect" );
+		} else {
+			client->state = CS_SPAWNED;
+			// call the game begin function
+			G_ClientBegin( client->edict );
+		}
+	}
+}
+
+/*
+* SV_NextDownload_f
+*
+* Responds to reliable nextdl packet with unreliable download packet
+* If nextdl packet's offet information is negative, download will be stopped
+*/
+static void HandleClientCommand_NextDownload( client_t *client, const CmdArgs &cmdArgs ) {
+	if( !client->download.name ) {
+		Com_Printf( "nextdl message for client with no download active, from: %s\n", client->name );
+	} else if( Q_stricmp( client->download.name, Cmd_Argv( 1 ) ) ) {
+		Com_Printf( "nextdl message for wrong filename, from: %s\n", client->name );
+	} else {
+		const int offset = atoi( Cmd_Argv( 2 ) );
+
+		if( offset > client->download.size ) {
+			Com_Printf( "nextdl message with too big offset, from: %s\n", client->name );
+		} else if( offset < 0 ) {
 			if( offset == -1 ) {
 				Com_Printf( "Upload of %s to %s%s completed\n", client->download.name, client->name, S_COLOR_WHITE );
 			} else {
@@ -2264,6 +2909,7 @@ static ucmd_t ucmds[] =
 		{ "new",           HandleClientCommand_New },
 		{ "configstrings", HandleClientCommand_Configstrings },
 		{ "baselines",  HandleClientCommand_Baselines },
+		{ "gamestate", HandleClientCommand_Gamestate },
 		{ "begin",      HandleClientCommand_Begin },
 		{ "disconnect", HandleClientCommand_Disconnect },
 		{ "usri",      HandleClientCommand_Userinfo },
@@ -2521,6 +3167,212 @@ void SV_AddGameCommand( client_t *client, const char *cmd ) {
 	}
 }
 
+/*
+* BroadcastCommandsLog
+*
+* An append-only log of reliable commands that are sent to multiple clients.
+* Clients keep references to log entries instead of copies of commands.
+* The log is a ring buffer. Entries that are still referenced by some clients
+* must be detached prior to being overwritten (see SV_PrepareBroadcastCommandsLog()).
+*/
+class BroadcastCommandsLog {
+public:
+	static constexpr unsigned kCapacity = 2 * MAX_RELIABLE_COMMANDS;
+
+	[[nodiscard]]
+	auto add( const wsw::StringView &cmd ) -> int64_t {
+		m_lastNum++;
+		assert( m_lastNum < m_oldestReferencedNum + kCapacity );
+		m_commands[m_lastNum % kCapacity].assign( cmd );
+		return m_lastNum;
+	}
+
+	/**
+	 * Returns a number of the entry that gets overwritten by the next added entry, or zero if there is no such entry.
+	 */
+	[[nodiscard]]
+	auto getNumToBeOverwritten() const -> int64_t {
+		return std::max<int64_t>( m_lastNum + 1 - kCapacity, 0 );
+	}
+
+	/**
+	 * Returns a lower bound of numbers of entries that are referenced by clients.
+	 */
+	[[nodiscard]]
+	auto getOldestReferencedNum() const -> int64_t { return m_oldestReferencedNum; }
+
+	void setOldestReferencedNum( int64_t num ) { m_oldestReferencedNum = num; }
+
+	[[nodiscard]]
+	auto get( int64_t num ) const -> const char * {
+		if( num > 0 && num <= m_lastNum && num + kCapacity > m_lastNum ) {
+			return m_commands[num % kCapacity].data();
+		}
+		return nullptr;
+	}
+
+	[[nodiscard]]
+	auto getLastNum() const -> int64_t { return m_lastNum; }
+
+	/**
+	 * Records a transmission of the entry.
+	 * @note this gets called concurrently if snapshots are built in parallel.
+	 */
+	void markAsTransmitted( int64_t num ) {
+		int64_t lastTransmittedNum = m_lastTransmittedNum.load( std::memory_order_relaxed );
+		while( lastTransmittedNum < num ) {
+			if( m_lastTransmittedNum.compare_exchange_weak( lastTransmittedNum, num, std::memory_order_relaxed ) ) {
+				break;
+			}
+		}
+	}
+
+	/*
+	* tryAppendingToLast
+	*
+	* Appends the command tail to the last entry if it has the same prefix and has not been transmitted yet.
+	* It's up to the caller to check whether recipients of the last entry are the same.
+	*/
+	[[nodiscard]]
+	bool tryAppendingToLast( const wsw::StringView &prefix, const wsw::StringView &cmd ) {
+		if( m_lastNum > m_lastTransmittedNum.load( std::memory_order_relaxed ) ) {
+			auto &lastCmd = m_commands[m_lastNum % kCapacity];
+			if( lastCmd.startsWith( prefix ) && lastCmd.length() + cmd.length() < lastCmd.capacity() ) {
+				lastCmd.append( cmd.drop( 2 ) );
+				return true;
+			}
+		}
+		return false;
+	}
+private:
+	wsw::StaticString<MAX_STRING_CHARS> m_commands[kCapacity];
+	int64_t m_lastNum { 0 };
+	int64_t m_oldestReferencedNum { 1 };
+	std::atomic<int64_t> m_lastTransmittedNum { 0 };
+};
+
+static BroadcastCommandsLog g_broadcastCommandsLog;
+
+static const wsw::StringView kConfigStringCmdPrefix( "cs ", 3 );
+
+/*
+* SV_PushReliableCommand
+*
+* Returns the added command slot or null if the client has been dropped
+*/
+static reliable_command_t *SV_PushReliableCommand( client_t *client ) {
+	client->reliableSequence++;
+	// if we would be losing an old command that hasn't been acknowledged, we must drop the connection
+	// we check == instead of >= so a broadcast print added by SV_DropClient() doesn't cause a recursive drop client
+	if( client->reliableSequence - client->reliableAcknowledge == MAX_RELIABLE_COMMANDS + 1 ) {
+		SV_DropClient( client, ReconnectBehaviour::OfUserChoice, "%s", "Error: Too many pending reliable server commands" );
+		return nullptr;
+	}
+	return &client->reliableCommands[client->reliableSequence & ( MAX_RELIABLE_COMMANDS - 1 )];
+}
+
+/*
+* SV_GetLocalCommandsTail
+*
+* Returns the offset of the oldest local command data that is still in use.
+* Offsets do not grow with the sequence if broadcast commands were detached, so all pending commands are checked.
+*/
+static int64_t SV_GetLocalCommandsTail( const client_t *client ) {
+	int64_t tail = client->localCommandsHead;
+	const int64_t oldestSequence = std::max( client->reliableAcknowledge, client->reliableSequence - MAX_RELIABLE_COMMANDS ) + 1;
+	for( int64_t i = oldestSequence; i <= client->reliableSequence; ++i ) {
+		const reliable_command_t &cmd = client->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )];
+		if( !cmd.broadcastNum && cmd.localLength ) {
+			tail = std::min( tail, cmd.localOffset );
+		}
+	}
+	return tail;
+}
+
+/*
+* SV_GetFreeLocalCommandsSpace
+*/
+static size_t SV_GetFreeLocalCommandsSpace( const client_t *client ) {
+	return (size_t)( LOCAL_COMMANDS_BUFFER_SIZE - ( client->localCommandsHead - SV_GetLocalCommandsTail( client ) ) );
+}
+
+/*
+* SV_ReleasePendingLocalCommands
+*/
+static void SV_ReleasePendingLocalCommands( client_t *client ) {
+	for( int64_t i = client->reliableAcknowledge + 1; i <= client->reliableSequence; ++i ) {
+		reliable_command_t *pendingCmd = &client->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )];
+		if( !pendingCmd->broadcastNum ) {
+			pendingCmd->localLength = 0;
+		}
+	}
+}
+
+/*
+* SV_AllocLocalCommandData
+*
+* Reserves a contiguous range of the local commands buffer, returns a negative value on failure
+*/
+static int64_t SV_AllocLocalCommandData( client_t *client, size_t size ) {
+	constexpr int64_t bufferSize = LOCAL_COMMANDS_BUFFER_SIZE;
+
+	int64_t offset = client->localCommandsHead;
+	// don't let a command wrap around the buffer end
+	if( offset % bufferSize + (int64_t)size > bufferSize ) {
+		offset += bufferSize - offset % bufferSize;
+	}
+	if( offset + (int64_t)size - SV_GetLocalCommandsTail( client ) > bufferSize ) {
+		return -1;
+	}
+
+	client->localCommandsHead = offset + (int64_t)size;
+	return offset;
+}
+
+/*
+* SV_TryBatchingLocalConfigString
+*
+* Appends a "cs" command to the last pending local "cs" command if it is not sent yet
+* and its data is at the head of the local commands buffer, so it could be extended in-place.
+*/
+static bool SV_TryBatchingLocalConfigString( client_t *client, const wsw::StringView &cmd ) {
+	constexpr int64_t bufferSize = LOCAL_COMMANDS_BUFFER_SIZE;
+
+	if( client->reliableSequence <= client->reliableSent ) {
+		return false;
+	}
+
+	reliable_command_t *lastCmd = &client->reliableCommands[client->reliableSequence & ( MAX_RELIABLE_COMMANDS - 1 )];
+	if( lastCmd->broadcastNum || !lastCmd->localLength ) {
+		return false;
+	}
+	if( lastCmd->localOffset + lastCmd->localLength + 1 != client->localCommandsHead ) {
+		return false;
+	}
+	if( lastCmd->localLength + cmd.length() >= MAX_STRING_CHARS ) {
+		return false;
+	}
+
+	char *const data = client->localCommandsData + lastCmd->localOffset % bufferSize;
+	if( !wsw::StringView( data, lastCmd->localLength ).startsWith( kConfigStringCmdPrefix ) ) {
+		return false;
+	}
+
+	const wsw::StringView tail( cmd.drop( 2 ) );
+	if( lastCmd->localOffset % bufferSize + lastCmd->localLength + tail.length() + 1 > bufferSize ) {
+		return false;
+	}
+	if( client->localCommandsHead + (int64_t)tail.length() - SV_GetLocalCommandsTail( client ) > bufferSize ) {
+		return false;
+	}
+
+	std::memcpy( data + lastCmd->localLength, tail.data(), tail.length() );
+	lastCmd->localLength += tail.length();
+	data[lastCmd->localLength] = '\0';
+	client->localCommandsHead += (int64_t)tail.length();
+	return true;
+}
+
 /*
 * SV_AddServerCommand
 *
@@ -2545,36 +3397,189 @@ void SV_AddServerCommand( client_t *client, const wsw::StringView &cmd ) {
 		return;
 	}
 
-	if( len + 1 > client->reliableCommands[0].capacity() ) {
+	if( len + 1 > MAX_STRING_CHARS ) {
 		// This is an server error, not the client one.
 		Com_Error( ERR_DROP, "A server command %s is too long\n", cmd.data() );
 	}
 
 	// ch : To avoid overflow of messages from excessive amount of configstrings
-	// we batch them here. On incoming "cs" command, we'll trackback the queue
-	// to find a pending "cs" command that has space in it. If we'll find one,
-	// we'll batch this there, if not, we'll create a new one.
-	const wsw::StringView csPrefix( "cs ", 3 );
-	if( cmd.startsWith( csPrefix ) ) {
-		for( auto i = client->reliableSequence; i > client->reliableSent; i-- ) {
-			auto &otherCmd = client->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )];
-			if( otherCmd.startsWith( csPrefix ) ) {
-				if( ( otherCmd.length() + len ) < otherCmd.capacity() ) {
-					otherCmd.append( cmd.drop( 2 ) );
-					return;
-				}
-			}
+	// we batch them here. On incoming "cs" command, we'll try to append it to
+	// the last pending "cs" command if it has space in it. If it does not,
+	// we'll create a new one.
+	if( cmd.startsWith( kConfigStringCmdPrefix ) ) {
+		if( SV_TryBatchingLocalConfigString( client, cmd ) ) {
+			return;
 		}
 	}
 
-	client->reliableSequence++;
-	// if we would be losing an old command that hasn't been acknowledged, we must drop the connection
-	// we check == instead of >= so a broadcast print added by SV_DropClient() doesn't cause a recursive drop client
-	if( client->reliableSequence - client->reliableAcknowledge == MAX_RELIABLE_COMMANDS + 1 ) {
+	const int64_t offset = SV_AllocLocalCommandData( client, len + 1 );
+	if( offset < 0 ) {
+		// Release pending local commands so the final disconnect command fits the buffer
+		SV_ReleasePendingLocalCommands( client );
 		SV_DropClient( client, ReconnectBehaviour::OfUserChoice, "%s", "Error: Too many pending reliable server commands" );
-	} else {
-		const auto index = client->reliableSequence & ( MAX_RELIABLE_COMMANDS - 1 );
-		client->reliableCommands[index].assign( cmd );
+		return;
+	}
+
+	if( reliable_command_t *addedCmd = SV_PushReliableCommand( client ) ) {
+		char *const data = client->localCommandsData + offset % LOCAL_COMMANDS_BUFFER_SIZE;
+		std::memcpy( data, cmd.data(), len );
+		data[len] = '\0';
+		addedCmd->broadcastNum = 0;
+		addedCmd->localOffset = offset;
+		addedCmd->localLength = len;
+	}
+}
+
+/*
+* SV_DetachClientFromBroadcastCommands
+*
+* Replaces pending references to broadcast log entries up to the given number by local copies.
+* Returns false if the local commands buffer has no space for copies.
+*/
+static bool SV_DetachClientFromBroadcastCommands( client_t *client, int64_t maxNum ) {
+	for( int64_t i = client->reliableAcknowledge + 1; i <= client->reliableSequence; ++i ) {
+		reliable_command_t *cmd = &client->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )];
+		if( !cmd->broadcastNum || cmd->broadcastNum > maxNum ) {
+			continue;
+		}
+		const char *cmdData = g_broadcastCommandsLog.get( cmd->broadcastNum );
+		assert( cmdData );
+		const size_t len = std::strlen( cmdData );
+		const int64_t offset = SV_AllocLocalCommandData( client, len + 1 );
+		if( offset < 0 ) {
+			return false;
+		}
+		std::memcpy( client->localCommandsData + offset % LOCAL_COMMANDS_BUFFER_SIZE, cmdData, len + 1 );
+		cmd->broadcastNum = 0;
+		cmd->localOffset = offset;
+		cmd->localLength = len;
+	}
+	return true;
+}
+
+/*
+* SV_FindOldestReferencedBroadcastCommand
+*/
+static int64_t SV_FindOldestReferencedBroadcastCommand( const client_t *client, int64_t oldestNum ) {
+	for( int64_t i = client->reliableAcknowledge + 1; i <= client->reliableSequence; ++i ) {
+		const reliable_command_t &cmd = client->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )];
+		if( cmd.broadcastNum ) {
+			oldestNum = std::min( oldestNum, cmd.broadcastNum );
+		}
+	}
+	return oldestNum;
+}
+
+/*
+* SV_PrepareBroadcastCommandsLog
+*
+* Makes sure the log entry that gets overwritten by the next added one is not referenced by clients.
+* Clients that still refer to it get local copies of their pending broadcast commands.
+* Clients that have no space for copies lose their pending commands and get returned for being dropped.
+*/
+static unsigned SV_PrepareBroadcastCommandsLog( client_t **clientsToDrop ) {
+	const int64_t numToBeOverwritten = g_broadcastCommandsLog.getNumToBeOverwritten();
+	// the usual case, no client can refer to the entry
+	if( numToBeOverwritten < g_broadcastCommandsLog.getOldestReferencedNum() ) {
+		return 0;
+	}
+
+	unsigned numClientsToDrop = 0;
+	int64_t oldestReferencedNum = g_broadcastCommandsLog.getLastNum() + 1;
+	const auto prepareClient = [&]( client_t *client ) {
+		if( !SV_DetachClientFromBroadcastCommands( client, numToBeOverwritten ) ) {
+			SV_ReleasePendingLocalCommands( client );
+			for( int64_t i = client->reliableAcknowledge + 1; i <= client->reliableSequence; ++i ) {
+				client->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )].broadcastNum = 0;
+			}
+			if( client->state >= CS_CONNECTING && client != &svs.demo.client ) {
+				clientsToDrop[numClientsToDrop++] = client;
+			}
+		}
+		oldestReferencedNum = SV_FindOldestReferencedBroadcastCommand( client, oldestReferencedNum );
+	};
+
+	for( int i = 0; i < sv_maxclients->integer; ++i ) {
+		if( client_t *client = svs.clients + i; client->state != CS_FREE && !client->isAFakeClient() ) {
+			prepareClient( client );
+		}
+	}
+	// the demo client acknowledges its commands every frame, so it is not expected to have old references
+	if( svs.demo.file ) {
+		prepareClient( &svs.demo.client );
+	}
+
+	g_broadcastCommandsLog.setOldestReferencedNum( oldestReferencedNum );
+	return numClientsToDrop;
+}
+
+/*
+* SV_AddBroadcastServerCommand
+*
+* Puts the command in the shared broadcast log and makes all clients of at least
+* the given state (and the demo client if requested) refer to the log entry
+*/
+static void SV_AddBroadcastServerCommand( const wsw::StringView &cmd, int minAcceptableState, bool includeDemo ) {
+	const auto len = cmd.length();
+	if( !len ) {
+		return;
+	}
+
+	if( len + 1 > MAX_STRING_CHARS ) {
+		// This is an server error, not the client one.
+		Com_Error( ERR_DROP, "A server command %s is too long\n", cmd.data() );
+	}
+
+	client_t *recipients[MAX_CLIENTS + 1];
+	unsigned numRecipients = 0;
+
+	IteratorOverClients iteratorOverClients( { .minAcceptableState = minAcceptableState, .includeFakeClients = false } );
+	while( client_t *client = iteratorOverClients.getNext() ) {
+		recipients[numRecipients++] = client;
+	}
+	if( includeDemo && svs.demo.file ) {
+		recipients[numRecipients++] = &svs.demo.client;
+	}
+
+	if( !numRecipients ) {
+		return;
+	}
+
+	// Batch "cs" commands in the last log entry if all recipients
+	// have it as their last pending command that has not been sent yet
+	if( cmd.startsWith( kConfigStringCmdPrefix ) ) {
+		const int64_t lastNum = g_broadcastCommandsLog.getLastNum();
+		bool canAppendToLast = lastNum > 0;
+		for( unsigned i = 0; i < numRecipients && canAppendToLast; ++i ) {
+			const client_t *client = recipients[i];
+			if( client->reliableSequence <= client->reliableSent ) {
+				canAppendToLast = false;
+			} else {
+				const auto &lastCmd = client->reliableCommands[client->reliableSequence & ( MAX_RELIABLE_COMMANDS - 1 )];
+				canAppendToLast = lastCmd.broadcastNum == lastNum;
+			}
+		}
+		if( canAppendToLast && g_broadcastCommandsLog.tryAppendingToLast( kConfigStringCmdPrefix, cmd ) ) {
+			return;
+		}
+	}
+
+	client_t *clientsToDrop[MAX_CLIENTS];
+	const unsigned numClientsToDrop = SV_PrepareBroadcastCommandsLog( clientsToDrop );
+
+	const int64_t num = g_broadcastCommandsLog.add( cmd );
+	for( unsigned i = 0; i < numRecipients; ++i ) {
+		if( reliable_command_t *addedCmd = SV_PushReliableCommand( recipients[i] ) ) {
+			addedCmd->broadcastNum = num;
+			addedCmd->localLength = 0;
+		}
+	}
+
+	// drop clients once the log is consistent, as dropping adds broadcast commands as well
+	for( unsigned i = 0; i < numClientsToDrop; ++i ) {
+		if( clientsToDrop[i]->state >= CS_CONNECTING ) {
+			SV_DropClient( clientsToDrop[i], ReconnectBehaviour::OfUserChoice, "%s", "Error: Too many pending reliable server commands" );
+		}
 	}
 }
 
@@ -2603,21 +3608,20 @@ void SV_SendServerCommand( client_t *cl, const char *format, ... ) {
 			SV_AddServerCommand( cl, cmd );
 		}
 	} else {
-		IteratorOverClients iteratorOverClients( { .includeFakeClients = true } );
-		while( client_t *client = iteratorOverClients.getNext() ) {
-			SV_AddServerCommand( client, cmd );
-		}
-		// add to demo
-		if( svs.demo.file ) {
-			SV_AddServerCommand( &svs.demo.client, cmd );
-		}
+		SV_AddBroadcastServerCommand( cmd, CS_CONNECTING, true );
 	}
 }
 
 static_assert( kMaxNonFragmentedConfigStringLen < MAX_STRING_CHARS );
 static_assert( kMaxNonFragmentedConfigStringLen > kMaxConfigStringFragmentLen );
 
-static void SV_AddFragmentedConfigString( client_t *cl, int index, const wsw::StringView &string ) {
+/*
+* SV_ForEachConfigStringFragment
+*
+* Splits a long config string into "csf" commands that are passed to the consumer
+*/
+template <typename Consumer>
+static void SV_ForEachConfigStringFragment( int index, const wsw::StringView &string, Consumer &&consumer ) {
 	wsw::StaticString<MAX_STRING_CHARS> buffer;
 
 	const size_t len = string.length();
@@ -2636,13 +3640,45 @@ static void SV_AddFragmentedConfigString( client_t *cl, int index, const wsw::St
 		buffer << wsw::StringView( "csf ", 4 );
 		buffer << index << ' ' << i << ' ' << numFragments << ' ' << fragment.length() << ' ';
 		buffer << '"' << fragment << '"';
-		SV_AddServerCommand( cl, buffer.asView() );
+		consumer( buffer.asView() );
 
 		view = view.drop( fragment.length() );
 		assert( !view.empty() || i + 1 == numFragments );
 	}
 }
 
+// A NULL client will broadcast fragments to all clients
+static void SV_AddFragmentedConfigString( client_t *cl, int index, const wsw::StringView &string ) {
+	SV_ForEachConfigStringFragment( index, string, [=]( const wsw::StringView &cmd ) {
+		if( cl ) {
+			SV_AddServerCommand( cl, cmd );
+		} else {
+			SV_AddBroadcastServerCommand( cmd, CS_CONNECTING, true );
+		}
+	});
+}
+
+/*
+* SV_WriteGamestateConfigString
+*
+* Writes a config string as unacknowledged commands of a gamestate chunk
+*/
+static void SV_WriteGamestateConfigString( msg_t *msg, int index, const wsw::StringView &string ) {
+	if( string.length() < kMaxNonFragmentedConfigStringLen ) {
+		char buffer[MAX_STRING_CHARS + 32];
+		assert( string.isZeroTerminated() );
+		Q_snprintfz( buffer, sizeof( buffer ), "cs %i \"%s\"", index, string.data() );
+		MSG_WriteUint8( msg, svc_servercs );
+		MSG_WriteString( msg, buffer );
+	} else {
+		SV_ForEachConfigStringFragment( index, string, [=]( const wsw::StringView &cmd ) {
+			assert( cmd.isZeroTerminated() );
+			MSG_WriteUint8( msg, svc_servercs );
+			MSG_WriteString( msg, cmd.data() );
+		});
+	}
+}
+
 void SV_SendConfigString( client_t *cl, int index, const wsw::StringView &string ) {
 	if( string.length() + 16 > MAX_MSGLEN ) {
 		Com_Error( ERR_DROP, "Configstring overflow: #%d len=%d\n", index, (int)string.length() );
@@ -2657,13 +3693,7 @@ void SV_SendConfigString( client_t *cl, int index, const wsw::StringView &string
 				SV_AddFragmentedConfigString( cl, index, string );
 			}
 		} else {
-			IteratorOverClients iteratorOverClients( { .includeFakeClients = true } );
-			while( client_t *client = iteratorOverClients.getNext() ) {
-				SV_AddFragmentedConfigString( client, index, string );
-			}
-			if( svs.demo.file ) {
-				SV_AddFragmentedConfigString( &svs.demo.client, index, string );
-			}
+			SV_AddFragmentedConfigString( nullptr, index, string );
 		}
 	}
 }
@@ -2685,20 +3715,34 @@ void SV_AddReliableCommandsToMessage( client_t *client, msg_t *msg ) {
 	}
 
 	// write any unacknowledged serverCommands
+	// merge local commands and references to the shared broadcast log
+	int64_t lastBroadcastNum = 0;
 	for( unsigned i = client->reliableAcknowledge + 1; i <= client->reliableSequence; i++ ) {
-		const auto &cmd = client->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )];
-		if( !cmd.empty() ) {
+		const reliable_command_t &cmd = client->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )];
+		const char *cmdData = nullptr;
+		if( cmd.broadcastNum ) {
+			cmdData = g_broadcastCommandsLog.get( cmd.broadcastNum );
+			lastBroadcastNum = std::max( lastBroadcastNum, cmd.broadcastNum );
+			assert( cmdData );
+		} else if( cmd.localLength ) {
+			cmdData = client->localCommandsData + cmd.localOffset % LOCAL_COMMANDS_BUFFER_SIZE;
+		}
+		if( cmdData ) {
 			MSG_WriteUint8( msg, svc_servercmd );
 			if( !client->reliable ) {
 				MSG_WriteInt32( msg, i );
 			}
-			MSG_WriteString( msg, cmd.data() );
+			MSG_WriteString( msg, cmdData );
 			if( sv_debug_serverCmd->integer ) {
-				Com_Printf( "SV_AddServerCommandsToMessage(%i):%s\n", i, cmd.data() );
+				Com_Printf( "SV_AddServerCommandsToMessage(%i):%s\n", i, cmdData );
 			}
 		}
 	}
 
+	if( lastBroadcastNum ) {
+		g_broadcastCommandsLog.markAsTransmitted( lastBroadcastNum );
+	}
+
 	client->reliableSent = client->reliableSequence;
 	if( client->reliable ) {
 		client->reliableAcknowledge = client->reliableSent;
@@ -2723,10 +3767,7 @@ void SV_BroadcastCommand( const char *format, ... ) {
 	Q_vsnprintfz( string, sizeof( string ), format, argptr );
 	va_end( argptr );
 
-	IteratorOverClients iteratorOverClients( { .includeFakeClients = true } );
-	while( client_t *client = iteratorOverClients.getNext() ) {
-		SV_SendServerCommand( client, string );
-	}
+	SV_AddBroadcastServerCommand( wsw::StringView( string ), CS_CONNECTING, false );
 }
 
 bool SV_SendClientsFragments() {
@@ -2752,13 +3793,13 @@ bool SV_SendClientsFragments() {
 	return sent;
 }
 
-bool SV_Netchan_Transmit( netchan_t *netchan, msg_t *msg ) {
+bool SV_Netchan_Transmit( netchan_t *netchan, msg_t *msg, bool compress ) {
 	// if we got here with unsent fragments, fire them all now
 	if( !Netchan_PushAllFragments( netchan ) ) {
 		return false;
 	}
 
-	if( sv_compresspackets->integer ) {
+	if( compress && sv_compresspackets->integer ) {
 		// it's compression error, just send uncompressed
 		if( const int zerror = Netchan_CompressMessage( msg, g_netchanCompressionBuffer ); zerror < 0 ) {
 			Com_DPrintf( "SV_Netchan_Transmit (ignoring compression): Compression error %i\n", zerror );
@@ -2788,7 +3829,7 @@ void SV_InitClientMessage( client_t *client, msg_t *msg, uint8_t *data, size_t s
 	}
 }
 
-bool SV_SendMessageToClient( client_t *client, msg_t *msg ) {
+bool SV_SendMessageToClient( client_t *client, msg_t *msg, bool compress ) {
 	assert( client );
 	// TODO: Do not call for fake clients
 	if( client->isAFakeClient() ) {
@@ -2797,7 +3838,7 @@ bool SV_SendMessageToClient( client_t *client, msg_t *msg ) {
 
 	// transmit the message data
 	client->lastPacketSentTime = svs.realtime;
-	return SV_Netchan_Transmit( &client->netchan, msg );
+	return SV_Netchan_Transmit( &client->netchan, msg, compress );
 }
 
 /*
@@ -2816,29 +3857,33 @@ void SV_WriteFrameSnapToClient( client_t *client, msg_t *msg ) {
 								 &svs.client_entities, 0, NULL, NULL );
 }
 
-void SV_BuildClientFrameSnap( client_t *client ) {
-	vec_t *skyorg = NULL, origin[3];
-
+static auto SV_GetSkyPortalPovOrigin( vec3_t buffer ) -> const float * {
 	if( auto maybeSkyBoxString = sv.configStrings.getSkyBox() ) {
 		int noents = 0;
 		float f1 = 0, f2 = 0;
 
-		if( sscanf( maybeSkyBoxString->data(), "%f %f %f %f %f %i", &origin[0], &origin[1], &origin[2], &f1, &f2, &noents ) >= 3 ) {
+		if( sscanf( maybeSkyBoxString->data(), "%f %f %f %f %f %i", &buffer[0], &buffer[1], &buffer[2], &f1, &f2, &noents ) >= 3 ) {
 			if( !noents ) {
-				skyorg = origin;
+				return buffer;
 			}
 		}
 	}
+	return nullptr;
+}
 
-	const ReplicatedScoreboardData *scoreboardData;
+static auto SV_GetScoreboardDataForClient( const client_t *client ) -> const ReplicatedScoreboardData * {
 	if( client->edict ) {
-		scoreboardData = G_GetScoreboardDataForClient( client->edict->s.number - 1 );
-	} else {
-		scoreboardData = G_GetScoreboardDataForDemo();
+		return G_GetScoreboardDataForClient( client->edict->s.number - 1 );
 	}
+	return G_GetScoreboardDataForDemo();
+}
+
+void SV_BuildClientFrameSnap( client_t *client ) {
+	vec3_t skyPortalPovOriginBuffer;
+	const float *skyPortalPovOrigin = SV_GetSkyPortalPovOrigin( skyPortalPovOriginBuffer );
 
-	SNAP_BuildClientFrameSnap( svs.cms, &sv.gi, sv.framenum, svs.gametime, skyorg,
-							   client, G_GetGameState(), scoreboardData, &svs.client_entities );
+	SNAP_BuildClientFrameSnap( svs.cms, &sv.gi, sv.framenum, svs.gametime, skyPortalPovOrigin,
+							   client, G_GetGameState(), SV_GetScoreboardDataForClient( client ), &svs.client_entities );
 }
 
 static bool SV_SendClientDatagram( client_t *client ) {
@@ -2857,7 +3902,28 @@ static bool SV_SendClientDatagram( client_t *client ) {
 	return SV_SendMessageToClient( client, &tmpMessage );
 }
 
+static void SV_HandleClientMessageFailure( client_t *client ) {
+	Com_Printf( "Error sending message to %s: %s\n", client->name, NET_ErrorString() );
+	if( client->reliable ) {
+		SV_DropClient( client, ReconnectBehaviour::OfUserChoice, "Error sending message: %s\n", NET_ErrorString() );
+	}
+}
+
+static void SV_SendClientDatagramsInParallel( std::span<client_t *const> clients );
+static void SV_BeginSnapFrameVisibility();
+
 void SV_SendClientMessages() {
+	WSW_PROFILER_SCOPE();
+
+	// Entities may have changed since the last call
+	SV_BeginSnapFrameVisibility();
+
+	// Queue outgoing packets so they get sent using few system calls
+	NET_BeginSendBatch();
+
+	client_t *clientsToSendDatagrams[MAX_CLIENTS];
+	unsigned numClientsToSendDatagrams = 0;
+
 	IteratorOverClients iteratorOverClients( { .includeFakeClients = true } );
 	while( client_t *const client = iteratorOverClients.getNext() ) {
 		if( client->isAFakeClient() ) {
@@ -2866,11 +3932,11 @@ void SV_SendClientMessages() {
 			SV_UpdateActivity();
 
 			if( client->state == CS_SPAWNED ) {
-				if( !SV_SendClientDatagram( client ) ) {
-					Com_Printf( "Error sending message to %s: %s\n", client->name, NET_ErrorString() );
-					if( client->reliable ) {
-						SV_DropClient( client, ReconnectBehaviour::OfUserChoice, "Error sending message: %s\n", NET_ErrorString() );
-					}
+				if( sv_parallelSnapshots->integer ) {
+					// Defer building and sending of snapshots
+					clientsToSendDatagrams[numClientsToSendDatagrams++] = client;
+				} else if( !SV_SendClientDatagram( client ) ) {
+					SV_HandleClientMessageFailure( client );
 				}
 			} else {
 				// send pending reliable commands, or send heartbeats for not timing out
@@ -2878,20 +3944,182 @@ void SV_SendClientMessages() {
 					SV_InitClientMessage( client, &tmpMessage, nullptr, 0 );
 					SV_AddReliableCommandsToMessage( client, &tmpMessage );
 					if( !SV_SendMessageToClient( client, &tmpMessage ) ) {
-						Com_Printf( "Error sending message to %s: %s\n", client->name, NET_ErrorString() );
-						if( client->reliable ) {
-							SV_DropClient( client, ReconnectBehaviour::OfUserChoice, "Error sending message: %s\n", NET_ErrorString() );
-						}
+						SV_HandleClientMessageFailure( client );
 					}
 				}
 			}
 		}
 	}
+
+	if( numClientsToSendDatagrams > 1 ) {
+		SV_SendClientDatagramsInParallel( { clientsToSendDatagrams, numClientsToSendDatagrams } );
+	} else if( numClientsToSendDatagrams == 1 ) {
+		// Not worth dispatching
+		if( !SV_SendClientDatagram( clientsToSendDatagrams[0] ) ) {
+			SV_HandleClientMessageFailure( clientsToSendDatagrams[0] );
+		}
+	}
+
+	NET_FlushSendBatch();
 }
 
-static inline void SNAP_WriteDeltaEntity( msg_t *msg, const entity_state_t *from, const entity_state_t *to,
-										  const client_snapshot_t *frame, bool force ) {
+/*
+* DeltaEntitiesCache
+*
+* Entity states of a snapshot frame are the same for all clients, and so are deltas from a baseline
+* or from a previous frame, as client_entities keep states of frames as-is.
+* Encoded deltas get shared between clients that delta from the same frame during a snapshot frame.
+* The cache is lock-free as clients may be encoded in parallel.
+*/
+class DeltaEntitiesCache {
+public:
+	DeltaEntitiesCache() : m_bytes( kArenaSize ) {}
+
+	void beginFrame( int64_t frameNum );
+	void endFrame() { m_isActive = false; }
+
+	// Writes a delta from the baseline if fromFrame is null
+	void writeDeltaEntity( msg_t *msg, const entity_state_t *from, const entity_state_t *to,
+						   const client_snapshot_t *fromFrame, int64_t fromFrameNum, bool force );
+
+	void printStats() const;
+private:
+	static constexpr unsigned kArenaSize = 1024 * 1024;
+
+	// Slot 0 is for deltas from baselines, others are for deltas from frames of respective age
+	struct Entry {
+		// Either 2 * generation if the entry is being written, or 2 * generation + 1 if it's ready
+		std::atomic<uint32_t> state { 0 };
+		int64_t fromTimeStamp { 0 };
+		uint32_t offset { 0 };
+		uint32_t length { 0 };
+	};
+
+	Entry m_entries[MAX_EDICTS][UPDATE_BACKUP];
+	std::vector<uint8_t> m_bytes;
+	std::atomic<uint32_t> m_bytesUsed { 0 };
+	int64_t m_frameNum { 0 };
+	uint32_t m_generation { 0 };
+	bool m_isActive { false };
+
+	std::atomic<uint64_t> m_numHits { 0 };
+	std::atomic<uint64_t> m_numMisses { 0 };
+};
+
+static DeltaEntitiesCache *g_deltaEntitiesCache;
+
+void DeltaEntitiesCache::beginFrame( int64_t frameNum ) {
+	m_frameNum  = frameNum;
+	m_bytesUsed = 0;
+	// Avoid clearing all entries by making previously written entries unmatched
+	m_generation++;
+	if( m_generation == std::numeric_limits<uint32_t>::max() / 2 ) [[unlikely]] {
+		for( auto &entriesOfEntity: m_entries ) {
+			for( Entry &entry: entriesOfEntity ) {
+				entry.state.store( 0, std::memory_order_relaxed );
+			}
+		}
+		m_generation = 1;
+	}
+	m_isActive = true;
+}
+
+void DeltaEntitiesCache::writeDeltaEntity( msg_t *msg, const entity_state_t *from, const entity_state_t *to,
+										   const client_snapshot_t *fromFrame, int64_t fromFrameNum, bool force ) {
+	// Removals are cheap to write
+	if( !m_isActive || !to ) {
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+
+	unsigned slot = 0;
+	int64_t fromTimeStamp = 0;
+	if( fromFrame ) {
+		if( fromFrameNum >= m_frameNum || m_frameNum - fromFrameNum >= UPDATE_BACKUP ) [[unlikely]] {
+			MSG_WriteDeltaEntity( msg, from, to, force );
+			return;
+		}
+		slot = (unsigned)( m_frameNum - fromFrameNum );
+		// Frame numbers may repeat across map changes, time stamps do not
+		fromTimeStamp = fromFrame->sentTimeStamp;
+	}
+
+	assert( to->number > 0 && to->number < MAX_EDICTS );
+	Entry *const entry = &m_entries[to->number][slot];
+
+	const uint32_t writingState = 2 * m_generation, readyState = writingState + 1;
+	uint32_t state = entry->state.load( std::memory_order_acquire );
+	if( state == readyState ) {
+		if( entry->fromTimeStamp == fromTimeStamp ) {
+			MSG_WriteData( msg, m_bytes.data() + entry->offset, entry->length );
+			m_numHits.fetch_add( 1, std::memory_order_relaxed );
+			return;
+		}
+	} else if( state != writingState ) {
+		if( entry->state.compare_exchange_strong( state, writingState, std::memory_order_acq_rel ) ) {
+			// We have become the writer of the entry
+			const size_t oldSize = msg->cursize;
+			MSG_WriteDeltaEntity( msg, from, to, force );
+			m_numMisses.fetch_add( 1, std::memory_order_relaxed );
+
+			const auto length = (uint32_t)( msg->cursize - oldSize );
+			const uint32_t offset = m_bytesUsed.fetch_add( length, std::memory_order_relaxed );
+			// Leave the entry in the writing state for the rest of the frame if the arena is exhausted
+			if( offset + length <= kArenaSize ) {
+				std::memcpy( m_bytes.data() + offset, msg->data + oldSize, length );
+				entry->fromTimeStamp = fromTimeStamp;
+				entry->offset        = offset;
+				entry->length        = length;
+				entry->state.store( readyState, std::memory_order_release );
+			}
+			return;
+		}
+	}
+
 	MSG_WriteDeltaEntity( msg, from, to, force );
+	m_numMisses.fetch_add( 1, std::memory_order_relaxed );
+}
+
+void DeltaEntitiesCache::printStats() const {
+	const uint64_t numHits = m_numHits.load(), numMisses = m_numMisses.load();
+	const uint64_t numTotal = numHits + numMisses;
+	const double hitRate = numTotal ? 100.0 * (double)numHits / (double)numTotal : 0.0;
+	Com_Printf( "Delta entities cache: %" PRIu64 " hits, %" PRIu64 " misses, hit rate %.1f%%\n", numHits, numMisses, hitRate );
+}
+
+static void SV_BeginDeltaEntitiesCache() {
+	if( !g_deltaEntitiesCache ) {
+		g_deltaEntitiesCache = new DeltaEntitiesCache;
+	}
+	g_deltaEntitiesCache->beginFrame( sv.framenum );
+}
+
+static void SV_EndDeltaEntitiesCache() {
+	if( g_deltaEntitiesCache ) {
+		g_deltaEntitiesCache->endFrame();
+	}
+}
+
+static void SV_ShutdownDeltaEntitiesCache() {
+	delete g_deltaEntitiesCache;
+	g_deltaEntitiesCache = nullptr;
+}
+
+static void SV_DeltaCacheStats_f( const CmdArgs & ) {
+	if( g_deltaEntitiesCache ) {
+		g_deltaEntitiesCache->printStats();
+	} else {
+		Com_Printf( "The delta entities cache has not been used yet\n" );
+	}
+}
+
+static inline void SNAP_WriteDeltaEntity( msg_t *msg, const entity_state_t *from, const entity_state_t *to,
+										  const client_snapshot_t *fromFrame, int64_t fromFrameNum, bool force ) {
+	if( g_deltaEntitiesCache ) {
+		g_deltaEntitiesCache->writeDeltaEntity( msg, from, to, fromFrame, fromFrameNum, force );
+	} else {
+		MSG_WriteDeltaEntity( msg, from, to, force );
+	}
 }
 
 /*
@@ -2899,7 +4127,7 @@ static inline void SNAP_WriteDeltaEntity( msg_t *msg, const entity_state_t *from
 *
 * Writes a delta update of an entity_state_t list to the message.
 */
-static void SNAP_EmitPacketEntities( const client_snapshot_t *from, const client_snapshot_t *to,
+static void SNAP_EmitPacketEntities( const client_snapshot_t *from, int64_t fromFrameNum, const client_snapshot_t *to,
 									 msg_t *msg, const entity_state_t *baselines,
 									 const entity_state_t *client_entities, int num_client_entities ) {
 	MSG_WriteUint8( msg, svc_packetentities );
@@ -2929,7 +4157,7 @@ static void SNAP_EmitPacketEntities( const client_snapshot_t *from, const client
 			// in any bytes being emited if the entity has not changed at all
 			// note that players are always 'newentities', this updates their oldorigin always
 			// and prevents warping ( wsw : jal : I removed it from the players )
-			SNAP_WriteDeltaEntity( msg, oldent, newent, to, false );
+			SNAP_WriteDeltaEntity( msg, oldent, newent, from, fromFrameNum, false );
 			oldindex++;
 			newindex++;
 			continue;
@@ -2937,14 +4165,14 @@ static void SNAP_EmitPacketEntities( const client_snapshot_t *from, const client
 
 		if( newnum < oldnum ) {
 			// this is a new entity, send it from the baseline
-			SNAP_WriteDeltaEntity( msg, &baselines[newnum], newent, to, true );
+			SNAP_WriteDeltaEntity( msg, &baselines[newnum], newent, nullptr, -1, true );
 			newindex++;
 			continue;
 		}
 
 		if( newnum > oldnum ) {
 			// the old entity isn't present in the new message
-			SNAP_WriteDeltaEntity( msg, oldent, nullptr, to, false );
+			SNAP_WriteDeltaEntity( msg, oldent, nullptr, from, fromFrameNum, false );
 			oldindex++;
 			continue;
 		}
@@ -3181,7 +4409,7 @@ void SNAP_WriteFrameSnapToClient( const ginfo_t *gi, client_t *client, msg_t *ms
 	// delta encode the entities
 	const entity_state_t *entityStates = client_entities ? client_entities->entities : nullptr;
 	const int numEntities = client_entities ? client_entities->num_entities : 0;
-	SNAP_EmitPacketEntities( oldframe, frame, msg, baselines, entityStates, numEntities );
+	SNAP_EmitPacketEntities( oldframe, client->lastframe, frame, msg, baselines, entityStates, numEntities );
 
 	// write length into reserved space
 	const int length = msg->cursize - pos - 2;
@@ -3223,6 +4451,13 @@ public:
 		std::memset( m_added, 0, sizeof( m_added ) );
 	}
 
+	void clear() {
+		std::memset( m_added, 0, sizeof( m_added ) );
+		m_numEnts     = 0;
+		m_maxNumSoFar = 0;
+		m_isSorted    = false;
+	}
+
 	void addEntNum( int entNum ) {
 		m_added[entNum] = true;
 		m_maxNumSoFar   = wsw::max( entNum, m_maxNumSoFar );
@@ -3333,76 +4568,238 @@ static CullResult SNAP_SnapCullEntity( const cmodel_state_t *cms, const edict_t
 	return CullResult::ShouldCheckBits;
 }
 
-static bool SNAP_SnapCullEntityForMultiPovs( const cmodel_state_t *cms, const edict_t *ent,
-											 const edict_t **povEntities, const vec3_t *viewOrigins,
-											 unsigned numPovEntities, const uint8_t *fatpvs ) {
-	assert( numPovEntities > 0 && numPovEntities < MAX_CLIENTS );
-	CullResult bestCullResult = CullResult::DefinitelyCulled;
-	static_assert( CullResult::DefinitelyCulled < CullResult::ShouldCheckBits );
-	static_assert( CullResult::ShouldCheckBits < CullResult::DefinitelyKept );
-	for( unsigned povNum = 0; povNum < numPovEntities; ++povNum ) {
-		const CullResult cullResult = SNAP_SnapCullEntity( cms, ent, povEntities[povNum], viewOrigins[povNum] );
-		if( bestCullResult < cullResult ) {
-			bestCullResult = cullResult;
-			if( cullResult == CullResult::DefinitelyKept ) {
-				break;
-			}
+static constexpr unsigned kNumSnapEntityMaskWords = MAX_EDICTS / 64;
+
+// A bitset over entity numbers
+struct SnapEntityMask {
+	uint64_t words[kNumSnapEntityMaskWords];
+
+	void clear() { std::memset( words, 0, sizeof( words ) ); }
+
+	void set( int entNum ) { words[entNum >> 6] |= (uint64_t)1 << ( entNum & 63 ); }
+	void reset( int entNum ) { words[entNum >> 6] &= ~( (uint64_t)1 << ( entNum & 63 ) ); }
+
+	[[nodiscard]]
+	bool test( int entNum ) const { return ( words[entNum >> 6] >> ( entNum & 63 ) ) & 1; }
+
+	void orWith( const SnapEntityMask &that ) {
+		for( unsigned i = 0; i < kNumSnapEntityMaskWords; ++i ) {
+			words[i] |= that.words[i];
 		}
 	}
-	bool isCulled = true;
-	if( bestCullResult == CullResult::DefinitelyKept ) {
-		isCulled = false;
-	} else if( bestCullResult == CullResult::ShouldCheckBits ) {
-		if( !SNAP_BitsCullEntity( cms, ent, fatpvs, ent->r.num_clusters ) ) {
-			isCulled = false;
-		}
+};
+
+/*
+* SnapFrameVisibilityCache
+*
+* Caches visibility data that does not depend on a particular snapshot viewer during a server frame.
+* Entity visibility from a PVS cluster and culling results from a POV entity are computed once
+* on demand, so culling for a client is reduced to a combination of respective entity masks.
+* Everything is computed serially, the computed data is safe to read in parallel.
+*/
+class SnapFrameVisibilityCache {
+public:
+	// Culling results of all entities from a POV, see SNAP_SnapCullEntity()
+	struct PovCullMasks {
+		SnapEntityMask definitelyKept;
+		SnapEntityMask shouldCheckBits;
+	};
+
+	void beginFrame();
+
+	[[nodiscard]]
+	auto getPovCullMasks( const cmodel_state_t *cms, const ginfo_t *gi, const edict_t *povEnt ) -> const PovCullMasks &;
+
+	// Adds entities that are not culled by the fat PVS at the origin, see CM_MergePVS()
+	void addEntitiesInFatPVS( const cmodel_state_t *cms, const ginfo_t *gi, const float *origin, SnapEntityMask *mask );
+
+	// Gets numbers of portal entities with a different target origin
+	[[nodiscard]]
+	auto getPortalEntNums( const ginfo_t *gi ) -> std::span<const int>;
+private:
+	[[nodiscard]]
+	auto getClusterEntityMask( const cmodel_state_t *cms, const ginfo_t *gi, int cluster ) -> const SnapEntityMask &;
+
+	PovCullMasks m_povCullMasks[MAX_CLIENTS];
+	bool m_hasPovCullMasks[MAX_CLIENTS] {};
+
+	// Maps a cluster + 1 to an index in m_clusterEntityMasks
+	std::vector<int> m_clusterMaskIndices;
+	std::vector<int> m_clustersOfMasks;
+	std::vector<SnapEntityMask> m_clusterEntityMasks;
+
+	int m_portalEntNums[MAX_EDICTS];
+	unsigned m_numPortalEnts { 0 };
+	bool m_hasPortalEntNums { false };
+};
+
+static SnapFrameVisibilityCache g_snapFrameVisibilityCache;
+
+void SnapFrameVisibilityCache::beginFrame() {
+	std::fill( std::begin( m_hasPovCullMasks ), std::end( m_hasPovCullMasks ), false );
+	for( const int cluster: m_clustersOfMasks ) {
+		m_clusterMaskIndices[cluster + 1] = -1;
 	}
-	return isCulled;
+	m_clustersOfMasks.clear();
+	m_clusterEntityMasks.clear();
+	m_hasPortalEntNums = false;
 }
 
-static void SNAP_BuildSnapEntitiesList( cmodel_state_t *cms, ginfo_t *gi,
-										const edict_t **povEntities, unsigned numPovEntities,
-										const float *skyPortalPovOrigin,
-										client_snapshot_t *frame, SnapEntNumsList &list ) {
-	// TODO: Get rid of areas?
-	frame->areabytes  = CM_AreaRowSize( cms ) * CM_NumAreas( cms );
-	frame->clientarea = -1;
-	std::memset( frame->areabits, 255, frame->areabytes );
+auto SnapFrameVisibilityCache::getPovCullMasks( const cmodel_state_t *cms, const ginfo_t *gi,
+												const edict_t *povEnt ) -> const PovCullMasks & {
+	const int povIndex = NUM_FOR_EDICT( povEnt ) - 1;
+	assert( povIndex >= 0 && povIndex < MAX_CLIENTS );
+	PovCullMasks *const masks = &m_povCullMasks[povIndex];
+	if( !m_hasPovCullMasks[povIndex] ) {
+		m_hasPovCullMasks[povIndex] = true;
 
-	// TODO: Should we allocate on stack THAT much?
-	[[maybe_unused]] vec3_t viewOrigins[MAX_CLIENTS];
-	[[maybe_unused]] uint8_t fatpvs[MAX_MAP_LEAFS / 8];
-	[[maybe_unused]] int8_t earlyCullingResults[MAX_EDICTS];
-
-	if( !frame->allentities ) {
-		assert( numPovEntities > 0 );
-		std::memset( earlyCullingResults, 0, gi->num_edicts );
-		for( unsigned povNum = 0; povNum < numPovEntities; ++povNum ) {
-			const edict_t *povEnt = povEntities[povNum];
-			VectorCopy( povEnt->s.origin, viewOrigins[povNum] );
-			viewOrigins[povNum][2] += povEnt->r.client->ps.viewheight;
-			if( povNum == 0 ) {
-				std::memset( fatpvs, 0, CM_ClusterRowSize( cms ) );
+		vec3_t viewOrigin;
+		VectorCopy( povEnt->s.origin, viewOrigin );
+		viewOrigin[2] += povEnt->r.client->ps.viewheight;
+
+		masks->definitelyKept.clear();
+		masks->shouldCheckBits.clear();
+		for( int entNum = 1; entNum < gi->num_edicts; entNum++ ) {
+			const CullResult cullResult = SNAP_SnapCullEntity( cms, EDICT_NUM( entNum ), povEnt, viewOrigin );
+			if( cullResult == CullResult::DefinitelyKept ) {
+				masks->definitelyKept.set( entNum );
+			} else if( cullResult == CullResult::ShouldCheckBits ) {
+				masks->shouldCheckBits.set( entNum );
 			}
-			CM_MergePVS( cms, viewOrigins[povNum], fatpvs );
 		}
-		if( skyPortalPovOrigin ) {
-			CM_MergePVS( cms, skyPortalPovOrigin, fatpvs );
+	}
+	return *masks;
+}
+
+auto SnapFrameVisibilityCache::getClusterEntityMask( const cmodel_state_t *cms, const ginfo_t *gi,
+													 int cluster ) -> const SnapEntityMask & {
+	// Clusters that are out of range (e.g. if there's no vis data) use the same null row
+	const int numClusters = CM_NumClusters( cms );
+	if( cluster < 0 || cluster >= numClusters ) {
+		cluster = -1;
+	}
+	if( m_clusterMaskIndices.size() != (size_t)( numClusters + 1 ) ) {
+		m_clusterMaskIndices.assign( numClusters + 1, -1 );
+	}
+
+	if( m_clusterMaskIndices[cluster + 1] < 0 ) {
+		m_clusterMaskIndices[cluster + 1] = (int)m_clusterEntityMasks.size();
+		m_clustersOfMasks.push_back( cluster );
+		SnapEntityMask *const mask = &m_clusterEntityMasks.emplace_back();
+		mask->clear();
+
+		const uint8_t *const pvs = CM_ClusterPVS( cms, cluster );
+		for( int entNum = 1; entNum < gi->num_edicts; entNum++ ) {
+			const edict_t *const ent = EDICT_NUM( entNum );
+			if( !( ent->r.svflags & SVF_NOCLIENT ) ) {
+				if( !SNAP_BitsCullEntity( cms, ent, pvs, ent->r.num_clusters ) ) {
+					mask->set( entNum );
+				}
+			}
 		}
+	}
+
+	return m_clusterEntityMasks[m_clusterMaskIndices[cluster + 1]];
+}
+
+void SnapFrameVisibilityCache::addEntitiesInFatPVS( const cmodel_state_t *cms, const ginfo_t *gi,
+													const float *origin, SnapEntityMask *mask ) {
+	int clusters[128];
+	const int numClusters = CM_FatPVSClusters( cms, origin, clusters, (int)std::size( clusters ) );
+	// An entity is visible in the merged PVS if it is visible in any of merged rows
+	for( int i = 0; i < numClusters; ++i ) {
+		mask->orWith( getClusterEntityMask( cms, gi, clusters[i] ) );
+	}
+}
+
+auto SnapFrameVisibilityCache::getPortalEntNums( const ginfo_t *gi ) -> std::span<const int> {
+	if( !m_hasPortalEntNums ) {
+		m_hasPortalEntNums = true;
+		m_numPortalEnts    = 0;
 		for( int entNum = 1; entNum < gi->num_edicts; entNum++ ) {
-			edict_t *const ent = EDICT_NUM( entNum );
-			// If it's a portal with a different target origin
+			const edict_t *const ent = EDICT_NUM( entNum );
 			if( ( ent->r.svflags & SVF_PORTAL ) && !VectorCompare( ent->s.origin, ent->s.origin2 ) ) {
-				const bool isCulled = SNAP_SnapCullEntityForMultiPovs( cms, ent, povEntities, viewOrigins, numPovEntities, fatpvs );
-				earlyCullingResults[entNum] = isCulled ? 1 : -1;
-				if( !isCulled ) {
-					CM_MergePVS( cms, ent->s.origin2, fatpvs );
-				}
+				m_portalEntNums[m_numPortalEnts++] = entNum;
 			}
 		}
 	}
+	return { m_portalEntNums, m_numPortalEnts };
+}
 
-	// add the entities to the list
+// Visibility data of a client frame.
+// It gets computed serially as the frame visibility cache is filled on demand,
+// the building of entity lists using it is safe to perform in parallel.
+struct SnapVisibilityState {
+	const edict_t *povEntities[MAX_CLIENTS];
+	unsigned numPovEntities { 0 };
+	SnapEntityMask visibleEntities;
+};
+
+static void SNAP_BuildSnapVisibilityState( const cmodel_state_t *cms, const ginfo_t *gi, const float *skyPortalPovOrigin,
+										   const client_snapshot_t *frame, SnapFrameVisibilityCache *visCache,
+										   SnapVisibilityState *visState ) {
+	if( frame->allentities ) {
+		return;
+	}
+
+	const edict_t *const *const povEntities = visState->povEntities;
+	const unsigned numPovEntities           = visState->numPovEntities;
+	assert( numPovEntities > 0 );
+
+	// An entity is kept if it's kept for any POV, or if the bits check is needed for any POV and it passes
+	SnapEntityMask definitelyKept, shouldCheckBits, inFatPVS;
+	definitelyKept.clear();
+	shouldCheckBits.clear();
+	inFatPVS.clear();
+	for( unsigned povNum = 0; povNum < numPovEntities; ++povNum ) {
+		const edict_t *const povEnt = povEntities[povNum];
+		const SnapFrameVisibilityCache::PovCullMasks &povCullMasks = visCache->getPovCullMasks( cms, gi, povEnt );
+		definitelyKept.orWith( povCullMasks.definitelyKept );
+		shouldCheckBits.orWith( povCullMasks.shouldCheckBits );
+
+		vec3_t viewOrigin;
+		VectorCopy( povEnt->s.origin, viewOrigin );
+		viewOrigin[2] += povEnt->r.client->ps.viewheight;
+		visCache->addEntitiesInFatPVS( cms, gi, viewOrigin, &inFatPVS );
+	}
+	if( skyPortalPovOrigin ) {
+		visCache->addEntitiesInFatPVS( cms, gi, skyPortalPovOrigin, &inFatPVS );
+	}
+
+	// Portals are checked in order against the PVS merged so far, and are not checked again later
+	const std::span<const int> portalEntNums = visCache->getPortalEntNums( gi );
+	bool isPortalVisible[MAX_EDICTS];
+	for( size_t portalIndex = 0; portalIndex < portalEntNums.size(); ++portalIndex ) {
+		const int entNum = portalEntNums[portalIndex];
+		isPortalVisible[portalIndex] = definitelyKept.test( entNum ) || ( shouldCheckBits.test( entNum ) && inFatPVS.test( entNum ) );
+		if( isPortalVisible[portalIndex] ) {
+			visCache->addEntitiesInFatPVS( cms, gi, EDICT_NUM( entNum )->s.origin2, &inFatPVS );
+		}
+	}
+
+	SnapEntityMask *const visibleEntities = &visState->visibleEntities;
+	for( unsigned i = 0; i < kNumSnapEntityMaskWords; ++i ) {
+		visibleEntities->words[i] = definitelyKept.words[i] | ( shouldCheckBits.words[i] & inFatPVS.words[i] );
+	}
+	for( size_t portalIndex = 0; portalIndex < portalEntNums.size(); ++portalIndex ) {
+		if( isPortalVisible[portalIndex] ) {
+			visibleEntities->set( portalEntNums[portalIndex] );
+		} else {
+			visibleEntities->reset( portalEntNums[portalIndex] );
+		}
+	}
+	// POV entities are always transmitted
+	for( unsigned povNum = 0; povNum < numPovEntities; ++povNum ) {
+		visibleEntities->set( NUM_FOR_EDICT( povEntities[povNum] ) );
+	}
+}
+
+/*
+* SNAP_FixEntityNumbers
+*
+* Must be called prior to building entity lists, so the latter don't have to modify entities.
+*/
+static void SNAP_FixEntityNumbers( const ginfo_t *gi ) {
 	for( int entNum = 1; entNum < gi->num_edicts; entNum++ ) {
 		edict_t *const ent = EDICT_NUM( entNum );
 
@@ -3412,30 +4809,30 @@ static void SNAP_BuildSnapEntitiesList( cmodel_state_t *cms, ginfo_t *gi,
 			ent->s.number = entNum;
 		}
 
-		bool shouldAdd = true;
-		if( !frame->allentities ) {
-			// If it's not in the list of povs
-			if( !wsw::contains( povEntities, povEntities + numPovEntities, ent ) ) {
-				if( earlyCullingResults[entNum] == 0 ) [[likely]] {
-					if( SNAP_SnapCullEntityForMultiPovs( cms, ent, povEntities, viewOrigins, numPovEntities, fatpvs ) ) {
-						shouldAdd = false;
-					}
-				} else if( earlyCullingResults[entNum] > 0 ) {
-					shouldAdd = false;
-				}
+		// make sure owner number is valid too
+		if( ent->r.svflags & SVF_FORCEOWNER ) {
+			if( ent->s.ownerNum != 0 && ( ent->s.ownerNum < 0 || ent->s.ownerNum >= gi->num_edicts ) ) {
+				Com_Printf( "FIXING ENT->S.OWNERNUM: %i %i!!!\n", ent->s.type, ent->s.ownerNum );
+				ent->s.ownerNum = 0;
 			}
 		}
+	}
+}
 
-		if( shouldAdd ) {
+static void SNAP_BuildSnapEntitiesList( const ginfo_t *gi, const client_snapshot_t *frame,
+										const SnapVisibilityState &visState, SnapEntNumsList &list ) {
+	// add the entities to the list
+	for( int entNum = 1; entNum < gi->num_edicts; entNum++ ) {
+		const edict_t *const ent = EDICT_NUM( entNum );
+		assert( ent->s.number == entNum );
+
+		if( frame->allentities || visState.visibleEntities.test( entNum ) ) {
 			list.addEntNum( entNum );
 
 			if( ent->r.svflags & SVF_FORCEOWNER ) {
-				// make sure owner number is valid too
-				if( ent->s.ownerNum > 0 && ent->s.ownerNum < gi->num_edicts ) {
+				// the owner number has been validated by SNAP_FixEntityNumbers()
+				if( ent->s.ownerNum > 0 ) {
 					list.addEntNum( ent->s.ownerNum );
-				} else {
-					Com_Printf( "FIXING ENT->S.OWNERNUM: %i %i!!!\n", ent->s.type, ent->s.ownerNum );
-					ent->s.ownerNum = 0;
 				}
 			}
 		}
@@ -3443,23 +4840,18 @@ static void SNAP_BuildSnapEntitiesList( cmodel_state_t *cms, ginfo_t *gi,
 }
 
 /*
-* SNAP_BuildClientFrameSnap
+* SNAP_PrepareClientFrameSnap
 *
-* Decides which entities are going to be visible to the client, and
-* copies off the playerstat and areabits.
+* Selects POV entities, copies off the playerstate and computes the visibility.
+* Returns false if the client is not in game yet.
 */
-void SNAP_BuildClientFrameSnap( cmodel_state_t *cms, ginfo_t *gi, int64_t frameNum,
-								int64_t timeStamp, const float *skyPortalPovOrigin, client_t *client,
-								const game_state_t *gameState,
-								const ReplicatedScoreboardData *scoreboardData,
-								client_entities_t *client_entities ) {
-	assert( gameState );
-	assert( scoreboardData );
-
+static bool SNAP_PrepareClientFrameSnap( const cmodel_state_t *cms, const ginfo_t *gi, int64_t frameNum,
+										 int64_t timeStamp, const float *skyPortalPovOrigin, client_t *client,
+										 SnapFrameVisibilityCache *visCache, SnapVisibilityState *visState ) {
 	edict_t *clent = client->edict;
 	// TODO: Should it happen?
 	if( clent && !clent->r.client ) {   // allow nullptr ent for server record
-		return;     // not in game yet
+		return false;     // not in game yet
 	}
 
 	// this is the frame we are creating
@@ -3475,7 +4867,7 @@ void SNAP_BuildClientFrameSnap( cmodel_state_t *cms, ginfo_t *gi, int64_t frameN
 		frame->allentities = true;
 	}
 
-	const edict_t *povEntities[MAX_CLIENTS];
+	const edict_t **const povEntities = visState->povEntities;
 	unsigned numPovEntities = 0;
 
 	if( frame->multipov ) {
@@ -3516,6 +4908,8 @@ void SNAP_BuildClientFrameSnap( cmodel_state_t *cms, ginfo_t *gi, int64_t frameN
 		numPovEntities = 1;
 	}
 
+	visState->numPovEntities = numPovEntities;
+
 	// areaportals matrix
 	int numareas = CM_NumAreas( cms );
 	if( frame->numareas < numareas ) {
@@ -3553,9 +4947,20 @@ void SNAP_BuildClientFrameSnap( cmodel_state_t *cms, ginfo_t *gi, int64_t frameN
 		frame->numplayers      = 1;
 	}
 
-	// build up the list of visible entities
-	SnapEntNumsList entNumsList;
-	SNAP_BuildSnapEntitiesList( cms, gi, povEntities, numPovEntities, skyPortalPovOrigin, frame, entNumsList );
+	// TODO: Get rid of areas?
+	frame->areabytes  = CM_AreaRowSize( cms ) * CM_NumAreas( cms );
+	frame->clientarea = -1;
+	std::memset( frame->areabits, 255, frame->areabytes );
+
+	SNAP_BuildSnapVisibilityState( cms, gi, skyPortalPovOrigin, frame, visCache, visState );
+	return true;
+}
+
+static void SNAP_StoreFrameMatchState( client_snapshot_t *frame, const edict_t *clent,
+									   const game_state_t *gameState,
+									   const ReplicatedScoreboardData *scoreboardData ) {
+	assert( gameState );
+	assert( scoreboardData );
 
 	// store current match state information
 	frame->gameState = *gameState;
@@ -3587,11 +4992,19 @@ void SNAP_BuildClientFrameSnap( cmodel_state_t *cms, ginfo_t *gi, int64_t frameN
 			}
 		}
 	}
+}
 
-	// dump the entities list
-	unsigned nextEntities = client_entities->next_entities;
+/*
+* SNAP_StoreSnapEntities
+*
+* Dumps the entities list to the circular client_entities array starting from the given position.
+* Calls for different frames do not interfere if the respective ranges do not overlap.
+*/
+static void SNAP_StoreSnapEntities( client_snapshot_t *frame, const SnapEntNumsList &entNumsList,
+									client_entities_t *client_entities, unsigned firstEntity ) {
+	unsigned nextEntities = firstEntity;
 	frame->num_entities = 0;
-	frame->first_entity = (int)nextEntities;
+	frame->first_entity = (int)firstEntity;
 
 	for( const int entNum : entNumsList.sortedNums() ) {
 		// add it to the circular client_entities array
@@ -3609,8 +5022,240 @@ void SNAP_BuildClientFrameSnap( cmodel_state_t *cms, ginfo_t *gi, int64_t frameN
 		frame->num_entities++;
 		nextEntities++;
 	}
+}
+
+/*
+* SNAP_BuildClientFrameSnap
+*
+* Decides which entities are going to be visible to the client, and
+* copies off the playerstat and areabits.
+*/
+void SNAP_BuildClientFrameSnap( cmodel_state_t *cms, ginfo_t *gi, int64_t frameNum,
+								int64_t timeStamp, const float *skyPortalPovOrigin, client_t *client,
+								const game_state_t *gameState,
+								const ReplicatedScoreboardData *scoreboardData,
+								client_entities_t *client_entities ) {
+	// TODO: Should we allocate on stack THAT much?
+	SnapVisibilityState visState;
+	SNAP_FixEntityNumbers( gi );
+
+	if( !SNAP_PrepareClientFrameSnap( cms, gi, frameNum, timeStamp, skyPortalPovOrigin, client,
+									  &g_snapFrameVisibilityCache, &visState ) ) {
+		return;
+	}
+
+	client_snapshot_t *frame = &client->snapShots[frameNum & UPDATE_MASK];
+
+	// build up the list of visible entities
+	SnapEntNumsList entNumsList;
+	SNAP_BuildSnapEntitiesList( gi, frame, visState, entNumsList );
+
+	SNAP_StoreFrameMatchState( frame, client->edict, gameState, scoreboardData );
+
+	SNAP_StoreSnapEntities( frame, entNumsList, client_entities, client_entities->next_entities );
+	client_entities->next_entities += (unsigned)frame->num_entities;
+}
+
+/*
+* ParallelSnapshotsBuilder
+*
+* Builds and encodes datagrams of spawned clients using the task system.
+* Stages that touch shared state (PVS merging, reservation of client_entities ranges and transmission)
+* are executed serially in the order of clients, so the output is the same as of the serial code path.
+*/
+class ParallelSnapshotsBuilder {
+public:
+	ParallelSnapshotsBuilder();
+
+	void sendClientDatagrams( std::span<client_t *const> clients );
+private:
+	struct ClientEntry {
+		client_t *client { nullptr };
+		const ReplicatedScoreboardData *scoreboardData { nullptr };
+		unsigned firstEntity { 0 };
+		unsigned workerIndex { 0 };
+		unsigned messageOffset { 0 };
+		unsigned messageSize { 0 };
+		bool isInGame { false };
+		SnapEntNumsList entNumsList;
+		SnapVisibilityState visState;
+	};
+
+	[[nodiscard]]
+	static auto suggestNumExtraThreads() -> unsigned;
+
+	void prepareFrameSnaps( std::span<client_t *const> clients );
+	void buildEntitiesList( ClientEntry *entry );
+	void reserveClientEntities();
+	void encodeDatagram( unsigned workerIndex, ClientEntry *entry );
+	void transmitDatagrams();
+
+	TaskSystem m_taskSystem;
+	// Encoded messages are appended to buffers of respective workers
+	std::vector<wsw::PodVector<uint8_t>> m_messageBuffersOfWorkers;
+	const game_state_t *m_gameState { nullptr };
+	unsigned m_numEntries { 0 };
+	ClientEntry m_entries[MAX_CLIENTS];
+};
+
+static ParallelSnapshotsBuilder *g_parallelSnapshotsBuilder;
+
+ParallelSnapshotsBuilder::ParallelSnapshotsBuilder()
+	: m_taskSystem( { .profilingGroup = wsw::ProfilingSystem::ServerGroup, .numExtraThreads = suggestNumExtraThreads() } ) {
+	m_messageBuffersOfWorkers.resize( m_taskSystem.getNumberOfWorkers() );
+	for( wsw::PodVector<uint8_t> &buffer: m_messageBuffersOfWorkers ) {
+		buffer.reserve( 4 * MAX_MSGLEN );
+	}
+}
+
+auto ParallelSnapshotsBuilder::suggestNumExtraThreads() -> unsigned {
+	unsigned numPhysicalProcessors = 0, numLogicalProcessors = 0;
+	if( Sys_GetNumberOfProcessors( &numPhysicalProcessors, &numLogicalProcessors ) ) {
+		// Take the server thread into account, and also the client thread and the sound backend if not dedicated
+		const unsigned numExcludedCores = dedicated->integer ? 1 : 3;
+		if( numPhysicalProcessors > numExcludedCores ) {
+			// Disallow more than 3 worker threads.
+			return wsw::min<unsigned>( 3, numPhysicalProcessors - numExcludedCores );
+		}
+	}
+	return 0;
+}
+
+void ParallelSnapshotsBuilder::sendClientDatagrams( std::span<client_t *const> clients ) {
+	WSW_PROFILER_SCOPE();
+
+	assert( !clients.empty() && clients.size() <= std::size( m_entries ) );
+	prepareFrameSnaps( clients );
+
+	for( wsw::PodVector<uint8_t> &buffer: m_messageBuffersOfWorkers ) {
+		buffer.clear();
+	}
+
+	const std::pair<unsigned, unsigned> entriesRange { 0, m_numEntries };
+	auto buildFn = [this]( unsigned, unsigned index ) {
+		buildEntitiesList( &m_entries[index] );
+	};
+	const TaskHandle buildTask = m_taskSystem.addForIndicesInRange( entriesRange, std::span<const TaskHandle>(),
+																	std::move( buildFn ) );
+	const TaskHandle reserveTask = m_taskSystem.add( { buildTask }, [this]( unsigned ) {
+		reserveClientEntities();
+	});
+	auto encodeFn = [this]( unsigned workerIndex, unsigned index ) {
+		encodeDatagram( workerIndex, &m_entries[index] );
+	};
+	(void)m_taskSystem.addForIndicesInRange( entriesRange, std::span<const TaskHandle>( &reserveTask, 1 ),
+											 std::move( encodeFn ) );
+
+	const TaskSystem::ExecutionHandle executionHandle = m_taskSystem.startExecution();
+	if( !m_taskSystem.awaitCompletion( executionHandle ) ) {
+		Com_Error( ERR_FATAL, "Failed to build client snapshots" );
+	}
+
+	transmitDatagrams();
+}
+
+void ParallelSnapshotsBuilder::prepareFrameSnaps( std::span<client_t *const> clients ) {
+	WSW_PROFILER_SCOPE();
+
+	vec3_t skyPortalPovOriginBuffer;
+	const float *skyPortalPovOrigin = SV_GetSkyPortalPovOrigin( skyPortalPovOriginBuffer );
+
+	SNAP_FixEntityNumbers( &sv.gi );
+
+	m_gameState  = G_GetGameState();
+	m_numEntries = 0;
+	for( client_t *client: clients ) {
+		ClientEntry *const entry = &m_entries[m_numEntries++];
+		entry->client            = client;
+		entry->scoreboardData    = SV_GetScoreboardDataForClient( client );
+		entry->isInGame          = SNAP_PrepareClientFrameSnap( svs.cms, &sv.gi, sv.framenum, svs.gametime,
+																skyPortalPovOrigin, client, &g_snapFrameVisibilityCache,
+																&entry->visState );
+	}
+}
+
+void ParallelSnapshotsBuilder::buildEntitiesList( ClientEntry *entry ) {
+	WSW_PROFILER_SCOPE();
+
+	if( entry->isInGame ) {
+		client_snapshot_t *const frame = &entry->client->snapShots[sv.framenum & UPDATE_MASK];
+		entry->entNumsList.clear();
+		SNAP_BuildSnapEntitiesList( &sv.gi, frame, entry->visState, entry->entNumsList );
+		// Make sure the list gets sorted in this parallel stage
+		(void)entry->entNumsList.sortedNums();
+		SNAP_StoreFrameMatchState( frame, entry->client->edict, m_gameState, entry->scoreboardData );
+	}
+}
+
+void ParallelSnapshotsBuilder::reserveClientEntities() {
+	WSW_PROFILER_SCOPE();
+
+	client_entities_t *const clientEntities = &svs.client_entities;
+	for( unsigned entryIndex = 0; entryIndex < m_numEntries; ++entryIndex ) {
+		ClientEntry *const entry = &m_entries[entryIndex];
+		if( entry->isInGame ) {
+			entry->firstEntity = clientEntities->next_entities;
+			clientEntities->next_entities += (unsigned)entry->entNumsList.sortedNums().size();
+		}
+	}
+}
+
+void ParallelSnapshotsBuilder::encodeDatagram( unsigned workerIndex, ClientEntry *entry ) {
+	WSW_PROFILER_SCOPE();
+
+	client_t *const client = entry->client;
+	if( entry->isInGame ) {
+		client_snapshot_t *const frame = &client->snapShots[sv.framenum & UPDATE_MASK];
+		SNAP_StoreSnapEntities( frame, entry->entNumsList, &svs.client_entities, entry->firstEntity );
+	}
+
+	wsw::PodVector<uint8_t> &buffer = m_messageBuffersOfWorkers[workerIndex];
+	const size_t messageOffset = buffer.size();
+	buffer.resize( messageOffset + MAX_MSGLEN );
+
+	msg_t msg;
+	SV_InitClientMessage( client, &msg, buffer.data() + messageOffset, MAX_MSGLEN );
+	SV_AddReliableCommandsToMessage( client, &msg );
+	SV_WriteFrameSnapToClient( client, &msg );
+
+	buffer.resize( messageOffset + msg.cursize );
+
+	entry->workerIndex   = workerIndex;
+	entry->messageOffset = (unsigned)messageOffset;
+	entry->messageSize   = (unsigned)msg.cursize;
+}
+
+void ParallelSnapshotsBuilder::transmitDatagrams() {
+	WSW_PROFILER_SCOPE();
+
+	// Transmit in the order of clients as the compression buffer is shared
+	for( unsigned entryIndex = 0; entryIndex < m_numEntries; ++entryIndex ) {
+		const ClientEntry &entry = m_entries[entryIndex];
+		uint8_t *const data = m_messageBuffersOfWorkers[entry.workerIndex].data() + entry.messageOffset;
+
+		msg_t msg;
+		MSG_Init( &msg, data, entry.messageSize );
+		msg.cursize = entry.messageSize;
+		if( !SV_SendMessageToClient( entry.client, &msg ) ) {
+			SV_HandleClientMessageFailure( entry.client );
+		}
+	}
+}
+
+static void SV_BeginSnapFrameVisibility() {
+	g_snapFrameVisibilityCache.beginFrame();
+}
+
+static void SV_SendClientDatagramsInParallel( std::span<client_t *const> clients ) {
+	if( !g_parallelSnapshotsBuilder ) {
+		g_parallelSnapshotsBuilder = new ParallelSnapshotsBuilder;
+	}
+	g_parallelSnapshotsBuilder->sendClientDatagrams( clients );
+}
 
-	client_entities->next_entities = nextEntities;
+static void SV_ShutdownParallelSnapshots() {
+	delete g_parallelSnapshotsBuilder;
+	g_parallelSnapshotsBuilder = nullptr;
 }
 
 static void SNAP_FreeClientFrame( client_snapshot_t *frame ) {
@@ -3766,6 +5411,166 @@ void SV_InfoServerSendQuit() {
 	}
 }
 
+/*
+* A built info string along with the version of the data it has been built from
+*/
+typedef struct {
+	bool valid;
+	uint64_t version;
+	size_t length;
+	// Nothing longer fits an out-of-band datagram anyway
+	char string[MAX_PACKETLEN];
+} sv_infocache_t;
+
+static sv_infocache_t sv_shortInfoCache;
+static sv_infocache_t sv_longInfoCache[2];
+
+// Kinds of info query replies
+enum {
+	SV_INFO_SHORT,      // "info" replies to broadcast scans
+	SV_INFO_LONG,       // "infoResponse" replies to getinfo queries
+	SV_INFO_STATUS,     // "statusResponse" replies to getstatus queries (include scores and pings)
+
+	SV_INFO_NUM_KINDS
+};
+
+#define SV_INFO_ALL_KINDS ( ( 1 << SV_INFO_SHORT ) | ( 1 << SV_INFO_LONG ) | ( 1 << SV_INFO_STATUS ) )
+
+/*
+* The data of clients that info replies are built from, as it has been seen the last time
+*/
+typedef struct {
+	int state;
+	bool fake;
+	int team;
+	int frags;
+	int ping;
+	uint64_t nameHash;
+} sv_infoclient_t;
+
+static struct {
+	uint64_t versions[SV_INFO_NUM_KINDS];
+	unsigned serverinfoModificationCount;
+	int spawncount;
+	int state;
+	int maxclients;
+	int skilllevel;
+	uint64_t trackedVarModificationIds[5];
+	int numConnectedClients;        // used for filtering of full and empty servers
+	sv_infoclient_t clients[MAX_CLIENTS];
+} sv_infoState;
+
+/*
+* SV_UpdateInfoVersions
+*
+* Bumps versions of kinds of info replies that the changed data affects.
+* This gets called once per server frame, so queries do not have to check the server state.
+*/
+static void SV_UpdateInfoVersions( void ) {
+	// The game module registers some of these vars, so they may appear later
+	static const char *const trackedVarNames[] = { "sv_hostname", "g_gametype", "g_instagib", "g_race_gametype", "password" };
+	static cvar_t *trackedVars[std::size( trackedVarNames )];
+	static_assert( std::size( trackedVarNames ) == std::size( sv_infoState.trackedVarModificationIds ) );
+
+	unsigned changedKinds = 0;
+
+	if( sv_infoState.serverinfoModificationCount != serverinfo_modification_count ) {
+		sv_infoState.serverinfoModificationCount = serverinfo_modification_count;
+		changedKinds |= SV_INFO_ALL_KINDS;
+	}
+	if( sv_infoState.spawncount != svs.spawncount || sv_infoState.state != (int)sv.state ) {
+		sv_infoState.spawncount = svs.spawncount;
+		sv_infoState.state = (int)sv.state;
+		changedKinds |= SV_INFO_ALL_KINDS;
+	}
+	if( sv_infoState.maxclients != sv_maxclients->integer || sv_infoState.skilllevel != sv_skilllevel->integer ) {
+		sv_infoState.maxclients = sv_maxclients->integer;
+		sv_infoState.skilllevel = sv_skilllevel->integer;
+		changedKinds |= SV_INFO_ALL_KINDS;
+	}
+	for( size_t i = 0; i < std::size( trackedVarNames ); ++i ) {
+		if( !trackedVars[i] ) {
+			trackedVars[i] = Cvar_Find( trackedVarNames[i] );
+		}
+		const uint64_t modificationId = trackedVars[i] ? trackedVars[i]->modificationId + 1 : 0;
+		if( sv_infoState.trackedVarModificationIds[i] != modificationId ) {
+			sv_infoState.trackedVarModificationIds[i] = modificationId;
+			changedKinds |= SV_INFO_ALL_KINDS;
+		}
+	}
+
+	sv_infoState.numConnectedClients = 0;
+	for( int i = 0; i < sv_maxclients->integer; i++ ) {
+		const client_t *client = svs.clients + i;
+		sv_infoclient_t *seen = &sv_infoState.clients[i];
+		if( client->state >= CS_CONNECTED ) {
+			sv_infoState.numConnectedClients++;
+		}
+
+		sv_infoclient_t actual {};
+		actual.state = client->state;
+		if( client->state >= CS_CONNECTING ) {
+			actual.fake = client->isAFakeClient();
+			actual.team = client->edict->s.team;
+			actual.frags = client->edict->r.client->m_frags;
+			actual.ping = client->edict->r.client->m_ping;
+			actual.nameHash = 14695981039346656037ull;
+			for( const char *p = client->name; *p; ++p ) {
+				actual.nameHash = ( actual.nameHash ^ (uint8_t)*p ) * 1099511628211ull;
+			}
+		}
+
+		// clients are counted by all kinds of replies
+		if( ( seen->state >= CS_CONNECTING ) != ( actual.state >= CS_CONNECTING ) || seen->fake != actual.fake ) {
+			changedKinds |= SV_INFO_ALL_KINDS;
+		}
+		if( seen->team != actual.team || seen->frags != actual.frags ||
+			seen->ping != actual.ping || seen->nameHash != actual.nameHash ) {
+			changedKinds |= 1 << SV_INFO_STATUS;
+		}
+		*seen = actual;
+	}
+
+	for( int kind = 0; kind < SV_INFO_NUM_KINDS; kind++ ) {
+		if( changedKinds & ( 1 << kind ) ) {
+			sv_infoState.versions[kind]++;
+		}
+	}
+}
+
+/*
+* SV_GetCachedInfoString
+*/
+template <typename BuildFn>
+static const sv_infocache_t *SV_GetCachedInfoString( sv_infocache_t *cache, int kind, BuildFn &&buildFn ) {
+	const uint64_t version = sv_infoState.versions[kind];
+	if( !cache->valid || cache->version != version ) {
+		const char *string = buildFn();
+		cache->length = wsw::min( strlen( string ), sizeof( cache->string ) - 1 );
+		memcpy( cache->string, string, cache->length );
+		cache->string[cache->length] = '\0';
+		cache->version = version;
+		cache->valid = true;
+	}
+	return cache;
+}
+
+/*
+* SV_SendInfoResponse
+*
+* Sends an out-of-band datagram of the given pieces, truncated like Netchan_OutOfBandPrint() does
+*/
+static void SV_SendInfoResponse( const socket_t *socket, const netadr_t *address, std::initializer_list<wsw::StringView> pieces ) {
+	char message[MAX_PACKETLEN - 4];
+	size_t length = 0;
+	for( const wsw::StringView &piece: pieces ) {
+		const size_t pieceLength = wsw::min( piece.size(), sizeof( message ) - 1 - length );
+		memcpy( message + length, piece.data(), pieceLength );
+		length += pieceLength;
+	}
+	Netchan_OutOfBand( socket, address, length, (const uint8_t *)message );
+}
+
 static char *SV_LongInfoString( bool fullStatus ) {
 	static char status[MAX_MSGLEN - 16];
 
@@ -3952,13 +5757,7 @@ static void HandleOobCommand_Info( const socket_t *socket, const netadr_t *addre
 		}
 	}
 
-	int count = 0;
-	for( int i = 0; i < sv_maxclients->integer; i++ ) {
-		if( svs.clients[i].state >= CS_CONNECTED ) {
-			count++;
-		}
-	}
-
+	const int count = sv_infoState.numConnectedClients;
 	if( ( count == sv_maxclients->integer ) && !allow_full ) {
 		return;
 	}
@@ -3967,9 +5766,14 @@ static void HandleOobCommand_Info( const socket_t *socket, const netadr_t *addre
 		return;
 	}
 
-	if( const char *string = SV_ShortInfoString() ) {
-		Netchan_OutOfBandPrint( socket, address, "info\n%s", string );
+	if( !g_infoQueryLimiter.tryAcquire( address, Sys_Milliseconds() ) ) {
+		return;
 	}
+
+	const sv_infocache_t *cache = SV_GetCachedInfoString( &sv_shortInfoCache, SV_INFO_SHORT, []() {
+		return SV_ShortInfoString();
+	});
+	SV_SendInfoResponse( socket, address, { "info\n"_asView, wsw::StringView( cache->string, cache->length ) } );
 }
 
 static void SVC_SendInfoString( const socket_t *socket, const netadr_t *address, const char *requestType, const char *responseType, bool fullStatus, const CmdArgs &cmdArgs ) {
@@ -3992,10 +5796,18 @@ static void SVC_SendInfoString( const socket_t *socket, const netadr_t *address,
 	// if( SV_MM_IsLocked() )
 	//	return;
 
-	// send the same string that we would give for a status OOB command
-	if( const char *string = SV_LongInfoString( fullStatus ) ) {
-		Netchan_OutOfBandPrint( socket, address, "%s\n\\challenge\\%s%s", responseType, Cmd_Argv( 1 ), string );
+	if( !g_infoQueryLimiter.tryAcquire( address, Sys_Milliseconds() ) ) {
+		return;
 	}
+
+	// send the same string that we would give for a status OOB command
+	const sv_infocache_t *cache = SV_GetCachedInfoString( &sv_longInfoCache[fullStatus], fullStatus ? SV_INFO_STATUS : SV_INFO_LONG, [=]() {
+		return SV_LongInfoString( fullStatus );
+	});
+	SV_SendInfoResponse( socket, address, {
+		wsw::StringView( responseType ), "\n\\challenge\\"_asView, wsw::StringView( Cmd_Argv( 1 ) ),
+		wsw::StringView( cache->string, cache->length )
+	});
 }
 
 static void HandleOobCommand_GetInfo( const socket_t *socket, const netadr_t *address, const CmdArgs &cmdArgs ) {
@@ -4350,65 +6162,211 @@ static void HandleOobCommand_Rcon( const socket_t *socket, const netadr_t *addre
 			Q_strncatz( remaining, "\" ", sizeof( remaining ) );
 		}
 
-		SV_Cmd_ExecuteNow( remaining );
+		SV_Cmd_ExecuteNow( remaining );
+	}
+
+	Com_EndRedirect();
+}
+
+typedef struct {
+	const char *name;
+	void ( *func )( const socket_t *socket, const netadr_t *address, const CmdArgs & );
+} connectionless_cmd_t;
+
+static connectionless_cmd_t connectionless_cmds[] =
+	{
+		{ "ping", HandleOobCommand_Ping },
+		{ "ack", HandleOobCommand_Ack },
+		{ "info", HandleOobCommand_Info },
+		{ "getinfo", HandleOobCommand_GetInfo },
+		{ "getstatus", HandleOobCommand_GetStatus },
+		{ "getchallenge", HandleOobCommand_GetChallenge },
+		{ "connect", HandleOobCommand_Connect },
+		{ "rcon", HandleOobCommand_Rcon },
+
+		{ NULL, NULL }
+	};
+
+/*
+* SV_ConnectionlessPacket
+*
+* A connectionless packet has four leading 0xff
+* characters to distinguish it from a game channel.
+* Clients that are in the game can still send
+* connectionless packets.
+*/
+void SV_ConnectionlessPacket( const socket_t *socket, const netadr_t *address, msg_t *msg ) {
+
+	MSG_BeginReading( msg );
+	MSG_ReadInt32( msg );    // skip the -1 marker
+
+	static CmdArgsSplitter argsSplitter;
+	const CmdArgs &cmdArgs = argsSplitter.exec( wsw::StringView( MSG_ReadStringLine( msg ) ) );
+
+	Com_DPrintf( "Packet %s : %s\n", NET_AddressToString( address ), cmdArgs[0].data() );
+
+	for( const connectionless_cmd_t *cmd = connectionless_cmds; cmd->name; cmd++ ) {
+		if( !strcmp( cmdArgs[0].data(), cmd->name ) ) {
+			cmd->func( socket, address, cmdArgs );
+			return;
+		}
+	}
+
+	Com_DPrintf( "Bad connectionless packet from %s:\n%s\n", NET_AddressToString( address ), cmdArgs[0].data() );
+}
+
+#define SV_DEMO_DIR va( "demos/server%s%s", sv_demodir->string[0] ? "/" : "", sv_demodir->string[0] ? sv_demodir->string : "" )
+
+/*
+* DemoWriter
+*
+* Writes demo messages to the (possibly compressed) demo file on a dedicated thread.
+* Messages are copied to a non-blocking pipe so compression and disk stalls do not
+* affect server frames. If the pipe is full, the message is rejected and the caller
+* is expected to drop the demo.
+*/
+class DemoWriter {
+public:
+	explicit DemoWriter( int file );
+	~DemoWriter();
+
+	[[nodiscard]]
+	bool enqueueMessage( const msg_t *msg );
+
+	// Makes the thread skip writing pending messages, so it could be joined quickly
+	void cancel() { m_isCanceled.store( true, std::memory_order_relaxed ); }
+
+	void printStats() const;
+private:
+	struct WriteMessageCmd final : public PipeCmd {
+		DemoWriter *const m_writer;
+		const unsigned m_length;
+		const unsigned m_totalSize;
+
+		WriteMessageCmd( DemoWriter *writer, unsigned length, unsigned totalSize )
+			: m_writer( writer ), m_length( length ), m_totalSize( totalSize ) {}
+
+		[[nodiscard]]
+		auto exec() -> unsigned override {
+			m_writer->writeMessage( (const uint8_t *)this + sizeWithPadding<WriteMessageCmd>(), m_length );
+			return m_totalSize;
+		}
+	};
+
+	static void *threadFunc( void *arg );
+	static int pipeWaiterFn( qbufPipe_t *pipe, bool ) { return QBufPipe_ReadCmds( pipe ); }
+
+	void writeMessage( const uint8_t *data, unsigned length );
+
+	static constexpr size_t kPipeBufferSize = 4 * 1024 * 1024;
+
+	const int m_file;
+	qbufPipe_t *m_pipe { nullptr };
+	qthread_t *m_thread { nullptr };
+
+	uint64_t m_numMessagesEnqueued { 0 };
+	uint64_t m_numBytesEnqueued { 0 };
+	uint64_t m_maxQueuedBytes { 0 };
+
+	std::atomic<uint64_t> m_numMessagesWritten { 0 };
+	std::atomic<uint64_t> m_numBytesWritten { 0 };
+	std::atomic<bool> m_isCanceled { false };
+};
+
+static DemoWriter *g_demoWriter;
+
+DemoWriter::DemoWriter( int file ) : m_file( file ) {
+	// Don't block writes
+	m_pipe = QBufPipe_Create( kPipeBufferSize, 0 );
+	m_thread = QThread_Create( &DemoWriter::threadFunc, this );
+}
+
+DemoWriter::~DemoWriter() {
+	struct TerminateCmd final : public PipeCmd {
+		[[nodiscard]]
+		auto exec() -> unsigned override { return kResultTerminate; }
+	};
+
+	// The pipe does not block writes, so wait for the space explicitly
+	const unsigned numBytes = PipeCmd::sizeWithPadding<TerminateCmd>();
+	uint8_t *mem;
+	while( !( mem = QBufPipe_AcquireWritableBytes( m_pipe, numBytes ) ) ) {
+		QThread_Yield();
 	}
+	new( mem )TerminateCmd;
+	QBufPipe_SubmitWrittenBytes( m_pipe, numBytes );
 
-	Com_EndRedirect();
+	QThread_Join( m_thread );
+	QBufPipe_Destroy( &m_pipe );
 }
 
-typedef struct {
-	const char *name;
-	void ( *func )( const socket_t *socket, const netadr_t *address, const CmdArgs & );
-} connectionless_cmd_t;
-
-static connectionless_cmd_t connectionless_cmds[] =
-	{
-		{ "ping", HandleOobCommand_Ping },
-		{ "ack", HandleOobCommand_Ack },
-		{ "info", HandleOobCommand_Info },
-		{ "getinfo", HandleOobCommand_GetInfo },
-		{ "getstatus", HandleOobCommand_GetStatus },
-		{ "getchallenge", HandleOobCommand_GetChallenge },
-		{ "connect", HandleOobCommand_Connect },
-		{ "rcon", HandleOobCommand_Rcon },
+void *DemoWriter::threadFunc( void *arg ) {
+	auto *const writer = (DemoWriter *)arg;
+	QBufPipe_Wait( writer->m_pipe, &DemoWriter::pipeWaiterFn, 100 );
+	return nullptr;
+}
 
-		{ NULL, NULL }
-	};
+bool DemoWriter::enqueueMessage( const msg_t *msg ) {
+	const auto length = (unsigned)msg->cursize;
+	if( !length ) {
+		return true;
+	}
 
-/*
-* SV_ConnectionlessPacket
-*
-* A connectionless packet has four leading 0xff
-* characters to distinguish it from a game channel.
-* Clients that are in the game can still send
-* connectionless packets.
-*/
-void SV_ConnectionlessPacket( const socket_t *socket, const netadr_t *address, msg_t *msg ) {
+	constexpr unsigned headerSize = PipeCmd::sizeWithPadding<WriteMessageCmd>();
+	const unsigned paddedLength = ( length + PipeCmd::kAlignment - 1 ) & ~( PipeCmd::kAlignment - 1 );
+	const unsigned totalSize = headerSize + paddedLength;
 
-	MSG_BeginReading( msg );
-	MSG_ReadInt32( msg );    // skip the -1 marker
+	uint8_t *const mem = QBufPipe_AcquireWritableBytes( m_pipe, totalSize );
+	if( !mem ) {
+		return false;
+	}
 
-	static CmdArgsSplitter argsSplitter;
-	const CmdArgs &cmdArgs = argsSplitter.exec( wsw::StringView( MSG_ReadStringLine( msg ) ) );
+	new( mem )WriteMessageCmd( this, length, totalSize );
+	std::memcpy( mem + headerSize, msg->data, length );
+	QBufPipe_SubmitWrittenBytes( m_pipe, totalSize );
 
-	Com_DPrintf( "Packet %s : %s\n", NET_AddressToString( address ), cmdArgs[0].data() );
+	m_numMessagesEnqueued++;
+	m_numBytesEnqueued += length;
+	m_maxQueuedBytes = std::max( m_maxQueuedBytes, m_numBytesEnqueued - m_numBytesWritten.load( std::memory_order_relaxed ) );
+	return true;
+}
 
-	for( const connectionless_cmd_t *cmd = connectionless_cmds; cmd->name; cmd++ ) {
-		if( !strcmp( cmdArgs[0].data(), cmd->name ) ) {
-			cmd->func( socket, address, cmdArgs );
-			return;
-		}
+void DemoWriter::writeMessage( const uint8_t *data, unsigned length ) {
+	if( !m_isCanceled.load( std::memory_order_relaxed ) ) {
+		msg_t msg;
+		MSG_Init( &msg, const_cast<uint8_t *>( data ), length );
+		msg.cursize = length;
+		SNAP_RecordDemoMessage( m_file, &msg, 0 );
 	}
+	m_numMessagesWritten.fetch_add( 1, std::memory_order_relaxed );
+	m_numBytesWritten.fetch_add( length, std::memory_order_relaxed );
+}
 
-	Com_DPrintf( "Bad connectionless packet from %s:\n%s\n", NET_AddressToString( address ), cmdArgs[0].data() );
+void DemoWriter::printStats() const {
+	const uint64_t numMessagesWritten = m_numMessagesWritten.load( std::memory_order_relaxed );
+	const uint64_t numBytesWritten = m_numBytesWritten.load( std::memory_order_relaxed );
+	Com_Printf( "Queued: %" PRIu64 " messages, %" PRIu64 " bytes (max %" PRIu64 " bytes)\n",
+				m_numMessagesEnqueued - numMessagesWritten, m_numBytesEnqueued - numBytesWritten, m_maxQueuedBytes );
+	Com_Printf( "Written: %" PRIu64 " messages, %" PRIu64 " bytes\n", numMessagesWritten, numBytesWritten );
 }
 
-#define SV_DEMO_DIR va( "demos/server%s%s", sv_demodir->string[0] ? "/" : "", sv_demodir->string[0] ? sv_demodir->string : "" )
+static void SV_DemoWriterStats_f( const CmdArgs & ) {
+	if( g_demoWriter ) {
+		g_demoWriter->printStats();
+	} else {
+		Com_Printf( "No server demo recording in progress\n" );
+	}
+}
+
+static void SV_Demo_Stop( bool cancel, bool silent );
 
 static void SV_Demo_WriteMessage( msg_t *msg ) {
-	assert( svs.demo.file );
-	if( svs.demo.file ) {
-		SNAP_RecordDemoMessage( svs.demo.file, msg, 0 );
+	assert( svs.demo.file && g_demoWriter );
+	if( g_demoWriter ) {
+		if( !g_demoWriter->enqueueMessage( msg ) ) {
+			Com_Printf( S_COLOR_YELLOW "The demo writer queue is full, dropping the server demo\n" );
+			SV_Demo_Stop( true, false );
+		}
 	}
 }
 
@@ -4439,6 +6397,14 @@ void SV_Demo_WriteSnap() {
 		uint8_t msg_buffer[MAX_MSGLEN];
 		MSG_Init( &msg, msg_buffer, sizeof( msg_buffer ) );
 
+		// write non-delta frames periodically so demo players don't have to parse everything when seeking
+		if( svs.gametime >= svs.demo.keyframetime + SV_DEMO_KEYFRAME_INTERVAL ) {
+			svs.demo.client.nodelta = true;
+		}
+		if( svs.demo.client.nodelta ) {
+			svs.demo.keyframetime = svs.gametime;
+		}
+
 		SV_BuildClientFrameSnap( &svs.demo.client );
 
 		SV_WriteFrameSnapToClient( &svs.demo.client, &msg );
@@ -4462,8 +6428,9 @@ static void SV_Demo_InitClient() {
 	svs.demo.client.reliableSent        = 0;
 
 	for( auto &cmd: svs.demo.client.reliableCommands ) {
-		cmd.clear();
+		cmd = reliable_command_t {};
 	}
+	svs.demo.client.localCommandsHead = 0;
 
 	svs.demo.client.lastframe = sv.framenum - 1;
 	svs.demo.client.nodelta   = false;
@@ -4539,6 +6506,9 @@ void SV_Demo_Start_f( const CmdArgs &cmdArgs ) {
 				svs.demo.localtime = time( nullptr );
 				SV_Demo_WriteStartMessages();
 
+				// further messages are written by a background thread
+				g_demoWriter = new DemoWriter( svs.demo.file );
+
 				// write one nodelta frame
 				svs.demo.client.nodelta = true;
 				SV_Demo_WriteSnap();
@@ -4556,6 +6526,15 @@ static void SV_Demo_Stop( bool cancel, bool silent ) {
 		return;
 	}
 
+	// wait for the writer thread (make it skip pending messages if the demo is going to be deleted)
+	if( g_demoWriter ) {
+		if( cancel ) {
+			g_demoWriter->cancel();
+		}
+		delete g_demoWriter;
+		g_demoWriter = nullptr;
+	}
+
 	if( cancel ) {
 		Com_Printf( "Canceled server demo recording: %s\n", svs.demo.filename );
 	} else {
@@ -4599,7 +6578,7 @@ static void SV_Demo_Stop( bool cancel, bool silent ) {
 	}
 
 	svs.demo.localtime = 0;
-	svs.demo.basetime = svs.demo.duration = 0;
+	svs.demo.basetime = svs.demo.duration = svs.demo.keyframetime = 0;
 
 	SNAP_FreeClientFrames( &svs.demo.client );
 
@@ -4998,6 +6977,517 @@ static void SV_CvarCheck_f( const CmdArgs &cmdArgs ) {
 	}
 }
 
+/*
+* SV_Benchmark_f
+*/
+static void SV_Benchmark_f( const CmdArgs &cmdArgs ) {
+	if( Cmd_Argc() < 4 ) {
+		Com_Printf( "Usage: %s <map> <numBots> <numFrames> [reportName]\n", Cmd_Argv( 0 ) );
+		Com_Printf( "Runs the given number of server frames as fast as possible, writes benchmarks/<reportName>.json and quits\n" );
+		return;
+	}
+
+	if( !dedicated->integer ) {
+		Com_Printf( "Benchmarks can only be run by a dedicated server\n" );
+		return;
+	}
+
+	if( g_serverBenchmark ) {
+		Com_Printf( "A benchmark is already pending\n" );
+		return;
+	}
+
+	bool found = false;
+	char mapname[MAX_QPATH];
+	Q_strncpyz( mapname, Cmd_Argv( 1 ), sizeof( mapname ) );
+	if( ML_ValidateFilename( mapname ) ) {
+		COM_StripExtension( mapname );
+		if( !ML_FilenameExists( mapname ) ) {
+			ML_Update();
+		}
+		found = ML_FilenameExists( mapname );
+	}
+
+	if( !found ) {
+		Com_Printf( "Couldn't find map: %s\n", Cmd_Argv( 1 ) );
+		return;
+	}
+
+	const auto maybeNumBots   = wsw::toNum<unsigned>( wsw::StringView( Cmd_Argv( 2 ) ) );
+	const auto maybeNumFrames = wsw::toNum<unsigned>( wsw::StringView( Cmd_Argv( 3 ) ) );
+	if( !maybeNumBots || *maybeNumBots >= (unsigned)sv_maxclients->integer || !maybeNumFrames || !*maybeNumFrames ) {
+		Com_Printf( "Invalid number of bots or frames (the number of bots must be less than sv_maxclients)\n" );
+		return;
+	}
+
+	char reportname[MAX_QPATH / 2];
+	Q_strncpyz( reportname, Cmd_Argc() > 4 ? Cmd_Argv( 4 ) : "server", sizeof( reportname ) );
+	COM_SanitizeFilePath( reportname );
+	if( !COM_ValidateRelativeFilename( reportname ) ) {
+		Com_Printf( "Invalid report name: %s\n", reportname );
+		return;
+	}
+
+	g_serverBenchmark = new ServerBenchmark( wsw::StringView( mapname ), *maybeNumBots, *maybeNumFrames, wsw::StringView( reportname ) );
+
+	// Lets the game exceed the regular limit of bots
+	Cvar_ForceSet( "sv_benchmark", "1" );
+	Cvar_ForceSet( "g_numbots", va( "%u", *maybeNumBots ) );
+	SV_Cbuf_AppendCommand( va( "map %s\n", mapname ) );
+}
+
+#ifndef PUBLIC_BUILD
+
+typedef struct {
+	vec3_t start, end;
+	vec3_t mins, maxs;
+	vec3_t hullOrigin;
+	vec3_t hullMins, hullMaxs;
+} sv_cmstressquery_t;
+
+/*
+* SV_CMStressHashTrace
+*/
+static uint64_t SV_CMStressHashTrace( uint64_t hash, const trace_t *tr ) {
+	const float floats[8] = {
+		tr->fraction, tr->endpos[0], tr->endpos[1], tr->endpos[2],
+		tr->plane.normal[0], tr->plane.normal[1], tr->plane.normal[2], tr->plane.dist
+	};
+	const int ints[5] = { tr->surfFlags, tr->contents, tr->shaderNum, tr->allsolid, tr->startsolid };
+	const auto *bytes = (const uint8_t *)floats;
+	for( size_t i = 0; i < sizeof( floats ); ++i ) {
+		hash = ( hash ^ bytes[i] ) * 0x100000001B3ull;
+	}
+	bytes = (const uint8_t *)ints;
+	for( size_t i = 0; i < sizeof( ints ); ++i ) {
+		hash = ( hash ^ bytes[i] ) * 0x100000001B3ull;
+	}
+	return hash;
+}
+
+/*
+* SV_CMStressRunQuery
+*
+* Performs every kind of reentrant collision query and reduces results to a single hash
+*/
+static uint64_t SV_CMStressRunQuery( const sv_cmstressquery_t *q, CMShapeList *shapeList, uint8_t *pvs, int pvsSize ) {
+	cmodel_state_t *const cms = svs.cms;
+	uint64_t hash = 0xCBF29CE484222325ull;
+
+	vec3_t sweepMins, sweepMaxs;
+	ClearBounds( sweepMins, sweepMaxs );
+	AddPointToBounds( q->start, sweepMins, sweepMaxs );
+	AddPointToBounds( q->end, sweepMins, sweepMaxs );
+	VectorAdd( sweepMins, q->mins, sweepMins );
+	VectorAdd( sweepMaxs, q->maxs, sweepMaxs );
+
+	int leafNums[64], topNode;
+	const int numLeafs = CM_BoxLeafnums( cms, sweepMins, sweepMaxs, leafNums, (int)std::size( leafNums ), &topNode );
+	for( int i = 0; i < numLeafs; ++i ) {
+		hash = ( hash ^ (uint32_t)leafNums[i] ) * 0x100000001B3ull;
+	}
+	hash = ( hash ^ (uint32_t)topNode ) * 0x100000001B3ull;
+
+	trace_t trace;
+	CM_TransformedBoxTrace( cms, &trace, q->start, q->end, q->mins, q->maxs, nullptr, MASK_PLAYERSOLID, nullptr, nullptr );
+	hash = SV_CMStressHashTrace( hash, &trace );
+
+	CMHullModelStorage hullStorage;
+	const struct cmodel_s *hullModel = CM_OctagonModelForBBox( cms, q->hullMins, q->hullMaxs, &hullStorage );
+	CM_TransformedBoxTrace( cms, &trace, q->start, q->end, q->mins, q->maxs, hullModel, MASK_ALL, q->hullOrigin, vec3_origin );
+	hash = SV_CMStressHashTrace( hash, &trace );
+
+	CM_BuildShapeList( cms, shapeList, sweepMins, sweepMaxs, MASK_SOLID );
+	hash = ( hash ^ (uint32_t)CM_GetNumShapesInShapeList( shapeList ) ) * 0x100000001B3ull;
+	CM_ClipToShapeList( cms, shapeList, &trace, q->start, q->end, q->mins, q->maxs, MASK_SOLID );
+	hash = SV_CMStressHashTrace( hash, &trace );
+
+	memset( pvs, 0, pvsSize );
+	CM_MergePVS( cms, q->start, pvs );
+	for( int i = 0; i < pvsSize; ++i ) {
+		hash = ( hash ^ pvs[i] ) * 0x100000001B3ull;
+	}
+
+	return hash;
+}
+
+/*
+* SV_CMStressTest_f
+*
+* Hammers collision queries of the current map from task system workers
+* and checks that results match ones that are computed serially
+*/
+static void SV_CMStressTest_f( const CmdArgs &cmdArgs ) {
+	if( sv.state != ss_game || !svs.cms ) {
+		Com_Printf( "The stress test requires a running map\n" );
+		return;
+	}
+
+	unsigned numQueries = 4096, numPasses = 8;
+	if( Cmd_Argc() > 1 ) {
+		const auto maybeNumQueries = wsw::toNum<unsigned>( wsw::StringView( Cmd_Argv( 1 ) ) );
+		if( !maybeNumQueries || !*maybeNumQueries || *maybeNumQueries > TaskSystem::kMaxTaskEntries / 2 ) {
+			Com_Printf( "Usage: %s [numQueries] [numPasses]\n", Cmd_Argv( 0 ) );
+			return;
+		}
+		numQueries = *maybeNumQueries;
+	}
+	if( Cmd_Argc() > 2 ) {
+		const auto maybeNumPasses = wsw::toNum<unsigned>( wsw::StringView( Cmd_Argv( 2 ) ) );
+		if( !maybeNumPasses || !*maybeNumPasses ) {
+			Com_Printf( "Usage: %s [numQueries] [numPasses]\n", Cmd_Argv( 0 ) );
+			return;
+		}
+		numPasses = *maybeNumPasses;
+	}
+
+	vec3_t worldMins, worldMaxs;
+	CM_InlineModelBounds( svs.cms, CM_InlineModel( svs.cms, 0 ), worldMins, worldMaxs );
+
+	wsw::RandomGenerator rng;
+	std::vector<sv_cmstressquery_t> queries( numQueries );
+	for( sv_cmstressquery_t &q: queries ) {
+		for( int i = 0; i < 3; ++i ) {
+			q.start[i] = rng.nextFloat( worldMins[i], worldMaxs[i] );
+			q.end[i] = q.start[i] + rng.nextFloat( -768.0f, +768.0f );
+			q.maxs[i] = rng.nextBounded( 3 ) ? rng.nextFloat( 0.0f, 32.0f ) : 0.0f;
+			q.mins[i] = -q.maxs[i];
+			q.hullOrigin[i] = q.start[i] + rng.nextFloat( 0.0f, 1.0f ) * ( q.end[i] - q.start[i] );
+			q.hullMaxs[i] = rng.nextFloat( 8.0f, 48.0f );
+			q.hullMins[i] = -rng.nextFloat( 8.0f, 48.0f );
+		}
+	}
+
+	const int pvsSize = CM_ClusterRowSize( svs.cms );
+
+	try {
+		unsigned numPhysicalProcessors = 0, numLogicalProcessors = 0;
+		unsigned numExtraThreads = 3;
+		if( Sys_GetNumberOfProcessors( &numPhysicalProcessors, &numLogicalProcessors ) && numLogicalProcessors > 1 ) {
+			numExtraThreads = numLogicalProcessors - 1;
+		}
+		TaskSystem taskSystem( { .numExtraThreads = numExtraThreads } );
+
+		struct WorkerScratch {
+			CMShapeList *shapeList { nullptr };
+			std::vector<uint8_t> pvs;
+		};
+		std::vector<WorkerScratch> scratchOfWorkers( taskSystem.getNumberOfWorkers() );
+		bool allocationFailed = false;
+		for( WorkerScratch &scratch: scratchOfWorkers ) {
+			scratch.pvs.resize( pvsSize + 4 );
+			if( !( scratch.shapeList = CM_AllocShapeList( svs.cms ) ) ) {
+				allocationFailed = true;
+			}
+		}
+
+		unsigned numMismatches = 0;
+		const int64_t startedAt = Sys_Milliseconds();
+		if( !allocationFailed ) {
+			std::vector<uint64_t> expectedHashes( numQueries );
+			for( unsigned i = 0; i < numQueries; ++i ) {
+				WorkerScratch &scratch = scratchOfWorkers.front();
+				expectedHashes[i] = SV_CMStressRunQuery( &queries[i], scratch.shapeList, scratch.pvs.data(), pvsSize );
+			}
+
+			std::vector<uint64_t> actualHashes( numQueries );
+			for( unsigned pass = 0; pass < numPasses; ++pass ) {
+				auto fn = [&]( unsigned workerIndex, unsigned queryIndex ) {
+					WorkerScratch &scratch = scratchOfWorkers[workerIndex];
+					actualHashes[queryIndex] = SV_CMStressRunQuery( &queries[queryIndex], scratch.shapeList,
+																	scratch.pvs.data(), pvsSize );
+				};
+				const TaskSystem::ExecutionHandle executionHandle = taskSystem.startExecution();
+				(void)taskSystem.addForIndicesInRange( { 0u, numQueries }, std::span<const TaskHandle>(), std::move( fn ) );
+				if( !taskSystem.awaitCompletion( executionHandle ) ) {
+					Com_Printf( S_COLOR_RED "The task system has failed to execute the stress test\n" );
+					break;
+				}
+				for( unsigned i = 0; i < numQueries; ++i ) {
+					numMismatches += expectedHashes[i] != actualHashes[i];
+				}
+			}
+		}
+
+		for( WorkerScratch &scratch: scratchOfWorkers ) {
+			CM_FreeShapeList( svs.cms, scratch.shapeList );
+		}
+
+		if( allocationFailed ) {
+			Com_Printf( S_COLOR_RED "Failed to allocate shape lists\n" );
+		} else if( numMismatches ) {
+			Com_Printf( S_COLOR_RED "%u of %u concurrent query results did not match serial ones\n",
+						numMismatches, numQueries * numPasses );
+		} else {
+			Com_Printf( "%u concurrent queries on %u workers matched serial results (%d millis)\n",
+						numQueries * numPasses, (unsigned)scratchOfWorkers.size(), (int)( Sys_Milliseconds() - startedAt ) );
+		}
+	} catch( ... ) {
+		Com_Printf( S_COLOR_RED "Failed to run the stress test\n" );
+	}
+}
+
+static constexpr unsigned kCMBenchMaxBatchSize = 64;
+
+/*
+* SV_CMBenchNextBatch
+*
+* Copies consecutive records that can be traced in a single batch
+*/
+static size_t SV_CMBenchNextBatch( std::span<const CMTraceCaptureRecord> records, size_t first,
+								   vec3_t *starts, vec3_t *ends ) {
+	const CMTraceCaptureRecord &head = records[first];
+	size_t count = 0;
+	for( size_t i = first; i < records.size() && count < kCMBenchMaxBatchSize; ++i, ++count ) {
+		const CMTraceCaptureRecord &r = records[i];
+		if( r.contentMask != head.contentMask || !VectorCompare( r.mins, head.mins ) || !VectorCompare( r.maxs, head.maxs ) ) {
+			break;
+		}
+		VectorCopy( r.start, starts[count] );
+		VectorCopy( r.end, ends[count] );
+	}
+	return count;
+}
+
+/*
+* SV_CMBenchCheckBatches
+*
+* Returns the number of batched traces that differ from separately traced ones
+*/
+static unsigned SV_CMBenchCheckBatches( cmodel_state_t *cms, std::span<const CMTraceCaptureRecord> records ) {
+	vec3_t starts[kCMBenchMaxBatchSize], ends[kCMBenchMaxBatchSize];
+	trace_t traces[kCMBenchMaxBatchSize];
+	unsigned numMismatches = 0;
+	for( size_t first = 0; first < records.size(); ) {
+		const CMTraceCaptureRecord &head = records[first];
+		const size_t count = SV_CMBenchNextBatch( records, first, starts, ends );
+		CM_TraceBatch( cms, traces, starts, ends, (int)count, head.mins, head.maxs, head.contentMask );
+		for( size_t i = 0; i < count; ++i ) {
+			trace_t trace;
+			CM_TransformedBoxTrace( cms, &trace, starts[i], ends[i], head.mins, head.maxs, nullptr, head.contentMask, nullptr, nullptr );
+			if( SV_CMStressHashTrace( 0, &trace ) != SV_CMStressHashTrace( 0, &traces[i] ) ) {
+				numMismatches++;
+			}
+		}
+		first += count;
+	}
+	return numMismatches;
+}
+
+/*
+* SV_CMBenchRunPass
+*
+* Returns the hash of results, loop timings are accumulated in the given array (point, box, shape list ones).
+* Records are expected to be partitioned by kind so every kind is timed as a whole loop.
+*/
+static uint64_t SV_CMBenchRunPass( cmodel_state_t *cms, CMShapeList *shapeList,
+								   std::span<const CMTraceCaptureRecord> pointRecords,
+								   std::span<const CMTraceCaptureRecord> boxRecords, uint64_t *nanos ) {
+	using Clock = std::chrono::steady_clock;
+	uint64_t hash = 0xCBF29CE484222325ull;
+	trace_t trace;
+
+	const std::span<const CMTraceCaptureRecord> recordsOfKinds[2] = { pointRecords, boxRecords };
+	for( int kind = 0; kind < 2; ++kind ) {
+		const Clock::time_point loopStartedAt = Clock::now();
+		for( const CMTraceCaptureRecord &r: recordsOfKinds[kind] ) {
+			CM_TransformedBoxTrace( cms, &trace, r.start, r.end, r.mins, r.maxs, nullptr, r.contentMask, nullptr, nullptr );
+			hash = SV_CMStressHashTrace( hash, &trace );
+		}
+		nanos[kind] += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>( Clock::now() - loopStartedAt ).count();
+	}
+
+	const Clock::time_point loopStartedAt = Clock::now();
+	for( const std::span<const CMTraceCaptureRecord> &records: recordsOfKinds ) {
+		for( const CMTraceCaptureRecord &r: records ) {
+			vec3_t sweepMins, sweepMaxs;
+			ClearBounds( sweepMins, sweepMaxs );
+			AddPointToBounds( r.start, sweepMins, sweepMaxs );
+			AddPointToBounds( r.end, sweepMins, sweepMaxs );
+			VectorAdd( sweepMins, r.mins, sweepMins );
+			VectorAdd( sweepMaxs, r.maxs, sweepMaxs );
+
+			CM_BuildShapeList( cms, shapeList, sweepMins, sweepMaxs, r.contentMask );
+			CM_ClipToShapeList( cms, shapeList, &trace, r.start, r.end, r.mins, r.maxs, r.contentMask );
+			hash = SV_CMStressHashTrace( hash, &trace );
+		}
+	}
+	nanos[2] += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>( Clock::now() - loopStartedAt ).count();
+
+	vec3_t starts[kCMBenchMaxBatchSize], ends[kCMBenchMaxBatchSize];
+	trace_t traces[kCMBenchMaxBatchSize];
+	const Clock::time_point batchesStartedAt = Clock::now();
+	for( const std::span<const CMTraceCaptureRecord> &records: recordsOfKinds ) {
+		for( size_t first = 0; first < records.size(); ) {
+			const CMTraceCaptureRecord &head = records[first];
+			const size_t count = SV_CMBenchNextBatch( records, first, starts, ends );
+			CM_TraceBatch( cms, traces, starts, ends, (int)count, head.mins, head.maxs, head.contentMask );
+			for( size_t i = 0; i < count; ++i ) {
+				hash = SV_CMStressHashTrace( hash, &traces[i] );
+			}
+			first += count;
+		}
+	}
+	nanos[3] += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>( Clock::now() - batchesStartedAt ).count();
+
+	return hash;
+}
+
+/*
+* SV_CMBench_f
+*
+* Replays traces captured by the game "tracecapture" command against a separately loaded map
+* and reports timings of every collision code path that is supported by the CPU
+*/
+static void SV_CMBench_f( const CmdArgs &cmdArgs ) {
+	if( Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: %s <capturefile> [numPasses] [mapname]\n", Cmd_Argv( 0 ) );
+		return;
+	}
+
+	unsigned numPasses = 10;
+	if( Cmd_Argc() > 2 ) {
+		const auto maybeNumPasses = wsw::toNum<unsigned>( wsw::StringView( Cmd_Argv( 2 ) ) );
+		if( !maybeNumPasses || !*maybeNumPasses ) {
+			Com_Printf( "Usage: %s <capturefile> [numPasses] [mapname]\n", Cmd_Argv( 0 ) );
+			return;
+		}
+		numPasses = *maybeNumPasses;
+	}
+
+	char filename[MAX_QPATH];
+	Q_strncpyz( filename, Cmd_Argv( 1 ), sizeof( filename ) );
+	COM_DefaultExtension( filename, ".cmt", sizeof( filename ) );
+
+	uint8_t *data = nullptr;
+	const int length = FS_LoadFile( filename, (void **)&data, nullptr, 0 );
+	if( !data ) {
+		Com_Printf( "Failed to load %s\n", filename );
+		return;
+	}
+
+	CMTraceCaptureHeader header;
+	if( length < (int)sizeof( header ) ) {
+		Com_Printf( "%s is not a trace capture file\n", filename );
+		FS_FreeFile( data );
+		return;
+	}
+	memcpy( &header, data, sizeof( header ) );
+	if( memcmp( header.magic, CM_TRACE_CAPTURE_MAGIC, sizeof( header.magic ) ) != 0 ) {
+		Com_Printf( "%s is not a trace capture file\n", filename );
+		FS_FreeFile( data );
+		return;
+	}
+	if( header.version != CM_TRACE_CAPTURE_VERSION ) {
+		Com_Printf( "%s has an unsupported version %d\n", filename, (int)header.version );
+		FS_FreeFile( data );
+		return;
+	}
+
+	const size_t numRecords = ( length - sizeof( header ) ) / sizeof( CMTraceCaptureRecord );
+	std::vector<CMTraceCaptureRecord> pointRecords, boxRecords;
+	for( size_t i = 0; i < numRecords; ++i ) {
+		CMTraceCaptureRecord r;
+		memcpy( &r, data + sizeof( header ) + i * sizeof( CMTraceCaptureRecord ), sizeof( CMTraceCaptureRecord ) );
+		// traces that pass the world entity do not touch the world model
+		if( r.passEntNum == 0 ) {
+			continue;
+		}
+		if( VectorCompare( r.mins, vec3_origin ) && VectorCompare( r.maxs, vec3_origin ) ) {
+			pointRecords.push_back( r );
+		} else {
+			boxRecords.push_back( r );
+		}
+	}
+	FS_FreeFile( data );
+
+	header.mapName[sizeof( header.mapName ) - 1] = '\0';
+	const char *mapname = Cmd_Argc() > 3 ? Cmd_Argv( 3 ) : header.mapName;
+	char mappath[MAX_QPATH];
+	Q_snprintfz( mappath, sizeof( mappath ), "maps/%s.bsp", mapname );
+	COM_SanitizeFilePath( mappath );
+	if( !COM_ValidateRelativeFilename( mappath ) || FS_FOpenFile( mappath, nullptr, FS_READ ) == -1 ) {
+		Com_Printf( "Failed to find %s\n", mappath );
+		return;
+	}
+
+	// The map is loaded in a separate instance so the benchmark does not need a running game
+	cmodel_state_t *cms = CM_New();
+	CM_AddReference( cms );
+	unsigned checksum;
+	CM_LoadMap( cms, mappath, false, &checksum );
+
+	Com_Printf( "Replaying %u traces of %s, %u passes\n", (unsigned)numRecords, mappath, numPasses );
+
+	static const char *const kOpsNames[] = { "generic", "sse42", "avx" };
+	static const char *const kKindNames[] = { "point", "box", "shapelist", "batched" };
+	std::optional<uint64_t> referenceHash;
+	for( const char *opsName: kOpsNames ) {
+		if( !CM_SelectOps( cms, opsName ) ) {
+			Com_Printf( "%s: not supported by the CPU\n", opsName );
+			continue;
+		}
+
+		CMShapeList *shapeList = CM_AllocShapeList( cms );
+		if( !shapeList ) {
+			Com_Printf( S_COLOR_RED "Failed to allocate a shape list\n" );
+			break;
+		}
+
+		uint64_t nanos[4] = { 0, 0, 0, 0 };
+		uint64_t hash = 0;
+		for( unsigned pass = 0; pass < numPasses; ++pass ) {
+			hash = SV_CMBenchRunPass( cms, shapeList, pointRecords, boxRecords, nanos );
+		}
+		CM_FreeShapeList( cms, shapeList );
+
+		const size_t numReplayedRecords = pointRecords.size() + boxRecords.size();
+		const size_t numRecordsOfKinds[4] = { pointRecords.size(), boxRecords.size(), numReplayedRecords, numReplayedRecords };
+		for( int kind = 0; kind < 4; ++kind ) {
+			const unsigned count = (unsigned)numRecordsOfKinds[kind] * numPasses;
+			const double nanosPerTrace = count ? (double)nanos[kind] / (double)count : 0.0;
+			Com_Printf( "%s: %u %s traces, %.1f ns per trace\n", opsName, count, kKindNames[kind], nanosPerTrace );
+		}
+
+		// Batched traces must be exactly the same as separate ones
+		const unsigned numMismatches = SV_CMBenchCheckBatches( cms, pointRecords ) + SV_CMBenchCheckBatches( cms, boxRecords );
+		if( numMismatches ) {
+			Com_Printf( S_COLOR_YELLOW "%s: %u batched traces do not match separate ones\n", opsName, numMismatches );
+		}
+
+		if( !referenceHash ) {
+			referenceHash = hash;
+		} else if( *referenceHash != hash ) {
+			Com_Printf( S_COLOR_YELLOW "%s: results do not match ones of the first code path\n", opsName );
+		}
+	}
+
+	CM_ReleaseReference( cms );
+}
+
+/*
+* SV_CheckDeltaCodecs_f
+*
+* Checks generated delta codecs against the fields table interpreter using random states
+*/
+static void SV_CheckDeltaCodecs_f( const CmdArgs &cmdArgs ) {
+	unsigned numIterations = 10000;
+	if( Cmd_Argc() > 1 ) {
+		const auto maybeNumIterations = wsw::toNum<unsigned>( wsw::StringView( Cmd_Argv( 1 ) ) );
+		if( !maybeNumIterations || !*maybeNumIterations ) {
+			Com_Printf( "Usage: %s [numIterations]\n", Cmd_Argv( 0 ) );
+			return;
+		}
+		numIterations = *maybeNumIterations;
+	}
+
+	if( !MSG_CheckDeltaCodecs( numIterations ) ) {
+		Com_Printf( S_COLOR_RED "Delta codecs do not match the interpreter\n" );
+	}
+}
+
+#endif
+
 void SV_InitOperatorCommands() {
 	SV_Cmd_Register( "heartbeat"_asView, SV_Heartbeat_f );
 	SV_Cmd_Register( "serverinfo"_asView, SV_Serverinfo_f );
@@ -5016,6 +7506,17 @@ void SV_InitOperatorCommands() {
 	SV_Cmd_Register( "purelist"_asView, SV_PureList_f );
 
 	SV_Cmd_Register( "cvarcheck"_asView, SV_CvarCheck_f );
+
+	SV_Cmd_Register( "deltacachestats"_asView, SV_DeltaCacheStats_f );
+	SV_Cmd_Register( "demowriterstats"_asView, SV_DemoWriterStats_f );
+
+	SV_Cmd_Register( "benchmark"_asView, SV_Benchmark_f, ML_CompleteBuildList );
+
+#ifndef PUBLIC_BUILD
+	SV_Cmd_Register( "cmstresstest"_asView, SV_CMStressTest_f );
+	SV_Cmd_Register( "cmbench"_asView, SV_CMBench_f );
+	SV_Cmd_Register( "checkdeltacodecs"_asView, SV_CheckDeltaCodecs_f );
+#endif
 }
 
 void SV_ShutdownOperatorCommands() {
@@ -5036,6 +7537,17 @@ void SV_ShutdownOperatorCommands() {
 	SV_Cmd_Unregister( "purelist"_asView );
 
 	SV_Cmd_Unregister( "cvarcheck"_asView );
+
+	SV_Cmd_Unregister( "deltacachestats"_asView );
+	SV_Cmd_Unregister( "demowriterstats"_asView );
+
+	SV_Cmd_Unregister( "benchmark"_asView );
+
+#ifndef PUBLIC_BUILD
+	SV_Cmd_Unregister( "cmstresstest"_asView );
+	SV_Cmd_Unregister( "cmbench"_asView );
+	SV_Cmd_Unregister( "checkdeltacodecs"_asView );
+#endif
 }
 
 void SV_MOTD_SetMOTD( const char *motd ) {
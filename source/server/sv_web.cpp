@@ -24,7 +24,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #ifdef HTTP_SUPPORT
 
-#define MAX_INCOMING_HTTP_CONNECTIONS           48
+#define MAX_INCOMING_HTTP_CONNECTIONS           256
 #define MAX_INCOMING_HTTP_CONNECTIONS_PER_ADDR  3
 
 #define MAX_INCOMING_CONTENT_LENGTH             0x2800
@@ -33,6 +33,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define INCOMING_HTTP_CONNECTION_SEND_TIMEOUT   15 // seconds
 
 #define HTTP_SERVER_SLEEP_TIME                  50 // milliseconds
+#define HTTP_SERVER_CHECK_INTERVAL              HTTP_SERVER_SLEEP_TIME // milliseconds
 
 typedef enum {
 	HTTP_CONN_STATE_NONE = 0,
@@ -112,6 +113,17 @@ typedef struct sv_http_connection_s {
 
 	int64_t last_active;
 
+	// readiness of the socket as reported by the poller,
+	// reset once an operation on the socket would block
+	bool readable;
+	bool writable;
+
+	// transfer stats
+	int64_t open_time;
+	int64_t resp_send_time;
+	uint64_t bytes_received;
+	uint64_t bytes_sent;
+
 	sv_http_request_t request;
 	sv_http_response_t response;
 
@@ -137,6 +149,9 @@ static sv_http_connection_t sv_http_connection_headnode, *sv_free_http_connectio
 static socket_t sv_socket_http;
 static socket_t sv_socket_http6;
 
+static net_poller_t *sv_http_poller;
+static int64_t sv_http_last_check_time;
+
 static netadr_t sv_web_upstream_addr;
 
 static uint64_t sv_http_request_autoicr;
@@ -262,6 +277,9 @@ static sv_http_connection_t *SV_Web_AllocConnection( void ) {
 	con->state = HTTP_CONN_STATE_NONE;
 	con->close_after_resp = false;
 	con->is_upstream = false;
+	con->readable = con->writable = true;
+	con->open_time = con->resp_send_time = Sys_Milliseconds();
+	con->bytes_received = con->bytes_sent = 0;
 	return con;
 }
 
@@ -311,12 +329,28 @@ static void SV_Web_ShutdownConnections( void ) {
 	for( con = hnode->prev; con != hnode; con = next ) {
 		next = con->prev;
 		if( con->open ) {
+			NET_RemoveFromPoller( sv_http_poller, &con->socket );
 			NET_CloseSocket( &con->socket );
 			SV_Web_FreeConnection( con );
 		}
 	}
 }
 
+/*
+* SV_Web_CloseConnection
+*/
+static void SV_Web_CloseConnection( sv_http_connection_t *con ) {
+	const int64_t elapsed = wsw::max( Sys_Milliseconds() - con->open_time, (int64_t)1 );
+
+	Com_DPrintf( "HTTP connection from %s closed: %" PRIu64 " bytes received, %" PRIu64 " bytes sent in %.3fs (%.1f KiB/s)\n",
+				 NET_AddressToString( &con->address ), con->bytes_received, con->bytes_sent,
+				 0.001 * elapsed, ( con->bytes_sent * 1000.0 / 1024.0 ) / elapsed );
+
+	NET_RemoveFromPoller( sv_http_poller, &con->socket );
+	NET_CloseSocket( &con->socket );
+	SV_Web_FreeConnection( con );
+}
+
 /*
 * SV_Web_AddGameClient
 */
@@ -443,11 +477,10 @@ static unsigned SV_Web_ConnectionLimitReached( const netadr_t *addr ) {
 	for( con = hnode->prev; con != hnode; con = next ) {
 		next = con->prev;
 		if( NET_CompareAddress( addr, &con->address ) ) {
-			if( cnt >= MAX_INCOMING_HTTP_CONNECTIONS_PER_ADDR ) {
+			if( ++cnt >= MAX_INCOMING_HTTP_CONNECTIONS_PER_ADDR ) {
 				return true;
 			}
 		}
-		cnt++;
 	}
 	return false;
 }
@@ -461,7 +494,12 @@ static int SV_Web_Get( sv_http_connection_t *con, void *recvbuf, size_t recvbuf_
 	read = NET_Get( &con->socket, NULL, recvbuf, recvbuf_size - 1 );
 	if( read < 0 ) {
 		con->open = false;
-		Com_DPrintf( "HTTP connection recv error from %s\n", NET_AddressToString( &con->address ) );
+		Com_DPrintf( "HTTP connection recv error from %s: %s\n", NET_AddressToString( &con->address ), NET_ErrorString() );
+	} else if( read == 0 ) {
+		// would block, wait for the next readiness notification
+		con->readable = false;
+	} else {
+		con->bytes_received += read;
 	}
 	return read;
 }
@@ -476,6 +514,10 @@ static int SV_Web_Send( sv_http_connection_t *con, void *sendbuf, size_t sendbuf
 	if( sent < 0 ) {
 		Com_DPrintf( "HTTP transmission error to %s\n", NET_AddressToString( &con->address ) );
 		con->open = false;
+	} else if( sent == 0 ) {
+		con->writable = false;
+	} else {
+		con->bytes_sent += sent;
 	}
 	return sent;
 }
@@ -495,8 +537,11 @@ static int64_t SV_Web_SendFile( sv_http_connection_t *con, int fileno, size_t fi
 	if( sent < 0 ) {
 		Com_DPrintf( "HTTP file transmission error to %s\n", NET_AddressToString( &con->address ) );
 		con->open = false;
+	} else if( sent == 0 ) {
+		con->writable = false;
 	} else {
 		*pos += sent;
+		con->bytes_sent += sent;
 	}
 	return sent;
 }
@@ -738,9 +783,7 @@ static void SV_Web_ReceiveRequest( socket_t *socket, sv_http_connection_t *con )
 		ret = SV_Web_Get( con, recvbuf, recvbuf_size - 1 );
 		if( ret <= 0 ) {
 			if( total_received == 0 ) {
-				// no data on the socket after select() call,
-				// the connection has probably been closed on the other end
-				con->open = false;
+				// either would block or the connection has been closed on the other end
 				return;
 			}
 			break;
@@ -943,6 +986,7 @@ static void SV_Web_RespondToQuery( sv_http_connection_t *con ) {
 
 		if( response->file ) {
 			Com_Printf( "HTTP serving file '%s' to '%s'\n", response->filename, NET_AddressToString( &con->address ) );
+			con->resp_send_time = Sys_Milliseconds();
 		}
 
 		// serve range requests
@@ -1097,6 +1141,13 @@ static size_t SV_Web_SendResponse( sv_http_connection_t *con ) {
 	if( stream->header_done
 		&& ( !stream->content_length || stream->content_p >= stream->content_length ) ) {
 		con->state = HTTP_CONN_STATE_RECV;
+
+		if( response->file ) {
+			const int64_t elapsed = wsw::max( Sys_Milliseconds() - con->resp_send_time, (int64_t)1 );
+			Com_DPrintf( "HTTP sent file '%s' to '%s': %" PRIu64 " bytes in %.3fs (%.1f KiB/s)\n",
+						 response->filename, NET_AddressToString( &con->address ), (uint64_t)stream->content_length,
+						 0.001 * elapsed, ( stream->content_length * 1000.0 / 1024.0 ) / elapsed );
+		}
 	}
 
 	return total_sent;
@@ -1204,6 +1255,11 @@ static void SV_Web_Listen( socket_t *socket ) {
 			con->open = true;
 			con->state = HTTP_CONN_STATE_RECV;
 			con->is_upstream = is_upstream;
+			if( !NET_AddToPoller( sv_http_poller, &con->socket, con ) ) {
+				Com_Printf( "HTTP connection from %s can't be polled: %s\n", NET_AddressToString( &newaddress ), NET_ErrorString() );
+				NET_CloseSocket( &con->socket );
+				SV_Web_FreeConnection( con );
+			}
 			continue;
 		}
 
@@ -1235,6 +1291,23 @@ void SV_Web_Init( void ) {
 		return;
 	}
 
+	sv_http_poller = NET_CreatePoller();
+	if( !sv_http_poller ) {
+		Com_Printf( "Error: Couldn't create HTTP sockets poller: %s\n", NET_ErrorString() );
+		NET_CloseSocket( &sv_socket_http );
+		NET_CloseSocket( &sv_socket_http6 );
+		sv_http_initialized = false;
+		return;
+	}
+
+	if( sv_socket_http.address.type == NA_IP ) {
+		NET_AddToPoller( sv_http_poller, &sv_socket_http, &sv_socket_http );
+	}
+	if( sv_socket_http6.address.type == NA_IP6 ) {
+		NET_AddToPoller( sv_http_poller, &sv_socket_http6, &sv_socket_http6 );
+	}
+
+	sv_http_last_check_time = 0;
 	sv_http_running = true;
 
 	Trie_Create( TRIE_CASE_SENSITIVE, &sv_http_clients );
@@ -1243,81 +1316,74 @@ void SV_Web_Init( void ) {
 }
 
 /*
-* SV_Web_Frame
+* SV_Web_ProcessConnection
+*
+* Advances the connection state machine as far as the socket readiness allows
 */
-static void SV_Web_Frame( void ) {
-	sv_http_connection_t *con, *next, *hnode = &sv_http_connection_headnode;
-	socket_t *sockets[MAX_INCOMING_HTTP_CONNECTIONS + 1];
-	void *connections[MAX_INCOMING_HTTP_CONNECTIONS];
-	int num_sockets = 0;
-	bool upstream_is_set;
+static void SV_Web_ProcessConnection( sv_http_connection_t *con ) {
+	while( con->open && sv_http_running ) {
+		const sv_http_connstate_t state = con->state;
 
-	if( !sv_http_initialized ) {
-		return;
-	}
-
-	upstream_is_set = sv_http_upstream_ip->string[0] != '\0' && sv_http_upstream_baseurl->string[0] != '\0';
-	if( upstream_is_set ) {
-		if( sv_http_upstream_ip->modified ) {
-			NET_StringToAddress( sv_http_upstream_ip->string, &sv_web_upstream_addr );
-			sv_http_upstream_ip->modified = false;
+		if( state == HTTP_CONN_STATE_RECV ) {
+			if( !con->readable ) {
+				break;
+			}
+			SV_Web_ReceiveRequest( &con->socket, con );
+		} else if( state == HTTP_CONN_STATE_RESP || ( state == HTTP_CONN_STATE_SEND && con->writable ) ) {
+			SV_Web_WriteResponse( &con->socket, con );
 		}
-	} else {
-		if( sv_web_upstream_addr.type != NA_NOTRANSMIT ) {
-			NET_InitAddress( &sv_web_upstream_addr, NA_NOTRANSMIT );
+
+		// either waiting for the socket or for the game thread now
+		if( con->state == state ) {
+			break;
 		}
 	}
 
-	// accept new connections
-	if( sv_socket_http.address.type == NA_IP ) {
-		SV_Web_Listen( &sv_socket_http );
-	}
-	if( sv_socket_http6.address.type == NA_IP6 ) {
-		SV_Web_Listen( &sv_socket_http6 );
+	if( con->open ) {
+		NET_SetPollerWriteInterest( sv_http_poller, &con->socket, con->state == HTTP_CONN_STATE_SEND );
 	}
+}
 
-	// handle incoming data
-	num_sockets = 0;
-	for( con = hnode->prev; con != hnode; con = next ) {
-		next = con->prev;
-		switch( con->state ) {
-			case HTTP_CONN_STATE_RECV:
-			case HTTP_CONN_STATE_RESP:
-			case HTTP_CONN_STATE_SEND:
-				sockets[num_sockets] = &con->socket;
-				connections[num_sockets] = con;
-				num_sockets++;
-				break;
-			default:
-				break;
-		}
+/*
+* SV_Web_HandlePollEvent
+*/
+static void SV_Web_HandlePollEvent( void *privatep, int events ) {
+	sv_http_connection_t *con;
+
+	if( privatep == &sv_socket_http || privatep == &sv_socket_http6 ) {
+		SV_Web_Listen( (socket_t *)privatep );
+		return;
 	}
-	sockets[num_sockets] = NULL;
 
-	if( num_sockets != 0 ) {
-		NET_Monitor( HTTP_SERVER_SLEEP_TIME, sockets,
-					 ( void ( * )( socket_t *, void* ) )SV_Web_ReceiveRequest,
-					 ( void ( * )( socket_t *, void* ) )SV_Web_WriteResponse,
-					 NULL, connections );
-	} else {
-		// sleep on network sockets if got nothing else to do
-		if( sv_socket_http.address.type == NA_IP ) {
-			sockets[num_sockets++] = &sv_socket_http;
-		}
-		if( sv_socket_http6.address.type == NA_IP6 ) {
-			sockets[num_sockets++] = &sv_socket_http6;
-		}
-		sockets[num_sockets] = NULL;
-		NET_Sleep( HTTP_SERVER_SLEEP_TIME, sockets );
+	con = (sv_http_connection_t *)privatep;
+	if( events & NET_POLL_READ ) {
+		con->readable = true;
 	}
+	if( events & NET_POLL_WRITE ) {
+		con->writable = true;
+	}
+	SV_Web_ProcessConnection( con );
+}
+
+/*
+* SV_Web_CheckConnections
+*
+* Picks up connections that don't get socket events: the ones waiting
+* for the game thread and timed out ones. Closes dead connections.
+*/
+static void SV_Web_CheckConnections( void ) {
+	sv_http_connection_t *con, *next, *hnode = &sv_http_connection_headnode;
 
-	// close dead connections
 	for( con = hnode->prev; con != hnode; con = next ) {
 		next = con->prev;
 		if( !sv_http_running ) {
 			return;
 		}
 
+		if( con->open && con->state == HTTP_CONN_STATE_RESP ) {
+			SV_Web_ProcessConnection( con );
+		}
+
 		if( con->open ) {
 			unsigned int timeout = 0;
 
@@ -1340,12 +1406,56 @@ static void SV_Web_Frame( void ) {
 		}
 
 		if( !con->open ) {
-			NET_CloseSocket( &con->socket );
-			SV_Web_FreeConnection( con );
+			SV_Web_CloseConnection( con );
 		}
 	}
 }
 
+/*
+* SV_Web_Frame
+*/
+static void SV_Web_Frame( void ) {
+	int64_t now;
+	bool upstream_is_set;
+
+	if( !sv_http_initialized ) {
+		return;
+	}
+
+	upstream_is_set = sv_http_upstream_ip->string[0] != '\0' && sv_http_upstream_baseurl->string[0] != '\0';
+	if( upstream_is_set ) {
+		if( sv_http_upstream_ip->modified ) {
+			NET_StringToAddress( sv_http_upstream_ip->string, &sv_web_upstream_addr );
+			sv_http_upstream_ip->modified = false;
+		}
+	} else {
+		if( sv_web_upstream_addr.type != NA_NOTRANSMIT ) {
+			NET_InitAddress( &sv_web_upstream_addr, NA_NOTRANSMIT );
+		}
+	}
+
+	// accept new connections and handle traffic of ready sockets
+	if( NET_Poll( sv_http_poller, HTTP_SERVER_SLEEP_TIME, SV_Web_HandlePollEvent ) < 0 ) {
+		Com_DPrintf( "HTTP sockets polling error: %s\n", NET_ErrorString() );
+	}
+
+	now = Sys_Milliseconds();
+	if( now < sv_http_last_check_time + HTTP_SERVER_CHECK_INTERVAL ) {
+		return;
+	}
+	sv_http_last_check_time = now;
+
+	// retry pending connections that were not accepted due to lack of free slots
+	if( sv_socket_http.address.type == NA_IP ) {
+		SV_Web_Listen( &sv_socket_http );
+	}
+	if( sv_socket_http6.address.type == NA_IP6 ) {
+		SV_Web_Listen( &sv_socket_http6 );
+	}
+
+	SV_Web_CheckConnections();
+}
+
 /*
 * SV_Web_Running
 */
@@ -1376,6 +1486,11 @@ void SV_Web_Shutdown( void ) {
 	sv_http_running = false;
 	QThread_Join( sv_http_thread );
 
+	NET_RemoveFromPoller( sv_http_poller, &sv_socket_http );
+	NET_RemoveFromPoller( sv_http_poller, &sv_socket_http6 );
+	NET_DestroyPoller( sv_http_poller );
+	sv_http_poller = NULL;
+
 	NET_CloseSocket( &sv_socket_http );
 	NET_CloseSocket( &sv_socket_http6 );
 
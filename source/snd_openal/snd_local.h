@@ -274,6 +274,10 @@ unsigned S_SuggestNumExtraThreadsForComputations();
 void S_Trace( trace_s *tr, const float *start, const float *end, const float *mins,
 			  const float *maxs, int mask, int topNodeHint = 0 );
 
+// Traces boxes of the same size in the world, the results match separate S_Trace() calls
+void S_TraceBatch( trace_s *traces, const vec3_t *starts, const vec3_t *ends, int numTraces,
+				   const float *mins, const float *maxs, int mask, int topNodeHint = 0 );
+
 int S_PointContents( const float *p, int topNodeHint = 0 );
 int S_PointLeafNum( const float *p, int topNodeHint = 0 );
 
@@ -233,6 +233,19 @@ void S_Trace( trace_t *tr, const vec3_t start,
 	tr->fraction = 1.0f;
 }
 
+void S_TraceBatch( trace_t *traces, const vec3_t *starts, const vec3_t *ends, int numTraces,
+				   const vec3_t mins, const vec3_t maxs, int mask, int topNodeHint ) {
+	if( cl.cms ) {
+		CM_TraceBatch( cl.cms, traces, starts, ends, numTraces, mins, maxs, mask, topNodeHint );
+		return;
+	}
+
+	for( int i = 0; i < numTraces; ++i ) {
+		::memset( &traces[i], 0, sizeof( trace_t ) );
+		traces[i].fraction = 1.0f;
+	}
+}
+
 int S_PointContents( const float *p, int topNodeHint ) {
 	if( cl.cms ) {
 		return CM_TransformedPointContents( cl.cms, p, nullptr, nullptr, nullptr, topNodeHint );
@@ -66,15 +66,30 @@ void GenericRaycastSampler::EmitPrimaryRays() {
 	assert( primaryRayDirs );
 	assert( primaryHitDistances );
 
-	trace_t trace;
+	// Rays are emitted from the same origin, so tracing these in batches shares the BSP descent
+	constexpr unsigned kBatchSize = 64;
+	vec3_t batchStarts[kBatchSize];
+	vec3_t batchEnds[kBatchSize];
+	trace_t batchTraces[kBatchSize];
+	for( unsigned i = 0; i < kBatchSize; ++i ) {
+		VectorCopy( emissionOrigin, batchStarts[i] );
+	}
+
 	for( unsigned i = 0; i < numPrimaryRays; ++i ) {
 		float *sampleDir, *hitPoint;
 		sampleDir = primaryRayDirs[i];
 
-		vec3_t testedRayPoint;
-		VectorScale( sampleDir, primaryEmissionRadius, testedRayPoint );
-		VectorAdd( testedRayPoint, emissionOrigin, testedRayPoint );
-		S_Trace( &trace, emissionOrigin, testedRayPoint, vec3_origin, vec3_origin, MASK_SOLID | MASK_WATER, topNode );
+		const unsigned batchIndex = i % kBatchSize;
+		if( !batchIndex ) {
+			const unsigned batchSize = std::min( kBatchSize, numPrimaryRays - i );
+			for( unsigned j = 0; j < batchSize; ++j ) {
+				VectorScale( primaryRayDirs[i + j], primaryEmissionRadius, batchEnds[j] );
+				VectorAdd( batchEnds[j], emissionOrigin, batchEnds[j] );
+			}
+			S_TraceBatch( batchTraces, batchStarts, batchEnds, batchSize, vec3_origin, vec3_origin, MASK_SOLID | MASK_WATER, topNode );
+		}
+
+		const trace_t &trace = batchTraces[batchIndex];
 
 		if( trace.startsolid || trace.allsolid ) {
 			continue;